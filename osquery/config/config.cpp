@@ -23,6 +23,7 @@
 #include <osquery/config/packs.h>
 #include <osquery/core/flagalias.h>
 #include <osquery/core/flags.h>
+#include <osquery/core/query.h>
 #include <osquery/core/shutdown.h>
 #include <osquery/core/system.h>
 #include <osquery/core/tables.h>
@@ -52,6 +53,9 @@ const int kMaxConfigSize = 1024 * 1024;
 using ConfigMap = std::map<std::string, std::string>;
 
 std::atomic<bool> is_first_time_refresh(true);
+
+/// Incremented when packs are added to or removed from the schedule.
+std::atomic<uint64_t> schedule_generation{0};
 }; // namespace
 
 /**
@@ -108,6 +112,7 @@ FLAG_ALIAS(google::uint64,
 
 DECLARE_string(config_plugin);
 DECLARE_string(pack_delimiter);
+DECLARE_uint64(pack_refresh_interval);
 
 /**
  * @brief The backing store key name for the executing query.
@@ -119,10 +124,19 @@ DECLARE_string(pack_delimiter);
 const std::string kExecutingQuery{"executing_query"};
 const std::string kFailedQueries{"failed_queries"};
 
+/// The scheduled query executing on this thread, see recordQueryStart.
+static thread_local std::string kThreadExecutingQuery;
+
+/// The key marking a scheduled query as executing.
+static std::string executingQueryKey(const std::string& name) {
+  return kExecutingQuery + "." + name;
+}
+
 // The config may be accessed and updated asynchronously; use mutexes.
 Mutex config_hash_mutex_;
 Mutex config_refresh_mutex_;
 Mutex config_backup_mutex_;
+Mutex config_snapshot_mutex_;
 
 /// Several config methods require enumeration via predicate lambdas.
 RecursiveMutex config_schedule_mutex_;
@@ -186,14 +200,6 @@ class Schedule : private boost::noncopyable {
   /// Underlying storage for the packs
   container packs_;
 
-  /**
-   * @brief The schedule will check and record previously executing queries.
-   *
-   * If a query is found on initialization, the name will be recorded, it is
-   * possible to skip previously failed queries.
-   */
-  std::string failed_query_;
-
   /**
    * @brief List of denylisted queries.
    *
@@ -214,6 +220,7 @@ bool Schedule::Step::operator()(const PackRef& pack) const {
 void Schedule::add(PackRef pack) {
   remove(pack->getName(), pack->getSource());
   packs_.push_back(std::move(pack));
+  ++schedule_generation;
 }
 
 void Schedule::remove(const std::string& pack) {
@@ -232,6 +239,7 @@ void Schedule::remove(const std::string& pack, const std::string& source) {
         return false;
       });
   packs_.erase(new_end, packs_.end());
+  ++schedule_generation;
 }
 
 void Schedule::removeAll(const std::string& source) {
@@ -245,6 +253,7 @@ void Schedule::removeAll(const std::string& source) {
         return false;
       });
   packs_.erase(new_end, packs_.end());
+  ++schedule_generation;
 }
 
 Schedule::iterator Schedule::begin() {
@@ -321,12 +330,30 @@ Schedule::Schedule() {
   restoreScheduleDenylist(denylist_);
 
   // Check if any queries were executing when the tool last stopped.
-  getDatabaseValue(kPersistentSettings, kExecutingQuery, failed_query_);
-  if (!failed_query_.empty()) {
-    LOG(WARNING) << "Scheduled query may have failed: " << failed_query_;
+  std::vector<std::string> failed_queries;
+  std::string failed_query;
+  getDatabaseValue(kPersistentSettings, kExecutingQuery, failed_query);
+  if (!failed_query.empty()) {
+    // A single executing query name, as stored by previous versions.
+    failed_queries.push_back(std::move(failed_query));
     setDatabaseValue(kPersistentSettings, kExecutingQuery, "");
-    // Add this query name to the denylist and save the denylist.
-    denylist_[failed_query_] = getUnixTime() + 86400;
+  }
+
+  auto prefix = executingQueryKey("");
+  std::vector<std::string> keys;
+  scanDatabaseKeys(kPersistentSettings, keys, prefix);
+  for (const auto& key : keys) {
+    failed_queries.push_back(key.substr(prefix.size()));
+    deleteDatabaseValue(kPersistentSettings, key);
+  }
+
+  for (const auto& name : failed_queries) {
+    LOG(WARNING) << "Scheduled query may have failed: " << name;
+    // Add this query name to the denylist.
+    denylist_[name] = getUnixTime() + 86400;
+  }
+
+  if (!failed_queries.empty()) {
     saveScheduleDenylist(denylist_);
   }
 }
@@ -457,6 +484,58 @@ void Config::scheduledQueries(
   }
 }
 
+ScheduleSnapshotRef Config::getScheduleSnapshot() const {
+  auto generation = schedule_generation.load();
+  {
+    ReadLock lock(config_snapshot_mutex_);
+    if (schedule_snapshot_ != nullptr &&
+        schedule_snapshot_->generation == generation &&
+        (schedule_snapshot_->expiration == 0 ||
+         getUnixTime() < schedule_snapshot_->expiration)) {
+      return schedule_snapshot_;
+    }
+  }
+
+  auto snapshot = std::make_shared<ScheduleSnapshot>();
+  snapshot->generation = generation;
+  auto expire_at = [&snapshot](uint64_t expiration) {
+    if (snapshot->expiration == 0 || expiration < snapshot->expiration) {
+      snapshot->expiration = expiration;
+    }
+  };
+
+  {
+    RecursiveLock lock(config_schedule_mutex_);
+    // The set of executing packs changes when their discovery cache expires.
+    auto now = getUnixTime();
+    for (const auto& pack : schedule_->packs_) {
+      if (!pack->getDiscoveryQueries().empty()) {
+        expire_at(now + std::max<uint64_t>(FLAGS_pack_refresh_interval, 1));
+      }
+    }
+
+    // The predicate runs with the schedule locked, a denylisted query is
+    // left out until its denylisting expires.
+    scheduledQueries(
+        ([this, &snapshot, &expire_at](std::string name,
+                                       const ScheduledQuery& query) {
+          if (query.denylisted) {
+            auto denylisted_query = schedule_->denylist_.find(name);
+            if (denylisted_query != schedule_->denylist_.end()) {
+              expire_at(denylisted_query->second);
+            }
+            return;
+          }
+          snapshot->queries.push_back({std::move(name), query});
+        }),
+        true);
+  }
+
+  WriteLock lock(config_snapshot_mutex_);
+  schedule_snapshot_ = snapshot;
+  return snapshot;
+}
+
 void Config::packs(std::function<void(const Pack& pack)> predicate) const {
   RecursiveLock lock(config_schedule_mutex_);
   for (PackRef& pack : schedule_->packs_) {
@@ -923,7 +1002,7 @@ void Config::purge() {
   RecursiveLock lock(config_schedule_mutex_);
   // Iterate over each result set in the database.
   for (const auto& saved_query : saved_queries) {
-    if (queryExists(saved_query)) {
+    if (queryExists(saved_query) || Query::isHashedResultsKey(saved_query)) {
       continue;
     }
 
@@ -950,8 +1029,7 @@ void Config::purge() {
 
     if (last_executed < getUnixTime() - 592200) {
       // Query has not run in the last week, expire results and interval.
-      deleteDatabaseValue(kQueries, saved_query);
-      deleteDatabaseValue(kQueries, saved_query + "epoch");
+      Query::deleteStoredResults(saved_query);
       deleteDatabaseValue(kPersistentSettings, "interval." + saved_query);
       deleteDatabaseValue(kPersistentSettings, "timestamp." + saved_query);
       VLOG(1) << "Expiring results for scheduled query: " << saved_query;
@@ -963,6 +1041,7 @@ void Config::reset() {
   setStartTime(getUnixTime());
 
   schedule_ = std::make_unique<Schedule>();
+  ++schedule_generation;
   std::map<std::string, QueryPerformance>().swap(performance_);
   std::map<std::string, FileCategories>().swap(files_);
   std::map<std::string, std::string>().swap(hash_);
@@ -998,9 +1077,7 @@ void ConfigParserPlugin::reset() {
 }
 
 void Config::recordQueryPerformance(const std::string& name,
-                                    uint64_t delay,
-                                    const Row& r0,
-                                    const Row& r1) {
+                                    const QueryExecutionStats& stats) {
   RecursiveLock lock(config_performance_mutex_);
   if (performance_.count(name) == 0) {
     performance_[name] = QueryPerformance();
@@ -1008,46 +1085,34 @@ void Config::recordQueryPerformance(const std::string& name,
 
   // Grab access to the non-const schedule item.
   auto& query = performance_.at(name);
-  if (!r1.at("user_time").empty() && !r0.at("user_time").empty()) {
-    auto ut1 = tryTo<long long>(r1.at("user_time"));
-    auto ut0 = tryTo<long long>(r0.at("user_time"));
-    auto diff = (ut1 && ut0) ? ut1.take() - ut0.take() : 0;
-    if (diff > 0) {
-      query.user_time += diff;
-    }
-  }
-
-  if (!r1.at("system_time").empty() && !r0.at("system_time").empty()) {
-    auto st1 = tryTo<long long>(r1.at("system_time"));
-    auto st0 = tryTo<long long>(r0.at("system_time"));
-    auto diff = (st1 && st0) ? st1.take() - st0.take() : 0;
-    if (diff > 0) {
-      query.system_time += diff;
-    }
+  query.user_time += stats.user_time;
+  query.system_time += stats.system_time;
+
+  if (stats.memory > 0) {
+    // Memory is stored as an average of RSS changes between query executions.
+    query.average_memory = (query.average_memory * query.executions) +
+                           static_cast<unsigned long long int>(stats.memory);
+    query.average_memory = (query.average_memory / (query.executions + 1));
   }
 
-  if (!r1.at("resident_size").empty() && !r0.at("resident_size").empty()) {
-    auto rs1 = tryTo<long long>(r1.at("resident_size"));
-    auto rs0 = tryTo<long long>(r0.at("resident_size"));
-    auto diff = (rs1 && rs0) ? rs1.take() - rs0.take() : 0;
-    if (diff > 0) {
-      // Memory is stored as an average of RSS changes between query executions.
-      query.average_memory = (query.average_memory * query.executions) + diff;
-      query.average_memory = (query.average_memory / (query.executions + 1));
-    }
+  for (const auto& table : stats.tables) {
+    query.tables[table.first] += table.second;
   }
 
-  query.wall_time += delay;
+  query.wall_time_ms += stats.wall_time_ms;
+  query.wall_time = query.wall_time_ms / 1000;
   query.executions += 1;
   query.last_executed = getUnixTime();
 
   // Clear the executing query (remove the dirty bit).
-  setDatabaseValue(kPersistentSettings, kExecutingQuery, "");
+  deleteDatabaseValue(kPersistentSettings, executingQueryKey(name));
+  kThreadExecutingQuery.clear();
 }
 
 void Config::recordQueryStart(const std::string& name) {
-  // There should only ever be a single executing query in the schedule.
-  setDatabaseValue(kPersistentSettings, kExecutingQuery, name);
+  // Concurrent queries each set a dirty bit, a failure denylists them all.
+  kThreadExecutingQuery = name;
+  setDatabaseValue(kPersistentSettings, executingQueryKey(name), name);
   // Store the time this query name last executed for later results eviction.
   // When configuration updates occur the previous schedule is searched for
   // 'stale' query names, aka those that have week-old or longer last execute
@@ -1056,6 +1121,10 @@ void Config::recordQueryStart(const std::string& name) {
       kPersistentSettings, "timestamp." + name, std::to_string(getUnixTime()));
 }
 
+const std::string& Config::getExecutingQuery() {
+  return kThreadExecutingQuery;
+}
+
 void Config::getPerformanceStats(
     const std::string& name,
     std::function<void(const QueryPerformance& query)> predicate) const {
@@ -12,6 +12,7 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include <osquery/core/plugins/plugin.h>
@@ -31,9 +32,33 @@ class Schedule;
 class ConfigParserPlugin;
 class ConfigRefreshRunner;
 
-/// The name of the executing query within the single-threaded schedule.
+/// The key, and key prefix, of the executing scheduled queries.
 extern const std::string kExecutingQuery;
 
+/**
+ * @brief An immutable copy of the scheduled queries that should execute.
+ *
+ * See Config::getScheduleSnapshot.
+ */
+struct ScheduleSnapshot {
+  /// A scheduled query and its unique (pack-prefixed) name.
+  struct Query {
+    std::string name;
+    ScheduledQuery query;
+  };
+
+  /// The queries in schedule order, denylisted queries are excluded.
+  std::vector<Query> queries;
+
+  /// The schedule generation the snapshot was built from.
+  uint64_t generation{0};
+
+  /// The time when the snapshot must be rebuilt, 0 if only on changes.
+  uint64_t expiration{0};
+};
+
+using ScheduleSnapshotRef = std::shared_ptr<const ScheduleSnapshot>;
+
 /**
  * @brief The programmatic representation of osquery's configuration
  *
@@ -85,15 +110,10 @@ class Config : private boost::noncopyable {
    * to the updates/changes reflected in the schedule, from the config.
    *
    * @param name The unique name of the scheduled item
-   * @param delay Number of seconds (wall time) taken by the query
-   * @param size Number of characters generated by query
-   * @param r0 the process row before the query
-   * @param r1 the process row after the query
+   * @param stats The resources used by one execution of the query
    */
   void recordQueryPerformance(const std::string& name,
-                              uint64_t delay,
-                              const Row& r0,
-                              const Row& r1);
+                              const QueryExecutionStats& stats);
 
   /**
    * @brief Record a query 'initialization', meaning the query will run.
@@ -104,10 +124,20 @@ class Config : private boost::noncopyable {
    * store. On process start, or worker state, if any dirty bit is set then
    * it is assumed that the current start is a result of a previous abort.
    *
+   * Each query has its own dirty bit, queries may execute concurrently.
+   *
    * @param name THe unique name of the scheduled item
    */
   void recordQueryStart(const std::string& name);
 
+  /**
+   * @brief The scheduled query executing on the calling thread.
+   *
+   * Set between Config::recordQueryStart and Config::recordQueryPerformance,
+   * otherwise empty.
+   */
+  static const std::string& getExecutingQuery();
+
   /**
    * @brief Calculate the hash of the osquery config
    *
@@ -185,6 +215,16 @@ class Config : private boost::noncopyable {
           predicate,
       bool denylisted = false) const;
 
+  /**
+   * @brief Get a snapshot of the scheduled queries that should execute.
+   *
+   * The same snapshot is returned until packs are added or removed, or until
+   * a pack's discovery cache or a query's denylisting expires. Unlike
+   * scheduledQueries, holding or executing a snapshot's queries does not lock
+   * the schedule, so a config refresh never waits for a query.
+   */
+  ScheduleSnapshotRef getScheduleSnapshot() const;
+
   /**
    * @brief Map a function across the set of configured files
    *
@@ -330,6 +370,9 @@ class Config : private boost::noncopyable {
   /// Schedule of packs and their queries.
   std::unique_ptr<Schedule> schedule_;
 
+  /// The last snapshot of the schedule, see getScheduleSnapshot.
+  mutable ScheduleSnapshotRef schedule_snapshot_{nullptr};
+
   /// A set of performance stats for each query in the schedule.
   std::map<std::string, QueryPerformance> performance_;
 
@@ -374,6 +417,7 @@ class Config : private boost::noncopyable {
   FRIEND_TEST(ConfigTests, test_config_refresh);
   FRIEND_TEST(ConfigTests, test_get_scheduled_queries);
   FRIEND_TEST(ConfigTests, test_nondenylist_query);
+  FRIEND_TEST(ConfigTests, test_schedule_snapshot);
   FRIEND_TEST(OptionsConfigParserPluginTests, test_get_option);
   FRIEND_TEST(OptionsConfigParserPluginTests, test_get_option_first);
   FRIEND_TEST(ViewsConfigParserPluginTests, test_add_view);
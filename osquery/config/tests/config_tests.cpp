@@ -356,6 +356,29 @@ TEST_F(ConfigTests, test_schedule_denylist) {
   EXPECT_EQ(denylist.size(), 1U);
 }
 
+TEST_F(ConfigTests, test_executing_queries_denylist) {
+  saveScheduleDenylist({});
+
+  // Two queries start concurrently, only the second completes.
+  get().recordQueryStart("test_executing_1");
+  get().recordQueryStart("test_executing_2");
+  EXPECT_EQ(Config::getExecutingQuery(), "test_executing_2");
+  get().recordQueryPerformance("test_executing_2", QueryExecutionStats());
+  EXPECT_TRUE(Config::getExecutingQuery().empty());
+
+  // The next schedule denylists the query that did not complete.
+  get().reset();
+  std::map<std::string, uint64_t> denylist;
+  restoreScheduleDenylist(denylist);
+  EXPECT_EQ(denylist.count("test_executing_1"), 1U);
+  EXPECT_EQ(denylist.count("test_executing_2"), 0U);
+
+  std::vector<std::string> keys;
+  scanDatabaseKeys(kPersistentSettings, keys, kExecutingQuery + ".");
+  EXPECT_TRUE(keys.empty());
+  saveScheduleDenylist({});
+}
+
 TEST_F(ConfigTests, test_pack_noninline) {
   auto& rf = RegistryFactory::get();
   rf.registry("config")->add("test", std::make_shared<TestConfigPlugin>());
@@ -525,6 +548,48 @@ TEST_F(ConfigTests, test_nondenylist_query) {
   EXPECT_FALSE(query->second);
 }
 
+TEST_F(ConfigTests, test_schedule_snapshot) {
+  get().addPack("unrestricted_pack", "", getUnrestrictedPack().doc());
+
+  std::vector<std::string> query_names;
+  get().scheduledQueries(
+      ([&query_names](std::string name, const ScheduledQuery&) {
+        query_names.push_back(std::move(name));
+      }));
+
+  // The snapshot holds the same queries, in the same order.
+  auto snapshot = get().getScheduleSnapshot();
+  ASSERT_NE(snapshot, nullptr);
+  ASSERT_EQ(snapshot->queries.size(), query_names.size());
+  for (size_t i = 0; i < query_names.size(); ++i) {
+    EXPECT_EQ(snapshot->queries[i].name, query_names[i]);
+  }
+
+  // It is reused until the schedule changes.
+  EXPECT_EQ(get().getScheduleSnapshot(), snapshot);
+  get().removePack("unrestricted_pack");
+  auto empty_snapshot = get().getScheduleSnapshot();
+  EXPECT_NE(empty_snapshot, snapshot);
+  EXPECT_TRUE(empty_snapshot->queries.empty());
+
+  // A previously taken snapshot is not modified.
+  EXPECT_EQ(snapshot->queries.size(), query_names.size());
+
+  // Denylisted queries are left out until the denylist expires.
+  std::map<std::string, uint64_t> denylist;
+  auto expiration = getUnixTime() * 2;
+  denylist[query_names[0]] = expiration;
+  saveScheduleDenylist(denylist);
+
+  get().reset();
+  get().addPack("unrestricted_pack", "", getUnrestrictedPack().doc());
+  snapshot = get().getScheduleSnapshot();
+  EXPECT_EQ(snapshot->queries.size(), query_names.size() - 1);
+  EXPECT_EQ(snapshot->expiration, expiration);
+
+  saveScheduleDenylist({});
+}
+
 class TestConfigParserPlugin : public ConfigParserPlugin {
  public:
   std::vector<std::string> keys() const override {
@@ -70,4 +70,13 @@ Status LoggerPlugin::call(const PluginRequest& request,
   }
 }
 
+Status LoggerPlugin::logChunk(const std::vector<std::string>& lines,
+                              bool snapshot) {
+  Status status;
+  for (const auto& line : lines) {
+    status = (snapshot) ? logSnapshot(line) : logString(line);
+  }
+  return status;
+}
+
 } // namespace osquery
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include <osquery/core/plugins/plugin.h>
 #include <osquery/utils/status/status.h>
@@ -186,6 +187,21 @@ class LoggerPlugin : public Plugin {
     return logString(s);
   }
 
+  /**
+   * @brief Optionally handle a chunk of query result events at once.
+   *
+   * Query results logged as events are streamed to the logger in chunks of
+   * at most `--logger_event_chunk_size` lines. A logger plugin with a cost per
+   * write may implement logChunk to write a chunk at once. Otherwise each line
+   * is forwarded to logSnapshot or logString.
+   *
+   * @param lines The serialized events of the chunk.
+   * @param snapshot true if the events are snapshot query results.
+   * @return log status
+   */
+  virtual Status logChunk(const std::vector<std::string>& lines,
+                          bool snapshot);
+
   /**
    * @brief Optionally handle each published event via the logger.
    *
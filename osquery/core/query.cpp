@@ -8,7 +8,10 @@
  */
 
 #include <algorithm>
+#include <iterator>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <osquery/core/flagalias.h>
@@ -17,6 +20,9 @@
 #include <osquery/database/database.h>
 #include <osquery/logger/logger.h>
 
+#include <osquery/utils/conversions/castvariant.h>
+#include <osquery/utils/conversions/split.h>
+#include <osquery/utils/conversions/tryto.h>
 #include <osquery/utils/json/json.h>
 
 namespace rj = rapidjson;
@@ -32,6 +38,143 @@ FLAG(bool,
      "Use numeric JSON syntax for numeric values");
 FLAG_ALIAS(bool, log_numerics_as_numbers, logger_numerics);
 
+FLAG(bool,
+     differential_hashes,
+     false,
+     "Store differential query results as row content hashes");
+
+FLAG(uint64,
+     differential_hash_shards,
+     16,
+     "Number of database keys used to store a query's row hashes");
+
+namespace {
+
+/// Prefix of the results value when results are stored as row hashes.
+const std::string kHashedResultsMarker{"hashed"};
+
+/// Key prefix for the shards of a query's row hash set.
+const std::string kHashShardPrefix{"hashes."};
+
+/// Key prefix for a single row, indexed by the row content hash.
+const std::string kHashedRowPrefix{"rows."};
+
+/// Number of hex characters used to encode a 64-bit hash.
+const size_t kHashWidth{16};
+
+/// A multiset of row content hashes.
+using HashCounts = std::unordered_map<uint64_t, size_t>;
+
+std::string hashToHex(uint64_t hash) {
+  static const char kHexDigits[] = "0123456789abcdef";
+  std::string hex(kHashWidth, '0');
+  for (size_t i = kHashWidth; i > 0; --i) {
+    hex[i - 1] = kHexDigits[hash & 0xf];
+    hash >>= 4;
+  }
+  return hex;
+}
+
+bool hexToHash(const std::string& hex, size_t offset, uint64_t& hash) {
+  hash = 0;
+  for (size_t i = offset; i < offset + kHashWidth; ++i) {
+    auto c = hex[i];
+    hash <<= 4;
+    if (c >= '0' && c <= '9') {
+      hash |= static_cast<uint64_t>(c - '0');
+    } else if (c >= 'a' && c <= 'f') {
+      hash |= static_cast<uint64_t>(c - 'a' + 10);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+inline std::string getShardKey(const std::string& name, size_t shard) {
+  return kHashShardPrefix + name + "." + std::to_string(shard);
+}
+
+inline std::string getRowKey(const std::string& name, uint64_t hash) {
+  return kHashedRowPrefix + name + "." + hashToHex(hash);
+}
+
+/// The layout of hashed results, parsed from the results value.
+struct HashedResultsLayout {
+  /// Number of hash shards, 0 if the results are not stored as hashes.
+  size_t shards{0};
+
+  /// True if each row's content is stored for removed row reporting.
+  bool rows{false};
+};
+
+/// The results value is "hashed:<shards>:<rows>" for hashed results.
+HashedResultsLayout getHashedResultsLayout(const std::string& value) {
+  HashedResultsLayout layout;
+  if (value.compare(0, kHashedResultsMarker.size(), kHashedResultsMarker) !=
+      0) {
+    return layout;
+  }
+
+  auto parts = osquery::split(value, ":");
+  if (parts.size() == 3 && parts[0] == kHashedResultsMarker) {
+    layout.shards = tryTo<size_t>(parts[1]).takeOr(size_t{0});
+    layout.rows = (parts[2] == "1");
+  }
+  return layout;
+}
+
+std::string getHashedResultsValue(size_t shards, bool rows) {
+  return kHashedResultsMarker + ":" + std::to_string(shards) + ":" +
+         (rows ? "1" : "0");
+}
+
+/// Read each shard of a hashed result set, a hash may appear several times.
+Status loadHashShards(const std::string& name,
+                      size_t shards,
+                      std::vector<std::vector<uint64_t>>& hashes) {
+  hashes.resize(shards);
+  for (size_t shard = 0; shard < shards; ++shard) {
+    std::string content;
+    getDatabaseValue(kQueries, getShardKey(name, shard), content);
+    if (content.size() % kHashWidth != 0) {
+      return Status::failure("Corrupted row hashes for query: " + name);
+    }
+
+    auto& shard_hashes = hashes[shard];
+    shard_hashes.reserve(content.size() / kHashWidth);
+    for (size_t offset = 0; offset < content.size(); offset += kHashWidth) {
+      uint64_t hash = 0;
+      if (!hexToHash(content, offset, hash)) {
+        return Status::failure("Corrupted row hashes for query: " + name);
+      }
+      shard_hashes.push_back(hash);
+    }
+  }
+  return Status::success();
+}
+
+/// Remove every key of a hashed result set.
+void deleteHashedResults(const std::string& name,
+                         const HashedResultsLayout& layout) {
+  std::vector<std::vector<uint64_t>> hashes;
+  if (layout.rows && loadHashShards(name, layout.shards, hashes).ok()) {
+    std::unordered_set<uint64_t> unique;
+    for (const auto& shard : hashes) {
+      unique.insert(shard.begin(), shard.end());
+    }
+    for (const auto& hash : unique) {
+      deleteDatabaseValue(kQueries, getRowKey(name, hash));
+    }
+  }
+
+  for (size_t shard = 0; shard < layout.shards; ++shard) {
+    deleteDatabaseValue(kQueries, getShardKey(name, shard));
+  }
+}
+
+} // namespace
+
 uint64_t Query::getPreviousEpoch() const {
   uint64_t epoch = 0;
   std::string raw;
@@ -63,6 +206,36 @@ Status Query::getPreviousQueryResults(QueryDataSet& results) const {
     return status;
   }
 
+  auto layout = getHashedResultsLayout(raw);
+  if (layout.shards > 0) {
+    // Hashed results can only be restored if each row's content is stored.
+    if (!layout.rows) {
+      return Status::failure("Results are stored as hashes only: " + name_);
+    }
+
+    std::vector<std::vector<uint64_t>> hashes;
+    status = loadHashShards(name_, layout.shards, hashes);
+    if (!status.ok()) {
+      return status;
+    }
+
+    for (const auto& shard : hashes) {
+      for (const auto& hash : shard) {
+        std::string json;
+        RowTyped row;
+        status = getDatabaseValue(kQueries, getRowKey(name_, hash), json);
+        if (status.ok()) {
+          status = deserializeRowJSON(json, row);
+        }
+        if (!status.ok()) {
+          return status;
+        }
+        results.insert(std::move(row));
+      }
+    }
+    return Status::success();
+  }
+
   status = deserializeQueryDataJSON(raw, results);
   if (!status.ok()) {
     return status;
@@ -76,9 +249,27 @@ std::vector<std::string> Query::getStoredQueryNames() {
   return results;
 }
 
+void Query::deleteStoredResults(const std::string& name) {
+  std::string raw;
+  getDatabaseValue(kQueries, name, raw);
+  auto layout = getHashedResultsLayout(raw);
+  if (layout.shards > 0) {
+    deleteHashedResults(name, layout);
+  }
+
+  deleteDatabaseValue(kQueries, name);
+  deleteDatabaseValue(kQueries, name + "epoch");
+}
+
+bool Query::isHashedResultsKey(const std::string& key) {
+  return key.compare(0, kHashShardPrefix.size(), kHashShardPrefix) == 0 ||
+         key.compare(0, kHashedRowPrefix.size(), kHashedRowPrefix) == 0;
+}
+
 bool Query::isQueryNameInDatabase() const {
-  auto names = Query::getStoredQueryNames();
-  return std::find(names.begin(), names.end(), name_) != names.end();
+  // A lookup of the results key, the stored rows are not enumerated.
+  std::string raw;
+  return getDatabaseValue(kQueries, name_, raw).ok();
 }
 
 static inline void saveQuery(const std::string& name,
@@ -147,6 +338,182 @@ Status Query::addNewResults(QueryDataTyped qd,
   return addNewResults(std::move(qd), epoch, counter, dr, false);
 }
 
+Status Query::addNewHashedResults(QueryDataTyped current_qd,
+                                  bool fresh_results,
+                                  DiffResults& dr,
+                                  bool& update_db) const {
+  std::string raw;
+  getDatabaseValue(kQueries, name_, raw);
+  auto previous_layout = getHashedResultsLayout(raw);
+
+  HashedResultsLayout layout;
+  layout.shards = std::max<size_t>(FLAGS_differential_hash_shards, 1);
+  layout.rows = store_removed_rows_;
+
+  // Multiset of the previous results' hashes.
+  HashCounts previous;
+  // Previous rows are available in memory when migrating from JSON results.
+  std::unordered_map<uint64_t, RowTyped> legacy_rows;
+  if (previous_layout.shards > 0) {
+    std::vector<std::vector<uint64_t>> hashes;
+    auto status = loadHashShards(name_, previous_layout.shards, hashes);
+    if (!status.ok()) {
+      return status;
+    }
+    for (const auto& shard : hashes) {
+      for (const auto& hash : shard) {
+        previous[hash]++;
+      }
+    }
+  } else if (!raw.empty()) {
+    QueryDataSet previous_qd;
+    auto status = deserializeQueryDataJSON(raw, previous_qd);
+    if (!status.ok()) {
+      return status;
+    }
+    for (const auto& row : previous_qd) {
+      auto hash = hashRowContent(row);
+      previous[hash]++;
+      legacy_rows.emplace(hash, row);
+    }
+  }
+
+  std::vector<uint64_t> current_hashes;
+  current_hashes.reserve(current_qd.size());
+  HashCounts remaining = previous;
+  std::vector<size_t> added;
+  for (size_t i = 0; i < current_qd.size(); ++i) {
+    auto hash = hashRowContent(current_qd[i]);
+    current_hashes.push_back(hash);
+
+    auto match = remaining.find(hash);
+    if (match != remaining.end() && match->second > 0) {
+      match->second--;
+    } else {
+      added.push_back(i);
+    }
+  }
+
+  std::unordered_set<uint64_t> current_set(current_hashes.begin(),
+                                           current_hashes.end());
+
+  // Shards containing an added or removed hash must be re-written.
+  bool relayout = (previous_layout.shards != layout.shards ||
+                   previous_layout.rows != layout.rows);
+  std::vector<bool> dirty_shards(layout.shards, relayout);
+  DatabaseStringValueList batch;
+  // Keys removed within the same write as the batch.
+  std::vector<std::string> removals;
+
+  // Rows must be written if they were not stored by the previous layout.
+  bool rows_stored = (previous_layout.shards > 0 && previous_layout.rows);
+  if (layout.rows && !rows_stored) {
+    for (size_t i = 0; i < current_qd.size(); ++i) {
+      std::string json;
+      serializeRowJSON(current_qd[i], json, true);
+      batch.push_back(
+          std::make_pair(getRowKey(name_, current_hashes[i]), std::move(json)));
+    }
+  } else if (!layout.rows && rows_stored) {
+    for (const auto& hash : previous) {
+      removals.push_back(getRowKey(name_, hash.first));
+    }
+  }
+
+  // Collect removed rows, their stored content is no longer needed.
+  QueryDataTyped removed;
+  for (const auto& hash : remaining) {
+    if (hash.second == 0) {
+      continue;
+    }
+    dirty_shards[hash.first % layout.shards] = true;
+
+    if (layout.rows && !fresh_results) {
+      RowTyped row;
+      auto legacy_row = legacy_rows.find(hash.first);
+      if (legacy_row != legacy_rows.end()) {
+        row = legacy_row->second;
+      } else {
+        std::string json;
+        getDatabaseValue(kQueries, getRowKey(name_, hash.first), json);
+        if (!deserializeRowJSON(json, row).ok()) {
+          VLOG(1) << "Cannot restore removed row for query: " << name_;
+          continue;
+        }
+      }
+      for (size_t i = 0; i < hash.second; ++i) {
+        removed.push_back(row);
+      }
+    }
+
+    if (rows_stored && current_set.count(hash.first) == 0) {
+      removals.push_back(getRowKey(name_, hash.first));
+    }
+  }
+
+  for (const auto& index : added) {
+    const auto& hash = current_hashes[index];
+    dirty_shards[hash % layout.shards] = true;
+    if (layout.rows && rows_stored && previous.count(hash) == 0) {
+      std::string json;
+      serializeRowJSON(current_qd[index], json, true);
+      batch.push_back(std::make_pair(getRowKey(name_, hash), std::move(json)));
+    }
+  }
+
+  // Re-write the dirty shards with the current hashes, sorted for stability.
+  std::vector<std::vector<uint64_t>> shard_hashes(layout.shards);
+  for (const auto& hash : current_hashes) {
+    if (dirty_shards[hash % layout.shards]) {
+      shard_hashes[hash % layout.shards].push_back(hash);
+    }
+  }
+  for (size_t shard = 0; shard < layout.shards; ++shard) {
+    if (!dirty_shards[shard]) {
+      continue;
+    }
+    auto& hashes = shard_hashes[shard];
+    std::sort(hashes.begin(), hashes.end());
+    std::string content;
+    content.reserve(hashes.size() * kHashWidth);
+    for (const auto& hash : hashes) {
+      content += hashToHex(hash);
+    }
+    batch.push_back(std::make_pair(getShardKey(name_, shard), content));
+  }
+
+  // Remove shards beyond the current layout.
+  for (size_t shard = layout.shards; shard < previous_layout.shards; ++shard) {
+    removals.push_back(getShardKey(name_, shard));
+  }
+
+  update_db = fresh_results || relayout || !added.empty() ||
+              std::any_of(remaining.begin(),
+                          remaining.end(),
+                          [](const auto& hash) { return hash.second > 0; });
+  if (update_db) {
+    batch.push_back(std::make_pair(
+        name_, getHashedResultsValue(layout.shards, layout.rows)));
+    auto status = setDatabaseBatch(kQueries, batch, removals);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  if (fresh_results) {
+    // Previous results do not apply, every current row is reported as added.
+    dr.added = std::move(current_qd);
+    return Status::success();
+  }
+
+  dr.added.reserve(added.size());
+  for (const auto& index : added) {
+    dr.added.push_back(std::move(current_qd[index]));
+  }
+  dr.removed = std::move(removed);
+  return Status::success();
+}
+
 Status Query::addNewResults(QueryDataTyped current_qd,
                             const uint64_t current_epoch,
                             uint64_t& counter,
@@ -157,6 +524,41 @@ Status Query::addNewResults(QueryDataTyped current_qd,
   bool new_query = false;
   getQueryStatus(current_epoch, fresh_results, new_query);
 
+  if (FLAGS_differential_hashes) {
+    bool update_db = true;
+    auto status = addNewHashedResults(
+        std::move(current_qd), fresh_results, dr, update_db);
+    if (!status.ok()) {
+      return status;
+    }
+
+    if (update_db) {
+      status = setDatabaseValue(
+          kQueries, name_ + "epoch", std::to_string(current_epoch));
+      if (!status.ok()) {
+        return status;
+      }
+    }
+
+    if (update_db || fresh_results || new_query) {
+      status = incrementCounter(fresh_results || new_query, counter);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    return Status::success();
+  }
+
+  // Results may have been stored as hashes by a previous configuration.
+  std::string raw;
+  getDatabaseValue(kQueries, name_, raw);
+  auto previous_layout = getHashedResultsLayout(raw);
+  if (previous_layout.shards > 0) {
+    LOG(INFO) << "Replacing hashed results for scheduled query: " << name_;
+    deleteHashedResults(name_, previous_layout);
+    fresh_results = true;
+  }
+
   // Use a 'target' avoid copying the query data when serializing and saving.
   // If a differential is requested and needed the target remains the original
   // query data, otherwise the content is moved to the differential's added set.
@@ -165,7 +567,7 @@ Status Query::addNewResults(QueryDataTyped current_qd,
   if (!fresh_results && calculate_diff) {
     // Get the rows from the last run of this query name.
     QueryDataSet previous_qd;
-    auto status = getPreviousQueryResults(previous_qd);
+    auto status = deserializeQueryDataJSON(raw, previous_qd);
     if (!status.ok()) {
       return status;
     }
@@ -374,4 +776,142 @@ Status serializeQueryLogItemAsEventsJSON(const QueryLogItem& item,
   return Status::success();
 }
 
+namespace {
+
+/// Writes a typed column value into an event, see serializeRow.
+class EventColumnVisitor : public boost::static_visitor<> {
+ public:
+  explicit EventColumnVisitor(rj::Writer<rj::StringBuffer>& writer)
+      : writer_(writer) {}
+
+  void operator()(const long long& i) const {
+    writer_.Int64(i);
+  }
+
+  void operator()(const double& d) const {
+    writer_.Double(d);
+  }
+
+  void operator()(const std::string& str) const {
+    writer_.String(str.data(), static_cast<rj::SizeType>(str.size()));
+  }
+
+ private:
+  rj::Writer<rj::StringBuffer>& writer_;
+};
+
+/// Render the fields shared by all events of an item as an open JSON object.
+std::string getEventEnvelope(const QueryLogItem& item) {
+  auto doc = JSON::newObject();
+  addLegacyFieldsAndDecorations(item, doc, doc.doc());
+
+  std::string envelope;
+  doc.toString(envelope);
+
+  // Replace the closing brace, the event members follow.
+  envelope.back() = ',';
+  return envelope;
+}
+
+void serializeEventColumns(const RowTyped& row,
+                           rj::Writer<rj::StringBuffer>& writer) {
+  EventColumnVisitor visitor(writer);
+
+  writer.StartObject();
+  for (const auto& column : row) {
+    writer.Key(column.first.data(),
+               static_cast<rj::SizeType>(column.first.size()));
+    if (FLAGS_logger_numerics) {
+      boost::apply_visitor(visitor, column.second);
+    } else {
+      visitor(castVariant(column.second));
+    }
+  }
+  writer.EndObject();
+}
+
+} // namespace
+
+Status serializeQueryLogItemAsEventChunks(
+    const QueryLogItem& item,
+    size_t chunk_size,
+    const QueryLogEventChunkCallback& callback) {
+  bool differential =
+      !item.results.added.empty() || !item.results.removed.empty();
+  if (!differential && item.snapshot_results.empty()) {
+    return Status(1, "No differential or snapshot results");
+  }
+
+  chunk_size = std::max<size_t>(chunk_size, 1);
+  if (FLAGS_decorations_top_level &&
+      (item.decorations.count("columns") > 0 ||
+       item.decorations.count("action") > 0)) {
+    // These decorations are replaced by the event members, which reorders
+    // the document members; keep the output of the document serialization.
+    std::vector<std::string> all_events;
+    auto status = serializeQueryLogItemAsEventsJSON(item, all_events);
+    for (auto it = all_events.begin(); status.ok() && it != all_events.end();) {
+      auto end = it + std::min<size_t>(chunk_size, all_events.end() - it);
+      std::vector<std::string> events(std::make_move_iterator(it),
+                                      std::make_move_iterator(end));
+      status = callback(events);
+      it = end;
+    }
+    return status;
+  }
+
+  auto envelope = getEventEnvelope(item);
+
+  std::vector<std::string> events;
+  rj::StringBuffer columns;
+  rj::Writer<rj::StringBuffer> writer(columns);
+
+  auto serialize_rows = [&](const QueryDataTyped& rows,
+                            const std::string& action) -> Status {
+    for (const auto& row : rows) {
+      columns.Clear();
+      writer.Reset(columns);
+      serializeEventColumns(row, writer);
+
+      std::string event;
+      event.reserve(envelope.size() + columns.GetSize() + action.size() + 23);
+      event.append(envelope);
+      event.append("\"columns\":");
+      event.append(columns.GetString(), columns.GetSize());
+      event.append(",\"action\":\"");
+      event.append(action);
+      event.append("\"}");
+      events.push_back(std::move(event));
+
+      if (events.size() >= chunk_size) {
+        auto status = callback(events);
+        events.clear();
+        if (!status.ok()) {
+          return status;
+        }
+      }
+    }
+    return Status::success();
+  };
+
+  // Events are emitted in the order of serializeQueryLogItemAsEvents.
+  Status status;
+  if (differential) {
+    events.reserve(std::min(
+        chunk_size, item.results.removed.size() + item.results.added.size()));
+    status = serialize_rows(item.results.removed, "removed");
+    if (status.ok()) {
+      status = serialize_rows(item.results.added, "added");
+    }
+  } else {
+    events.reserve(std::min(chunk_size, item.snapshot_results.size()));
+    status = serialize_rows(item.snapshot_results, "snapshot");
+  }
+
+  if (!status.ok() || events.empty()) {
+    return status;
+  }
+  return callback(events);
+}
+
 }
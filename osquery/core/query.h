@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <functional>
 #include <map>
 #include <set>
 #include <string>
@@ -116,6 +117,29 @@ Status serializeQueryLogItemAsEvents(const QueryLogItem& item, JSON& json);
 Status serializeQueryLogItemAsEventsJSON(const QueryLogItem& i,
                                          std::vector<std::string>& items);
 
+/// Receives a chunk of JSON events, which it may consume.
+using QueryLogEventChunkCallback =
+    std::function<Status(std::vector<std::string>& events)>;
+
+/**
+ * @brief Serialize a QueryLogItem object into chunks of JSON event strings.
+ *
+ * The events are the same as the ones from serializeQueryLogItemAsEventsJSON
+ * but no document is built for the results. The fields shared by all events
+ * are rendered once and each row is written directly into its event, so at
+ * most chunk_size events are held at a time.
+ *
+ * @param item the QueryLogItem to serialize
+ * @param chunk_size the maximum number of events in a chunk
+ * @param callback called with each chunk, serialization stops on failure
+ *
+ * @return Status indicating the success or failure of the operation
+ */
+Status serializeQueryLogItemAsEventChunks(
+    const QueryLogItem& item,
+    size_t chunk_size,
+    const QueryLogEventChunkCallback& callback);
+
 /**
  * @brief Interact with the historical on-disk storage for a given query.
  */
@@ -131,7 +155,9 @@ class Query {
    * @param q a ScheduledQuery struct.
    */
   explicit Query(std::string name, const ScheduledQuery& q)
-      : query_(q.query), name_(std::move(name)) {}
+      : query_(q.query),
+        name_(std::move(name)),
+        store_removed_rows_(q.reportRemovedRows()) {}
 
   /**
    * @brief Serialize the data in RocksDB into a useful data structure
@@ -255,6 +281,38 @@ class Query {
    */
   static std::vector<std::string> getStoredQueryNames();
 
+  /**
+   * @brief Remove the stored results of a query name.
+   *
+   * This removes the results, epoch, and any row hashes stored for the name.
+   */
+  static void deleteStoredResults(const std::string& name);
+
+  /// Check if a stored key is an internal key of hashed results.
+  static bool isHashedResultsKey(const std::string& key);
+
+ private:
+  /**
+   * @brief Differential using a stored set of row content hashes.
+   *
+   * Used when --differential_hashes is enabled. Instead of the full results
+   * as JSON, the previous results are stored as a sharded set of row content
+   * hashes. Only shards containing added or removed rows are re-written.
+   * If removed rows are reported, each row's content is stored once under its
+   * hash and only the removed rows are read back.
+   *
+   * @param current_qd the current results.
+   * @param fresh_results true if the previous results do not apply.
+   * @param dr [output] the differential results.
+   * @param update_db [output] true if the stored results changed.
+   *
+   * @return the success or failure of the operation.
+   */
+  Status addNewHashedResults(QueryDataTyped current_qd,
+                             bool fresh_results,
+                             DiffResults& dr,
+                             bool& update_db) const;
+
  private:
   /// The scheduled query's query string.
   std::string query_;
@@ -262,6 +320,9 @@ class Query {
   /// The scheduled query name.
   std::string name_;
 
+  /// Hashed results keep each row's content only if removed rows are logged.
+  bool store_removed_rows_{true};
+
  private:
   FRIEND_TEST(QueryTests, test_private_members);
   FRIEND_TEST(QueryTests, test_add_and_get_current_results);
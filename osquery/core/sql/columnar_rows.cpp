@@ -0,0 +1,134 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include "columnar_rows.h"
+
+#include <cstdlib>
+
+#include <osquery/utils/conversions/tryto.h>
+
+namespace osquery {
+
+namespace {
+
+bool isIntegerType(ColumnType type) {
+  return type == INTEGER_TYPE || type == BIGINT_TYPE ||
+         type == UNSIGNED_BIGINT_TYPE;
+}
+
+template <typename T>
+void setIntegerValue(ColumnarRows::Column& column,
+                     size_t row,
+                     const std::string& value) {
+  auto integer = tryTo<T>(value, 0);
+  if (integer.isError() || value.empty()) {
+    column.setNull(row);
+  } else {
+    column.integer_values[row] = static_cast<int64_t>(integer.take());
+  }
+}
+
+} // namespace
+
+bool ColumnarRows::Column::isNull(size_t row) const {
+  return row / 8 < nulls.size() &&
+         (static_cast<unsigned char>(nulls[row / 8]) >> (row % 8)) & 1;
+}
+
+void ColumnarRows::Column::setNull(size_t row) {
+  if (row / 8 >= nulls.size()) {
+    nulls.resize(row / 8 + 1, '\0');
+  }
+  nulls[row / 8] |= static_cast<char>(1 << (row % 8));
+}
+
+size_t ColumnarRows::Column::size() const {
+  if (isIntegerType(type)) {
+    return integer_values.size();
+  } else if (type == DOUBLE_TYPE) {
+    return double_values.size();
+  }
+  return text_values.size();
+}
+
+const ColumnarRows::Column* ColumnarRows::find(const std::string& name) const {
+  // Tables have few columns, a scan is cheaper than hashing the name.
+  for (const auto& column : columns) {
+    if (column.name == name) {
+      return &column;
+    }
+  }
+  return nullptr;
+}
+
+bool ColumnarRows::valid() const {
+  for (const auto& column : columns) {
+    if (column.size() != row_count || column.nulls.size() > row_count / 8 + 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Status tableRowsToColumns(const TableRows& rows,
+                          const TableColumns& columns,
+                          ColumnarRows& results) {
+  results.row_count = rows.size();
+  results.columns.clear();
+  results.columns.resize(columns.size());
+  for (size_t i = 0; i < columns.size(); i++) {
+    auto& column = results.columns[i];
+    column.name = std::get<0>(columns[i]);
+    column.type = std::get<1>(columns[i]);
+    if (isIntegerType(column.type)) {
+      column.integer_values.resize(rows.size());
+    } else if (column.type == DOUBLE_TYPE) {
+      column.double_values.resize(rows.size());
+    } else {
+      column.text_values.resize(rows.size());
+    }
+  }
+
+  for (size_t r = 0; r < rows.size(); r++) {
+    auto row = static_cast<Row>(*rows[r]);
+    size_t found = 0;
+    for (auto& column : results.columns) {
+      auto value = row.find(column.name);
+      if (value == row.end()) {
+        column.setNull(r);
+        continue;
+      }
+
+      found++;
+      if (column.type == INTEGER_TYPE) {
+        setIntegerValue<long>(column, r, value->second);
+      } else if (isIntegerType(column.type)) {
+        setIntegerValue<long long>(column, r, value->second);
+      } else if (column.type == DOUBLE_TYPE) {
+        char* end = nullptr;
+        double real = strtod(value->second.c_str(), &end);
+        if (end == nullptr || end == value->second.c_str() || *end != '\0') {
+          column.setNull(r);
+        } else {
+          column.double_values[r] = real;
+        }
+      } else {
+        column.text_values[r] = std::move(value->second);
+      }
+    }
+
+    // Values outside of the declared columns (like a rowid) need rows.
+    if (found != row.size()) {
+      return Status::failure("Row contains an undeclared column");
+    }
+  }
+  return Status::success();
+}
+
+} // namespace osquery
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <osquery/utils/status/status.h>
+
+#include "column.h"
+#include "table_rows.h"
+
+namespace osquery {
+
+/**
+ * @brief Table rows stored as typed columns.
+ *
+ * Extension tables may send their results as columns. Each column name is
+ * sent once and the values are sent typed, instead of a string map per row.
+ */
+struct ColumnarRows {
+  struct Column {
+    /// The column name.
+    std::string name;
+
+    /// The column type, selects which of the values vectors is used.
+    ColumnType type{TEXT_TYPE};
+
+    /// Values of TEXT, BLOB and unknown type columns.
+    std::vector<std::string> text_values;
+
+    /// Values of INTEGER, BIGINT and UNSIGNED_BIGINT columns.
+    std::vector<int64_t> integer_values;
+
+    /// Values of DOUBLE columns.
+    std::vector<double> double_values;
+
+    /// One bit for each row, set if the row has no value. May be empty.
+    std::string nulls;
+
+    /// Check if a row has no value for this column.
+    bool isNull(size_t row) const;
+
+    /// Mark a row as having no value for this column.
+    void setNull(size_t row);
+
+    /// Get the number of values in the vector used for the column type.
+    size_t size() const;
+  };
+
+  /// The number of rows, every column has a value (or null) for each.
+  size_t row_count{0};
+
+  /// The columns, in the order of the table's declared columns.
+  std::vector<Column> columns;
+
+  /// Find a column by name, returns nullptr if there is no such column.
+  const Column* find(const std::string& name) const;
+
+  /// Check that every column has a value for each row.
+  bool valid() const;
+};
+
+/**
+ * @brief Convert generated rows to columns of the table's declared types.
+ *
+ * Values are converted as the SQL virtual table would convert them, a value
+ * that cannot be converted to the column type becomes null.
+ *
+ * @param rows the rows generated by a table.
+ * @param columns the table's declared columns.
+ * @param results [output] the rows as columns.
+ *
+ * @return Failure if a row contains a value for an undeclared column.
+ */
+Status tableRowsToColumns(const TableRows& rows,
+                          const TableColumns& columns,
+                          ColumnarRows& results);
+
+} // namespace osquery
@@ -7,12 +7,58 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <cstring>
+
 #include "diff_results.h"
 
 namespace rj = rapidjson;
 
 namespace osquery {
 
+namespace {
+
+/// 64-bit FNV-1a parameters.
+const uint64_t kFNVOffsetBasis = 0xcbf29ce484222325ULL;
+const uint64_t kFNVPrime = 0x100000001b3ULL;
+
+inline void hashBytes(uint64_t& hash, const void* data, size_t size) {
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= kFNVPrime;
+  }
+}
+
+/// Hash a type tag followed by the value bytes.
+class RowValueHashVisitor : public boost::static_visitor<> {
+ public:
+  explicit RowValueHashVisitor(uint64_t& hash) : hash_(hash) {}
+
+  void operator()(long long value) const {
+    hashBytes(hash_, "i", 1);
+    hashBytes(hash_, &value, sizeof(value));
+  }
+
+  void operator()(double value) const {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    hashBytes(hash_, "d", 1);
+    hashBytes(hash_, &bits, sizeof(bits));
+  }
+
+  void operator()(const std::string& value) const {
+    uint64_t size = value.size();
+    hashBytes(hash_, "s", 1);
+    hashBytes(hash_, &size, sizeof(size));
+    hashBytes(hash_, value.data(), value.size());
+  }
+
+ private:
+  uint64_t& hash_;
+};
+
+} // namespace
+
 Status serializeDiffResults(const DiffResults& d,
                             JSON& doc,
                             rj::Document& obj,
@@ -69,4 +115,24 @@ DiffResults diff(QueryDataSet& old, QueryDataTyped& current) {
   return r;
 }
 
+uint64_t hashRowContent(const RowTyped& row) {
+  uint64_t hash = kFNVOffsetBasis;
+  RowValueHashVisitor visitor(hash);
+  // Rows are ordered maps so the column order is stable.
+  for (const auto& column : row) {
+    uint64_t size = column.first.size();
+    hashBytes(hash, &size, sizeof(size));
+    hashBytes(hash, column.first.data(), column.first.size());
+    boost::apply_visitor(visitor, column.second);
+  }
+
+  // Finalize (splitmix64) so the low bits are well distributed for sharding.
+  hash ^= hash >> 30;
+  hash *= 0xbf58476d1ce4e5b9ULL;
+  hash ^= hash >> 27;
+  hash *= 0x94d049bb133111ebULL;
+  hash ^= hash >> 31;
+  return hash;
+}
+
 } // namespace osquery
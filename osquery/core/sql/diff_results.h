@@ -96,4 +96,17 @@ Status serializeDiffResultsJSON(const DiffResults& d,
  */
 DiffResults diff(QueryDataSet& old_, QueryDataTyped& new_);
 
+/**
+ * @brief Compute a stable 64-bit content hash of a row.
+ *
+ * The hash covers each column name, value type, and value. It does not depend
+ * on process state, so it may be persisted and compared across executions and
+ * restarts on the same host.
+ *
+ * @param row the row to hash.
+ *
+ * @return the 64-bit content hash.
+ */
+uint64_t hashRowContent(const RowTyped& row);
+
 } // namespace osquery
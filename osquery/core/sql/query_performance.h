@@ -10,9 +10,57 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
 
 namespace osquery {
 
+/**
+ * @brief performance statistics about a virtual table used by a query
+ */
+struct TablePerformance {
+  /// Number of times the table generated rows (one per scan/xFilter).
+  size_t generations{0};
+
+  /// Total rows produced by the table.
+  unsigned long long int rows{0};
+
+  /// Total time spent generating rows, in microseconds.
+  unsigned long long int generate_time{0};
+
+  /// Accumulate the statistics of another set of table scans.
+  TablePerformance& operator+=(const TablePerformance& other) {
+    generations += other.generations;
+    rows += other.rows;
+    generate_time += other.generate_time;
+    return *this;
+  }
+};
+
+/// Per-table statistics keyed by virtual table name.
+using TablePerformanceMap = std::map<std::string, TablePerformance>;
+
+/**
+ * @brief resources used by a single execution of a query
+ */
+struct QueryExecutionStats {
+  /// Monotonic wall time taken, in milliseconds.
+  uint64_t wall_time_ms{0};
+
+  /// User time of the executing thread, in milliseconds.
+  uint64_t user_time{0};
+
+  /// System time of the executing thread, in milliseconds.
+  uint64_t system_time{0};
+
+  /// Change in the resident memory of the process, in bytes.
+  int64_t memory{0};
+
+  /// The virtual tables generated while executing.
+  TablePerformanceMap tables;
+};
+
 /**
  * @brief performance statistics about a query
  */
@@ -26,6 +74,9 @@ struct QueryPerformance {
   /// Total wall time taken
   unsigned long long int wall_time{0};
 
+  /// Total wall time taken, in milliseconds.
+  unsigned long long int wall_time_ms{0};
+
   /// Total user time (cycles)
   unsigned long long int user_time{0};
 
@@ -34,6 +85,9 @@ struct QueryPerformance {
 
   /// Average memory differentials. This should be near 0.
   unsigned long long int average_memory{0};
+
+  /// Accumulated statistics of each virtual table the query generates.
+  TablePerformanceMap tables;
 };
 
 } // namespace osquery
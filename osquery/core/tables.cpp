@@ -24,8 +24,8 @@ FLAG(bool, disable_caching, false, "Disable scheduled query caching");
 
 CREATE_LAZY_REGISTRY(TablePlugin, "table");
 
-uint64_t TablePlugin::kCacheInterval = 0;
-uint64_t TablePlugin::kCacheStep = 0;
+thread_local uint64_t TablePlugin::kCacheInterval = 0;
+thread_local uint64_t TablePlugin::kCacheStep = 0;
 
 #define kDisableRowId "WITHOUT ROWID"
 
@@ -160,6 +160,25 @@ Status TablePlugin::call(const PluginRequest& request,
   return Status::success();
 }
 
+Status TablePlugin::callColumnar(const PluginRequest& request,
+                                 PluginResponse& response,
+                                 ColumnarRows& columns) {
+  auto action = request.find("action");
+  if (action == request.end() || action->second != "generate") {
+    return call(request, response);
+  }
+
+  response.clear();
+  auto context = getContextFromRequest(request);
+  TableRows result = generate(context);
+  if (!tableRowsToColumns(result, this->columns(), columns).ok()) {
+    columns = ColumnarRows();
+    response = tableRowsToPluginResponse(result);
+  }
+
+  return Status::success();
+}
+
 std::string TablePlugin::columnDefinition(bool is_extension) const {
   return osquery::columnDefinition(columns(), is_extension);
 }
@@ -218,7 +237,14 @@ bool TablePlugin::isCached(uint64_t step, const QueryContext& ctx) const {
   }
 
   // Perform the step comparison first, because it's easy.
-  return (step < last_cached_ + last_interval_ && cacheAllowed(columns(), ctx));
+  if (step >= last_cached_ + last_interval_ || !cacheAllowed(columns(), ctx)) {
+    return false;
+  }
+
+  // The cached results must include every column this query uses.
+  auto used =
+      ctx.colsUsedBitset ? *ctx.colsUsedBitset : UsedColumnsBitset().set();
+  return (used & ~last_cached_columns_).none();
 }
 
 TableRows TablePlugin::getCache() const {
@@ -244,6 +270,8 @@ void TablePlugin::setCache(uint64_t step,
   if (serializeTableRowsJSON(results, content)) {
     last_cached_ = step;
     last_interval_ = interval;
+    last_cached_columns_ =
+        ctx.colsUsedBitset ? *ctx.colsUsedBitset : UsedColumnsBitset().set();
     setDatabaseValue(kQueries, "cache." + getName(), content);
   }
 }
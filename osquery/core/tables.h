@@ -26,6 +26,7 @@
 #include <osquery/core/plugins/plugin.h>
 #include <osquery/core/query.h>
 #include <osquery/core/sql/column.h>
+#include <osquery/core/sql/columnar_rows.h>
 
 #include <gtest/gtest_prod.h>
 
@@ -834,7 +835,8 @@ class TablePlugin : public Plugin {
    *
    * Set will serialize and save the results as JSON to be retrieved later.
    * It will inspect the query context, if any required/indexed/optimized or
-   * additional columns are used then the cache will not be saved.
+   * additional columns are used then the cache will not be saved. The columns
+   * used by the context are saved alongside the results.
    */
   void setCache(uint64_t step,
                 uint64_t interval,
@@ -848,6 +850,14 @@ class TablePlugin : public Plugin {
   /// The last interval in seconds when the table data was cached.
   uint64_t last_interval_{0};
 
+  /**
+   * @brief The columns generated for the cached results.
+   *
+   * Tables may skip generating columns a query does not use. Cached results
+   * only satisfy queries using a subset of the cached columns.
+   */
+  UsedColumnsBitset last_cached_columns_;
+
  public:
   /**
    * @brief The scheduled interval for the executing query.
@@ -855,11 +865,14 @@ class TablePlugin : public Plugin {
    * Scheduled queries execute within a pseudo-mutex, and each may communicate
    * their scheduled interval to internal TablePlugin implementations. If the
    * table is cachable then the interval can be used to calculate freshness.
+   *
+   * A concurrent schedule executes queries on several threads, so the
+   * interval and step are tracked per executing thread.
    */
-  static uint64_t kCacheInterval;
+  static thread_local uint64_t kCacheInterval;
 
   /// The schedule step, this is the current position of the schedule.
-  static uint64_t kCacheStep;
+  static thread_local uint64_t kCacheStep;
 
  public:
   /**
@@ -877,6 +890,22 @@ class TablePlugin : public Plugin {
    */
   Status call(const PluginRequest& request, PluginResponse& response) override;
 
+  /**
+   * @brief The registry call "router" for callers accepting columns.
+   *
+   * Extension tables respond with columns when the core accepts them. A
+   * generate action fills in the columns, unless a row has values outside of
+   * the declared columns, then the response contains the rows. Every other
+   * action is handled by call.
+   *
+   * @param request The plugin request, must include an action key.
+   * @param response A plugin response, used if the rows are not columns.
+   * @param columns The generated rows as columns.
+   */
+  Status callColumnar(const PluginRequest& request,
+                      PluginResponse& response,
+                      ColumnarRows& columns);
+
  public:
   /// Helper data structure transformation methods.
   static void setRequestFromContext(const QueryContext& context,
@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <ctime>
 #include <deque>
+#include <set>
 
 #include <boost/filesystem/operations.hpp>
 
@@ -25,6 +26,7 @@ namespace osquery {
 
 DECLARE_bool(disable_database);
 DECLARE_bool(logger_numerics);
+DECLARE_bool(differential_hashes);
 
 class QueryTests : public testing::Test {
  public:
@@ -143,6 +145,88 @@ TEST_F(QueryTests, test_add_and_get_current_results) {
   }
 }
 
+TEST_F(QueryTests, test_add_hashed_results) {
+  FLAGS_logger_numerics = true;
+  FLAGS_differential_hashes = true;
+  auto query = getOsqueryScheduledQuery();
+  auto cf = Query("hashed_foobar", query);
+  uint64_t counter = 128;
+  auto status = cf.addNewResults(getTestDBExpectedResults(), 0, counter);
+  EXPECT_TRUE(status.ok());
+  EXPECT_EQ(counter, 0UL);
+
+  uint64_t expected_counter = counter + 1;
+  for (auto result : getTestDBResultStream()) {
+    QueryDataSet previous_qd;
+    status = cf.getPreviousQueryResults(previous_qd);
+    EXPECT_TRUE(status.ok());
+
+    DiffResults dr;
+    counter = 128;
+    auto s = cf.addNewResults(result.second, 0, counter, dr, true);
+    EXPECT_TRUE(s.ok());
+    EXPECT_EQ(counter, expected_counter++);
+
+    // The hashed differential may order removed rows differently.
+    DiffResults expected = diff(previous_qd, result.second);
+    EXPECT_EQ(dr.added, expected.added);
+    EXPECT_EQ(QueryDataSet(dr.removed.begin(), dr.removed.end()),
+              QueryDataSet(expected.removed.begin(), expected.removed.end()));
+
+    QueryDataSet qds_previous;
+    cf.getPreviousQueryResults(qds_previous);
+    EXPECT_EQ(qds_previous,
+              QueryDataSet(result.second.begin(), result.second.end()));
+
+    // Each distinct current row is stored once, removed rows are deleted.
+    std::set<RowTyped> distinct(result.second.begin(), result.second.end());
+    std::vector<std::string> row_keys;
+    scanDatabaseKeys(kQueries, row_keys, "rows.hashed_foobar.");
+    EXPECT_EQ(row_keys.size(), distinct.size());
+  }
+
+  // The stored results and row hashes are removed together.
+  Query::deleteStoredResults("hashed_foobar");
+  std::vector<std::string> keys;
+  scanDatabaseKeys(kQueries, keys);
+  for (const auto& key : keys) {
+    EXPECT_EQ(key.find("hashed_foobar."), std::string::npos) << key;
+  }
+  FLAGS_differential_hashes = false;
+}
+
+TEST_F(QueryTests, test_hashed_results_migration) {
+  FLAGS_logger_numerics = true;
+  auto query = getOsqueryScheduledQuery();
+  auto cf = Query("migrate_foobar", query);
+  auto stream = getTestDBResultStream();
+  ASSERT_GE(stream.size(), 2U);
+
+  // Store JSON results, then switch to hashed results.
+  uint64_t counter = 0;
+  auto status = cf.addNewResults(stream[0].second, 0, counter);
+  ASSERT_TRUE(status.ok());
+
+  FLAGS_differential_hashes = true;
+  QueryDataSet previous_qd(stream[0].second.begin(), stream[0].second.end());
+  DiffResults dr;
+  status = cf.addNewResults(stream[1].second, 0, counter, dr, true);
+  ASSERT_TRUE(status.ok());
+
+  // The first hashed differential is computed against the JSON results.
+  DiffResults expected = diff(previous_qd, stream[1].second);
+  EXPECT_EQ(dr.added, expected.added);
+  EXPECT_EQ(dr.removed, expected.removed);
+
+  // Switching back replaces the hashed results with fresh JSON results.
+  FLAGS_differential_hashes = false;
+  DiffResults fresh;
+  status = cf.addNewResults(stream[1].second, 0, counter, fresh, true);
+  ASSERT_TRUE(status.ok());
+  EXPECT_EQ(fresh.added, stream[1].second);
+  EXPECT_TRUE(fresh.removed.empty());
+}
+
 TEST_F(QueryTests, test_get_query_results) {
   // Grab an expected set of query data and add it as the previous result.
   auto encoded_qd = getSerializedQueryDataJSON();
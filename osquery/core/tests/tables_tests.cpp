@@ -162,6 +162,23 @@ class TestTablePlugin : public TablePlugin {
     ctx.useCache(true);
     return isCached(interval, ctx);
   }
+
+  void testSetCache(uint64_t step,
+                    uint64_t interval,
+                    UsedColumnsBitset columns) {
+    TableRows r;
+    QueryContext ctx;
+    ctx.useCache(true);
+    ctx.colsUsedBitset = columns;
+    setCache(step, interval, ctx, r);
+  }
+
+  bool testIsCached(size_t interval, UsedColumnsBitset columns) {
+    QueryContext ctx;
+    ctx.useCache(true);
+    ctx.colsUsedBitset = columns;
+    return isCached(interval, ctx);
+  }
 };
 
 TEST_F(TablesTests, test_caching) {
@@ -189,4 +206,20 @@ TEST_F(TablesTests, test_caching) {
   EXPECT_TRUE(test.testIsCached(6));
   EXPECT_FALSE(test.testIsCached(7));
 }
+
+TEST_F(TablesTests, test_caching_used_columns) {
+  TestTablePlugin test;
+  TablePlugin::kCacheInterval = 5;
+  TablePlugin::kCacheStep = 1;
+
+  // Results generated for the first two columns only.
+  test.testSetCache(TablePlugin::kCacheStep,
+                    TablePlugin::kCacheInterval,
+                    UsedColumnsBitset(0x3));
+  EXPECT_TRUE(test.testIsCached(5, UsedColumnsBitset(0x1)));
+  EXPECT_TRUE(test.testIsCached(5, UsedColumnsBitset(0x3)));
+  // A query using another column, or all columns, must generate again.
+  EXPECT_FALSE(test.testIsCached(5, UsedColumnsBitset(0x5)));
+  EXPECT_FALSE(test.testIsCached(5));
+}
 }
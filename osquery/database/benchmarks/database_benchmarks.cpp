@@ -177,4 +177,52 @@ static void DATABASE_store_append(benchmark::State& state) {
 }
 
 BENCHMARK(DATABASE_store_append);
+
+static void setScanBenchmarkValues(size_t count) {
+  // The scanned keys are surrounded by keys outside of the prefix.
+  for (size_t i = 0; i < count; ++i) {
+    auto index = std::to_string(1000000 + i);
+    setDatabaseValue(kPersistentSettings, "benchmark.a." + index, "1");
+    setDatabaseValue(kPersistentSettings, "benchmark.scan." + index, "1");
+    setDatabaseValue(kPersistentSettings, "benchmark.z." + index, "1");
+  }
+}
+
+static void deleteScanBenchmarkValues() {
+  // All benchmarks will share a single database handle.
+  deleteDatabaseRange(kPersistentSettings, "benchmark.", "benchmark/");
+}
+
+static void DATABASE_scan_keys_get(benchmark::State& state) {
+  setScanBenchmarkValues(state.range(0));
+  while (state.KeepRunning()) {
+    std::vector<std::string> keys;
+    scanDatabaseKeys(kPersistentSettings, keys, "benchmark.scan.", 0);
+    for (const auto& key : keys) {
+      std::string value;
+      getDatabaseValue(kPersistentSettings, key, value);
+    }
+  }
+  deleteScanBenchmarkValues();
+}
+
+BENCHMARK(DATABASE_scan_keys_get)->Arg(10)->Arg(1000);
+
+static void DATABASE_scan_prefix(benchmark::State& state) {
+  setScanBenchmarkValues(state.range(0));
+  while (state.KeepRunning()) {
+    size_t count = 0;
+    scanDatabasePrefix(
+        kPersistentSettings,
+        "benchmark.scan.",
+        [&count](const std::string& key, const std::string& value) {
+          count += value.size();
+          return true;
+        });
+    benchmark::DoNotOptimize(count);
+  }
+  deleteScanBenchmarkValues();
+}
+
+BENCHMARK(DATABASE_scan_prefix)->Arg(10)->Arg(1000);
 }
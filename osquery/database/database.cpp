@@ -7,6 +7,8 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <algorithm>
+
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/io/detail/quoted_manip.hpp>
 #include <boost/property_tree/json_parser.hpp>
@@ -45,6 +47,7 @@ const std::string kQueries = "queries";
 const std::string kEvents = "events";
 const std::string kCarves = "carves";
 const std::string kLogs = "logs";
+const std::string kFileHashes = "file_hashes";
 
 const std::string kDbEpochSuffix = "epoch";
 const std::string kDbCounterSuffix = "counter";
@@ -52,7 +55,7 @@ const std::string kDbCounterSuffix = "counter";
 const std::string kDbVersionKey = "results_version";
 
 const std::vector<std::string> kDomains = {
-    kPersistentSettings, kQueries, kEvents, kLogs, kCarves};
+    kPersistentSettings, kQueries, kEvents, kLogs, kCarves, kFileHashes};
 
 std::atomic<bool> kDBAllowOpen(false);
 std::atomic<bool> kDBInitialized(false);
@@ -113,6 +116,53 @@ Status DatabasePlugin::scan(const std::string& domain,
   return Status::success();
 }
 
+Status DatabasePlugin::scanRange(const std::string& domain,
+                                 const std::string& low,
+                                 const std::string& high,
+                                 const DatabaseScanCallback& callback) const {
+  std::vector<std::string> keys;
+  auto status = scan(domain, keys, "", 0);
+  if (!status.ok()) {
+    return status;
+  }
+
+  std::sort(keys.begin(), keys.end());
+  for (const auto& key : keys) {
+    if (key < low) {
+      continue;
+    }
+    if (!high.empty() && key >= high) {
+      break;
+    }
+
+    std::string value;
+    if (get(domain, key, value).ok() && !callback(key, value)) {
+      break;
+    }
+  }
+  return Status::success();
+}
+
+Status DatabasePlugin::writeBatch(const std::string& domain,
+                                  const DatabaseStringValueList& data,
+                                  const std::vector<std::string>& removals) {
+  for (const auto& key : removals) {
+    auto status = remove(domain, key);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  if (data.empty()) {
+    return Status::success();
+  }
+  return putBatch(domain, data);
+}
+
+Status DatabasePlugin::stats(PluginResponse& response) const {
+  return Status::success();
+}
+
 Status DatabasePlugin::call(const PluginRequest& request,
                             PluginResponse& response) {
   if (request.count("action") == 0) {
@@ -204,6 +254,8 @@ Status DatabasePlugin::call(const PluginRequest& request,
       response.push_back({{"k", k}});
     }
     return status;
+  } else if (request.at("action") == "stats") {
+    return this->stats(response);
   }
 
   return Status(1, "Unknown database plugin action");
@@ -346,6 +398,33 @@ Status setDatabaseValue(const std::string& domain,
   return setDatabaseBatch(domain, {std::make_pair(key, std::to_string(value))});
 }
 
+Status setDatabaseBatch(const std::string& domain,
+                        const DatabaseStringValueList& data,
+                        const std::vector<std::string>& removals) {
+  if (domain.empty()) {
+    return Status(1, "Missing domain");
+  }
+
+  if (RegistryFactory::get().external()) {
+    // Extensions have no batch removal action, the write is not atomic.
+    for (const auto& key : removals) {
+      auto status = deleteDatabaseValue(domain, key);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    return data.empty() ? Status::success() : setDatabaseBatch(domain, data);
+  }
+
+  ReadLock lock(kDatabaseReset);
+  if (!kDBInitialized) {
+    throw std::runtime_error("Cannot set database values");
+  }
+
+  auto plugin = getDatabasePlugin();
+  return plugin->writeBatch(domain, data, removals);
+}
+
 Status deleteDatabaseValue(const std::string& domain, const std::string& key) {
   if (domain.empty()) {
     return Status(1, "Missing domain");
@@ -437,6 +516,61 @@ Status scanDatabaseKeys(const std::string& domain,
   }
 }
 
+Status getDatabaseStats(PluginResponse& stats) {
+  PluginRequest request = {{"action", "stats"}};
+  return Registry::call("database", request, stats);
+}
+
+Status scanDatabaseRange(const std::string& domain,
+                         const std::string& low,
+                         const std::string& high,
+                         const DatabaseScanCallback& callback) {
+  if (domain.empty()) {
+    return Status(1, "Missing domain");
+  }
+
+  if (RegistryFactory::get().external()) {
+    // External registries (extensions) do not have databases active.
+    // Scan the keys sharing the range's prefix, then get each value.
+    auto common =
+        std::mismatch(low.begin(), low.end(), high.begin(), high.end());
+    auto prefix = std::string(low.begin(), common.first);
+    std::vector<std::string> keys;
+    auto status = scanDatabaseKeys(domain, keys, prefix, 0);
+    if (!status.ok()) {
+      return status;
+    }
+
+    std::sort(keys.begin(), keys.end());
+    for (const auto& key : keys) {
+      if (key < low || (!high.empty() && key >= high)) {
+        continue;
+      }
+
+      std::string value;
+      if (getDatabaseValue(domain, key, value).ok() && !callback(key, value)) {
+        break;
+      }
+    }
+    return Status::success();
+  }
+
+  ReadLock lock(kDatabaseReset);
+  if (!kDBInitialized) {
+    throw std::runtime_error("Cannot scan database values: " + low);
+  } else {
+    auto plugin = getDatabasePlugin();
+    return plugin->scanRange(domain, low, high, callback);
+  }
+}
+
+Status scanDatabasePrefix(const std::string& domain,
+                          const std::string& prefix,
+                          const DatabaseScanCallback& callback) {
+  return scanDatabaseRange(
+      domain, prefix, getDatabasePrefixEnd(prefix), callback);
+}
+
 void resetDatabase() {
   PluginRequest request = {{"action", "reset"}};
   Registry::call("database", request);
@@ -711,6 +845,13 @@ class OsqueryDatabase final : public IDatabaseInterface {
     return osquery::setDatabaseBatch(domain, data);
   }
 
+  virtual Status setDatabaseBatch(
+      const std::string& domain,
+      const DatabaseStringValueList& data,
+      const std::vector<std::string>& removals) const override {
+    return osquery::setDatabaseBatch(domain, data, removals);
+  }
+
   virtual Status deleteDatabaseValue(const std::string& domain,
                                      const std::string& key) const override {
     return osquery::deleteDatabaseValue(domain, key);
@@ -734,6 +875,14 @@ class OsqueryDatabase final : public IDatabaseInterface {
                                   size_t max) const override {
     return osquery::scanDatabaseKeys(domain, keys, prefix, max);
   }
+
+  virtual Status scanDatabaseRange(
+      const std::string& domain,
+      const std::string& low,
+      const std::string& high,
+      const DatabaseScanCallback& callback) const override {
+    return osquery::scanDatabaseRange(domain, low, high, callback);
+  }
 };
 
 IDatabaseInterface& getOsqueryDatabase() {
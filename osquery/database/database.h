@@ -49,6 +49,9 @@ extern const std::string kEvents;
 /// The "domain" where the results of carve queries are stored.
 extern const std::string kCarves;
 
+/// The "domain" where file hashes are cached, keyed by path.
+extern const std::string kFileHashes;
+
 /// The key for the DB version
 extern const std::string kDbVersionKey;
 
@@ -126,6 +129,17 @@ class DatabasePlugin : public Plugin {
   virtual Status putBatch(const std::string& domain,
                           const DatabaseStringValueList& data) = 0;
 
+  /**
+   * @brief Remove keys and store values of a domain in a single write.
+   *
+   * The removals are applied before the values. Plugins should apply the
+   * write atomically, the default implementation removes each key and then
+   * stores the values.
+   */
+  virtual Status writeBatch(const std::string& domain,
+                            const DatabaseStringValueList& data,
+                            const std::vector<std::string>& removals);
+
   /// Data removal method.
   virtual Status remove(const std::string& domain, const std::string& k) = 0;
 
@@ -139,6 +153,26 @@ class DatabasePlugin : public Plugin {
                       const std::string& prefix,
                       uint64_t max) const;
 
+  /**
+   * @brief Scan the keys in [low, high) and their values, in key order.
+   *
+   * An empty high scans to the end of the domain. Plugins should seek to low
+   * and stop at high, the default implementation scans the domain's keys and
+   * gets each value in the range.
+   */
+  virtual Status scanRange(const std::string& domain,
+                           const std::string& low,
+                           const std::string& high,
+                           const DatabaseScanCallback& callback) const;
+
+  /**
+   * @brief Get statistics about the backing storage.
+   *
+   * Each row has a domain (empty for the whole database), a statistic name,
+   * and a value. Plugins without statistics return no rows.
+   */
+  virtual Status stats(PluginResponse& response) const;
+
   /**
    * @brief Shutdown the database and release initialization resources.
    *
@@ -220,6 +254,11 @@ Status setDatabaseValue(const std::string& domain,
 Status setDatabaseBatch(const std::string& domain,
                         const DatabaseStringValueList& data);
 
+/// Remove keys and store values in a single write, see writeBatch.
+Status setDatabaseBatch(const std::string& domain,
+                        const DatabaseStringValueList& data,
+                        const std::vector<std::string>& removals);
+
 /// Remove a domain/key identified value from backing-store.
 Status deleteDatabaseValue(const std::string& domain, const std::string& key);
 
@@ -239,6 +278,20 @@ Status scanDatabaseKeys(const std::string& domain,
                         const std::string& prefix,
                         uint64_t max = 0);
 
+/// Get statistics about the active database plugin's backing storage.
+Status getDatabaseStats(PluginResponse& stats);
+
+/// Scan the keys in [low, high) of a domain and their values, in key order.
+Status scanDatabaseRange(const std::string& domain,
+                         const std::string& low,
+                         const std::string& high,
+                         const DatabaseScanCallback& callback);
+
+/// Scan the keys starting with prefix and their values, in key order.
+Status scanDatabasePrefix(const std::string& domain,
+                          const std::string& prefix,
+                          const DatabaseScanCallback& callback);
+
 /// Allow callers to reload or reset the database plugin.
 void resetDatabase();
 
@@ -65,6 +65,12 @@ class EphemeralDatabasePlugin : public DatabasePlugin {
               const std::string& prefix,
               uint64_t max) const override;
 
+  /// Key and value range lookup method.
+  Status scanRange(const std::string& domain,
+                   const std::string& low,
+                   const std::string& high,
+                   const DatabaseScanCallback& callback) const override;
+
  public:
   /// Database workflow: open and setup.
   Status setUp() override {
@@ -199,4 +205,32 @@ Status EphemeralDatabasePlugin::scan(const std::string& domain,
   }
   return Status(0);
 }
+
+Status EphemeralDatabasePlugin::scanRange(
+    const std::string& domain,
+    const std::string& low,
+    const std::string& high,
+    const DatabaseScanCallback& callback) const {
+  auto domain_it = db_.find(domain);
+  if (domain_it == db_.end()) {
+    return Status(0);
+  }
+
+  const auto& keys = domain_it->second;
+  for (auto it = keys.lower_bound(low); it != keys.end(); ++it) {
+    if (!high.empty() && it->first >= high) {
+      break;
+    }
+
+    const auto* value = boost::get<std::string>(&it->second);
+    auto stop = (value != nullptr)
+                    ? !callback(it->first, *value)
+                    : !callback(it->first,
+                                std::to_string(boost::get<int>(it->second)));
+    if (stop) {
+      break;
+    }
+  }
+  return Status(0);
+}
 } // namespace osquery
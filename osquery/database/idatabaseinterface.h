@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -20,6 +21,28 @@ namespace osquery {
 using DatabaseStringValueList =
     std::vector<std::pair<std::string, std::string>>;
 
+/// Receives each key and value of a database scan, return false to stop.
+using DatabaseScanCallback =
+    std::function<bool(const std::string& key, const std::string& value)>;
+
+/**
+ * @brief Get the first key after every key starting with prefix.
+ *
+ * Keys are ordered bytewise, this is the exclusive upper bound of a prefix
+ * scan. An empty result means the keys are not bounded.
+ */
+inline std::string getDatabasePrefixEnd(std::string prefix) {
+  while (!prefix.empty()) {
+    auto& last = reinterpret_cast<unsigned char&>(prefix.back());
+    if (last != 0xff) {
+      last++;
+      return prefix;
+    }
+    prefix.pop_back();
+  }
+  return prefix;
+}
+
 class IDatabaseInterface {
  public:
   IDatabaseInterface() = default;
@@ -44,6 +67,12 @@ class IDatabaseInterface {
   virtual Status setDatabaseBatch(
       const std::string& domain, const DatabaseStringValueList& data) const = 0;
 
+  /// Remove keys and store values in a single write.
+  virtual Status setDatabaseBatch(
+      const std::string& domain,
+      const DatabaseStringValueList& data,
+      const std::vector<std::string>& removals) const = 0;
+
   virtual Status deleteDatabaseValue(const std::string& domain,
                                      const std::string& key) const = 0;
 
@@ -60,6 +89,26 @@ class IDatabaseInterface {
                                   const std::string& prefix,
                                   size_t max) const = 0;
 
+  /**
+   * @brief Scan the keys in [low, high) and their values, in key order.
+   *
+   * The scan seeks to low and stops at high, an empty high scans to the end
+   * of the domain.
+   */
+  virtual Status scanDatabaseRange(
+      const std::string& domain,
+      const std::string& low,
+      const std::string& high,
+      const DatabaseScanCallback& callback) const = 0;
+
+  /// Scan the keys starting with prefix and their values, in key order.
+  Status scanDatabasePrefix(const std::string& domain,
+                            const std::string& prefix,
+                            const DatabaseScanCallback& callback) const {
+    return scanDatabaseRange(
+        domain, prefix, getDatabasePrefixEnd(prefix), callback);
+  }
+
   IDatabaseInterface(const IDatabaseInterface&) = delete;
   IDatabaseInterface& operator=(const IDatabaseInterface&) = delete;
 };
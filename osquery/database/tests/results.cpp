@@ -9,6 +9,7 @@
 
 #include <osquery/database/database.h>
 
+#include <osquery/core/flags.h>
 #include <osquery/core/query.h>
 #include <osquery/core/sql/diff_results.h>
 #include <osquery/core/sql/query_data.h>
@@ -17,9 +18,13 @@
 #include <gtest/gtest.h>
 
 #include <string>
+#include <vector>
 
 namespace osquery {
 
+DECLARE_bool(decorations_top_level);
+DECLARE_bool(logger_numerics);
+
 class ResultsTests : public testing::Test {};
 
 TEST_F(ResultsTests, test_simple_diff) {
@@ -126,6 +131,66 @@ TEST_F(ResultsTests, test_serialize_query_log_item_json) {
   EXPECT_EQ(results.first, json);
 }
 
+TEST_F(ResultsTests, test_serialize_query_log_item_as_event_chunks) {
+  auto item = getSerializedQueryLogItem().second;
+  item.results.added.push_back({{"id", 1LL}, {"size", 2.5}, {"path", "/"}});
+  item.decorations["host_uuid"] = "uuid";
+
+  auto expect_same_events = [&item](size_t chunk_size) {
+    std::vector<std::string> expected;
+    ASSERT_TRUE(serializeQueryLogItemAsEventsJSON(item, expected).ok());
+
+    std::vector<std::string> events;
+    auto s = serializeQueryLogItemAsEventChunks(
+        item, chunk_size, [&events, chunk_size](std::vector<std::string>& c) {
+          EXPECT_FALSE(c.empty());
+          EXPECT_LE(c.size(), chunk_size);
+          events.insert(events.end(), c.begin(), c.end());
+          return Status::success();
+        });
+    EXPECT_TRUE(s.ok());
+    EXPECT_EQ(expected, events);
+  };
+
+  for (bool numerics : {false, true}) {
+    for (bool top_level : {false, true}) {
+      FLAGS_logger_numerics = numerics;
+      FLAGS_decorations_top_level = top_level;
+      expect_same_events(1);
+      expect_same_events(2);
+      expect_same_events(1024);
+    }
+  }
+
+  // Decorations replaced by event members keep the document member order.
+  item.decorations["action"] = "decorated";
+  expect_same_events(2);
+
+  // The snapshot results are serialized when there is no differential.
+  item.results = DiffResults();
+  item.snapshot_results.push_back({{"id", 2LL}});
+  expect_same_events(1);
+
+  FLAGS_logger_numerics = false;
+  FLAGS_decorations_top_level = false;
+
+  // Serialization stops at the first failed chunk.
+  size_t chunks = 0;
+  item.snapshot_results.push_back({{"id", 3LL}});
+  auto s = serializeQueryLogItemAsEventChunks(
+      item, 1, [&chunks](std::vector<std::string>&) {
+        chunks++;
+        return Status::failure("failed");
+      });
+  EXPECT_FALSE(s.ok());
+  EXPECT_EQ(chunks, 1U);
+
+  item.snapshot_results.clear();
+  s = serializeQueryLogItemAsEventChunks(
+      item, 1, [](std::vector<std::string>&) { return Status::success(); });
+  EXPECT_FALSE(s.ok());
+}
+
 TEST_F(ResultsTests, test_adding_duplicate_rows_to_query_data) {
   RowTyped r1, r2, r3;
   r1["foo"] = "bar";
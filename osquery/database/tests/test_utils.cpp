@@ -200,6 +200,26 @@ void DatabasePluginTests::testDelete() {
   EXPECT_TRUE(r.empty());
 }
 
+void DatabasePluginTests::testWriteBatch() {
+  getPlugin()->put(kQueries, "test_write_old", "old");
+  getPlugin()->put(kQueries, "test_write_replaced", "old");
+
+  // Removals are applied before the values.
+  auto s = getPlugin()->writeBatch(
+      kQueries,
+      {{"test_write_new", "new"}, {"test_write_replaced", "new"}},
+      {"test_write_old", "test_write_replaced"});
+  EXPECT_TRUE(s.ok());
+
+  std::string r;
+  s = getPlugin()->get(kQueries, "test_write_old", r);
+  EXPECT_FALSE(s.ok());
+  getPlugin()->get(kQueries, "test_write_new", r);
+  EXPECT_EQ(r, "new");
+  getPlugin()->get(kQueries, "test_write_replaced", r);
+  EXPECT_EQ(r, "new");
+}
+
 void DatabasePluginTests::testDeleteRange() {
   getPlugin()->put(kQueries, "test_delete", "baz");
   getPlugin()->put(kQueries, "test1", "1");
@@ -269,4 +289,61 @@ void DatabasePluginTests::testScanLimit() {
   EXPECT_EQ(s.getMessage(), "OK");
   EXPECT_EQ(keys.size(), 2U);
 }
+
+void DatabasePluginTests::testScanRange() {
+  getPlugin()->put(kQueries, "test_range_a", "0");
+  getPlugin()->put(kQueries, "test_range_foo1", "1");
+  getPlugin()->put(kQueries, "test_range_foo2", "2");
+  getPlugin()->put(kQueries, "test_range_foo3", "3");
+  getPlugin()->put(kQueries, "test_range_z", "4");
+
+  std::vector<std::pair<std::string, std::string>> items;
+  auto collect = [&items](const std::string& key, const std::string& value) {
+    items.emplace_back(key, value);
+    return true;
+  };
+
+  // The keys and values within the prefix are returned in key order.
+  auto prefix = std::string("test_range_foo");
+  auto s = getPlugin()->scanRange(
+      kQueries, prefix, getDatabasePrefixEnd(prefix), collect);
+  EXPECT_TRUE(s.ok());
+  std::vector<std::pair<std::string, std::string>> expected = {
+      {"test_range_foo1", "1"},
+      {"test_range_foo2", "2"},
+      {"test_range_foo3", "3"}};
+  EXPECT_EQ(items, expected);
+
+  // The upper bound is exclusive.
+  items.clear();
+  s = getPlugin()->scanRange(
+      kQueries, "test_range_foo2", "test_range_foo3", collect);
+  EXPECT_TRUE(s.ok());
+  ASSERT_EQ(items.size(), 1U);
+  EXPECT_EQ(items[0].first, "test_range_foo2");
+
+  // An empty upper bound scans to the end of the domain.
+  items.clear();
+  s = getPlugin()->scanRange(kQueries, "test_range_foo3", "", collect);
+  EXPECT_TRUE(s.ok());
+  ASSERT_EQ(items.size(), 2U);
+  EXPECT_EQ(items[1].first, "test_range_z");
+
+  // The callback may stop the scan.
+  items.clear();
+  s = getPlugin()->scanRange(
+      kQueries,
+      "test_range_",
+      "",
+      [&items](const std::string& key, const std::string& value) {
+        items.emplace_back(key, value);
+        return false;
+      });
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(items.size(), 1U);
+
+  EXPECT_EQ(getDatabasePrefixEnd("ab"), "ac");
+  EXPECT_EQ(getDatabasePrefixEnd("a\xff"), "b");
+  EXPECT_TRUE(getDatabasePrefixEnd("\xff\xff").empty());
+}
 } // namespace osquery
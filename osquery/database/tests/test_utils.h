@@ -33,6 +33,9 @@
   TEST_F(n, test_delete) {                                                     \
     testDelete();                                                              \
   }                                                                            \
+  TEST_F(n, test_write_batch) {                                                \
+    testWriteBatch();                                                          \
+  }                                                                            \
   TEST_F(n, test_delete_range) {                                               \
     testDeleteRange();                                                         \
   }                                                                            \
@@ -41,6 +44,9 @@
   }                                                                            \
   TEST_F(n, test_scan_limit) {                                                 \
     testScanLimit();                                                           \
+  }                                                                            \
+  TEST_F(n, test_scan_range) {                                                 \
+    testScanRange();                                                           \
   }
 
 namespace osquery {
@@ -92,8 +98,10 @@ class DatabasePluginTests : public testing::Test {
   void testPutBatch();
   void testGet();
   void testDelete();
+  void testWriteBatch();
   void testDeleteRange();
   void testScan();
   void testScanLimit();
+  void testScanRange();
 };
 } // namespace osquery
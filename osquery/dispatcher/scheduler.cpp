@@ -8,7 +8,11 @@
  */
 
 #include <algorithm>
+#include <chrono>
 #include <ctime>
+#include <future>
+#include <utility>
+#include <vector>
 
 #include <boost/format.hpp>
 #include <boost/io/detail/quoted_manip.hpp>
@@ -24,11 +28,13 @@
 #include <osquery/numeric_monitoring/numeric_monitoring.h>
 #include <osquery/process/process.h>
 #include <osquery/profiler/code_profiler.h>
+#include <osquery/profiler/resource_usage.h>
 
 #include <osquery/utils/system/time.h>
 
 #include "osquery/dispatcher/scheduler.h"
 #include "osquery/sql/sqlite_util.h"
+#include "osquery/sql/virtual_table.h"
 #include "plugins/config/parsers/decorators.h"
 
 namespace osquery {
@@ -52,6 +58,12 @@ FLAG(bool,
      false,
      "Log the running scheduled query name at INFO level");
 
+FLAG(uint64,
+     schedule_concurrency,
+     1,
+     "Number of due scheduled queries to execute concurrently (0 for one per "
+     "CPU)");
+
 HIDDEN_FLAG(bool,
             schedule_reload_sql,
             false,
@@ -62,7 +74,55 @@ DECLARE_bool(events_optimize);
 DECLARE_bool(enable_numeric_monitoring);
 DECLARE_bool(verbose);
 
+namespace {
+
+/// The result of a scheduled query execution, logged in schedule order.
+struct ScheduledQueryExecution {
+  /// The unique (pack-prefixed) name of the scheduled query.
+  std::string name;
+
+  /// The execution status, a failure is not logged.
+  Status status;
+
+  /// The prepared log item.
+  QueryLogItem item;
+
+  /// True if the item should be logged as a snapshot.
+  bool snapshot{false};
+
+  /// True if the item contains results to log.
+  bool emit{false};
+};
+
+/// Compare resource samples taken around a query's execution.
+QueryExecutionStats getExecutionStats(const ResourceUsage& r0,
+                                      const ResourceUsage& r1,
+                                      const SQLInternal& sql) {
+  QueryExecutionStats stats;
+  stats.wall_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           r1.time - r0.time)
+                           .count();
+  if (r1.user_time > r0.user_time) {
+    stats.user_time = r1.user_time - r0.user_time;
+  }
+  if (r1.system_time > r0.system_time) {
+    stats.system_time = r1.system_time - r0.system_time;
+  }
+  stats.memory = static_cast<int64_t>(r1.resident_size) -
+                 static_cast<int64_t>(r0.resident_size);
+  stats.tables = sql.tableStats();
+  return stats;
+}
+
+} // namespace
+
 SQLInternal monitor(const std::string& name, const ScheduledQuery& query) {
+  return monitor(name, query, SQLiteDBManager::get());
+}
+
+SQLInternal monitor(const std::string& name,
+                    const ScheduledQuery& query,
+                    const SQLiteDBInstanceRef& instance) {
   if (FLAGS_enable_numeric_monitoring) {
     CodeProfiler profiler(
         {(boost::format("scheduler.pack.%s") % query.pack_name).str(),
@@ -77,34 +137,32 @@ SQLInternal monitor(const std::string& name, const ScheduledQuery& query) {
           monitoring::hostIdentifierKeys().scheme % query.pack_name %
           query.name)
              .str()});
-    return SQLInternal(query.query, true);
+    return SQLInternal(query.query, instance, true);
   } else {
     // Snapshot the performance and times for the worker before running.
-    auto pid = std::to_string(PlatformProcess::getCurrentPid());
-    auto r0 = SQL::selectFrom({"resident_size", "user_time", "system_time"},
-                              "processes",
-                              "pid",
-                              EQUALS,
-                              pid);
-    auto t0 = getUnixTime();
+    auto r0 = getResourceUsage();
     Config::get().recordQueryStart(name);
-    SQLInternal sql(query.query, true);
+    SQLInternal sql(query.query, instance, true);
     // Snapshot the performance after, and compare.
-    auto t1 = getUnixTime();
-    auto r1 = SQL::selectFrom({"resident_size", "user_time", "system_time"},
-                              "processes",
-                              "pid",
-                              EQUALS,
-                              pid);
-    if (r0.size() > 0 && r1.size() > 0) {
-      // Always called while processes table is working.
-      Config::get().recordQueryPerformance(name, t1 - t0, r0[0], r1[0]);
-    }
+    auto r1 = getResourceUsage();
+    Config::get().recordQueryPerformance(name, getExecutionStats(r0, r1, sql));
     return sql;
   }
 }
 
-Status launchQuery(const std::string& name, const ScheduledQuery& query) {
+/**
+ * @brief Execute a scheduled query and prepare its log item.
+ *
+ * This executes the query and applies the differential against the stored
+ * results but does not emit the log item, see emitQueryLogItem.
+ */
+static ScheduledQueryExecution executeQuery(
+    const std::string& name,
+    const ScheduledQuery& query,
+    const SQLiteDBInstanceRef& instance) {
+  ScheduledQueryExecution execution;
+  execution.name = name;
+
   // Execute the scheduled query and create a named query object.
   if (FLAGS_verbose) {
     VLOG(1) << "Executing scheduled query " << name << ": " << query.query;
@@ -113,11 +171,12 @@ Status launchQuery(const std::string& name, const ScheduledQuery& query) {
   }
   runDecorators(DECORATE_ALWAYS);
 
-  auto sql = monitor(name, query);
+  auto sql = monitor(name, query, instance);
   if (!sql.getStatus().ok()) {
     LOG(ERROR) << "Error executing scheduled query " << name << ": "
                << sql.getStatus().toString();
-    return Status::failure("Error executing scheduled query");
+    execution.status = Status::failure("Error executing scheduled query");
+    return execution;
   }
 
   // Fill in a host identifier fields based on configuration or availability.
@@ -125,7 +184,7 @@ Status launchQuery(const std::string& name, const ScheduledQuery& query) {
 
   // A query log item contains an optional set of differential results or
   // a copy of the most-recent execution alongside some query metadata.
-  QueryLogItem item;
+  QueryLogItem& item = execution.item;
   item.name = name;
   item.identifier = ident;
   item.time = osquery::getUnixTime();
@@ -136,8 +195,9 @@ Status launchQuery(const std::string& name, const ScheduledQuery& query) {
   if (query.isSnapshotQuery()) {
     // This is a snapshot query, emit results with a differential or state.
     item.snapshot_results = std::move(sql.rowsTyped());
-    logSnapshotQuery(item);
-    return Status::success();
+    execution.snapshot = true;
+    execution.emit = true;
+    return execution;
   }
 
   // Create a database-backed set of query results.
@@ -168,23 +228,51 @@ Status launchQuery(const std::string& name, const ScheduledQuery& query) {
     diff_results.removed.clear();
   }
 
-  if (diff_results.hasNoResults()) {
-    // No diff results or events to emit.
-    return status;
+  execution.status = status;
+  // No diff results or events to emit.
+  execution.emit = !diff_results.hasNoResults();
+  return execution;
+}
+
+/// Emit the log item prepared by executeQuery.
+static Status emitQueryLogItem(ScheduledQueryExecution& execution) {
+  if (!execution.status.ok() || !execution.emit) {
+    return execution.status;
   }
 
-  VLOG(1) << "Found results for query: " << name;
+  if (execution.snapshot) {
+    logSnapshotQuery(execution.item);
+    return Status::success();
+  }
+
+  VLOG(1) << "Found results for query: " << execution.name;
 
-  status = logQueryLogItem(item);
+  auto status = logQueryLogItem(execution.item);
   if (!status.ok()) {
     // If log directory is not available, then the daemon shouldn't continue.
-    std::string message = "Error logging the results of query: " + name + ": " +
-                          status.toString();
+    std::string message = "Error logging the results of query: " +
+                          execution.name + ": " + status.toString();
     requestShutdown(EXIT_CATASTROPHIC, message);
   }
   return status;
 }
 
+static void recordQueryStatus(const ScheduledQuery& query,
+                              const Status& status) {
+  monitoring::record((boost::format("scheduler.query.%s.%s.status.%s") %
+                      query.pack_name % query.name %
+                      (status.ok() ? "success" : "failure"))
+                         .str(),
+                     1,
+                     monitoring::PreAggregationType::Sum,
+                     true);
+}
+
+Status launchQuery(const std::string& name, const ScheduledQuery& query) {
+  auto execution = executeQuery(name, query, SQLiteDBManager::get());
+  return emitQueryLogItem(execution);
+}
+
 void SchedulerRunner::calculateTimeDriftAndMaybePause(
     std::chrono::milliseconds loop_step_duration) {
   if (loop_step_duration + time_drift_ < interval_) {
@@ -216,6 +304,11 @@ void SchedulerRunner::maybeReloadSchedule(uint64_t time_step) {
   if (FLAGS_schedule_reload > 0 && (time_step % FLAGS_schedule_reload) == 0) {
     if (FLAGS_schedule_reload_sql) {
       SQLiteDBManager::resetPrimary();
+      if (pool_ != nullptr) {
+        // Re-create the workers and their transient SQLite connections.
+        auto size = pool_->size();
+        pool_ = std::make_unique<ThreadPool>(size, "scheduler");
+      }
     }
     resetDatabase();
   }
@@ -228,29 +321,93 @@ void SchedulerRunner::maybeFlushLogs(uint64_t time_step) {
   }
 }
 
+std::vector<const ScheduleSnapshot::Query*> SchedulerRunner::getDueQueries(
+    uint64_t time_step) {
+  auto schedule = Config::get().getScheduleSnapshot();
+  if (schedule != schedule_ || due_queries_ == nullptr) {
+    // Queries run on the steps that are a multiple of their interval.
+    schedule_ = std::move(schedule);
+    due_queries_ = std::make_unique<TimingWheel>(time_step);
+    for (size_t i = 0; i < schedule_->queries.size(); ++i) {
+      auto interval = schedule_->queries[i].query.splayed_interval;
+      if (interval > 0) {
+        due_queries_->insert(
+            i, (time_step + interval - 1) / interval * interval);
+      }
+    }
+  }
+
+  // Due queries are executed in schedule order.
+  auto due_ids = due_queries_->advance(time_step);
+  std::sort(due_ids.begin(), due_ids.end());
+
+  std::vector<const ScheduleSnapshot::Query*> due;
+  due.reserve(due_ids.size());
+  for (auto id : due_ids) {
+    const auto& query = schedule_->queries[id];
+    due_queries_->insert(id, time_step + query.query.splayed_interval);
+    due.push_back(&query);
+  }
+  return due;
+}
+
+void SchedulerRunner::runSerial(
+    const std::vector<const ScheduleSnapshot::Query*>& due,
+    uint64_t time_step) {
+  for (const auto* query : due) {
+    TablePlugin::kCacheInterval = query->query.splayed_interval;
+    TablePlugin::kCacheStep = time_step;
+    const auto status = launchQuery(query->name, query->query);
+    recordQueryStatus(query->query, status);
+  }
+}
+
+void SchedulerRunner::runConcurrent(
+    const std::vector<const ScheduleSnapshot::Query*>& due,
+    uint64_t time_step) {
+  // Tables are guarded until every worker has finished its query.
+  TableGenerateGuardScope guards;
+  std::vector<std::future<ScheduledQueryExecution>> executions;
+  executions.reserve(due.size());
+  for (const auto* query : due) {
+    executions.push_back(pool_->submit([query, time_step]() {
+      TablePlugin::kCacheInterval = query->query.splayed_interval;
+      TablePlugin::kCacheStep = time_step;
+      return executeQuery(query->name,
+                          query->query,
+                          SQLiteDBManager::getWorkerConnection());
+    }));
+  }
+
+  // Log items are emitted in schedule order, regardless of completion order.
+  for (size_t i = 0; i < executions.size(); ++i) {
+    auto execution = executions[i].get();
+    const auto status = emitQueryLogItem(execution);
+    recordQueryStatus(due[i]->query, status);
+  }
+}
+
 void SchedulerRunner::start() {
   // Start the counter at the second.
   auto i = osquery::getUnixTime();
   // Timeout is the number of seconds from starting.
   auto end = (timeout_ == 0) ? 0 : timeout_ + i;
 
+  auto concurrency = resolveThreadCount(FLAGS_schedule_concurrency);
+  if (concurrency > 1) {
+    VLOG(1) << "Executing scheduled queries using " << concurrency
+            << " workers";
+    pool_ = std::make_unique<ThreadPool>(concurrency, "scheduler");
+  }
+
   for (; (end == 0) || (i <= end); ++i) {
     auto start_time_point = std::chrono::steady_clock::now();
-    Config::get().scheduledQueries(([&i](const std::string& name,
-                                         const ScheduledQuery& query) {
-      if (query.splayed_interval > 0 && i % query.splayed_interval == 0) {
-        TablePlugin::kCacheInterval = query.splayed_interval;
-        TablePlugin::kCacheStep = i;
-        const auto status = launchQuery(name, query);
-        monitoring::record((boost::format("scheduler.query.%s.%s.status.%s") %
-                            query.pack_name % query.name %
-                            (status.ok() ? "success" : "failure"))
-                               .str(),
-                           1,
-                           monitoring::PreAggregationType::Sum,
-                           true);
-      }
-    }));
+    auto due = getDueQueries(i);
+    if (pool_ != nullptr) {
+      runConcurrent(due, i);
+    } else {
+      runSerial(due, i);
+    }
 
     maybeRunDecorators(i);
     maybeReloadSchedule(i);
@@ -266,6 +423,11 @@ void SchedulerRunner::start() {
     }
   }
 
+  // Workers own transient SQLite connections, release them with the pool.
+  pool_.reset();
+  due_queries_.reset();
+  schedule_.reset();
+
   // Scheduler ended.
   if (!interrupted() && request_shutdown_on_expiration) {
     LOG(INFO) << "The scheduler ended after " << timeout_ << " seconds";
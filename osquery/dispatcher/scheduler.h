@@ -11,8 +11,13 @@
 
 #include <chrono>
 #include <map>
+#include <memory>
+#include <vector>
 
+#include <osquery/config/config.h>
 #include <osquery/dispatcher/dispatcher.h>
+#include <osquery/dispatcher/timing_wheel.h>
+#include <osquery/utils/thread_pool.h>
 
 #include "osquery/sql/sqlite_util.h"
 
@@ -57,6 +62,18 @@ class SchedulerRunner : public InternalRunnable {
   /// Check if carve requests should be scheduled.
   void maybeScheduleCarves(uint64_t time_step);
 
+  /// Refresh the schedule snapshot and collect the queries due at this step.
+  std::vector<const ScheduleSnapshot::Query*> getDueQueries(
+      uint64_t time_step);
+
+  /// Execute the due queries, one after another.
+  void runSerial(const std::vector<const ScheduleSnapshot::Query*>& due,
+                 uint64_t time_step);
+
+  /// Execute the due queries using the worker pool.
+  void runConcurrent(const std::vector<const ScheduleSnapshot::Query*>& due,
+                     uint64_t time_step);
+
  private:
   /// Interval in seconds between schedule steps.
   const std::chrono::milliseconds interval_;
@@ -71,6 +88,15 @@ class SchedulerRunner : public InternalRunnable {
 
   const std::chrono::milliseconds max_time_drift_;
 
+  /// Workers used when the schedule executes queries concurrently.
+  std::unique_ptr<ThreadPool> pool_{nullptr};
+
+  /// The schedule being executed, replaced when the config changes.
+  ScheduleSnapshotRef schedule_{nullptr};
+
+  /// The next run step of each query in the schedule, by query index.
+  std::unique_ptr<TimingWheel> due_queries_{nullptr};
+
   /// Tests should not always trigger a shutdown when the scheduler expires,
   /// so let tests decide when this should happen.
   FRIEND_TEST(TLSConfigTests, test_runner_and_scheduler);
@@ -79,6 +105,11 @@ class SchedulerRunner : public InternalRunnable {
 
 SQLInternal monitor(const std::string& name, const ScheduledQuery& query);
 
+/// See monitor, but execute the query using a specific SQLite connection.
+SQLInternal monitor(const std::string& name,
+                    const ScheduledQuery& query,
+                    const SQLiteDBInstanceRef& instance);
+
 /// Start querying according to the config's schedule
 void startScheduler();
 
@@ -17,12 +17,14 @@
 #include <osquery/config/config.h>
 #include <osquery/dispatcher/scheduler.h>
 #include <osquery/sql/sqlite_util.h>
+#include <osquery/sql/virtual_table.h>
 #include <osquery/utils/system/time.h>
 
 namespace osquery {
 
 DECLARE_bool(disable_logging);
 DECLARE_uint64(schedule_reload);
+DECLARE_uint64(schedule_concurrency);
 
 class SchedulerTests : public testing::Test {
   void SetUp() override {
@@ -69,6 +71,11 @@ TEST_F(SchedulerTests, test_monitor) {
   // performance stats are tracked independently.
   EXPECT_EQ(perf.executions, 1U);
 
+  // The virtual tables used by the query are tracked alongside.
+  ASSERT_EQ(perf.tables.count("time"), 1U);
+  EXPECT_EQ(perf.tables.at("time").generations, 1U);
+  EXPECT_EQ(perf.tables.at("time").rows, 1U);
+
   // A bit more testing, potentially redundant, check the database results.
   // Since we are only monitoring, no 'actual' results are stored.
   std::string content;
@@ -178,6 +185,47 @@ TEST_F(SchedulerTests, test_scheduler) {
   TablePlugin::kCacheInterval = backup_interval;
 }
 
+TEST_F(SchedulerTests, test_scheduler_concurrent) {
+  auto backup_concurrency = FLAGS_schedule_concurrency;
+  FLAGS_schedule_concurrency = 4;
+
+  std::string config = R"config(
+  {
+    "packs": {
+      "concurrent": {
+        "queries": {
+          "1": {"query": "select * from osquery_info", "interval": 1},
+          "2": {"query": "select * from processes", "interval": 1},
+          "3": {"query": "select 3 as number", "interval": 1},
+          "4": {"query": "select * from time", "interval": 1},
+          "5": {"query": "select 5 as number", "interval": 1}
+        }
+      }
+    }
+  })config";
+  Config::get().update({{"data", config}});
+
+  SchedulerRunner runner(static_cast<unsigned long int>(1), 1);
+  runner.start();
+
+  // Every due query was started by a worker.
+  for (const auto& query : {"1", "2", "3", "4", "5"}) {
+    std::string timestamp;
+    getDatabaseValue(kPersistentSettings,
+                     std::string("timestamp.pack_concurrent_") + query,
+                     timestamp);
+    EXPECT_FALSE(timestamp.empty());
+  }
+
+  // Every worker cleared the executing mark of its query.
+  std::vector<std::string> executing;
+  scanDatabaseKeys(kPersistentSettings, executing, kExecutingQuery + ".");
+  EXPECT_TRUE(executing.empty());
+
+  FLAGS_schedule_concurrency = backup_concurrency;
+  EXPECT_FALSE(TableGenerateGuardScope::active());
+}
+
 TEST_F(SchedulerTests, test_scheduler_zero_drift) {
   const auto backup_step = TablePlugin::kCacheStep;
   const auto backup_interval = TablePlugin::kCacheInterval;
@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <osquery/dispatcher/timing_wheel.h>
+
+namespace osquery {
+
+class TimingWheelTests : public testing::Test {};
+
+TEST_F(TimingWheelTests, test_advance) {
+  TimingWheel wheel(100);
+  wheel.insert(1, 100);
+  wheel.insert(2, 101);
+  wheel.insert(3, 101);
+  wheel.insert(4, 50);
+  EXPECT_EQ(wheel.size(), 4U);
+
+  // Past steps are due on the next advance.
+  EXPECT_EQ(wheel.advance(100), (std::vector<size_t>{1, 4}));
+  EXPECT_EQ(wheel.advance(100), std::vector<size_t>{});
+  EXPECT_EQ(wheel.advance(101), (std::vector<size_t>{2, 3}));
+  EXPECT_EQ(wheel.size(), 0U);
+}
+
+TEST_F(TimingWheelTests, test_cascade) {
+  // Start just before a boundary of every level.
+  const uint64_t start = (uint64_t{1} << 24) - 3;
+  TimingWheel wheel(start);
+
+  // Cover each level and reinsert every due identifier with its interval,
+  // as the scheduler does.
+  std::vector<uint64_t> intervals = {
+      1, 7, 60, 64, 65, 300, 3600, 4096, 86400, 262144, 300000};
+  std::map<size_t, uint64_t> next_steps;
+  for (size_t id = 0; id < intervals.size(); ++id) {
+    next_steps[id] = start + intervals[id];
+    wheel.insert(id, next_steps[id]);
+  }
+
+  const auto end = start + 3 * intervals.back();
+  for (auto step = start; step <= end; ++step) {
+    auto due = wheel.advance(step);
+    std::sort(due.begin(), due.end());
+
+    std::vector<size_t> expected;
+    for (const auto& next_step : next_steps) {
+      if (next_step.second == step) {
+        expected.push_back(next_step.first);
+      }
+    }
+    ASSERT_EQ(due, expected) << "at step " << step;
+
+    for (auto id : due) {
+      next_steps[id] = step + intervals[id];
+      wheel.insert(id, next_steps[id]);
+    }
+  }
+  EXPECT_EQ(wheel.size(), intervals.size());
+}
+
+TEST_F(TimingWheelTests, test_overflow) {
+  const uint64_t start = 1000;
+  const uint64_t due_step = start + (uint64_t{1} << 24) + 5;
+
+  // Beyond the range of the top level.
+  TimingWheel wheel(start);
+  wheel.insert(1, due_step);
+  EXPECT_EQ(wheel.advance(due_step - 1), std::vector<size_t>{});
+  EXPECT_EQ(wheel.size(), 1U);
+  EXPECT_EQ(wheel.advance(due_step), std::vector<size_t>{1});
+  EXPECT_EQ(wheel.size(), 0U);
+}
+
+} // namespace osquery
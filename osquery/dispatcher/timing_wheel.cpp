@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <algorithm>
+
+#include "osquery/dispatcher/timing_wheel.h"
+
+namespace osquery {
+
+namespace {
+
+/// Each level has 64 slots, the step bits selecting a slot in a level.
+const size_t kSlotBits{6};
+const uint64_t kSlotMask{63};
+
+} // namespace
+
+TimingWheel::TimingWheel(uint64_t step) : next_step_(step) {}
+
+void TimingWheel::insert(size_t id, uint64_t step) {
+  place({id, step});
+  ++size_;
+}
+
+std::vector<size_t> TimingWheel::advance(uint64_t step) {
+  std::vector<size_t> due;
+  for (; next_step_ <= step; ++next_step_) {
+    auto index = next_step_ & kSlotMask;
+    if (index == 0) {
+      // The first level wrapped around, spread the next slot of the second
+      // level over it. That one may have wrapped too, and so on.
+      size_t level = 1;
+      while (level < levels_.size() && cascade(level) == 0) {
+        ++level;
+      }
+
+      if (level == levels_.size()) {
+        Slot overflow;
+        overflow.swap(overflow_);
+        for (const auto& entry : overflow) {
+          place(entry);
+        }
+      }
+    }
+
+    auto& slot = levels_[0][index];
+    for (const auto& entry : slot) {
+      due.push_back(entry.id);
+    }
+    size_ -= slot.size();
+    slot.clear();
+  }
+  return due;
+}
+
+size_t TimingWheel::size() const {
+  return size_;
+}
+
+void TimingWheel::place(Entry entry) {
+  // A past step is placed in the slot of the next step.
+  entry.step = std::max(entry.step, next_step_);
+
+  auto delta = entry.step - next_step_;
+  for (size_t level = 0; level < levels_.size(); ++level) {
+    auto shift = kSlotBits * level;
+    if (delta < (uint64_t{1} << (shift + kSlotBits))) {
+      levels_[level][(entry.step >> shift) & kSlotMask].push_back(entry);
+      return;
+    }
+  }
+  overflow_.push_back(entry);
+}
+
+size_t TimingWheel::cascade(size_t level) {
+  auto index = (next_step_ >> (kSlotBits * level)) & kSlotMask;
+
+  Slot slot;
+  slot.swap(levels_[level][index]);
+  for (const auto& entry : slot) {
+    place(entry);
+  }
+  return index;
+}
+
+} // namespace osquery
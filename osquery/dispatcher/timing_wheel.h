@@ -0,0 +1,75 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace osquery {
+
+/**
+ * @brief A hierarchical timing wheel of identifiers keyed by a time step.
+ *
+ * The wheel has four levels of 64 slots. The first level holds identifiers
+ * due within the next 64 steps, one slot per step; each following level
+ * covers 64 times the range of the previous one. When the first level wraps
+ * around, the next slot of the second level is spread over the first, and so
+ * on. Advancing a step only touches the identifiers due at that step, plus
+ * an occasional cascade, no matter how many identifiers the wheel holds.
+ *
+ * Identifiers due further than the top level are kept aside and reinserted
+ * each time the top level cascades.
+ */
+class TimingWheel {
+ public:
+  /// Create an empty wheel, the first step to advance to is `step`.
+  explicit TimingWheel(uint64_t step);
+
+  /// Add an identifier due at `step`, a past step is due on the next advance.
+  void insert(size_t id, uint64_t step);
+
+  /// Advance through `step` and return the identifiers due until then.
+  std::vector<size_t> advance(uint64_t step);
+
+  /// The number of identifiers in the wheel.
+  size_t size() const;
+
+ private:
+  struct Entry {
+    size_t id;
+    uint64_t step;
+  };
+
+  using Slot = std::vector<Entry>;
+  using Level = std::array<Slot, 64>;
+
+  /// Place an entry relative to the next step.
+  void place(Entry entry);
+
+  /// Move the entries of a slot to the levels below, returns the slot index.
+  size_t cascade(size_t level);
+
+ private:
+  /// The levels, each slot of a level spans 64 slots of the previous one.
+  std::array<Level, 4> levels_;
+
+  /// Entries due after the range of the top level.
+  Slot overflow_;
+
+  /// The next step to advance to.
+  uint64_t next_step_{0};
+
+  /// The number of entries in the wheel.
+  size_t size_{0};
+};
+
+} // namespace osquery
@@ -7,6 +7,8 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <chrono>
+#include <future>
 #include <sstream>
 #include <utility>
 
@@ -17,8 +19,12 @@
 #include <osquery/logger/logger.h>
 #include <osquery/registry/registry_factory.h>
 #include <osquery/sql/sql.h>
+#include <osquery/sql/sqlite_util.h>
+#include <osquery/sql/virtual_table.h>
+#include <osquery/utils/conversions/castvariant.h>
 #include <osquery/utils/json/json.h>
 #include <osquery/utils/system/time.h>
+#include <osquery/utils/thread_pool.h>
 
 namespace rj = rapidjson;
 
@@ -33,9 +39,152 @@ FLAG(bool,
      true,
      "Disable distributed queries (default true)");
 
+FLAG(uint64,
+     distributed_results_chunk_size,
+     0,
+     "Bytes of distributed query results to write at once (default 0, all)");
+
+FLAG(uint64,
+     distributed_concurrency,
+     1,
+     "Number of distributed queries to execute concurrently (0 for one per "
+     "CPU)");
+
+FLAG(uint64,
+     distributed_query_timeout,
+     0,
+     "Seconds a distributed query may execute before it is interrupted "
+     "(default 0, no limit)");
+
 const std::string kDistributedQueryPrefix{"distributed."};
 
-std::string Distributed::currentRequestId_{""};
+thread_local std::string Distributed::currentRequestId_{""};
+
+namespace {
+
+/// Append a string to a serialized JSON document as an escaped JSON string.
+void appendJSONString(const std::string& value, std::string& json) {
+  rj::StringBuffer sb;
+  rj::Writer<rj::StringBuffer> writer(sb);
+  writer.String(value.data(), static_cast<rj::SizeType>(value.size()));
+  json.append(sb.GetString(), sb.GetSize());
+}
+
+/// Append a "key":value member to the serialized members of a JSON object.
+void appendJSONMember(const std::string& key,
+                      const std::string& value,
+                      std::string& json) {
+  if (!json.empty()) {
+    json += ',';
+  }
+  appendJSONString(key, json);
+  json += ':';
+  json += value;
+}
+
+} // namespace
+
+void DistributedResultsBuffer::startQuery(const std::string& id) {
+  id_ = id;
+  running_ = true;
+  rows_open_ = false;
+}
+
+void DistributedResultsBuffer::addRow(const RowTyped& row,
+                                      const ColumnNames& columns) {
+  if (rows_open_) {
+    queries_ += ',';
+  } else {
+    appendJSONMember(id_, "[", queries_);
+    rows_open_ = true;
+  }
+
+  // Match serializeRow, columns are written in the order of the query.
+  rj::StringBuffer sb;
+  rj::Writer<rj::StringBuffer> writer(sb);
+  writer.StartObject();
+  for (const auto& column : columns) {
+    auto value = row.find(column);
+    if (value == row.end()) {
+      continue;
+    }
+    auto text = castVariant(value->second);
+    writer.Key(column.data(), static_cast<rj::SizeType>(column.size()));
+    writer.String(text.data(), static_cast<rj::SizeType>(text.size()));
+  }
+  writer.EndObject();
+  queries_.append(sb.GetString(), sb.GetSize());
+}
+
+void DistributedResultsBuffer::endQuery(const Status& status,
+                                        const std::string& message) {
+  if (!rows_open_) {
+    appendJSONMember(id_, "[", queries_);
+  }
+  queries_ += ']';
+
+  appendJSONMember(id_, std::to_string(status.getCode()), statuses_);
+  std::string message_json;
+  appendJSONString(message, message_json);
+  appendJSONMember(id_, message_json, messages_);
+
+  running_ = false;
+  rows_open_ = false;
+  completed_++;
+}
+
+void DistributedResultsBuffer::append(const DistributedResultsBuffer& other) {
+  if (!other.queries_.empty()) {
+    if (!queries_.empty()) {
+      queries_ += ',';
+    }
+    queries_ += other.queries_;
+  }
+  if (!other.statuses_.empty()) {
+    if (!statuses_.empty()) {
+      statuses_ += ',';
+      messages_ += ',';
+    }
+    statuses_ += other.statuses_;
+    messages_ += other.messages_;
+  }
+  completed_ += other.completed_;
+}
+
+void DistributedResultsBuffer::render(std::string& json) const {
+  json.clear();
+  json.reserve(size() + 48);
+  json += "{\"queries\":{";
+  json += queries_;
+  if (rows_open_) {
+    json += ']';
+  }
+  json += "},\"statuses\":{";
+  json += statuses_;
+  json += "},\"messages\":{";
+  json += messages_;
+  json += "}}";
+}
+
+void DistributedResultsBuffer::clear() {
+  queries_.clear();
+  statuses_.clear();
+  messages_.clear();
+  rows_open_ = false;
+  completed_ = 0;
+}
+
+size_t DistributedResultsBuffer::size() const {
+  return queries_.size() + statuses_.size() + messages_.size();
+}
+
+size_t DistributedResultsBuffer::completed() const {
+  return completed_;
+}
+
+bool DistributedResultsBuffer::empty() const {
+  return queries_.empty() && statuses_.empty();
+}
 
 Status DistributedPlugin::call(const PluginRequest& request,
                                PluginResponse& response) {
@@ -86,60 +235,160 @@ size_t Distributed::getPendingQueryCount() {
 }
 
 size_t Distributed::getCompletedCount() {
-  return results_.size();
+  WriteLock lock(results_mutex_);
+  return results_.completed();
 }
 
 Status Distributed::serializeResults(std::string& json) {
-  auto doc = JSON::newObject();
-  auto queries_obj = doc.getObject();
-  auto statuses_obj = doc.getObject();
-  auto messages_obj = doc.getObject();
-  for (const auto& result : results_) {
-    auto arr = doc.getArray();
-    auto s = serializeQueryData(result.results, result.columns, doc, arr);
-    if (!s.ok()) {
-      return s;
+  WriteLock lock(results_mutex_);
+  results_.render(json);
+  return Status::success();
+}
+
+void Distributed::addResult(const DistributedQueryResult& result) {
+  DistributedResultsBuffer buffer;
+  buffer.startQuery(result.request.id);
+  for (const auto& row : result.results) {
+    RowTyped row_typed;
+    for (const auto& column : row) {
+      row_typed[column.first] = column.second;
     }
-    doc.add(result.request.id, arr, queries_obj);
-    doc.add(result.request.id, result.status.getCode(), statuses_obj);
-    doc.add(result.request.id, result.message, messages_obj);
+    buffer.addRow(row_typed, result.columns);
   }
+  buffer.endQuery(result.status, result.message);
 
-  doc.add("queries", queries_obj);
-  doc.add("statuses", statuses_obj);
-  doc.add("messages", messages_obj);
-  return doc.toString(json);
+  WriteLock lock(results_mutex_);
+  results_.append(buffer);
 }
 
-void Distributed::addResult(const DistributedQueryResult& result) {
-  results_.push_back(result);
+Status Distributed::streamQuery(const std::string& query,
+                                const SQLiteDBInstanceRef& instance,
+                                DistributedResultsBuffer& buffer) {
+  TableColumns table_columns;
+  auto status = getQueryColumnsInternal(query, table_columns, instance);
+  if (!status.ok()) {
+    return status;
+  }
+
+  ColumnNames columns;
+  for (const auto& column : table_columns) {
+    columns.push_back(std::get<0>(column));
+  }
+
+  SQLiteQueryDeadline deadline(
+      instance, std::chrono::seconds(FLAGS_distributed_query_timeout));
+
+  // Each row is serialized as it is read, it is not kept as QueryData.
+  instance->useCache(false);
+  status = queryInternal(query,
+                         [this, &columns, &buffer](RowTyped&& row) {
+                           buffer.addRow(row, columns);
+                           writeChunk(buffer);
+                           return Status::success();
+                         },
+                         instance);
+  instance->clearAffectedTables();
+  if (deadline.expired()) {
+    return Status::failure("Distributed query timed out after " +
+                           std::to_string(FLAGS_distributed_query_timeout) +
+                           " seconds");
+  }
+  return status;
+}
+
+void Distributed::executeRequest(const DistributedQueryRequest& request,
+                                 const SQLiteDBInstanceRef& instance) {
+  LOG(INFO) << "Executing distributed query: " << request.id << ": "
+            << request.query;
+
+  // Keep track of the currently executing request
+  Distributed::setCurrentRequestId(request.id);
+
+  DistributedResultsBuffer buffer;
+  buffer.startQuery(request.id);
+  auto status = streamQuery(request.query, instance, buffer);
+  const auto& msg = status.ok() ? "" : status.toString();
+  if (!status.ok()) {
+    LOG(ERROR) << "Error executing distributed query: " << request.id << ": "
+               << msg;
+  }
+  buffer.endQuery(status, msg);
+
+  WriteLock lock(results_mutex_);
+  results_.append(buffer);
+  flushChunk();
+}
+
+void Distributed::writeChunk(DistributedResultsBuffer& buffer) {
+  if (FLAGS_distributed_results_chunk_size == 0 || chunk_failed_ ||
+      buffer.size() < FLAGS_distributed_results_chunk_size) {
+    return;
+  }
+
+  WriteLock lock(results_mutex_);
+  flushChunk(buffer);
+}
+
+void Distributed::flushChunk() {
+  if (FLAGS_distributed_results_chunk_size == 0 || chunk_failed_ ||
+      results_.size() < FLAGS_distributed_results_chunk_size) {
+    return;
+  }
+  flushChunk(results_);
+}
+
+void Distributed::flushChunk(DistributedResultsBuffer& buffer) {
+  auto s = writeResults(buffer);
+  if (!s.ok()) {
+    // Keep the results, they are retried when the queries have finished.
+    LOG(WARNING) << "Could not write distributed query results: "
+                 << s.getMessage();
+    chunk_failed_ = true;
+  }
 }
 
 Status Distributed::runQueries() {
+  chunk_failed_ = false;
+  std::vector<DistributedQueryRequest> requests;
   while (getPendingQueryCount() > 0) {
-    auto request = popRequest();
-    LOG(INFO) << "Executing distributed query: " << request.id << ": "
-              << request.query;
-
-    // Keep track of the currently executing request
-    Distributed::setCurrentRequestId(request.id);
-
-    SQL sql(request.query);
-    const auto ok = sql.getStatus().ok();
-    const auto& msg = ok ? "" : sql.getMessageString();
-    if (!ok) {
-      LOG(ERROR) << "Error executing distributed query: " << request.id << ": "
-                 << msg;
+    requests.push_back(popRequest());
+  }
+
+  auto concurrency = resolveThreadCount(FLAGS_distributed_concurrency);
+  if (concurrency > 1 && pool_ == nullptr) {
+    VLOG(1) << "Executing distributed queries using " << concurrency
+            << " workers";
+    pool_ = std::make_unique<ThreadPool>(concurrency, "distributed");
+  }
+
+  if (pool_ == nullptr || requests.size() <= 1) {
+    for (const auto& request : requests) {
+      executeRequest(request, SQLiteDBManager::get());
+    }
+  } else {
+    // Each worker executes queries using its own connection.
+    TableGenerateGuardScope guards;
+    std::vector<std::future<void>> executions;
+    executions.reserve(requests.size());
+    for (const auto& request : requests) {
+      executions.push_back(pool_->submit([this, &request]() {
+        executeRequest(request, SQLiteDBManager::getWorkerConnection());
+      }));
+    }
+    for (auto& execution : executions) {
+      execution.get();
     }
-    DistributedQueryResult result(
-        request, sql.rows(), sql.columns(), sql.getStatus(), msg);
-    addResult(result);
   }
   return flushCompleted();
 }
 
 Status Distributed::flushCompleted() {
-  if (getCompletedCount() == 0) {
+  WriteLock lock(results_mutex_);
+  return writeResults(results_);
+}
+
+Status Distributed::writeResults(DistributedResultsBuffer& buffer) {
+  if (buffer.empty()) {
     return Status::success();
   }
 
@@ -149,17 +398,14 @@ Status Distributed::flushCompleted() {
   }
 
   std::string results;
-  auto s = serializeResults(results);
-  if (!s.ok()) {
-    return s;
-  }
+  buffer.render(results);
 
   PluginResponse response;
-  s = Registry::call("distributed",
-                     {{"action", "writeResults"}, {"results", results}},
-                     response);
+  auto s = Registry::call("distributed",
+                          {{"action", "writeResults"}, {"results", results}},
+                          response);
   if (s.ok()) {
-    results_.clear();
+    buffer.clear();
   }
   return s;
 }
@@ -9,15 +9,21 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include <osquery/core/plugins/plugin.h>
 #include <osquery/core/query.h>
+#include <osquery/utils/mutex.h>
 #include <osquery/utils/status/status.h>
+#include <osquery/utils/thread_pool.h>
 
 namespace osquery {
 
+class SQLiteDBInstance;
+
 /**
  * @brief Small struct containing the query and ID information for a
  * distributed query
@@ -141,6 +147,67 @@ Status deserializeDistributedQueryResult(const rapidjson::Value& obj,
 Status deserializeDistributedQueryResultJSON(const std::string& json,
                                              DistributedQueryResult& r);
 
+/**
+ * @brief Serialized distributed query results waiting to be written
+ *
+ * Rows are serialized as they are read, the results of a query are never held
+ * as QueryData. The buffer renders the JSON document given to
+ * DistributedPlugin::writeResults. When the buffer is cleared while a query is
+ * running, the rows that follow are rendered under the same id in the next
+ * document.
+ */
+class DistributedResultsBuffer {
+ public:
+  /// Start the results of a query, the previous query must have ended.
+  void startQuery(const std::string& id);
+
+  /// Append a row of the current query, in the order of columns.
+  void addRow(const RowTyped& row, const ColumnNames& columns);
+
+  /// End the current query with the status of its execution.
+  void endQuery(const Status& status, const std::string& message);
+
+  /// Append the results of another buffer, its query must have ended.
+  void append(const DistributedResultsBuffer& other);
+
+  /// Render the buffered results as a writeResults JSON document.
+  void render(std::string& json) const;
+
+  /// Drop the buffered results, a running query remains started.
+  void clear();
+
+  /// Get the number of serialized bytes buffered.
+  size_t size() const;
+
+  /// Get the number of ended queries buffered.
+  size_t completed() const;
+
+  /// Check if there are no rows or ended queries buffered.
+  bool empty() const;
+
+ private:
+  /// The members of the "queries" object, one array of rows for each query.
+  std::string queries_;
+
+  /// The members of the "statuses" object.
+  std::string statuses_;
+
+  /// The members of the "messages" object.
+  std::string messages_;
+
+  /// The id of the running query.
+  std::string id_;
+
+  /// Set while a query is running.
+  bool running_{false};
+
+  /// Set when the rows array of the running query is open in queries_.
+  bool rows_open_{false};
+
+  /// The number of ended queries.
+  size_t completed_{0};
+};
+
 class DistributedPlugin : public Plugin {
  public:
   /**
@@ -190,6 +257,12 @@ class DistributedPlugin : public Plugin {
    *   }
    * @endcode
    *
+   * The "statuses" and "messages" objects hold each query's status code and
+   * error message. When --distributed_results_chunk_size is set, the results
+   * are written as soon as they exceed the size: the rows of a query may be
+   * split across several calls, and only the call with its final rows
+   * includes the query's status.
+   *
    * @param json is the results data to write
    * @return a Status indicating the success or failure of the operation
    */
@@ -263,6 +336,36 @@ class Distributed {
    */
   void addResult(const DistributedQueryResult& result);
 
+  /**
+   * @brief Execute a request and queue its results to be sent to the server
+   *
+   * This may be called concurrently, each with a different connection.
+   */
+  void executeRequest(const DistributedQueryRequest& request,
+                      const std::shared_ptr<SQLiteDBInstance>& instance);
+
+  /**
+   * @brief Execute a query, serializing its rows into a results buffer
+   *
+   * The buffer is written whenever it exceeds the results chunk size. The
+   * query is interrupted if it executes past the distributed query timeout.
+   */
+  Status streamQuery(const std::string& query,
+                     const std::shared_ptr<SQLiteDBInstance>& instance,
+                     DistributedResultsBuffer& buffer);
+
+  /// Write a query's buffered results if they exceed the results chunk size.
+  void writeChunk(DistributedResultsBuffer& buffer);
+
+  /// Write the collected results if they exceed the results chunk size.
+  void flushChunk();
+
+  /// Write a buffer, keeping the results if the write fails.
+  void flushChunk(DistributedResultsBuffer& buffer);
+
+  /// Write a buffer to the distributed plugin, and clear it on success.
+  Status writeResults(DistributedResultsBuffer& buffer);
+
   /**
    * @brief Flush all of the collected results to the server
    */
@@ -271,13 +374,25 @@ class Distributed {
   // Setter for ID of currently executing request
   static void setCurrentRequestId(const std::string& cReqId);
 
-  std::vector<DistributedQueryResult> results_;
+  /// Serialized results waiting to be written.
+  DistributedResultsBuffer results_;
+
+  /// Protects results_ and serializes writes to the distributed plugin.
+  Mutex results_mutex_;
+
+  /// Set when a chunk could not be written, results buffer until the end.
+  std::atomic<bool> chunk_failed_{false};
+
+  /// Workers used when distributed queries execute concurrently.
+  std::unique_ptr<ThreadPool> pool_{nullptr};
 
-  // ID of the currently executing query
-  static std::string currentRequestId_;
+  // ID of the query executing on the calling thread
+  static thread_local std::string currentRequestId_;
 
  private:
   friend class DistributedTests;
   FRIEND_TEST(DistributedTests, test_workflow);
+  FRIEND_TEST(DistributedTests, test_results_chunks);
+  FRIEND_TEST(DistributedTests, test_concurrent_queries);
 };
 } // namespace osquery
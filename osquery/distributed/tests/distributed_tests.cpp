@@ -20,6 +20,7 @@
 
 #include "osquery/remote/tests/test_utils.h"
 #include "osquery/sql/sqlite_util.h"
+#include "osquery/sql/virtual_table.h"
 #include <osquery/utils/conversions/tryto.h>
 #include <osquery/utils/json/json.h>
 
@@ -27,6 +28,23 @@ namespace osquery {
 
 DECLARE_string(distributed_tls_read_endpoint);
 DECLARE_string(distributed_tls_write_endpoint);
+DECLARE_uint64(distributed_results_chunk_size);
+DECLARE_uint64(distributed_concurrency);
+DECLARE_uint64(distributed_query_timeout);
+
+class TestDistributedPlugin : public DistributedPlugin {
+ public:
+  Status getQueries(std::string& json) override {
+    return Status::success();
+  }
+
+  Status writeResults(const std::string& json) override {
+    writes.push_back(json);
+    return Status::success();
+  }
+
+  std::vector<std::string> writes;
+};
 
 class DistributedTests : public testing::Test {
  protected:
@@ -206,4 +224,119 @@ TEST_F(DistributedTests, test_workflow) {
   EXPECT_EQ(dist.getPendingQueryCount(), 0U);
   EXPECT_EQ(dist.results_.size(), 0U);
 }
+
+TEST_F(DistributedTests, test_results_chunks) {
+  auto& rf = RegistryFactory::get();
+  auto plugin = std::make_shared<TestDistributedPlugin>();
+  rf.registry("distributed")->add("test", plugin);
+  ASSERT_TRUE(rf.setActive("distributed", "test").ok());
+
+  auto chunk_size = FLAGS_distributed_results_chunk_size;
+  FLAGS_distributed_results_chunk_size = 1024;
+
+  auto dist = Distributed();
+  auto s = dist.acceptWork(
+      "{\"queries\": {"
+      "\"many\": \"WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL "
+      "SELECT x + 1 FROM c WHERE x < 1000) SELECT x, 'y' AS y FROM c\","
+      "\"bad\": \"SELECT * FROM no_such_table\""
+      "}}");
+  ASSERT_TRUE(s.ok()) << s.getMessage();
+  s = dist.runQueries();
+  ASSERT_TRUE(s.ok()) << s.getMessage();
+  EXPECT_EQ(dist.results_.size(), 0U);
+
+  // The rows of the large query are split across several writes.
+  ASSERT_GT(plugin->writes.size(), 2U);
+  size_t rows = 0;
+  size_t statuses = 0;
+  for (const auto& json : plugin->writes) {
+    auto doc = JSON::newObject();
+    ASSERT_TRUE(doc.fromString(json) && doc.doc().IsObject()) << json;
+    ASSERT_TRUE(doc.doc()["queries"].IsObject());
+    ASSERT_TRUE(doc.doc()["statuses"].IsObject());
+    ASSERT_TRUE(doc.doc()["messages"].IsObject());
+
+    const auto& statuses_obj = doc.doc()["statuses"];
+    if (doc.doc()["queries"].HasMember("many")) {
+      for (const auto& row : doc.doc()["queries"]["many"].GetArray()) {
+        EXPECT_EQ(std::to_string(rows + 1), row["x"].GetString());
+        EXPECT_EQ(std::string("y"), row["y"].GetString());
+        rows++;
+      }
+      if (rows < 1000) {
+        EXPECT_FALSE(statuses_obj.HasMember("many"));
+      }
+    }
+    if (statuses_obj.HasMember("many")) {
+      EXPECT_EQ(statuses_obj["many"].GetInt(), 0);
+      statuses++;
+    }
+    if (statuses_obj.HasMember("bad")) {
+      EXPECT_EQ(statuses_obj["bad"].GetInt(), 1);
+      EXPECT_TRUE(doc.doc()["queries"]["bad"].Empty());
+      EXPECT_FALSE(
+          std::string(doc.doc()["messages"]["bad"].GetString()).empty());
+      statuses++;
+    }
+  }
+  EXPECT_EQ(rows, 1000U);
+  EXPECT_EQ(statuses, 2U);
+
+  FLAGS_distributed_results_chunk_size = chunk_size;
+  rf.registry("distributed")->remove("test");
+}
+
+TEST_F(DistributedTests, test_concurrent_queries) {
+  auto& rf = RegistryFactory::get();
+  auto plugin = std::make_shared<TestDistributedPlugin>();
+  rf.registry("distributed")->add("test", plugin);
+  ASSERT_TRUE(rf.setActive("distributed", "test").ok());
+
+  auto concurrency = FLAGS_distributed_concurrency;
+  auto timeout = FLAGS_distributed_query_timeout;
+  FLAGS_distributed_concurrency = 4;
+  FLAGS_distributed_query_timeout = 1;
+
+  auto dist = Distributed();
+  auto s = dist.acceptWork(
+      "{\"queries\": {"
+      "\"slow\": \"WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL "
+      "SELECT x + 1 FROM c) SELECT count(*) AS n FROM c\","
+      "\"a\": \"SELECT 1 AS n\","
+      "\"b\": \"SELECT 2 AS n\","
+      "\"c\": \"SELECT 3 AS n\""
+      "}}");
+  ASSERT_TRUE(s.ok()) << s.getMessage();
+
+  // The slow query is interrupted instead of blocking the others.
+  s = dist.runQueries();
+  ASSERT_TRUE(s.ok()) << s.getMessage();
+  EXPECT_EQ(dist.getPendingQueryCount(), 0U);
+
+  ASSERT_EQ(plugin->writes.size(), 1U);
+  auto doc = JSON::newObject();
+  ASSERT_TRUE(doc.fromString(plugin->writes[0]) && doc.doc().IsObject());
+  const auto& queries = doc.doc()["queries"];
+  const auto& statuses = doc.doc()["statuses"];
+  const auto& messages = doc.doc()["messages"];
+  EXPECT_EQ(statuses["slow"].GetInt(), 1);
+  EXPECT_NE(std::string(messages["slow"].GetString()).find("timed out"),
+            std::string::npos);
+  EXPECT_TRUE(queries["slow"].Empty());
+
+  std::map<std::string, std::string> expected = {
+      {"a", "1"}, {"b", "2"}, {"c", "3"}};
+  for (const auto& query : expected) {
+    const auto id = query.first.c_str();
+    EXPECT_EQ(statuses[id].GetInt(), 0);
+    ASSERT_EQ(queries[id].Size(), 1U);
+    EXPECT_EQ(query.second, queries[id][0]["n"].GetString());
+  }
+
+  FLAGS_distributed_concurrency = concurrency;
+  FLAGS_distributed_query_timeout = timeout;
+  EXPECT_FALSE(TableGenerateGuardScope::active());
+  rf.registry("distributed")->remove("test");
+}
 } // namespace osquery
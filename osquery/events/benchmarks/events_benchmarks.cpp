@@ -7,10 +7,13 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <map>
+
 #include <benchmark/benchmark.h>
 
 #include <osquery/config/config.h>
 #include <osquery/core/tables.h>
+#include <osquery/database/database.h>
 #include <osquery/registry/registry_factory.h>
 
 #include "osquery/tests/test_util.h"
@@ -42,6 +45,112 @@ static void EVENTS_register(benchmark::State& state) {
 
 BENCHMARK(EVENTS_register);
 
+/// An in-memory events database counting the bytes written to it.
+class BenchmarkEventDatabase final : public IDatabaseInterface {
+ public:
+  Status getDatabaseValue(const std::string& domain,
+                          const std::string& key,
+                          std::string& value) const override {
+    auto it = key_map_.find(key);
+    if (it == key_map_.end()) {
+      return Status::failure("Key not found");
+    }
+    value = it->second;
+    return Status::success();
+  }
+
+  Status getDatabaseValue(const std::string& domain,
+                          const std::string& key,
+                          int& value) const override {
+    return Status::failure("Unsupported");
+  }
+
+  Status setDatabaseValue(const std::string& domain,
+                          const std::string& key,
+                          const std::string& value) const override {
+    bytes_written += key.size() + value.size();
+    key_map_[key] = value;
+    return Status::success();
+  }
+
+  Status setDatabaseValue(const std::string& domain,
+                          const std::string& key,
+                          int value) const override {
+    return setDatabaseValue(domain, key, std::to_string(value));
+  }
+
+  Status setDatabaseBatch(const std::string& domain,
+                          const DatabaseStringValueList& data) const override {
+    for (const auto& p : data) {
+      setDatabaseValue(domain, p.first, p.second);
+    }
+    return Status::success();
+  }
+
+  Status setDatabaseBatch(
+      const std::string& domain,
+      const DatabaseStringValueList& data,
+      const std::vector<std::string>& removals) const override {
+    for (const auto& key : removals) {
+      key_map_.erase(key);
+    }
+    return setDatabaseBatch(domain, data);
+  }
+
+  Status deleteDatabaseValue(const std::string& domain,
+                             const std::string& key) const override {
+    key_map_.erase(key);
+    return Status::success();
+  }
+
+  Status deleteDatabaseRange(const std::string& domain,
+                             const std::string& low,
+                             const std::string& high) const override {
+    key_map_.erase(key_map_.lower_bound(low), key_map_.upper_bound(high));
+    return Status::success();
+  }
+
+  Status scanDatabaseKeys(const std::string& domain,
+                          std::vector<std::string>& keys,
+                          size_t max) const override {
+    return scanDatabaseKeys(domain, keys, "", max);
+  }
+
+  Status scanDatabaseKeys(const std::string& domain,
+                          std::vector<std::string>& keys,
+                          const std::string& prefix,
+                          size_t max) const override {
+    keys.clear();
+    for (auto it = key_map_.lower_bound(prefix); it != key_map_.end(); ++it) {
+      if (it->first.compare(0, prefix.size(), prefix) != 0) {
+        break;
+      }
+      keys.push_back(it->first);
+    }
+    return Status::success();
+  }
+
+  Status scanDatabaseRange(
+      const std::string& domain,
+      const std::string& low,
+      const std::string& high,
+      const DatabaseScanCallback& callback) const override {
+    for (auto it = key_map_.lower_bound(low); it != key_map_.end(); ++it) {
+      if ((!high.empty() && it->first >= high) ||
+          !callback(it->first, it->second)) {
+        break;
+      }
+    }
+    return Status::success();
+  }
+
+  /// Bytes of keys and values written, including overwritten ones.
+  mutable size_t bytes_written{0};
+
+ private:
+  mutable std::map<std::string, std::string> key_map_;
+};
+
 class BenchmarkEventSubscriber
     : public EventSubscriber<BenchmarkEventPublisher> {
  public:
@@ -76,6 +185,25 @@ class BenchmarkEventSubscriber
     expire_time_ = et;
   }
 
+  /// Store the events in a separate database, as blocks or single events.
+  void benchmarkSetStorage(IDatabaseInterface& database, bool event_blocks) {
+    database_ = &database;
+    event_blocks_ = event_blocks;
+    setDatabaseNamespace();
+    generateEventDataIndex();
+  }
+
+  void benchmarkAddBatch(std::vector<Row>& row_list, EventTime event_time) {
+    addBatch(row_list, event_time);
+  }
+
+  size_t benchmarkGenerateRows() {
+    size_t row_count{0};
+    EventSubscriberPlugin::generateRows(
+        context, getDatabase(), [&row_count](Row) { ++row_count; }, 0, 0);
+    return row_count;
+  }
+
   void benchmarkGet(int low, int high) {
     RowGenerator::pull_type generator(std::bind(
         &EventSubscriberPlugin::get, this, std::placeholders::_1, low, high));
@@ -88,8 +216,102 @@ class BenchmarkEventSubscriber
       generator();
     }
   }
+
+ private:
+  IDatabaseInterface& getDatabase() const override {
+    return database_ != nullptr ? *database_
+                                : EventSubscriberPlugin::getDatabase();
+  }
+
+  bool usesEventBlocks() const override {
+    return event_blocks_;
+  }
+
+  /// Never expire the stored events while benchmarking.
+  size_t getEventsExpiry() override {
+    return database_ != nullptr ? 0 : EventSubscriberPlugin::getEventsExpiry();
+  }
+
+ private:
+  IDatabaseInterface* database_{nullptr};
+  bool event_blocks_{false};
 };
 
+/// A batch of rows shaped like the process_file_events table.
+std::vector<Row> getExampleFileEvents(size_t count) {
+  std::vector<Row> row_list;
+  for (size_t i = 0; i < count; i++) {
+    row_list.push_back({
+        {"operation", (i % 2 == 0) ? "open" : "write"},
+        {"pid", std::to_string(1000 + i % 16)},
+        {"ppid", "1"},
+        {"executable", "/usr/bin/python3"},
+        {"partial", "0"},
+        {"cwd", "/home/user"},
+        {"path", "/home/user/project/file" + std::to_string(i % 64) + ".txt"},
+        {"dest_path", ""},
+        {"uid", "1000"},
+        {"gid", "1000"},
+        {"auid", "1000"},
+        {"euid", "1000"},
+        {"egid", "1000"},
+        {"fsuid", "1000"},
+        {"fsgid", "1000"},
+        {"suid", "1000"},
+        {"sgid", "1000"},
+        {"uptime", std::to_string(123456 + i)},
+    });
+  }
+  return row_list;
+}
+
+static void EVENTS_add_batch_storage(benchmark::State& state) {
+  BenchmarkEventDatabase database;
+  auto sub = std::make_shared<BenchmarkEventSubscriber>();
+  sub->benchmarkSetStorage(database, state.range(0) != 0);
+
+  auto row_list = getExampleFileEvents(state.range(1));
+  EventTime event_time{1};
+  size_t event_count{0};
+  while (state.KeepRunning()) {
+    sub->benchmarkAddBatch(row_list, event_time++);
+    event_count += row_list.size();
+  }
+
+  // The write amplification: bytes stored per event, index included.
+  state.counters["bytes_per_event"] =
+      static_cast<double>(database.bytes_written) / event_count;
+}
+
+BENCHMARK(EVENTS_add_batch_storage)
+    ->ArgPair(0, 1)
+    ->ArgPair(0, 64)
+    ->ArgPair(1, 1)
+    ->ArgPair(1, 64);
+
+static void EVENTS_generate_rows_storage(benchmark::State& state) {
+  BenchmarkEventDatabase database;
+  auto sub = std::make_shared<BenchmarkEventSubscriber>();
+  sub->benchmarkSetStorage(database, state.range(0) != 0);
+
+  // Batches of 64 events, spread over time buckets.
+  auto row_list = getExampleFileEvents(64);
+  for (int i = 0; i < state.range(1) / 64; i++) {
+    sub->benchmarkAddBatch(row_list, 1 + i / 4);
+  }
+
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(sub->benchmarkGenerateRows());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+
+BENCHMARK(EVENTS_generate_rows_storage)
+    ->ArgPair(0, 1024)
+    ->ArgPair(0, 16384)
+    ->ArgPair(1, 1024)
+    ->ArgPair(1, 16384);
+
 static void EVENTS_subscribe_fire(benchmark::State& state) {
   // Setup the event config parser plugin.
   auto plugin = Config::get().getParser("events");
@@ -149,6 +149,9 @@ class EventFactory : private boost::noncopyable {
   /// Optionally forward events to loggers.
   static void forwardEvent(const std::string& event);
 
+  /// Check if any logger receives forwarded events.
+  static bool forwardsEvents();
+
   /**
    * @brief The event factory, subscribers, and publishers respond to updates.
    *
@@ -7,6 +7,18 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <set>
+#include <unordered_map>
+
+#include <zstd.h>
+
 #include <osquery/config/config.h>
 #include <osquery/core/flags.h>
 #include <osquery/database/database.h>
@@ -26,9 +38,210 @@ namespace {
 /// Checkpoint interval to inspect max event buffering.
 const EventContextID kEventsCheckpoint{256U};
 
-void removeDeprecatedEventKeysOnceHelper() {
+/// Key prefix of the persisted time index, one key per time bucket.
+const char* const kEventIndexPrefix{"time_index."};
+
+/// Key prefix of the last EventID covered by the persisted time index.
+const char* const kLastEventIdPrefix{"last_eid."};
+
+/// Key prefix of the event blocks, one key per stored batch.
+const char* const kEventBlockPrefix{"block."};
+
+/// Marks a persisted time bucket whose events are stored as blocks.
+const std::string kEventBlockBucketMarker{"b:"};
+
+/// The event block format version, the first byte of a block.
+const char kEventBlockVersion{1};
+
+/// The second byte of a block, how the encoded events are stored.
+const char kEventBlockUncompressed{0};
+const char kEventBlockZstd{1};
+
+/// A compressed block claiming more than this is considered corrupt.
+const std::size_t kMaxEventBlockSize{256U << 20};
+
+void appendVarint(std::string& output, std::uint64_t value) {
+  while (value >= 0x80U) {
+    output.push_back(static_cast<char>((value & 0x7FU) | 0x80U));
+    value >>= 7;
+  }
+  output.push_back(static_cast<char>(value));
+}
+
+void appendString(std::string& output, const std::string& value) {
+  appendVarint(output, value.size());
+  output += value;
+}
+
+/// Reads the varints and length-prefixed strings of an event block.
+class EventBlockReader final {
+ public:
+  EventBlockReader(const char* data, std::size_t size)
+      : current_(data), end_(data + size) {}
+
+  bool readVarint(std::uint64_t& value) {
+    value = 0U;
+    for (unsigned shift = 0U; shift < 64U && current_ != end_; shift += 7U) {
+      auto byte = static_cast<unsigned char>(*current_++);
+      value |= static_cast<std::uint64_t>(byte & 0x7FU) << shift;
+      if ((byte & 0x80U) == 0U) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool readString(std::string& value) {
+    std::uint64_t size{0U};
+    if (!readVarint(size) || size > remaining()) {
+      return false;
+    }
+    value.assign(current_, size);
+    current_ += size;
+    return true;
+  }
+
+  bool skipString() {
+    std::uint64_t size{0U};
+    if (!readVarint(size) || size > remaining()) {
+      return false;
+    }
+    current_ += size;
+    return true;
+  }
+
+  std::size_t remaining() const {
+    return static_cast<std::size_t>(end_ - current_);
+  }
+
+ private:
+  const char* current_;
+  const char* end_;
+};
+
+/// Check for a plain decimal number, as SQLite would compare numerically.
+bool isDecimalConstraint(const std::string& expr) {
+  std::size_t i = (!expr.empty() && expr[0] == '-') ? 1U : 0U;
+
+  std::size_t digit_count{0U};
+  for (; i < expr.size() && std::isdigit(expr[i]) != 0; ++i) {
+    ++digit_count;
+  }
+
+  if (i < expr.size() && expr[i] == '.') {
+    for (++i; i < expr.size() && std::isdigit(expr[i]) != 0; ++i) {
+      ++digit_count;
+    }
+  }
+
+  return digit_count != 0U && i == expr.size();
+}
+
+/**
+ * @brief Narrow an inclusive range with the constraints on a column.
+ *
+ * Constraints that are not plain numbers are ignored, the range can only
+ * include more rows than the constraints do. Returns false if the
+ * constraints cannot match any value.
+ */
+bool narrowConstraintRange(const ConstraintList& constraint_list,
+                           std::uint64_t& low,
+                           std::uint64_t& high) {
+  const auto max_value =
+      static_cast<long double>(std::numeric_limits<std::uint64_t>::max());
+
+  for (const auto& constraint : constraint_list.getAll()) {
+    if (!isDecimalConstraint(constraint.expr)) {
+      continue;
+    }
+    auto value = std::strtold(constraint.expr.c_str(), nullptr);
+
+    // The first and last integers satisfying the constraint.
+    long double first{0};
+    long double last{max_value};
+    if (constraint.op == EQUALS) {
+      first = std::ceil(value);
+      last = std::floor(value);
+    } else if (constraint.op == GREATER_THAN) {
+      first = std::floor(value) + 1;
+    } else if (constraint.op == GREATER_THAN_OR_EQUALS) {
+      first = std::ceil(value);
+    } else if (constraint.op == LESS_THAN) {
+      last = std::ceil(value) - 1;
+    } else if (constraint.op == LESS_THAN_OR_EQUALS) {
+      last = std::floor(value);
+    } else {
+      continue;
+    }
+
+    if (first > last || last < 0 || first >= max_value) {
+      return false;
+    }
+
+    if (first > 0) {
+      low = std::max(low, static_cast<std::uint64_t>(first));
+    }
+    if (last < max_value) {
+      high = std::min(high, static_cast<std::uint64_t>(last));
+    }
+  }
+
+  return low <= high;
+}
+
+/// Serialize a time bucket, marking the ones whose events are blocks.
+std::string serializeEventIndexBucket(const EventIDList& event_id_list,
+                                      bool block_bucket) {
+  auto serialized = EventSubscriberPlugin::serializeEventIDList(event_id_list);
+  return block_bucket ? kEventBlockBucketMarker + serialized : serialized;
+}
+
+/// Serialize a row as a single line of JSON.
+Status serializeEventJSON(const Row& row, std::string& serialized_row) {
+  auto status = serializeRowJSON(row, serialized_row);
+  if (!status.ok()) {
+    return status;
+  }
+
+  // Then remove the newline.
+  if (serialized_row.size() > 0 && serialized_row.back() == '\n') {
+    serialized_row.pop_back();
+  }
+  return Status::success();
+}
+
+/// Delete the blocks of a time bucket, returns the number of blocks deleted.
+std::size_t deleteEventBlocks(EventSubscriberPlugin::Context& context,
+                              IDatabaseInterface& db_interface,
+                              EventTime event_time,
+                              std::size_t& error_count) {
+  std::vector<std::string> key_list;
+  auto status = db_interface.scanDatabaseKeys(
+      kEvents,
+      key_list,
+      EventSubscriberPlugin::databaseKeyPrefixForEventBlocks(context,
+                                                             event_time),
+      0);
+  if (!status.ok()) {
+    ++error_count;
+    return 0U;
+  }
+
+  std::size_t deleted_count{0U};
+  for (const auto& key : key_list) {
+    status = db_interface.deleteDatabaseValue(kEvents, key);
+    if (status.ok()) {
+      ++deleted_count;
+    } else {
+      ++error_count;
+    }
+  }
+  return deleted_count;
+}
+
+void removeDeprecatedEventKeysOnceHelper(IDatabaseInterface& db_interface) {
   std::vector<std::string> key_list;
-  auto status = scanDatabaseKeys(kEvents, key_list);
+  auto status = db_interface.scanDatabaseKeys(kEvents, key_list, "", 0);
   if (!status.ok()) {
     LOG(ERROR) << "Failed to scan the database keys";
     return;
@@ -45,7 +258,7 @@ void removeDeprecatedEventKeysOnceHelper() {
       continue;
     }
 
-    status = deleteDatabaseValue(kEvents, key);
+    status = db_interface.deleteDatabaseValue(kEvents, key);
     if (status.ok()) {
       ++deleted_key_count;
     } else {
@@ -63,13 +276,133 @@ void removeDeprecatedEventKeysOnceHelper() {
   }
 }
 
-void removeDeprecatedEventKeysOnce() {
+void removeDeprecatedEventKeysOnce(IDatabaseInterface& db_interface) {
   static std::once_flag f;
-  std::call_once(f, removeDeprecatedEventKeysOnceHelper);
+  std::call_once(
+      f, removeDeprecatedEventKeysOnceHelper, std::ref(db_interface));
+}
+
+/**
+ * @brief Load the time bucket keys of a persisted time index.
+ *
+ * Fails if there is no persisted index or if events were stored beyond the
+ * last EventID the index covers.
+ */
+Status loadPersistedEventIndex(EventSubscriberPlugin::Context& context,
+                               IDatabaseInterface& db_interface) {
+  std::string string_last_event_id;
+  auto status = db_interface.getDatabaseValue(
+      kEvents,
+      EventSubscriberPlugin::databaseKeyForLastEventId(context),
+      string_last_event_id);
+  if (!status.ok() || string_last_event_id.empty()) {
+    return Status::failure("No persisted index");
+  }
+
+  auto last_event_id = tryTo<EventID>(string_last_event_id);
+  if (last_event_id.isError()) {
+    return Status::failure("Invalid last EventID");
+  }
+
+  // A single prefix scan detects events stored without updating the index.
+  std::vector<std::string> key_list;
+  status = db_interface.scanDatabaseKeys(
+      kEvents,
+      key_list,
+      EventSubscriberPlugin::databaseKeyForEventId(context,
+                                                   *last_event_id + 1),
+      0);
+  if (!status.ok()) {
+    return status;
+  }
+  if (!key_list.empty()) {
+    return Status::failure("Events are stored beyond the persisted index");
+  }
+
+  std::string prefix = kEventIndexPrefix + context.database_namespace + ".";
+  status = db_interface.scanDatabaseKeys(kEvents, key_list, prefix, 0);
+  if (!status.ok()) {
+    return status;
+  }
+
+  EventIndex event_index;
+  std::set<EventTime> unloaded_buckets;
+  for (const auto& key : key_list) {
+    auto event_time = tryTo<EventTime>(key.substr(prefix.size()));
+    if (event_time.isError()) {
+      // Rebuild, the persisted replacement removes the invalid key.
+      return Status::failure("Invalid event time bucket key: " + key);
+    }
+
+    event_index.insert(event_index.end(), {*event_time, {}});
+    unloaded_buckets.insert(unloaded_buckets.end(), *event_time);
+  }
+
+  if (!event_index.empty()) {
+    VLOG(1) << "Found " << event_index.size() << " event time buckets for "
+            << "subscriber " << context.database_namespace;
+  }
+
+  context.last_event_id = *last_event_id;
+  context.event_index = std::move(event_index);
+  context.unloaded_buckets = std::move(unloaded_buckets);
+  context.block_buckets.clear();
+  return Status::success();
+}
+
+/**
+ * @brief Replace the persisted time index with the (fully loaded) index.
+ *
+ * The previous time bucket keys are removed in the same write batch, an
+ * interrupted replacement never leaves a last EventID without its buckets.
+ */
+Status persistEventIndex(EventSubscriberPlugin::Context& context,
+                         IDatabaseInterface& db_interface) {
+  std::vector<std::string> key_list;
+  std::string prefix = kEventIndexPrefix + context.database_namespace + ".";
+  auto status = db_interface.scanDatabaseKeys(kEvents, key_list, prefix, 0);
+  if (!status.ok()) {
+    return status;
+  }
+
+  DatabaseStringValueList database_data;
+  database_data.reserve(context.event_index.size() + 1);
+  for (const auto& bucket : context.event_index) {
+    database_data.push_back(std::make_pair(
+        EventSubscriberPlugin::databaseKeyForEventTime(context, bucket.first),
+        serializeEventIndexBucket(
+            bucket.second, context.block_buckets.count(bucket.first) != 0)));
+  }
+  database_data.push_back(
+      std::make_pair(EventSubscriberPlugin::databaseKeyForLastEventId(context),
+                     EventSubscriberPlugin::toIndex(context.last_event_id)));
+
+  return db_interface.setDatabaseBatch(kEvents, database_data, key_list);
+}
+
+/// Write the time bucket pushdown to the runtime planner output.
+void planScannedBuckets(const std::string& database_namespace,
+                        std::size_t scanned_bucket_count,
+                        std::size_t bucket_count) {
+  auto skipped_bucket_count = bucket_count - scanned_bucket_count;
+  auto skip_ratio = (bucket_count == 0U)
+                        ? 0.0
+                        : static_cast<double>(skipped_bucket_count) /
+                              static_cast<double>(bucket_count);
+
+  fprintf(stderr,
+          "osquery planner: generateRows Scanned event buckets for "
+          "subscriber: %s [scanned=%zu skipped=%zu skip_ratio=%.2f]\n",
+          database_namespace.c_str(),
+          scanned_bucket_count,
+          skipped_bucket_count,
+          skip_ratio);
 }
 
 } // namespace
 
+DECLARE_bool(planner);
+
 FLAG(bool,
      events_optimize,
      true,
@@ -86,6 +419,11 @@ FLAG(uint64,
      50000,
      "Maximum number of event batches per type to buffer");
 
+FLAG(bool,
+     events_compress_blocks,
+     true,
+     "Compress the event blocks of high-volume subscribers with zstd");
+
 CREATE_REGISTRY(EventSubscriberPlugin, "event_subscriber");
 
 EventSubscriberPlugin::EventSubscriberPlugin(bool enabled)
@@ -110,10 +448,7 @@ Status EventSubscriberPlugin::addBatch(std::vector<Row>& row_list) {
 
 Status EventSubscriberPlugin::addBatch(std::vector<Row>& row_list,
                                        EventTime custom_event_time) {
-  removeDeprecatedEventKeysOnce();
-
-  DatabaseStringValueList database_data;
-  database_data.reserve(row_list.size());
+  removeDeprecatedEventKeysOnce(getDatabase());
 
   EventIDList event_id_list;
   event_id_list.reserve(row_list.size());
@@ -125,34 +460,91 @@ Status EventSubscriberPlugin::addBatch(std::vector<Row>& row_list,
     auto event_identifier = getEventID();
     event_id_list.push_back(event_identifier);
 
-    auto string_event_identifier = toIndex(event_identifier);
-
     row["time"] = string_event_time;
-    row["eid"] = string_event_identifier;
+    row["eid"] = toIndex(event_identifier);
+  }
 
-    // Serialize and store the row data, for query-time retrieval.
-    std::string serialized_row;
-    auto status = serializeRowJSON(row, serialized_row);
-    if (!status.ok()) {
-      VLOG(1) << status.getMessage();
-      continue;
+  // Events are added to a time bucket in the storage format it started with.
+  auto store_blocks = usesEventBlocks();
+
+  {
+    WriteLock index_lock(context.event_index_mutex);
+    auto it = context.event_index.find(event_time);
+    if (it != context.event_index.end()) {
+      loadEventIndexBucket(context, getDatabase(), it);
+      if (!it->second.empty()) {
+        store_blocks = context.block_buckets.count(event_time) != 0;
+      }
+    }
+  }
+
+  // The JSON rows are only needed as stored values or to forward them.
+  std::vector<std::string> serialized_row_list;
+
+  auto serializeRows = [&]() {
+    serialized_row_list.reserve(row_list.size());
+    for (const auto& row : row_list) {
+      std::string serialized_row;
+      auto status = serializeEventJSON(row, serialized_row);
+      if (!status.ok()) {
+        VLOG(1) << status.getMessage();
+      }
+      serialized_row_list.push_back(std::move(serialized_row));
+    }
+  };
+
+  auto serializeBatch = [&](DatabaseStringValueList& database_data) {
+    database_data.clear();
+
+    if (store_blocks) {
+      std::string block;
+      auto status = serializeEventBlock(event_time,
+                                        event_id_list,
+                                        row_list,
+                                        FLAGS_events_compress_blocks,
+                                        block);
+      if (!status.ok()) {
+        VLOG(1) << status.getMessage();
+        return;
+      }
+
+      database_data.push_back(std::make_pair(
+          databaseKeyForEventBlock(
+              context, event_time, event_id_list.front()),
+          std::move(block)));
+      return;
     }
 
-    // Then remove the newline.
-    if (serialized_row.size() > 0 && serialized_row.back() == '\n') {
-      serialized_row.pop_back();
+    if (serialized_row_list.empty()) {
+      serializeRows();
     }
 
-    // Logger plugins may request events to be forwarded directly.
-    // If no active logger is marked 'usesLogEvent' then this is a no-op.
-    EventFactory::forwardEvent(serialized_row);
+    database_data.reserve(row_list.size() + 2);
+    for (std::size_t i = 0U; i < row_list.size(); ++i) {
+      if (serialized_row_list[i].empty()) {
+        continue;
+      }
 
-    // Store the event data in the batch
-    database_data.push_back(
-        std::make_pair("data." + dbNamespace() + "." + string_event_identifier,
-                       serialized_row));
+      // Store the event data in the batch
+      database_data.push_back(
+          std::make_pair(databaseKeyForEventId(context, event_id_list[i]),
+                         std::move(serialized_row_list[i])));
+    }
+  };
+
+  // Logger plugins may request events to be forwarded directly.
+  if (!store_blocks || EventFactory::forwardsEvents()) {
+    serializeRows();
+    for (const auto& serialized_row : serialized_row_list) {
+      if (!serialized_row.empty()) {
+        EventFactory::forwardEvent(serialized_row);
+      }
+    }
   }
 
+  DatabaseStringValueList database_data;
+  serializeBatch(database_data);
+
   if (database_data.empty()) {
     return Status(1, "Failed to process the rows");
   }
@@ -162,20 +554,49 @@ Status EventSubscriberPlugin::addBatch(std::vector<Row>& row_list,
 
   {
     WriteLock lock(event_id_lock_);
+    WriteLock index_lock(context.event_index_mutex);
+
+    // The time bucket is persisted within the same batch as the event data.
+    EventIDList bucket;
+    auto it = context.event_index.find(event_time);
+    if (it != context.event_index.end()) {
+      loadEventIndexBucket(context, getDatabase(), it);
+      bucket = it->second;
+    }
+
+    // The bucket may have been expired and started again in another format.
+    if (!bucket.empty() &&
+        (context.block_buckets.count(event_time) != 0) != store_blocks) {
+      store_blocks = !store_blocks;
+      serializeBatch(database_data);
+      if (database_data.empty()) {
+        return Status(1, "Failed to process the rows");
+      }
+    }
+
+    bucket.insert(bucket.end(), event_id_list.begin(), event_id_list.end());
 
-    auto status = setDatabaseBatch(kEvents, database_data);
+    database_data.push_back(
+        std::make_pair(databaseKeyForEventTime(context, event_time),
+                       serializeEventIndexBucket(bucket, store_blocks)));
+    database_data.push_back(std::make_pair(databaseKeyForLastEventId(context),
+                                           toIndex(context.last_event_id)));
+
+    auto status = getDatabase().setDatabaseBatch(kEvents, database_data);
     if (!status.ok()) {
       return status;
     }
 
-    auto it = context.event_index.find(event_time);
     if (it == context.event_index.end()) {
-      context.event_index.insert({event_time, event_id_list});
+      context.event_index.insert({event_time, std::move(bucket)});
+    } else {
+      it->second = std::move(bucket);
+    }
 
+    if (store_blocks) {
+      context.block_buckets.insert(event_time);
     } else {
-      auto& index_entry = it->second;
-      index_entry.insert(
-          index_entry.end(), event_id_list.begin(), event_id_list.end());
+      context.block_buckets.erase(event_time);
     }
 
     cleanup_events = (((event_count_ % kEventsCheckpoint) + row_list.size()) >
@@ -214,6 +635,10 @@ bool EventSubscriberPlugin::shouldOptimize() const {
   return isDaemon() && FLAGS_events_optimize;
 }
 
+bool EventSubscriberPlugin::usesEventBlocks() const {
+  return false;
+}
+
 void EventSubscriberPlugin::resetQueryCount(size_t count) {
   WriteLock subscriber_lock(event_query_record_);
   queries_.clear();
@@ -253,15 +678,17 @@ uint64_t EventSubscriberPlugin::getExpireTime() {
 
 void EventSubscriberPlugin::generateRows(std::function<void(Row)> callback,
                                          bool can_optimize,
+                                         const std::string& query_name,
                                          EventTime start_time,
-                                         EventTime stop_time) {
+                                         EventTime stop_time,
+                                         EventID start_eid,
+                                         EventID stop_eid) {
   EventTime optimize_time{0U};
   EventID optimize_eid{0U};
   if (can_optimize && shouldOptimize()) {
     // If the daemon is querying a subscriber without a 'time' constraint and
     // allows optimization, only emit events since the last query.
-    std::string query_name;
-    getOptimizeData(getDatabase(), optimize_time, optimize_eid, query_name);
+    getOptimizeData(getDatabase(), query_name, optimize_time, optimize_eid);
     start_time = optimize_time == 0 ? 0 : optimize_time - 1;
 
     // Track the queries that have selected data.
@@ -269,17 +696,19 @@ void EventSubscriberPlugin::generateRows(std::function<void(Row)> callback,
   }
 
   {
+    auto last_eid = std::max(optimize_eid, start_eid == 0 ? 0 : start_eid - 1);
     auto last = generateRows(this->context,
                              getDatabase(),
                              callback,
                              start_time,
                              stop_time,
-                             optimize_eid);
+                             last_eid,
+                             stop_eid);
 
     if (can_optimize && shouldOptimize()) {
       if (last != this->context.event_index.end()) {
         auto last_eid = last->second.empty() ? 0 : last->second.back();
-        setOptimizeData(getDatabase(), last->first, last_eid);
+        setOptimizeData(getDatabase(), query_name, last->first, last_eid);
       }
     }
   }
@@ -291,34 +720,42 @@ void EventSubscriberPlugin::generateRows(std::function<void(Row)> callback,
 }
 
 void EventSubscriberPlugin::genTable(RowYield& yield, QueryContext& context) {
-  // Stop is an unsigned (-1), our end of time equivalent.
-  EventTime start = 0, stop = 0;
-  bool can_optimize{true};
-  if (context.constraints["time"].getAll().size() > 0) {
-    can_optimize = false;
-    // Use the 'time' constraint to optimize backing-store lookups.
-    for (const auto& constraint : context.constraints["time"].getAll()) {
-      EventTime expr = timeFromRecord(constraint.expr);
-      if (constraint.op == EQUALS) {
-        stop = start = expr;
-        break;
-      } else if (constraint.op == GREATER_THAN) {
-        start = std::max(start, expr + 1);
-      } else if (constraint.op == GREATER_THAN_OR_EQUALS) {
-        start = std::max(start, expr);
-      } else if (constraint.op == LESS_THAN) {
-        stop = std::min(stop, expr - 1);
-      } else if (constraint.op == LESS_THAN_OR_EQUALS) {
-        stop = std::min(stop, expr);
-      }
-    }
+  // The time and eid constraints select the time buckets and the events to
+  // read, SQLite still filters the generated rows. xBestIndex only passes
+  // them for INTEGER and BIGINT columns, a TEXT eid is never narrowed.
+  auto& time_constraints = context.constraints["time"];
+  auto& eid_constraints = context.constraints["eid"];
+  auto can_optimize =
+      time_constraints.getAll().empty() && eid_constraints.getAll().empty();
+
+  std::uint64_t start = 0, stop = std::numeric_limits<std::uint64_t>::max();
+  std::uint64_t start_eid = 0,
+                stop_eid = std::numeric_limits<std::uint64_t>::max();
+  if (!narrowConstraintRange(time_constraints, start, stop) ||
+      !narrowConstraintRange(eid_constraints, start_eid, stop_eid)) {
+    return;
   }
 
   auto generateRowsCallback = [&yield](Row row) {
     yield(TableRowHolder(new DynamicTableRow(std::move(row))));
   };
 
-  generateRows(generateRowsCallback, can_optimize, start, stop);
+  // A stop of 0 means no upper bound, as with a (-1) end of time.
+  if (stop == std::numeric_limits<std::uint64_t>::max()) {
+    stop = 0;
+  }
+  if (stop_eid == std::numeric_limits<std::uint64_t>::max()) {
+    stop_eid = 0;
+  }
+
+  // Scheduled queries execute concurrently, each on its own thread.
+  generateRows(generateRowsCallback,
+               can_optimize,
+               Config::getExecutingQuery(),
+               start,
+               stop,
+               start_eid,
+               stop_eid);
 }
 
 size_t EventSubscriberPlugin::numSubscriptions() const {
@@ -343,12 +780,10 @@ std::string EventSubscriberPlugin::toIndex(std::uint64_t i) {
 }
 
 void EventSubscriberPlugin::setOptimizeData(IDatabaseInterface& db_interface,
+                                            const std::string& query_name,
                                             EventTime time,
                                             EventID eid) {
   // Store the optimization time and eid.
-  std::string query_name;
-  db_interface.getDatabaseValue(
-      kPersistentSettings, kExecutingQuery, query_name);
   if (query_name.empty()) {
     return;
   }
@@ -366,13 +801,10 @@ EventTime EventSubscriberPlugin::timeFromRecord(const std::string& record) {
 }
 
 void EventSubscriberPlugin::getOptimizeData(IDatabaseInterface& db_interface,
+                                            const std::string& query_name,
                                             EventTime& o_time,
-                                            EventID& o_eid,
-                                            std::string& query_name) {
-  // Read the optimization time for the current executing query.
-  db_interface.getDatabaseValue(
-      kPersistentSettings, kExecutingQuery, query_name);
-
+                                            EventID& o_eid) {
+  // Read the optimization time for the query.
   if (query_name.empty()) {
     o_time = 0;
     o_eid = 0;
@@ -406,73 +838,106 @@ void EventSubscriberPlugin::setDatabaseNamespace(Context& context,
 
 Status EventSubscriberPlugin::generateEventDataIndex(
     Context& context, IDatabaseInterface& db_interface) {
-  std::vector<std::string> key_list;
+  auto status = loadPersistedEventIndex(context, db_interface);
+  if (status.ok()) {
+    return status;
+  }
 
-  std::string prefix = "data." + context.database_namespace + ".";
-  auto status = db_interface.scanDatabaseKeys(kEvents, key_list, prefix, 0);
+  VLOG(1) << "Rebuilding the event index for subscriber "
+          << context.database_namespace << ": " << status.getMessage();
+
+  status = rebuildEventDataIndex(context, db_interface);
   if (!status.ok()) {
     return status;
   }
 
+  return persistEventIndex(context, db_interface);
+}
+
+Status EventSubscriberPlugin::rebuildEventDataIndex(
+    Context& context, IDatabaseInterface& db_interface) {
   std::vector<std::string> invalid_data_key_list;
   std::size_t event_count{0U};
 
   EventID last_event_id{1U};
   EventIndex event_index;
 
-  for (const auto& key : key_list) {
-    auto string_event_id = &key[prefix.size()];
-
-    EventID event_identifier = {};
-
-    {
-      char* null_terminator = nullptr;
-      auto int_value = std::strtoull(string_event_id, &null_terminator, 10);
-      if (int_value == 0U || null_terminator == nullptr ||
-          *null_terminator != '\0') {
-        invalid_data_key_list.push_back(key);
-        continue;
-      }
-
-      event_identifier = static_cast<EventID>(int_value);
-    }
-
-    last_event_id = std::max(last_event_id, event_identifier);
-
-    EventTime event_time = {};
-
-    {
-      std::string serialized_row;
-      status = db_interface.getDatabaseValue(kEvents, key, serialized_row);
-      if (!status.ok()) {
-        invalid_data_key_list.push_back(key);
-        continue;
-      }
-
-      Row row;
-      if (!deserializeRowJSON(serialized_row, row)) {
-        invalid_data_key_list.push_back(key);
-        continue;
-      }
-
-      if (row.count("time") == 0) {
-        invalid_data_key_list.push_back(key);
-        continue;
-      }
-
-      event_time = boost::lexical_cast<EventTime>(row.at("time"));
-    }
-
-    auto it = event_index.find(event_time);
-    if (it == event_index.end()) {
-      auto insert_status = event_index.insert({event_time, {}});
-      it = insert_status.first;
-    }
+  // The keys and values are read together, in key order.
+  std::string prefix = "data." + context.database_namespace + ".";
+  auto status = db_interface.scanDatabasePrefix(
+      kEvents,
+      prefix,
+      [&](const std::string& key, const std::string& serialized_row) {
+        auto string_event_id = &key[prefix.size()];
+
+        char* null_terminator = nullptr;
+        auto int_value = std::strtoull(string_event_id, &null_terminator, 10);
+        if (int_value == 0U || null_terminator == nullptr ||
+            *null_terminator != '\0') {
+          invalid_data_key_list.push_back(key);
+          return true;
+        }
+
+        auto event_identifier = static_cast<EventID>(int_value);
+        last_event_id = std::max(last_event_id, event_identifier);
+
+        Row row;
+        if (!deserializeRowJSON(serialized_row, row) ||
+            row.count("time") == 0) {
+          invalid_data_key_list.push_back(key);
+          return true;
+        }
+
+        auto event_time = boost::lexical_cast<EventTime>(row.at("time"));
+        event_index[event_time].push_back(event_identifier);
+        ++event_count;
+        return true;
+      });
+  if (!status.ok()) {
+    return status;
+  }
 
-    auto& event_id_list = it->second;
-    event_id_list.push_back(event_identifier);
+  std::set<EventTime> block_buckets;
+
+  prefix = kEventBlockPrefix + context.database_namespace + ".";
+  status = db_interface.scanDatabasePrefix(
+      kEvents, prefix, [&](const std::string& key, const std::string& block) {
+        // Only the EventIDs are needed, skip decoding the rows.
+        EventTime event_time{0U};
+        EventIDList block_event_id_list;
+        std::vector<Row> row_list;
+        auto block_status =
+            deserializeEventBlock(block,
+                                  std::numeric_limits<EventID>::max(),
+                                  event_time,
+                                  block_event_id_list,
+                                  row_list);
+        if (!block_status.ok() || block_event_id_list.empty() ||
+            key != databaseKeyForEventBlock(
+                       context, event_time, block_event_id_list.front())) {
+          invalid_data_key_list.push_back(key);
+          return true;
+        }
+
+        last_event_id = std::max(last_event_id, block_event_id_list.back());
+
+        auto& event_id_list = event_index[event_time];
+        event_id_list.insert(event_id_list.end(),
+                             block_event_id_list.begin(),
+                             block_event_id_list.end());
+        block_buckets.insert(event_time);
+
+        event_count += block_event_id_list.size();
+        return true;
+      });
+  if (!status.ok()) {
+    return status;
+  }
 
-    ++event_count;
+  // Concurrent batches of a bucket may interleave their EventIDs.
+  for (auto event_time : block_buckets) {
+    auto& event_id_list = event_index[event_time];
+    std::sort(event_id_list.begin(), event_id_list.end());
   }
 
   if (!invalid_data_key_list.empty()) {
@@ -495,10 +960,43 @@ Status EventSubscriberPlugin::generateEventDataIndex(
 
   context.last_event_id = last_event_id;
   context.event_index = std::move(event_index);
+  context.unloaded_buckets.clear();
+  context.block_buckets = std::move(block_buckets);
 
   return Status::success();
 }
 
+void EventSubscriberPlugin::loadEventIndexBucket(
+    Context& context,
+    IDatabaseInterface& db_interface,
+    EventIndex::iterator bucket) {
+  if (context.unloaded_buckets.erase(bucket->first) == 0U) {
+    return;
+  }
+
+  auto key = databaseKeyForEventTime(context, bucket->first);
+  std::string serialized;
+  auto status = db_interface.getDatabaseValue(kEvents, key, serialized);
+
+  auto block_bucket = serialized.compare(0,
+                                         kEventBlockBucketMarker.size(),
+                                         kEventBlockBucketMarker) == 0;
+  if (block_bucket) {
+    serialized.erase(0, kEventBlockBucketMarker.size());
+  }
+
+  if (!status.ok() || !deserializeEventIDList(serialized, bucket->second)) {
+    // The bucket's events can no longer be found through the index.
+    VLOG(1) << "Invalid event index bucket: " << key;
+    bucket->second.clear();
+    return;
+  }
+
+  if (block_bucket) {
+    context.block_buckets.insert(bucket->first);
+  }
+}
+
 std::string EventSubscriberPlugin::databaseKeyForEventId(Context& context,
                                                          EventID event_id) {
   auto string_event_id = toIndex(event_id);
@@ -507,6 +1005,271 @@ std::string EventSubscriberPlugin::databaseKeyForEventId(Context& context,
          string_event_id;
 }
 
+std::string EventSubscriberPlugin::databaseKeyForEventTime(
+    Context& context, EventTime event_time) {
+  return std::string(kEventIndexPrefix) + context.database_namespace + "." +
+         toIndex(event_time);
+}
+
+std::string EventSubscriberPlugin::databaseKeyForLastEventId(
+    Context& context) {
+  return std::string(kLastEventIdPrefix) + context.database_namespace;
+}
+
+std::string EventSubscriberPlugin::databaseKeyForEventBlock(
+    Context& context, EventTime event_time, EventID first_event_id) {
+  return databaseKeyPrefixForEventBlocks(context, event_time) +
+         toIndex(first_event_id);
+}
+
+std::string EventSubscriberPlugin::databaseKeyPrefixForEventBlocks(
+    Context& context, EventTime event_time) {
+  return std::string(kEventBlockPrefix) + context.database_namespace + "." +
+         toIndex(event_time) + ".";
+}
+
+std::string EventSubscriberPlugin::serializeEventIDList(
+    const EventIDList& event_id_list) {
+  // Events within a batch have consecutive ids, store them as ranges.
+  std::string serialized;
+  for (std::size_t i = 0U; i < event_id_list.size();) {
+    auto first = event_id_list[i];
+    auto last = first;
+    while (++i < event_id_list.size() && event_id_list[i] == last + 1) {
+      ++last;
+    }
+
+    if (!serialized.empty()) {
+      serialized += ',';
+    }
+    serialized += std::to_string(first);
+    if (last != first) {
+      serialized += '-' + std::to_string(last);
+    }
+  }
+  return serialized;
+}
+
+bool EventSubscriberPlugin::deserializeEventIDList(
+    const std::string& serialized, EventIDList& event_id_list) {
+  event_id_list.clear();
+
+  const char* current = serialized.c_str();
+  while (*current != '\0') {
+    char* end = nullptr;
+    auto first = std::strtoull(current, &end, 10);
+    if (end == current) {
+      return false;
+    }
+
+    auto last = first;
+    if (*end == '-') {
+      current = end + 1;
+      last = std::strtoull(current, &end, 10);
+      if (end == current || last < first) {
+        return false;
+      }
+    }
+
+    for (auto event_id = first; event_id <= last; ++event_id) {
+      event_id_list.push_back(static_cast<EventID>(event_id));
+    }
+
+    if (*end == ',') {
+      ++end;
+    } else if (*end != '\0') {
+      return false;
+    }
+    current = end;
+  }
+
+  return true;
+}
+
+Status EventSubscriberPlugin::serializeEventBlock(
+    EventTime event_time,
+    const EventIDList& event_id_list,
+    const std::vector<Row>& row_list,
+    bool compress,
+    std::string& block) {
+  block.clear();
+  if (row_list.empty() || event_id_list.size() != row_list.size()) {
+    return Status::failure("Each event in a block needs an EventID");
+  }
+
+  std::unordered_map<std::string, std::uint64_t> column_index_map;
+  std::string column_list;
+  std::string event_list;
+
+  EventID previous_event_id{0U};
+  for (std::size_t i = 0U; i < row_list.size(); ++i) {
+    auto event_id = event_id_list[i];
+    if (event_id <= previous_event_id) {
+      return Status::failure("The EventIDs of a block must be increasing");
+    }
+
+    appendVarint(event_list, event_id - previous_event_id);
+    previous_event_id = event_id;
+
+    const auto& row = row_list[i];
+    appendVarint(event_list,
+                 row.size() - row.count("time") - row.count("eid"));
+
+    for (const auto& column : row) {
+      if (column.first == "time" || column.first == "eid") {
+        continue;
+      }
+
+      auto column_index_it = column_index_map.find(column.first);
+      if (column_index_it == column_index_map.end()) {
+        auto column_index = column_index_map.size();
+        column_index_it =
+            column_index_map.insert({column.first, column_index}).first;
+        appendString(column_list, column.first);
+      }
+
+      appendVarint(event_list, column_index_it->second);
+      appendString(event_list, column.second);
+    }
+  }
+
+  std::string payload;
+  payload.reserve(column_list.size() + event_list.size() + 32U);
+  appendVarint(payload, event_time);
+  appendVarint(payload, column_index_map.size());
+  payload += column_list;
+  appendVarint(payload, row_list.size());
+  payload += event_list;
+
+  block.push_back(kEventBlockVersion);
+
+  if (compress) {
+    std::string compressed(ZSTD_compressBound(payload.size()), '\0');
+    auto compressed_size = ZSTD_compress(&compressed[0],
+                                         compressed.size(),
+                                         payload.data(),
+                                         payload.size(),
+                                         1);
+    if (!ZSTD_isError(compressed_size) && compressed_size < payload.size()) {
+      block.push_back(kEventBlockZstd);
+      block.append(compressed.data(), compressed_size);
+      return Status::success();
+    }
+  }
+
+  block.push_back(kEventBlockUncompressed);
+  block += payload;
+  return Status::success();
+}
+
+Status EventSubscriberPlugin::deserializeEventBlock(
+    const std::string& block,
+    EventID last_eid,
+    EventTime& event_time,
+    EventIDList& event_id_list,
+    std::vector<Row>& row_list) {
+  event_id_list.clear();
+  row_list.clear();
+
+  if (block.size() < 2U || block[0] != kEventBlockVersion) {
+    return Status::failure("Unsupported event block format");
+  }
+
+  const char* data = block.data() + 2U;
+  std::size_t size = block.size() - 2U;
+
+  std::string payload;
+  if (block[1] == kEventBlockZstd) {
+    auto payload_size = ZSTD_getFrameContentSize(data, size);
+    if (payload_size == ZSTD_CONTENTSIZE_UNKNOWN ||
+        payload_size == ZSTD_CONTENTSIZE_ERROR ||
+        payload_size > kMaxEventBlockSize) {
+      return Status::failure("Invalid compressed event block");
+    }
+
+    payload.resize(static_cast<std::size_t>(payload_size));
+    auto result = ZSTD_decompress(&payload[0], payload.size(), data, size);
+    if (ZSTD_isError(result) || result != payload.size()) {
+      return Status::failure("Failed to decompress the event block");
+    }
+
+    data = payload.data();
+    size = payload.size();
+
+  } else if (block[1] != kEventBlockUncompressed) {
+    return Status::failure("Unsupported event block compression");
+  }
+
+  EventBlockReader reader(data, size);
+
+  std::uint64_t block_event_time{0U};
+  std::uint64_t column_count{0U};
+  if (!reader.readVarint(block_event_time) ||
+      !reader.readVarint(column_count) || column_count > reader.remaining()) {
+    return Status::failure("Invalid event block header");
+  }
+
+  std::vector<std::string> column_list(static_cast<std::size_t>(column_count));
+  for (auto& column : column_list) {
+    if (!reader.readString(column)) {
+      return Status::failure("Invalid event block columns");
+    }
+  }
+
+  std::uint64_t event_count{0U};
+  if (!reader.readVarint(event_count) || event_count > reader.remaining()) {
+    return Status::failure("Invalid event block header");
+  }
+
+  auto string_event_time = std::to_string(block_event_time);
+  event_id_list.reserve(static_cast<std::size_t>(event_count));
+
+  EventID event_id{0U};
+  for (std::uint64_t i = 0U; i < event_count; ++i) {
+    std::uint64_t event_id_delta{0U};
+    std::uint64_t field_count{0U};
+    if (!reader.readVarint(event_id_delta) || event_id_delta == 0U ||
+        !reader.readVarint(field_count)) {
+      return Status::failure("Invalid event in block");
+    }
+
+    event_id += event_id_delta;
+    event_id_list.push_back(event_id);
+
+    // A previous optimized query has already visited this event.
+    auto skip_row = event_id <= last_eid;
+
+    Row row;
+    for (std::uint64_t j = 0U; j < field_count; ++j) {
+      std::uint64_t column_index{0U};
+      if (!reader.readVarint(column_index) ||
+          column_index >= column_list.size()) {
+        return Status::failure("Invalid event column in block");
+      }
+
+      auto valid = skip_row
+                       ? reader.skipString()
+                       : reader.readString(row[column_list[column_index]]);
+      if (!valid) {
+        return Status::failure("Invalid event value in block");
+      }
+    }
+
+    if (!skip_row) {
+      row["time"] = string_event_time;
+      row["eid"] = toIndex(event_id);
+      row_list.push_back(std::move(row));
+    }
+  }
+
+  if (reader.remaining() != 0U) {
+    return Status::failure("Unexpected data after the event block");
+  }
+
+  event_time = static_cast<EventTime>(block_event_time);
+  return Status::success();
+}
+
 void EventSubscriberPlugin::removeOverflowingEventBatches(
     Context& context,
     IDatabaseInterface& db_interface,
@@ -516,6 +1279,7 @@ void EventSubscriberPlugin::removeOverflowingEventBatches(
   }
 
   EventIndex excess_event_batch_list;
+  std::set<EventTime> excess_block_buckets;
 
   {
     WriteLock lock(context.event_index_mutex);
@@ -526,6 +1290,15 @@ void EventSubscriberPlugin::removeOverflowingEventBatches(
     auto batches_to_remove = context.event_index.size() - max_event_batches;
     auto range_start = context.event_index.begin();
     auto range_end = std::next(range_start, batches_to_remove);
+    for (auto it = range_start; it != range_end; ++it) {
+      loadEventIndexBucket(context, db_interface, it);
+    }
+
+    for (auto it = range_start; it != range_end; ++it) {
+      if (context.block_buckets.erase(it->first) != 0U) {
+        excess_block_buckets.insert(it->first);
+      }
+    }
 
     excess_event_batch_list.insert(std::make_move_iterator(range_start),
                                    std::make_move_iterator(range_end));
@@ -554,9 +1327,18 @@ void EventSubscriberPlugin::removeOverflowingEventBatches(
   }
 
   std::size_t batches_removed{};
+  std::size_t block_error_count{};
   for (const auto& p : excess_event_batch_list) {
     const auto& event_identifier_list = p.second;
 
+    if (excess_block_buckets.count(p.first) != 0U) {
+      batches_removed +=
+          deleteEventBlocks(context, db_interface, p.first, block_error_count);
+      db_interface.deleteDatabaseValue(
+          kEvents, databaseKeyForEventTime(context, p.first));
+      continue;
+    }
+
     for (auto event_id : event_identifier_list) {
       auto key = databaseKeyForEventId(context, event_id);
       auto status = db_interface.deleteDatabaseValue(kEvents, key);
@@ -564,6 +1346,14 @@ void EventSubscriberPlugin::removeOverflowingEventBatches(
         ++batches_removed;
       }
     }
+
+    db_interface.deleteDatabaseValue(kEvents,
+                                     databaseKeyForEventTime(context, p.first));
+  }
+
+  if (block_error_count != 0U) {
+    LOG(ERROR) << "Failed to remove " << block_error_count
+               << " event blocks due to database errors";
   }
 
   auto failed_delete_count = (excess_event_batch_list.size() - batches_removed);
@@ -591,6 +1381,7 @@ void EventSubscriberPlugin::expireEventBatches(Context& context,
   }
 
   EventIndex expired_event_batch_list;
+  std::set<EventTime> expired_block_buckets;
 
   {
     WriteLock lock(context.event_index_mutex);
@@ -607,6 +1398,15 @@ void EventSubscriberPlugin::expireEventBatches(Context& context,
 
     auto range_start = context.event_index.begin();
     auto range_end = context.event_index.upper_bound(oldest_valid_time);
+    for (auto it = range_start; it != range_end; ++it) {
+      loadEventIndexBucket(context, db_interface, it);
+    }
+
+    for (auto it = range_start; it != range_end; ++it) {
+      if (context.block_buckets.erase(it->first) != 0U) {
+        expired_block_buckets.insert(it->first);
+      }
+    }
 
     expired_event_batch_list.insert(std::make_move_iterator(range_start),
                                     std::make_move_iterator(range_end));
@@ -620,13 +1420,25 @@ void EventSubscriberPlugin::expireEventBatches(Context& context,
   for (const auto& p : expired_event_batch_list) {
     const auto& event_identifier_list = p.second;
 
-    for (const auto& event_identifier : event_identifier_list) {
-      auto key = databaseKeyForEventId(context, event_identifier);
-      auto status = db_interface.deleteDatabaseValue(kEvents, key);
-      if (!status.ok()) {
-        ++error_count;
+    // Whole blocks are deleted instead of each of their events.
+    if (expired_block_buckets.count(p.first) != 0U) {
+      deleteEventBlocks(context, db_interface, p.first, error_count);
+
+    } else {
+      for (const auto& event_identifier : event_identifier_list) {
+        auto key = databaseKeyForEventId(context, event_identifier);
+        auto status = db_interface.deleteDatabaseValue(kEvents, key);
+        if (!status.ok()) {
+          ++error_count;
+        }
       }
     }
+
+    auto status = db_interface.deleteDatabaseValue(
+        kEvents, databaseKeyForEventTime(context, p.first));
+    if (!status.ok()) {
+      ++error_count;
+    }
   }
 
   if (error_count > 0U) {
@@ -635,13 +1447,55 @@ void EventSubscriberPlugin::expireEventBatches(Context& context,
   }
 }
 
+void EventSubscriberPlugin::generateBlockRows(
+    Context& context,
+    IDatabaseInterface& db_interface,
+    const std::function<void(Row)>& callback,
+    EventTime event_time,
+    EventID last_eid,
+    EventID end_eid,
+    std::vector<std::string>& invalid_key_list) {
+  EventIDList event_id_list;
+  std::vector<Row> row_list;
+  auto status = db_interface.scanDatabasePrefix(
+      kEvents,
+      databaseKeyPrefixForEventBlocks(context, event_time),
+      [&](const std::string& key, const std::string& block) {
+        EventTime block_event_time{0U};
+        auto block_status = deserializeEventBlock(
+            block, last_eid, block_event_time, event_id_list, row_list);
+        if (!block_status.ok()) {
+          invalid_key_list.push_back(key);
+          return true;
+        }
+
+        // The rows are decoded for the events after the last EventID.
+        auto row_it = row_list.begin();
+        for (auto event_id : event_id_list) {
+          if (event_id <= last_eid) {
+            continue;
+          }
+
+          if (end_eid == 0U || event_id <= end_eid) {
+            callback(std::move(*row_it));
+          }
+          ++row_it;
+        }
+        return true;
+      });
+  if (!status.ok()) {
+    VLOG(1) << "Failed to scan the event blocks: " << status.getMessage();
+  }
+}
+
 EventIndex::iterator EventSubscriberPlugin::generateRows(
     Context& context,
     IDatabaseInterface& db_interface,
     std::function<void(Row)> callback,
     EventTime start_time,
     EventTime end_time,
-    EventID last_eid) {
+    EventID last_eid,
+    EventID end_eid) {
   auto last = context.event_index.end();
   if (end_time != 0 && start_time > end_time) {
     return last;
@@ -662,15 +1516,56 @@ EventIndex::iterator EventSubscriberPlugin::generateRows(
                             ? context.event_index.end()
                             : context.event_index.upper_bound(end_time);
 
+  std::set<EventTime> block_buckets;
+  std::size_t bucket_count{0U};
+
+  {
+    WriteLock lock(context.event_index_mutex);
+    bucket_count = context.event_index.size();
+    for (auto it = lower_bound_it; it != upper_bound_it; ++it) {
+      loadEventIndexBucket(context, db_interface, it);
+      if (context.block_buckets.count(it->first) != 0U) {
+        block_buckets.insert(block_buckets.end(), it->first);
+      }
+    }
+  }
+
+  std::size_t scanned_bucket_count{0U};
   std::vector<std::string> invalid_key_list;
   for (auto it = lower_bound_it; it != upper_bound_it; ++it) {
     const auto& event_id_list = it->second;
+    last = it;
+
+    // Only read the buckets holding events within the EventID range.
+    auto event_id_range =
+        std::minmax_element(event_id_list.begin(), event_id_list.end());
+    if (event_id_list.empty() || *event_id_range.second <= last_eid ||
+        (end_eid != 0U && *event_id_range.first > end_eid)) {
+      continue;
+    }
+    ++scanned_bucket_count;
+
+    if (block_buckets.count(it->first) != 0U) {
+      generateBlockRows(context,
+                        db_interface,
+                        callback,
+                        it->first,
+                        last_eid,
+                        end_eid,
+                        invalid_key_list);
+      continue;
+    }
 
     for (const auto& event_identifier : event_id_list) {
       if (last_eid >= event_identifier) {
         // A previous optimized query has already visited this event.
         continue;
       }
+
+      if (end_eid != 0U && event_identifier > end_eid) {
+        continue;
+      }
+
       auto key = databaseKeyForEventId(context, event_identifier);
 
       std::string serialized_row;
@@ -689,7 +1584,11 @@ EventIndex::iterator EventSubscriberPlugin::generateRows(
 
       callback(std::move(row));
     }
-    last = it;
+  }
+
+  if (FLAGS_planner) {
+    planScannedBuckets(
+        context.database_namespace, scanned_bucket_count, bucket_count);
   }
 
   if (!invalid_key_list.empty()) {
@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include <set>
+
 #include <gtest/gtest_prod.h>
 
 #include <osquery/core/plugins/plugin.h>
@@ -114,6 +116,15 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
   /// Determine if the subscriber should attempt optmization.
   virtual bool shouldOptimize() const;
 
+  /**
+   * @brief Determine if events are stored as binary blocks.
+   *
+   * The default implementation stores each event as its own JSON value. High
+   * volume subscribers override this to store each batch of events as a
+   * single block within its time bucket, see serializeEventBlock.
+   */
+  virtual bool usesEventBlocks() const;
+
   /**
    * @brief Return all events added by this EventSubscriber within start, stop.
    *
@@ -121,14 +132,21 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
    *
    * @param callback A callback encapsulating Row yield method.
    * @param can_optimize If true then optimization can be considered.
+   * @param query_name The scheduled query reading the events, the optimization
+   * continues from the last events read by this query.
    * @param start_time Inclusive lower bound time limit.
    * @param end_time Inclusive upper bound time limit.
+   * @param start_eid (optional) Inclusive lower bound EventID.
+   * @param stop_eid (optional) Inclusive upper bound EventID, 0 for none.
    * @return Set of event rows matching time limits.
    */
   void generateRows(std::function<void(Row)> callback,
                     bool can_optimize,
+                    const std::string& query_name,
                     EventTime start_time,
-                    EventTime stop_stop);
+                    EventTime stop_stop,
+                    EventID start_eid = 0,
+                    EventID stop_eid = 0);
 
   /// Track a query execution.
   virtual void setExecutedQuery(const std::string& query_name,
@@ -186,6 +204,12 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
     EventIndex event_index;
     Mutex event_index_mutex;
 
+    /// Time buckets whose EventID%s have not been read from the database yet.
+    std::set<EventTime> unloaded_buckets;
+
+    /// Loaded time buckets whose events are stored as blocks.
+    std::set<EventTime> block_buckets;
+
     std::size_t last_query_time{0U};
     std::atomic<EventID> last_event_id{0U};
   };
@@ -193,15 +217,16 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
   static std::string toIndex(std::uint64_t i);
 
   static void setOptimizeData(IDatabaseInterface& db_interface,
+                              const std::string& query_name,
                               EventTime time,
                               EventID eid);
 
   static EventTime timeFromRecord(const std::string& record);
 
   static void getOptimizeData(IDatabaseInterface& db_interface,
+                              const std::string& query_name,
                               EventTime& o_time,
-                              EventID& o_eid,
-                              std::string& query_name);
+                              EventID& o_eid);
 
   static EventID generateEventIdentifier(Context& context);
 
@@ -209,11 +234,79 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
                                    const std::string& type,
                                    const std::string& name);
 
+  /**
+   * @brief Load the persisted time index, or rebuild it from the event data.
+   *
+   * The time index is persisted as one key per time bucket. Only the bucket
+   * keys are scanned here, the EventID%s of a bucket are read on first use.
+   * Events stored without an index, for example by an older version, cause a
+   * full rebuild which then persists the index.
+   */
   static Status generateEventDataIndex(Context& context,
                                        IDatabaseInterface& db_interface);
 
+  /// Rebuild the time index by reading every stored event.
+  static Status rebuildEventDataIndex(Context& context,
+                                      IDatabaseInterface& db_interface);
+
+  /**
+   * @brief Read the EventID%s of a time bucket if they were not loaded yet.
+   *
+   * The caller must hold the context's event_index_mutex.
+   */
+  static void loadEventIndexBucket(Context& context,
+                                   IDatabaseInterface& db_interface,
+                                   EventIndex::iterator bucket);
+
   static std::string databaseKeyForEventId(Context& context, EventID event_id);
 
+  static std::string databaseKeyForEventTime(Context& context,
+                                             EventTime event_time);
+
+  static std::string databaseKeyForLastEventId(Context& context);
+
+  /// The key of the block of events starting with first_event_id.
+  static std::string databaseKeyForEventBlock(Context& context,
+                                              EventTime event_time,
+                                              EventID first_event_id);
+
+  /// The key prefix of all the blocks of a time bucket.
+  static std::string databaseKeyPrefixForEventBlocks(Context& context,
+                                                     EventTime event_time);
+
+  /// Serialize a time bucket's EventID%s as a list of ranges.
+  static std::string serializeEventIDList(const EventIDList& event_id_list);
+
+  static bool deserializeEventIDList(const std::string& serialized,
+                                     EventIDList& event_id_list);
+
+  /**
+   * @brief Serialize a batch of events sharing an event time as one block.
+   *
+   * The block starts with a dictionary of the column names, followed by each
+   * event as a varint EventID delta and its columns as varint dictionary
+   * indexes and length-prefixed values. The time and eid columns are not
+   * stored, they are restored from the block. The encoded events are zstd
+   * compressed when asked to, unless that does not make them smaller.
+   */
+  static Status serializeEventBlock(EventTime event_time,
+                                    const EventIDList& event_id_list,
+                                    const std::vector<Row>& row_list,
+                                    bool compress,
+                                    std::string& block);
+
+  /**
+   * @brief Deserialize a block of events.
+   *
+   * Every EventID in the block is returned, but rows are only decoded for the
+   * events after last_eid.
+   */
+  static Status deserializeEventBlock(const std::string& block,
+                                      EventID last_eid,
+                                      EventTime& event_time,
+                                      EventIDList& event_id_list,
+                                      std::vector<Row>& row_list);
+
   static void removeOverflowingEventBatches(Context& context,
                                             IDatabaseInterface& db_interface,
                                             std::size_t max_event_batches);
@@ -234,6 +327,7 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
    * @param start_time Inclusive lower bound time limit.
    * @param end_time Inclusive upper bound time limit.
    * @param last_eid (optional) The last visited event id.
+   * @param end_eid (optional) Inclusive upper bound event id, 0 for none.
    * @return The upper bound time or 0 if there were no events in the range.
    */
   static EventIndex::iterator generateRows(Context& context,
@@ -241,7 +335,17 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
                                            std::function<void(Row)> callback,
                                            EventTime start_time,
                                            EventTime end_time,
-                                           EventID last_eid = 0);
+                                           EventID last_eid = 0,
+                                           EventID end_eid = 0);
+
+  /// Decode the blocks of a time bucket, collecting the invalid block keys.
+  static void generateBlockRows(Context& context,
+                                IDatabaseInterface& db_interface,
+                                const std::function<void(Row)>& callback,
+                                EventTime event_time,
+                                EventID last_eid,
+                                EventID end_eid,
+                                std::vector<std::string>& invalid_key_list);
 
   explicit EventSubscriberPlugin(EventSubscriberPlugin const&) = delete;
   EventSubscriberPlugin& operator=(EventSubscriberPlugin const&) = delete;
@@ -330,6 +434,7 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
   FRIEND_TEST(EventSubscriberPluginTests, getEventsExpiry);
   FRIEND_TEST(EventSubscriberPluginTests, generateRowsWithExpiry);
   FRIEND_TEST(EventSubscriberPluginTests, generateRowsWithOptimize);
+  FRIEND_TEST(EventSubscriberPluginTests, addBatchWithBlocks);
 
   friend class DBFakeEventSubscriber;
   friend class BenchmarkEventSubscriber;
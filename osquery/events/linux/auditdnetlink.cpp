@@ -10,13 +10,17 @@
 #include <libaudit.h>
 #include <linux/audit.h>
 #include <poll.h>
+#include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstring>
 #include <iostream>
-
-#include <boost/utility/string_ref.hpp>
+#include <iterator>
 
 #include <osquery/core/flags.h>
 #include <osquery/events/linux/apparmor_events.h>
@@ -70,41 +74,45 @@ DECLARE_bool(audit_allow_seccomp_events);
 
 namespace {
 
-const std::string kAppArmorRecordMarker{"apparmor="};
+const std::string_view kAppArmorRecordMarker{"apparmor="};
+
+/// How many messages are received with a single recvmmsg call.
+const std::size_t kAuditReadBatchSize{64U};
+
+/// How many messages are received before handing them to the parser.
+const std::size_t kAuditMaxMessagesPerRead{4096U};
 
-bool IsSELinuxRecord(const audit_reply& reply) noexcept {
+bool IsSELinuxRecord(int type, std::string_view message) noexcept {
   static const auto& selinux_event_set = kSELinuxEventList;
-  return (selinux_event_set.find(reply.type) != selinux_event_set.end()) &&
-         (std::string(reply.message).find(kAppArmorRecordMarker) ==
-          std::string::npos);
+  return (selinux_event_set.find(type) != selinux_event_set.end()) &&
+         (message.find(kAppArmorRecordMarker) == std::string_view::npos);
 }
 
-bool isAppArmorRecord(const audit_reply& reply) noexcept {
+bool isAppArmorRecord(int type, std::string_view message) noexcept {
   static const auto& apparmor_event_set = kAppArmorEventSet;
 
-  return (apparmor_event_set.find(reply.type) != apparmor_event_set.end()) &&
-         (std::string(reply.message).find(kAppArmorRecordMarker) !=
-          std::string::npos);
+  return (apparmor_event_set.find(type) != apparmor_event_set.end()) &&
+         (message.find(kAppArmorRecordMarker) != std::string_view::npos);
 }
 
 /**
  * User messages should be filtered. Also, we should handle the 2nd user
  * message type.
  */
-bool ShouldHandle(const audit_reply& reply) noexcept {
-  if (isAppArmorRecord(reply)) {
+bool ShouldHandle(int type, std::string_view message) noexcept {
+  if (isAppArmorRecord(type, message)) {
     return FLAGS_audit_allow_apparmor_events;
   }
 
-  if (IsSELinuxRecord(reply)) {
+  if (IsSELinuxRecord(type, message)) {
     return FLAGS_audit_allow_selinux_events;
   }
 
-  if (reply.type == AUDIT_SECCOMP) {
+  if (type == AUDIT_SECCOMP) {
     return FLAGS_audit_allow_seccomp_events;
   }
 
-  switch (reply.type) {
+  switch (type) {
   case NLMSG_NOOP:
   case NLMSG_DONE:
   case NLMSG_ERROR:
@@ -128,6 +136,56 @@ enum AuditStatus {
   AUDIT_IMMUTABLE = 2,
 };
 
+AuditRecordBufferPool::AuditRecordBufferPool(std::size_t max_free_buffers)
+    : max_free_buffers_(max_free_buffers) {
+  // Releasing a buffer never allocates.
+  free_buffers_.reserve(max_free_buffers_);
+}
+
+AuditRecordBufferRef AuditRecordBufferPool::acquire() {
+  std::unique_ptr<AuditRecordBuffer> buffer;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_buffers_.empty()) {
+      buffer = std::move(free_buffers_.back());
+      free_buffers_.pop_back();
+    }
+  }
+
+  if (!buffer) {
+    // Default initialized, the data is overwritten by the next receive.
+    buffer.reset(new AuditRecordBuffer);
+  }
+  buffer->size = 0U;
+
+  // The buffers may outlive the pool.
+  std::weak_ptr<AuditRecordBufferPool> pool = weak_from_this();
+  return AuditRecordBufferRef(buffer.release(),
+                              [pool](AuditRecordBuffer* released_buffer) {
+                                auto pool_ref = pool.lock();
+                                if (pool_ref) {
+                                  pool_ref->release(released_buffer);
+                                } else {
+                                  delete released_buffer;
+                                }
+                              });
+}
+
+std::size_t AuditRecordBufferPool::freeBufferCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return free_buffers_.size();
+}
+
+void AuditRecordBufferPool::release(AuditRecordBuffer* buffer) noexcept {
+  std::unique_ptr<AuditRecordBuffer> buffer_ref(buffer);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (free_buffers_.size() < max_free_buffers_) {
+    free_buffers_.push_back(std::move(buffer_ref));
+  }
+}
+
 AuditdNetlink::AuditdNetlink() {
   try {
     auditd_context_ = std::make_shared<AuditdContext>();
@@ -166,7 +224,7 @@ std::vector<AuditEventRecord> AuditdNetlink::getEvents() noexcept {
 AuditdNetlinkReader::AuditdNetlinkReader(AuditdContextRef context)
     : InternalRunnable("AuditdNetlinkReader"),
       auditd_context_(std::move(context)),
-      read_buffer_(4096U) {}
+      read_buffer_list_(kAuditReadBatchSize) {}
 
 void AuditdNetlinkReader::start() {
   int counter_to_next_status_request = 0;
@@ -237,17 +295,17 @@ void AuditdNetlinkReader::stop() {
 bool AuditdNetlinkReader::acquireMessages() noexcept {
   pollfd fds[] = {{audit_netlink_handle_, POLLIN, 0}};
 
-  struct sockaddr_nl nladdr = {};
-  socklen_t nladdrlen = sizeof(nladdr);
+  std::array<mmsghdr, kAuditReadBatchSize> message_list;
+  std::array<iovec, kAuditReadBatchSize> iovec_list;
+  std::array<sockaddr_nl, kAuditReadBatchSize> address_list;
 
   bool reset_handle = false;
-  size_t events_received = 0;
+  std::vector<AuditRecordBufferRef> received_list;
 
   // Attempt to read as many messages as possible before we exit, and terminate
   // early if we have been asked to terminate
-  for (events_received = 0;
-       !interrupted() && events_received < read_buffer_.size();
-       events_received++) {
+  while (!interrupted() && !reset_handle &&
+         received_list.size() < kAuditMaxMessagesPerRead) {
     errno = 0;
     int poll_status = ::poll(fds, 1, 2000);
     if (poll_status == 0) {
@@ -267,57 +325,92 @@ bool AuditdNetlinkReader::acquireMessages() noexcept {
       break;
     }
 
-    audit_reply reply = {};
-    ssize_t len = recvfrom(audit_netlink_handle_,
-                           &reply.msg,
-                           sizeof(reply.msg),
-                           0,
-                           reinterpret_cast<struct sockaddr*>(&nladdr),
-                           &nladdrlen);
+    // Receive a batch of messages straight into the pooled buffers; the
+    // buffers handed to the parser are replaced before the next batch
+    auto batch_size = std::min(kAuditReadBatchSize,
+                               kAuditMaxMessagesPerRead - received_list.size());
 
-    if (len < 0) {
-      VLOG(1) << "Failed to receive data from the audit netlink";
-      reset_handle = true;
-      break;
-    }
+    for (std::size_t i = 0U; i < batch_size; ++i) {
+      auto& buffer = read_buffer_list_[i];
+      if (!buffer) {
+        buffer = auditd_context_->record_buffer_pool->acquire();
+      }
 
-    if (nladdrlen != sizeof(nladdr)) {
-      VLOG(1) << "Protocol error";
-      reset_handle = true;
-      break;
-    }
+      iovec_list[i] = {};
+      iovec_list[i].iov_base = buffer->data;
+      iovec_list[i].iov_len = sizeof(buffer->data);
 
-    if (nladdr.nl_pid) {
-      VLOG(1) << "Invalid netlink endpoint";
-      reset_handle = true;
-      break;
+      address_list[i] = {};
+      message_list[i] = {};
+      message_list[i].msg_hdr.msg_name = &address_list[i];
+      message_list[i].msg_hdr.msg_namelen = sizeof(address_list[i]);
+      message_list[i].msg_hdr.msg_iov = &iovec_list[i];
+      message_list[i].msg_hdr.msg_iovlen = 1;
     }
 
-    if (!NLMSG_OK(&reply.msg.nlh, static_cast<unsigned int>(len))) {
-      if (len == sizeof(reply.msg)) {
-        VLOG(1) << "Netlink event too big (EFBIG)";
-      } else {
-        VLOG(1) << "Broken netlink event (EBADE)";
+    int message_count = recvmmsg(audit_netlink_handle_,
+                                 message_list.data(),
+                                 static_cast<unsigned int>(batch_size),
+                                 MSG_DONTWAIT,
+                                 nullptr);
+
+    if (message_count < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        continue;
       }
 
+      VLOG(1) << "Failed to receive data from the audit netlink";
       reset_handle = true;
       break;
     }
 
-    read_buffer_[events_received] = reply;
+    for (std::size_t i = 0U; i < static_cast<std::size_t>(message_count);
+         ++i) {
+      const auto& message = message_list[i];
+      auto& buffer = read_buffer_list_[i];
+
+      if (message.msg_hdr.msg_namelen != sizeof(sockaddr_nl)) {
+        VLOG(1) << "Protocol error";
+        reset_handle = true;
+        break;
+      }
+
+      if (address_list[i].nl_pid) {
+        VLOG(1) << "Invalid netlink endpoint";
+        reset_handle = true;
+        break;
+      }
+
+      auto nlh = reinterpret_cast<const nlmsghdr*>(buffer->data);
+      if ((message.msg_hdr.msg_flags & MSG_TRUNC) != 0 ||
+          !NLMSG_OK(nlh, message.msg_len)) {
+        if ((message.msg_hdr.msg_flags & MSG_TRUNC) != 0 ||
+            message.msg_len == sizeof(buffer->data)) {
+          VLOG(1) << "Netlink event too big (EFBIG)";
+        } else {
+          VLOG(1) << "Broken netlink event (EBADE)";
+        }
+
+        reset_handle = true;
+        break;
+      }
+
+      buffer->size = message.msg_len;
+      received_list.push_back(std::move(buffer));
+    }
   }
 
-  if (events_received != 0) {
+  if (!received_list.empty()) {
     std::unique_lock<std::mutex> lock(
         auditd_context_->unprocessed_records_mutex);
 
     auditd_context_->unprocessed_records.reserve(
-        auditd_context_->unprocessed_records.size() + events_received);
+        auditd_context_->unprocessed_records.size() + received_list.size());
 
     auditd_context_->unprocessed_records.insert(
         auditd_context_->unprocessed_records.end(),
-        read_buffer_.begin(),
-        std::next(read_buffer_.begin(), events_received));
+        std::make_move_iterator(received_list.begin()),
+        std::make_move_iterator(received_list.end()));
 
     auditd_context_->unprocessed_records_cv.notify_all();
   }
@@ -680,7 +773,7 @@ AuditdNetlinkParser::AuditdNetlinkParser(AuditdContextRef context)
 
 void AuditdNetlinkParser::start() {
   while (!interrupted()) {
-    std::vector<audit_reply> queue;
+    std::vector<AuditRecordBufferRef> queue;
 
     {
       std::unique_lock<std::mutex> lock(
@@ -698,19 +791,31 @@ void AuditdNetlinkParser::start() {
     std::vector<AuditEventRecord> audit_event_record_queue;
     audit_event_record_queue.reserve(queue.size());
 
-    for (auto& reply : queue) {
+    for (auto& buffer : queue) {
       if (interrupted()) {
         break;
       }
 
-      AdjustAuditReply(reply);
+      if (buffer->size < NLMSG_HDRLEN) {
+        continue;
+      }
+
+      auto nlh = reinterpret_cast<const nlmsghdr*>(buffer->data);
+      auto type = static_cast<int>(nlh->nlmsg_type);
+      const char* payload = buffer->data + NLMSG_HDRLEN;
+      auto payload_size = buffer->size - NLMSG_HDRLEN;
 
       // This record carries the process id of the controlling daemon; in case
       // we lost control of the audit service, we are going to request a reset
       // as soon as we finish processing the pending queue
-      if (reply.type == AUDIT_GET) {
-        reply.status = static_cast<struct audit_status*>(NLMSG_DATA(reply.nlh));
-        auto new_pid = static_cast<pid_t>(reply.status->pid);
+      if (type == AUDIT_GET) {
+        if (payload_size < sizeof(audit_status)) {
+          continue;
+        }
+
+        audit_status status = {};
+        std::memcpy(&status, payload, sizeof(status));
+        auto new_pid = static_cast<pid_t>(status.pid);
 
         if (new_pid != getpid()) {
           VLOG(1) << "Audit control lost to pid: " << new_pid;
@@ -724,19 +829,30 @@ void AuditdNetlinkParser::start() {
         continue;
       }
 
+      // The kernel stores the size of the message (without the header) in
+      // nlmsg_len for the audit records
+      std::string_view message(
+          payload, std::min<std::size_t>(nlh->nlmsg_len, payload_size));
+      while (!message.empty() && message.back() == '\0') {
+        message.remove_suffix(1);
+      }
+
       // We are not interested in all messages; only get the ones related to
       // user events, seccomp, syscalls, SELinux events and AppArmor events
-      if (!ShouldHandle(reply)) {
+      if (!ShouldHandle(type, message)) {
         continue;
       }
 
+      // The record points into the buffer, which is recycled once the record
+      // and its copies are released
       AuditEventRecord audit_event_record = {};
-      if (!ParseAuditReply(reply, audit_event_record)) {
+      if (!ParseAuditMessage(
+              type, message, std::move(buffer), audit_event_record)) {
         VLOG(1) << "Malformed audit record received";
         continue;
       }
 
-      audit_event_record_queue.push_back(audit_event_record);
+      audit_event_record_queue.push_back(std::move(audit_event_record));
     }
 
     // Save the new records and notify the reader
@@ -750,8 +866,8 @@ void AuditdNetlinkParser::start() {
 
       auditd_context_->processed_events.insert(
           auditd_context_->processed_events.end(),
-          audit_event_record_queue.begin(),
-          audit_event_record_queue.end());
+          std::make_move_iterator(audit_event_record_queue.begin()),
+          std::make_move_iterator(audit_event_record_queue.end()));
 
       auditd_context_->processed_records_cv.notify_all();
     }
@@ -764,141 +880,106 @@ void AuditdNetlinkParser::start() {
 bool AuditdNetlinkParser::ParseAuditReply(
     const audit_reply& reply, AuditEventRecord& event_record) noexcept {
   event_record = {};
+  if (reply.message == nullptr) {
+    return false;
+  }
+
+  // The reply is owned by the caller, the record keeps a copy of the message
+  auto storage = std::make_shared<std::string>(
+      reply.message, static_cast<std::size_t>(reply.len));
+
+  std::string_view message(*storage);
+  return ParseAuditMessage(reply.type, message, storage, event_record);
+}
+
+bool AuditdNetlinkParser::ParseAuditMessage(
+    int type,
+    std::string_view message,
+    std::shared_ptr<const void> storage,
+    AuditEventRecord& event_record) noexcept {
+  event_record = {};
 
   if (FLAGS_audit_debug) {
-    VLOG(1) << reply.type << ", " << std::string(reply.message, reply.len);
+    VLOG(1) << type << ", " << message;
   }
 
   // Parse the record header
-  event_record.type = reply.type;
-  boost::string_ref message_view(reply.message,
-                                 static_cast<unsigned int>(reply.len));
+  event_record.type = type;
+  event_record.storage = std::move(storage);
 
-  auto preamble_end = message_view.find("): ");
-  if (preamble_end == std::string::npos) {
+  auto preamble_end = message.find("): ");
+  if (preamble_end == std::string_view::npos || preamble_end < 6) {
     return false;
   }
 
   event_record.time =
-      tryTo<unsigned long int>(message_view.substr(6, 10).to_string(), 10)
+      tryTo<unsigned long int>(std::string(message.substr(6, 10)), 10)
           .takeOr(event_record.time);
-  event_record.audit_id = message_view.substr(6, preamble_end - 6).to_string();
+  event_record.audit_id = std::string(message.substr(6, preamble_end - 6));
 
   // SELinux doesn't output valid audit records; just save them as they are
-  if (IsSELinuxRecord(reply)) {
-    event_record.raw_data = reply.message;
+  if (IsSELinuxRecord(type, message)) {
+    event_record.raw_data = message;
     return true;
   }
 
   // Save the whole message for AppArmor too
-  if (isAppArmorRecord(reply)) {
-    event_record.raw_data = reply.message;
+  if (isAppArmorRecord(type, message)) {
+    event_record.raw_data = message;
   }
 
   // Tokenize the message
-  boost::string_ref field_view(message_view.substr(preamble_end + 3));
+  auto field_view = message.substr(preamble_end + 3);
+
+  // The linear search will construct series of key value pairs; the keys and
+  // values are contiguous, only their boundaries are tracked.
+  std::size_t key_begin{0U};
+  auto value_begin = std::string_view::npos;
 
-  // The linear search will construct series of key value pairs.
-  std::string key, value;
-  key.reserve(20);
-  value.reserve(256);
+  auto L_addField = [&](std::size_t field_end) {
+    std::string_view key, value;
+    if (value_begin == std::string_view::npos) {
+      key = field_view.substr(key_begin, field_end - key_begin);
+    } else {
+      key = field_view.substr(key_begin, value_begin - 1 - key_begin);
+      value = field_view.substr(value_begin, field_end - value_begin);
+    }
+
+    // Multiple space tokens are supported.
+    if (!key.empty()) {
+      event_record.fields.emplace(key, value);
+    }
+  };
 
   // There are several ways of representing value data (enclosed strings,
   // etc).
-  bool found_assignment{false};
   bool found_enclose{false};
 
-  for (const auto& c : field_view) {
+  for (std::size_t i = 0U; i < field_view.size(); ++i) {
     // Iterate over each character in the audit message.
+    auto c = field_view[i];
     if ((found_enclose && c == '"') || (!found_enclose && c == ' ')) {
-      if (c == '"') {
-        value += c;
-      }
-
       // This is a terminating sequence, the end of an enclosure or space
-      // tok.
-      if (!key.empty()) {
-        // Multiple space tokens are supported.
-        event_record.fields.emplace(
-            std::make_pair(std::move(key), std::move(value)));
-      }
+      // tok. The closing quote is part of the value.
+      L_addField(c == '"' ? i + 1 : i);
 
       found_enclose = false;
-      found_assignment = false;
-
-      key.clear();
-      value.clear();
-
-    } else if (!found_assignment && c == ' ') {
-      // A field tokenizer.
+      value_begin = std::string_view::npos;
+      key_begin = i + 1;
 
-    } else if (found_assignment) {
+    } else if (value_begin != std::string_view::npos) {
       // Enclosure sequences appear immediately following assignment.
       if (c == '"') {
         found_enclose = true;
       }
 
-      value += c;
-
     } else if (c == '=') {
-      found_assignment = true;
-
-    } else {
-      key += c;
+      value_begin = i + 1;
     }
   }
 
   // Last step, if there was no trailing tokenizer.
-  if (!key.empty()) {
-    event_record.fields.emplace(
-        std::make_pair(std::move(key), std::move(value)));
-  }
-
+  L_addField(field_view.size());
   return true;
 }
-
-void AuditdNetlinkParser::AdjustAuditReply(audit_reply& reply) noexcept {
-  reply.type = reply.msg.nlh.nlmsg_type;
-  reply.len = reply.msg.nlh.nlmsg_len;
-  reply.nlh = &reply.msg.nlh;
-
-  reply.status = nullptr;
-  reply.ruledata = nullptr;
-  reply.login = nullptr;
-  reply.message = nullptr;
-  reply.error = nullptr;
-  reply.signal_info = nullptr;
-  reply.conf = nullptr;
-
-  switch (reply.type) {
-  case NLMSG_ERROR: {
-    reply.error = static_cast<struct nlmsgerr*>(NLMSG_DATA(reply.nlh));
-    break;
-  }
-
-  case AUDIT_LIST_RULES: {
-    reply.ruledata =
-        static_cast<struct audit_rule_data*>(NLMSG_DATA(reply.nlh));
-    break;
-  }
-
-  case AUDIT_USER:
-  case AUDIT_LOGIN:
-  case AUDIT_KERNEL:
-  case AUDIT_FIRST_USER_MSG ... AUDIT_LAST_USER_MSG:
-  case AUDIT_FIRST_USER_MSG2 ... AUDIT_LAST_USER_MSG2:
-  case AUDIT_FIRST_EVENT ... AUDIT_INTEGRITY_LAST_MSG: {
-    reply.message = static_cast<char*>(NLMSG_DATA(reply.nlh));
-    break;
-  }
-
-  case AUDIT_SIGNAL_INFO: {
-    reply.signal_info = static_cast<audit_sig_info*>(NLMSG_DATA(reply.nlh));
-    break;
-  }
-
-  default:
-    break;
-  }
-}
 } // namespace osquery
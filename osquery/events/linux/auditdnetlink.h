@@ -10,17 +10,24 @@
 #pragma once
 
 #include <libaudit.h>
+#include <linux/netlink.h>
 
 #include <atomic>
 #include <condition_variable>
 #include <future>
+#include <iterator>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
+#include <stdexcept>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <boost/algorithm/hex.hpp>
+#include <boost/container/small_vector.hpp>
 
 #include <osquery/dispatcher/dispatcher.h>
 
@@ -32,6 +39,120 @@ enum class NetlinkStatus { ActiveMutable, ActiveImmutable, Disabled, Error };
 /// Contains an audit_rule_data structure
 using AuditRuleDataObject = std::vector<std::uint8_t>;
 
+/// A netlink receive buffer holding a single audit message.
+struct AuditRecordBuffer final {
+  /// The netlink message, as received
+  alignas(nlmsghdr) char data[MAX_AUDIT_MESSAGE_LENGTH];
+
+  /// How many bytes have been received
+  std::size_t size{0U};
+};
+
+using AuditRecordBufferRef = std::shared_ptr<AuditRecordBuffer>;
+
+/**
+ * @brief Recycles the netlink receive buffers.
+ *
+ * A buffer goes back to the pool when its last reference is released; the
+ * records parsed from a buffer point into it, so it is recycled once the
+ * events assembled from those records have been fired. At most
+ * `max_free_buffers` idle buffers are kept, the others are freed.
+ */
+class AuditRecordBufferPool final
+    : public std::enable_shared_from_this<AuditRecordBufferPool> {
+ public:
+  explicit AuditRecordBufferPool(std::size_t max_free_buffers);
+
+  /// Takes an idle buffer, or allocates a new one
+  AuditRecordBufferRef acquire();
+
+  /// How many idle buffers are kept
+  std::size_t freeBufferCount() const;
+
+ private:
+  /// Keeps or frees a buffer that is no longer referenced
+  void release(AuditRecordBuffer* buffer) noexcept;
+
+ private:
+  /// Protects the idle buffers
+  mutable std::mutex mutex_;
+
+  /// The idle buffers
+  std::vector<std::unique_ptr<AuditRecordBuffer>> free_buffers_;
+
+  /// How many idle buffers are kept at most
+  std::size_t max_free_buffers_{0U};
+};
+
+/**
+ * @brief The fields of an audit record, in message order.
+ *
+ * Records have a few dozen fields at most: they are kept in a flat list and
+ * looked up linearly. Names and values point into the storage of the record.
+ */
+class AuditFieldMap final {
+ public:
+  using value_type = std::pair<std::string_view, std::string_view>;
+  using FieldList = boost::container::small_vector<value_type, 16>;
+  using const_iterator = FieldList::const_iterator;
+
+  /// Adds a field; like std::map, the first value of a name is kept
+  bool emplace(std::string_view name, std::string_view value) {
+    if (find(name) != end()) {
+      return false;
+    }
+
+    field_list_.emplace_back(name, value);
+    return true;
+  }
+
+  const_iterator find(std::string_view name) const {
+    for (auto it = field_list_.begin(); it != field_list_.end(); ++it) {
+      if (it->first == name) {
+        return it;
+      }
+    }
+
+    return field_list_.end();
+  }
+
+  std::string_view at(std::string_view name) const {
+    auto it = find(name);
+    if (it == end()) {
+      throw std::out_of_range("Missing audit record field");
+    }
+
+    return it->second;
+  }
+
+  std::size_t count(std::string_view name) const {
+    return find(name) != end() ? 1U : 0U;
+  }
+
+  const_iterator begin() const {
+    return field_list_.begin();
+  }
+
+  const_iterator end() const {
+    return field_list_.end();
+  }
+
+  std::size_t size() const {
+    return field_list_.size();
+  }
+
+  bool empty() const {
+    return field_list_.empty();
+  }
+
+  void clear() {
+    field_list_.clear();
+  }
+
+ private:
+  FieldList field_list_;
+};
+
 /// A single, prepared audit event record.
 struct AuditEventRecord final {
   /// Record type (i.e.: AUDIT_SYSCALL, AUDIT_PATH, ...)
@@ -45,21 +166,31 @@ struct AuditEventRecord final {
 
   /// The field list for this record. Valid for everything except SELinux and
   /// AppArmor records
-  std::map<std::string, std::string> fields;
+  AuditFieldMap fields;
 
   /// The raw message, only valid for SELinux and AppArmor records (because they
   /// have broken syntax)
-  std::string raw_data;
+  std::string_view raw_data;
+
+  /// The memory that the fields and the raw message point into
+  std::shared_ptr<const void> storage;
 };
 
 static_assert(std::is_move_constructible<AuditEventRecord>::value,
               "not move constructible");
 
+/// How many idle netlink receive buffers are kept for reuse.
+const std::size_t kAuditRecordBufferPoolSize{4096U};
+
 // This structure is used to share data between the reading and processing
 // services
 struct AuditdContext final {
-  /// Unprocessed audit records
-  std::vector<audit_reply> unprocessed_records;
+  /// The netlink receive buffers
+  std::shared_ptr<AuditRecordBufferPool> record_buffer_pool{
+      std::make_shared<AuditRecordBufferPool>(kAuditRecordBufferPoolSize)};
+
+  /// Unprocessed audit records, as received
+  std::vector<AuditRecordBufferRef> unprocessed_records;
   static_assert(
       std::is_move_constructible<decltype(unprocessed_records)>::value,
       "not move constructible");
@@ -117,8 +248,8 @@ class AuditdNetlinkReader final : public InternalRunnable {
   /// Shared data
   AuditdContextRef auditd_context_;
 
-  /// Read buffer used when receiving events from the netlink
-  std::vector<audit_reply> read_buffer_;
+  /// Buffers for the next batch of messages received from the netlink
+  std::vector<AuditRecordBufferRef> read_buffer_list_;
 
   /// The set of rules we applied (and that we'll uninstall when exiting)
   std::vector<audit_rule_data> installed_rule_list_;
@@ -140,8 +271,11 @@ class AuditdNetlinkParser final : public InternalRunnable {
   static bool ParseAuditReply(const audit_reply& reply,
                               AuditEventRecord& event_record) noexcept;
 
-  /// Adjusts the internal pointers of the audit_reply object
-  static void AdjustAuditReply(audit_reply& reply) noexcept;
+  /// Parses an audit message; the record fields point into the storage
+  static bool ParseAuditMessage(int type,
+                                std::string_view message,
+                                std::shared_ptr<const void> storage,
+                                AuditEventRecord& event_record) noexcept;
 
  private:
   /// Shared data
@@ -163,15 +297,17 @@ class AuditdNetlink final : private boost::noncopyable {
 };
 
 /// Handle quote and hex-encoded audit field content.
-inline std::string DecodeAuditPathValues(const std::string& s) {
+inline std::string DecodeAuditPathValues(std::string_view s) {
   if (s.size() > 1 && s[0] == '"') {
-    return s.substr(1, s.size() - 2);
+    return std::string(s.substr(1, s.size() - 2));
   }
 
   try {
-    return boost::algorithm::unhex(s);
+    std::string decoded;
+    boost::algorithm::unhex(s.begin(), s.end(), std::back_inserter(decoded));
+    return decoded;
   } catch (const boost::algorithm::hex_decode_error& e) {
-    return s;
+    return std::string(s);
   }
 }
 } // namespace osquery
@@ -421,7 +421,7 @@ const AuditEventRecord* GetEventRecord(const AuditEvent& event,
 };
 
 bool GetStringFieldFromMap(std::string& value,
-                           const std::map<std::string, std::string>& fields,
+                           const AuditFieldMap& fields,
                            const std::string& name,
                            const std::string& default_value) noexcept {
   auto it = fields.find(name);
@@ -435,7 +435,7 @@ bool GetStringFieldFromMap(std::string& value,
 }
 
 bool GetIntegerFieldFromMap(std::uint64_t& value,
-                            const std::map<std::string, std::string>& field_map,
+                            const AuditFieldMap& field_map,
                             const std::string& field_name,
                             std::size_t base,
                             std::uint64_t default_value) noexcept {
@@ -450,7 +450,7 @@ bool GetIntegerFieldFromMap(std::uint64_t& value,
 }
 
 void CopyFieldFromMap(Row& row,
-                      const std::map<std::string, std::string>& fields,
+                      const AuditFieldMap& fields,
                       const std::string& name,
                       const std::string& default_value) noexcept {
   GetStringFieldFromMap(row[name], fields, name, default_value);
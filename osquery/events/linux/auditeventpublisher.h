@@ -169,14 +169,14 @@ const AuditEventRecord* GetEventRecord(const AuditEvent& event,
 /// Extracts the specified string key from the given string map
 bool GetStringFieldFromMap(
     std::string& value,
-    const std::map<std::string, std::string>& fields,
+    const AuditFieldMap& fields,
     const std::string& name,
     const std::string& default_value = std::string()) noexcept;
 
 /// Extracts the specified integer key from the given string map
 bool GetIntegerFieldFromMap(
     std::uint64_t& value,
-    const std::map<std::string, std::string>& field_map,
+    const AuditFieldMap& field_map,
     const std::string& field_name,
     std::size_t base = 10,
     std::uint64_t default_value =
@@ -185,7 +185,7 @@ bool GetIntegerFieldFromMap(
 /// Copies a named field from the 'fields' map to the specified row
 void CopyFieldFromMap(
     Row& row,
-    const std::map<std::string, std::string>& fields,
+    const AuditFieldMap& fields,
     const std::string& name,
     const std::string& default_value = std::string()) noexcept;
 
@@ -8,15 +8,20 @@
  */
 
 #include <osquery/core/flags.h>
+#include <osquery/dispatcher/dispatcher.h>
 #include <osquery/events/linux/bpf/bpfeventpublisher.h>
+#include <osquery/events/linux/bpf/bpfeventreorderbuffer.h>
 #include <osquery/events/linux/bpf/setrlimit.h>
 #include <osquery/events/linux/bpf/systemstatetracker.h>
 #include <osquery/logger/logger.h>
+#include <osquery/numeric_monitoring/numeric_monitoring.h>
 #include <osquery/registry/registry_factory.h>
 #include <osquery/utils/system/time.h>
 
+#include <mutex>
+
 #include <fcntl.h>
-#include <sys/sysinfo.h>
+#include <time.h>
 
 namespace osquery {
 
@@ -157,6 +162,83 @@ const FunctionTracerAllocatorList kFunctionTracerAllocators = {
      true,
      &kExecveatKprobeParameterList}};
 
+/// State shared between the publisher and its perf event reader service
+struct BPFEventQueue final {
+  BPFEventQueue(std::uint64_t reorder_delay, std::size_t max_queued_events)
+      : reorder_buffer(reorder_delay, max_queued_events) {}
+
+  ebpf::PerfEventArray::Ref perf_event_array;
+  ebpfpub::IPerfEventReader::Ref perf_event_reader;
+  BufferStorageMap buffer_storage_map;
+
+  /// Protects the reorder buffer and the error counters
+  std::mutex mutex;
+
+  /// Events read from the perf buffers, waiting to be processed
+  BPFEventReorderBuffer reorder_buffer;
+
+  /// Error counters accumulated since the last report
+  ebpfpub::IPerfEventReader::ErrorCounters error_counters{};
+
+  /// Events dropped since the last report because the queue was full
+  std::uint64_t dropped_events{0U};
+};
+
+using BPFEventQueueRef = std::shared_ptr<BPFEventQueue>;
+
+/// Drains the perf buffers into the reorder buffer. Reading on its own thread
+/// keeps the perf buffers from overflowing while the publisher is busy
+/// running the event handlers
+class BPFPerfEventReader final : public InternalRunnable {
+ public:
+  explicit BPFPerfEventReader(BPFEventQueueRef event_queue)
+      : InternalRunnable("BPFPerfEventReader"),
+        event_queue_(std::move(event_queue)) {}
+
+ protected:
+  virtual void start() override {
+    while (!interrupted()) {
+      event_queue_->perf_event_reader->exec(
+          std::chrono::seconds(1U),
+
+          [&](const ebpfpub::IFunctionTracer::EventList& event_list,
+              const ebpfpub::IPerfEventReader::ErrorCounters&
+                  new_error_counters) {
+            std::lock_guard<std::mutex> lock(event_queue_->mutex);
+
+            auto& error_counters = event_queue_->error_counters;
+            error_counters.invalid_event += new_error_counters.invalid_event;
+            error_counters.lost_events += new_error_counters.lost_events;
+
+            error_counters.invalid_probe_output +=
+                new_error_counters.invalid_probe_output;
+
+            error_counters.invalid_event_data +=
+                new_error_counters.invalid_event_data;
+
+            for (const auto& event : event_list) {
+              if (!event_queue_->reorder_buffer.insert(event)) {
+                ++error_counters.lost_events;
+                ++event_queue_->dropped_events;
+              }
+            }
+          });
+    }
+  }
+
+ private:
+  BPFEventQueueRef event_queue_;
+};
+
+/// Returns the time in the clock used by the BPF event timestamps
+std::uint64_t getMonotonicTime() {
+  struct timespec time_spec {};
+  clock_gettime(CLOCK_MONOTONIC, &time_spec);
+
+  return static_cast<std::uint64_t>(time_spec.tv_sec) * 1000000000ULL +
+         static_cast<std::uint64_t>(time_spec.tv_nsec);
+}
+
 } // namespace
 
 FLAG(bool,
@@ -174,17 +256,26 @@ FLAG(uint64,
      512ULL,
      "How many slots each buffer storage should have");
 
+FLAG(uint64,
+     bpf_reorder_delay,
+     5ULL,
+     "Seconds to hold BPF events so they can be processed in order");
+
+FLAG(uint64,
+     bpf_max_queued_events,
+     500000ULL,
+     "Max BPF events waiting to be processed, newer events are dropped (0 for "
+     "no limit)");
+
 REGISTER(BPFEventPublisher, "event_publisher", "BPFEventPublisher");
 
 struct BPFEventPublisher::PrivateData final {
   bool initialized{false};
 
-  ebpf::PerfEventArray::Ref perf_event_array;
-  ebpfpub::IPerfEventReader::Ref perf_event_reader;
-  BufferStorageMap buffer_storage_map;
+  BPFEventQueueRef event_queue;
+  InternalRunnableRef perf_event_reader_service;
   EventHandlerMap event_handler_map;
 
-  std::map<std::uint64_t, ebpfpub::IFunctionTracer::Event> event_queue;
   ISystemStateTracker::Ref system_state_tracker;
 };
 
@@ -198,6 +289,11 @@ Status BPFEventPublisher::setUp() {
     return status;
   }
 
+  d->event_queue = std::make_shared<BPFEventQueue>(
+      FLAGS_bpf_reorder_delay,
+      static_cast<std::size_t>(FLAGS_bpf_max_queued_events));
+  auto& event_queue = *d->event_queue.get();
+
   auto perf_event_array_exp =
       ebpf::PerfEventArray::create(FLAGS_bpf_perf_event_array_exp);
 
@@ -206,23 +302,23 @@ Status BPFEventPublisher::setUp() {
                              perf_event_array_exp.error().message());
   }
 
-  d->perf_event_array = perf_event_array_exp.takeValue();
+  event_queue.perf_event_array = perf_event_array_exp.takeValue();
 
   auto perf_event_reader_exp =
-      ebpfpub::IPerfEventReader::create(*d->perf_event_array.get());
+      ebpfpub::IPerfEventReader::create(*event_queue.perf_event_array.get());
 
   if (!perf_event_reader_exp.succeeded()) {
     throw std::runtime_error("Failed to create the perf event reader: " +
                              perf_event_reader_exp.error().message());
   }
 
-  d->perf_event_reader = perf_event_reader_exp.takeValue();
+  event_queue.perf_event_reader = perf_event_reader_exp.takeValue();
 
   for (const auto& tracer_allocator : kFunctionTracerAllocators) {
-    auto buffer_storage_it =
-        d->buffer_storage_map.find(tracer_allocator.buffer_storage_pool);
+    auto buffer_storage_it = event_queue.buffer_storage_map.find(
+        tracer_allocator.buffer_storage_pool);
 
-    if (buffer_storage_it == d->buffer_storage_map.end()) {
+    if (buffer_storage_it == event_queue.buffer_storage_map.end()) {
       auto buffer_storage_exp =
           ebpfpub::IBufferStorage::create(FLAGS_bpf_buffer_storage_size, 4096);
 
@@ -231,7 +327,7 @@ Status BPFEventPublisher::setUp() {
       }
 
       auto buffer_storage = buffer_storage_exp.takeValue();
-      auto insert_status = d->buffer_storage_map.insert(
+      auto insert_status = event_queue.buffer_storage_map.insert(
           {tracer_allocator.buffer_storage_pool, std::move(buffer_storage)});
 
       buffer_storage_it = insert_status.first;
@@ -256,7 +352,7 @@ Status BPFEventPublisher::setUp() {
           tracer_allocator.syscall_name,
           parameter_list,
           buffer_storage,
-          *d->perf_event_array.get(),
+          *event_queue.perf_event_array.get(),
           kEventMapSize);
 
     } else {
@@ -268,7 +364,7 @@ Status BPFEventPublisher::setUp() {
                 tracer_allocator.syscall_name,
                 parameter_list,
                 buffer_storage,
-                *d->perf_event_array.get(),
+                *event_queue.perf_event_array.get(),
                 kEventMapSize);
 
       } else {
@@ -276,7 +372,7 @@ Status BPFEventPublisher::setUp() {
             ebpfpub::IFunctionTracer::createFromSyscallTracepoint(
                 tracer_allocator.syscall_name,
                 buffer_storage,
-                *d->perf_event_array.get(),
+                *event_queue.perf_event_array.get(),
                 kEventMapSize);
       }
     }
@@ -311,7 +407,7 @@ Status BPFEventPublisher::setUp() {
             << tracer_allocator.syscall_name << " (" << event_id << ")";
 
     d->event_handler_map[event_id] = tracer_allocator.event_handler;
-    d->perf_event_reader->insert(std::move(function_tracer));
+    event_queue.perf_event_reader->insert(std::move(function_tracer));
   }
 
   d->system_state_tracker = SystemStateTracker::create();
@@ -337,6 +433,11 @@ void BPFEventPublisher::tearDown() {
   if (!d->initialized) {
     return;
   }
+
+  if (d->perf_event_reader_service) {
+    d->perf_event_reader_service->interrupt();
+    d->perf_event_reader_service.reset();
+  }
 }
 
 Status BPFEventPublisher::run() {
@@ -349,30 +450,75 @@ Status BPFEventPublisher::run() {
         "Halting the publisher since initialization has failed");
   }
 
+  if (!d->perf_event_reader_service) {
+    d->perf_event_reader_service =
+        std::make_shared<BPFPerfEventReader>(d->event_queue);
+
+    auto status = Dispatcher::addService(d->perf_event_reader_service);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
   ebpfpub::IPerfEventReader::ErrorCounters error_counters{};
   auto last_error_counters_report = getUnixTime();
 
   while (!isEnding()) {
-    d->perf_event_reader->exec(
-        std::chrono::seconds(1U),
+    pause(std::chrono::seconds(1U));
+
+    ebpfpub::IFunctionTracer::EventList event_list;
+    std::size_t queue_depth{0U};
+    std::uint64_t oldest_timestamp{0U};
+    std::uint64_t lost_events{0U};
+    std::uint64_t dropped_events{0U};
+
+    auto current_timestamp = getMonotonicTime();
 
-        [&](const ebpfpub::IFunctionTracer::EventList& event_list,
-            const ebpfpub::IPerfEventReader::ErrorCounters&
-                new_error_counters) {
-          error_counters.invalid_event += new_error_counters.invalid_event;
-          error_counters.lost_events += new_error_counters.lost_events;
+    {
+      std::lock_guard<std::mutex> lock(d->event_queue->mutex);
 
-          error_counters.invalid_probe_output +=
-              new_error_counters.invalid_probe_output;
+      auto& event_queue = *d->event_queue.get();
+      event_list = event_queue.reorder_buffer.release(current_timestamp);
+      queue_depth = event_queue.reorder_buffer.size();
+      oldest_timestamp = event_queue.reorder_buffer.oldestTimestamp();
 
-          error_counters.invalid_event_data +=
-              new_error_counters.invalid_event_data;
+      const auto& new_error_counters = event_queue.error_counters;
+      error_counters.invalid_event += new_error_counters.invalid_event;
+      error_counters.lost_events += new_error_counters.lost_events;
 
-          for (auto& event : event_list) {
-            auto rel_timestamp = event.header.timestamp;
-            d->event_queue.insert({rel_timestamp, std::move(event)});
-          }
-        });
+      error_counters.invalid_probe_output +=
+          new_error_counters.invalid_probe_output;
+
+      error_counters.invalid_event_data +=
+          new_error_counters.invalid_event_data;
+
+      lost_events = new_error_counters.lost_events;
+      event_queue.error_counters = {};
+
+      dropped_events = event_queue.dropped_events;
+      event_queue.dropped_events = 0U;
+    }
+
+    std::uint64_t queue_lag{0U};
+    if (oldest_timestamp != 0U && oldest_timestamp < current_timestamp) {
+      queue_lag = (current_timestamp - oldest_timestamp) / 1000000ULL;
+    }
+
+    monitoring::record("bpf.event_queue.depth",
+                       static_cast<monitoring::ValueType>(queue_depth),
+                       monitoring::PreAggregationType::Max);
+
+    monitoring::record("bpf.event_queue.lag_ms",
+                       static_cast<monitoring::ValueType>(queue_lag),
+                       monitoring::PreAggregationType::Max);
+
+    monitoring::record("bpf.event_queue.dropped",
+                       static_cast<monitoring::ValueType>(dropped_events),
+                       monitoring::PreAggregationType::Sum);
+
+    monitoring::record("bpf.lost_events",
+                       static_cast<monitoring::ValueType>(lost_events),
+                       monitoring::PreAggregationType::Sum);
 
     auto current_time = getUnixTime();
     if (last_error_counters_report + 5U < current_time) {
@@ -402,20 +548,7 @@ Status BPFEventPublisher::run() {
     std::size_t invalid_event_count = 0U;
     auto& state = *d->system_state_tracker.get();
 
-    struct sysinfo system_info {};
-    sysinfo(&system_info);
-
-    for (auto event_it = d->event_queue.begin();
-         event_it != d->event_queue.end();) {
-      const auto& rel_timestamp = event_it->first / 1000000000ULL;
-      if (system_info.uptime - rel_timestamp < 5ULL) {
-        ++event_it;
-        continue;
-      }
-
-      auto event = std::move(event_it->second);
-      event_it = d->event_queue.erase(event_it);
-
+    for (const auto& event : event_list) {
       auto event_handler_it = d->event_handler_map.find(event.identifier);
       if (event_handler_it == d->event_handler_map.end()) {
         VLOG(1) << "Unhandled event received in BPFEventPublisher: "
@@ -436,10 +569,10 @@ Status BPFEventPublisher::run() {
                  << " malformed events";
     }
 
-    auto event_list = state.eventList();
-    if (!event_list.empty()) {
+    auto state_event_list = state.eventList();
+    if (!state_event_list.empty()) {
       auto event_context = createEventContext();
-      event_context->event_list = std::move(event_list);
+      event_context->event_list = std::move(state_event_list);
 
       fire(event_context);
     }
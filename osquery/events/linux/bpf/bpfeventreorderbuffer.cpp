@@ -0,0 +1,182 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <osquery/events/linux/bpf/bpfeventreorderbuffer.h>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace osquery {
+
+namespace {
+
+const std::uint64_t kNanosecondsPerSecond{1000000000ULL};
+
+std::uint64_t getEventSecond(const BPFEventReorderBuffer::Event& event) {
+  return event.header.timestamp / kNanosecondsPerSecond;
+}
+
+void appendEventList(BPFEventReorderBuffer::EventList& destination,
+                     BPFEventReorderBuffer::EventList& source) {
+  destination.insert(destination.end(),
+                     std::make_move_iterator(source.begin()),
+                     std::make_move_iterator(source.end()));
+  source.clear();
+}
+
+} // namespace
+
+struct BPFEventReorderBuffer::PrivateData final {
+  /// The events received for a single second
+  struct Bucket final {
+    std::uint64_t second{0U};
+    EventList event_list;
+  };
+
+  /// The reorder delay, in seconds
+  std::uint64_t delay{0U};
+
+  /// The maximum number of buffered events, 0 for no limit
+  std::size_t max_size{0U};
+
+  /// The ring of per-second buckets, indexed by second modulo its size
+  std::vector<Bucket> bucket_list;
+
+  /// Events whose bucket was reused before they were released
+  EventList overdue_event_list;
+
+  /// Number of buffered events
+  std::size_t size{0U};
+};
+
+BPFEventReorderBuffer::BPFEventReorderBuffer(std::uint64_t delay,
+                                             std::size_t max_size)
+    : d(new PrivateData) {
+  d->delay = delay;
+  d->max_size = max_size;
+
+  // One bucket for each second of the delay, one for the current second
+  // and one more for events of the next second across a release
+  d->bucket_list.resize(delay + 2U);
+}
+
+BPFEventReorderBuffer::~BPFEventReorderBuffer() {}
+
+bool BPFEventReorderBuffer::insert(Event event) {
+  if (d->max_size != 0U && d->size >= d->max_size) {
+    // The handlers are not keeping up; drop the event like a full perf
+    // buffer would, instead of growing until the watchdog steps in
+    return false;
+  }
+
+  auto second = getEventSecond(event);
+  auto& bucket = d->bucket_list[second % d->bucket_list.size()];
+
+  if (second < bucket.second && !bucket.event_list.empty()) {
+    // The event is older than the whole ring, release it as soon as possible
+    d->overdue_event_list.push_back(std::move(event));
+    ++d->size;
+    return true;
+  }
+
+  if (bucket.second != second) {
+    // The bucket still holds events from an older second, which could
+    // only happen if a release was late; they are released first
+    appendEventList(d->overdue_event_list, bucket.event_list);
+    bucket.second = second;
+  }
+
+  bucket.event_list.push_back(std::move(event));
+  ++d->size;
+  return true;
+}
+
+BPFEventReorderBuffer::EventList BPFEventReorderBuffer::release(
+    std::uint64_t now) {
+  EventList event_list;
+
+  auto current_second = now / kNanosecondsPerSecond;
+  if (current_second >= d->delay) {
+    auto last_second = current_second - d->delay;
+
+    // Buckets are released in second order, the ring is small
+    std::vector<PrivateData::Bucket*> released_bucket_list;
+    for (auto& bucket : d->bucket_list) {
+      if (!bucket.event_list.empty() && bucket.second <= last_second) {
+        released_bucket_list.push_back(&bucket);
+      }
+    }
+
+    std::sort(released_bucket_list.begin(),
+              released_bucket_list.end(),
+              [](const PrivateData::Bucket* lhs,
+                 const PrivateData::Bucket* rhs) -> bool {
+                return lhs->second < rhs->second;
+              });
+
+    appendEventList(event_list, d->overdue_event_list);
+    for (auto bucket : released_bucket_list) {
+      appendEventList(event_list, bucket->event_list);
+    }
+
+  } else {
+    appendEventList(event_list, d->overdue_event_list);
+  }
+
+  std::stable_sort(
+      event_list.begin(),
+      event_list.end(),
+      [](const Event& lhs, const Event& rhs) -> bool {
+        return lhs.header.timestamp < rhs.header.timestamp;
+      });
+
+  d->size -= event_list.size();
+  return event_list;
+}
+
+std::size_t BPFEventReorderBuffer::size() const {
+  return d->size;
+}
+
+std::uint64_t BPFEventReorderBuffer::oldestTimestamp() const {
+  std::uint64_t oldest_timestamp{0U};
+
+  auto update_oldest = [&oldest_timestamp](const EventList& event_list) {
+    for (const auto& event : event_list) {
+      if (oldest_timestamp == 0U ||
+          event.header.timestamp < oldest_timestamp) {
+        oldest_timestamp = event.header.timestamp;
+      }
+    }
+  };
+
+  update_oldest(d->overdue_event_list);
+
+  // Events in a bucket all belong to the same second; only the bucket with
+  // the oldest second needs to be scanned
+  const PrivateData::Bucket* oldest_bucket{nullptr};
+  for (const auto& bucket : d->bucket_list) {
+    if (bucket.event_list.empty()) {
+      continue;
+    }
+
+    if (oldest_bucket == nullptr || bucket.second < oldest_bucket->second) {
+      oldest_bucket = &bucket;
+    }
+  }
+
+  if (oldest_bucket != nullptr) {
+    update_oldest(oldest_bucket->event_list);
+  }
+
+  return oldest_timestamp;
+}
+
+} // namespace osquery
@@ -0,0 +1,59 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <ebpfpub/ifunctiontracer.h>
+
+#include <cstdint>
+#include <memory>
+
+namespace osquery {
+
+/// \brief Restores the timestamp order of BPF events over a bounded window
+/// Events read from the per-CPU perf buffers are not ordered. They are kept
+/// in a ring of per-second buckets, indexed by the second of their timestamp,
+/// and a bucket is released once it is older than the reorder delay. The
+/// released events are sorted by timestamp; events with the same timestamp
+/// keep their insertion order
+class BPFEventReorderBuffer final {
+ public:
+  using Event = tob::ebpfpub::IFunctionTracer::Event;
+  using EventList = tob::ebpfpub::IFunctionTracer::EventList;
+
+  /// \param delay How many seconds an event is held before being released
+  /// \param max_size How many events can be buffered, 0 for no limit
+  explicit BPFEventReorderBuffer(std::uint64_t delay,
+                                 std::size_t max_size = 0U);
+  ~BPFEventReorderBuffer();
+
+  BPFEventReorderBuffer(const BPFEventReorderBuffer&) = delete;
+  BPFEventReorderBuffer& operator=(const BPFEventReorderBuffer&) = delete;
+
+  /// \brief Adds a new event to the buffer
+  /// \return False if the buffer is full and the event was dropped
+  bool insert(Event event);
+
+  /// \brief Releases the events that are older than the reorder delay
+  /// \param now The current time, in nanoseconds since boot
+  /// \return The released events, sorted by timestamp
+  EventList release(std::uint64_t now);
+
+  /// Returns how many events are waiting to be released
+  std::size_t size() const;
+
+  /// Returns the timestamp of the oldest buffered event, or 0 if empty
+  std::uint64_t oldestTimestamp() const;
+
+ private:
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+};
+
+} // namespace osquery
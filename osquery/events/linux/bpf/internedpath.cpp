@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <osquery/events/linux/bpf/internedpath.h>
+
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace osquery {
+
+namespace {
+
+/// The table of live interned paths. The keys point inside the strings
+/// owned by the entries, which remove themselves once released
+struct InternedPathTable final {
+  std::mutex mutex;
+  std::unordered_map<std::string_view, std::weak_ptr<const std::string>>
+      path_map;
+};
+
+InternedPathTable& getInternedPathTable() {
+  // Never destroyed, as paths may be released during static destruction
+  static auto* table = new InternedPathTable;
+  return *table;
+}
+
+struct InternedPathDeleter final {
+  void operator()(const std::string* path) const {
+    auto& table = getInternedPathTable();
+
+    {
+      std::lock_guard<std::mutex> lock(table.mutex);
+
+      // The entry may have been replaced by a new copy of the same path
+      // while this one was being released
+      auto path_it = table.path_map.find(*path);
+      if (path_it != table.path_map.end() &&
+          path_it->first.data() == path->data()) {
+        table.path_map.erase(path_it);
+      }
+    }
+
+    delete path;
+  }
+};
+
+std::shared_ptr<const std::string> getEmptyPath() {
+  static const auto empty_path = std::make_shared<const std::string>();
+  return empty_path;
+}
+
+std::shared_ptr<const std::string> internPath(std::string path) {
+  if (path.empty()) {
+    return getEmptyPath();
+  }
+
+  auto& table = getInternedPathTable();
+
+  {
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    auto path_it = table.path_map.find(path);
+    if (path_it != table.path_map.end()) {
+      auto path_ref = path_it->second.lock();
+      if (path_ref) {
+        return path_ref;
+      }
+    }
+  }
+
+  // Allocate outside of the lock, since a failed allocation invokes the
+  // deleter
+  std::shared_ptr<const std::string> new_path_ref(
+      new std::string(std::move(path)), InternedPathDeleter{});
+
+  std::shared_ptr<const std::string> path_ref;
+
+  {
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    auto path_it = table.path_map.find(*new_path_ref);
+    if (path_it != table.path_map.end()) {
+      path_ref = path_it->second.lock();
+      if (!path_ref) {
+        table.path_map.erase(path_it);
+      }
+    }
+
+    if (!path_ref) {
+      table.path_map.insert({*new_path_ref, new_path_ref});
+      path_ref = new_path_ref;
+    }
+  }
+
+  return path_ref;
+}
+
+} // namespace
+
+InternedPath::InternedPath() : path_ref(getEmptyPath()) {}
+
+InternedPath::InternedPath(const std::string& path)
+    : path_ref(internPath(path)) {}
+
+InternedPath::InternedPath(std::string&& path)
+    : path_ref(internPath(std::move(path))) {}
+
+InternedPath::InternedPath(const char* path)
+    : path_ref(internPath(path)) {}
+
+std::size_t InternedPath::internedCount() {
+  auto& table = getInternedPathTable();
+
+  std::lock_guard<std::mutex> lock(table.mutex);
+  return table.path_map.size();
+}
+
+} // namespace osquery
@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace osquery {
+
+/// \brief An immutable, interned path string
+/// Equal paths share a single reference counted copy, so the same
+/// library or terminal path held open by thousands of processes is only
+/// stored once, and copying a path never allocates
+class InternedPath final {
+ public:
+  /// Creates an empty path
+  InternedPath();
+
+  /// Interns the given path
+  InternedPath(const std::string& path);
+
+  /// Interns the given path
+  InternedPath(std::string&& path);
+
+  /// Interns the given path
+  InternedPath(const char* path);
+
+  /// Returns the path string
+  const std::string& str() const {
+    return *path_ref;
+  }
+
+  /// Returns the path string
+  operator const std::string&() const {
+    return *path_ref;
+  }
+
+  /// Returns true if the path is empty
+  bool empty() const {
+    return path_ref->empty();
+  }
+
+  /// Returns how many distinct paths are currently interned
+  static std::size_t internedCount();
+
+  friend bool operator==(const InternedPath& lhs, const InternedPath& rhs) {
+    return lhs.path_ref == rhs.path_ref || *lhs.path_ref == *rhs.path_ref;
+  }
+
+  friend bool operator!=(const InternedPath& lhs, const InternedPath& rhs) {
+    return !(lhs == rhs);
+  }
+
+  friend bool operator==(const InternedPath& lhs, const std::string& rhs) {
+    return *lhs.path_ref == rhs;
+  }
+
+  friend bool operator==(const std::string& lhs, const InternedPath& rhs) {
+    return lhs == *rhs.path_ref;
+  }
+
+  friend bool operator!=(const InternedPath& lhs, const std::string& rhs) {
+    return !(lhs == rhs);
+  }
+
+  friend bool operator!=(const std::string& lhs, const InternedPath& rhs) {
+    return !(lhs == rhs);
+  }
+
+  friend bool operator==(const InternedPath& lhs, const char* rhs) {
+    return *lhs.path_ref == rhs;
+  }
+
+  friend bool operator==(const char* lhs, const InternedPath& rhs) {
+    return lhs == *rhs.path_ref;
+  }
+
+  friend bool operator!=(const InternedPath& lhs, const char* rhs) {
+    return !(lhs == rhs);
+  }
+
+  friend bool operator!=(const char* lhs, const InternedPath& rhs) {
+    return !(lhs == rhs);
+  }
+
+  friend std::ostream& operator<<(std::ostream& stream,
+                                  const InternedPath& path) {
+    return stream << *path.path_ref;
+  }
+
+ private:
+  std::shared_ptr<const std::string> path_ref;
+};
+
+} // namespace osquery
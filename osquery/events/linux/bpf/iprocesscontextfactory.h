@@ -9,11 +9,13 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include <osquery/events/linux/bpf/ifilesystem.h>
+#include <osquery/events/linux/bpf/internedpath.h>
 
 namespace osquery {
 
@@ -24,7 +26,7 @@ struct ProcessContext final {
     /// Path data for files
     struct FileData final {
       /// File or directory path
-      std::string path;
+      InternedPath path;
     };
 
     /// Network information for sockets
@@ -60,6 +62,115 @@ struct ProcessContext final {
 
   using FileDescriptorMap = std::unordered_map<int, FileDescriptor>;
 
+  /// \brief A copy-on-write file descriptor map
+  /// Copies share the same map until one of them is modified, so that
+  /// a forked process only duplicates its parent's file descriptors once
+  /// it opens or closes one of them
+  class FileDescriptorTable final {
+   public:
+    using const_iterator = FileDescriptorMap::const_iterator;
+    using value_type = FileDescriptorMap::value_type;
+
+    const_iterator begin() const {
+      return map().begin();
+    }
+
+    const_iterator end() const {
+      return map().end();
+    }
+
+    const_iterator find(int fd) const {
+      return map().find(fd);
+    }
+
+    const FileDescriptor& at(int fd) const {
+      return map().at(fd);
+    }
+
+    std::size_t count(int fd) const {
+      return map().count(fd);
+    }
+
+    std::size_t size() const {
+      return map().size();
+    }
+
+    bool empty() const {
+      return map().empty();
+    }
+
+    /// Returns true if the map is shared with another table
+    bool shared() const {
+      return fd_map_ref && fd_map_ref.use_count() > 1;
+    }
+
+    /// Adds a file descriptor, unless it is already present
+    bool insert(value_type value) {
+      return mutableMap().insert(std::move(value)).second;
+    }
+
+    /// \brief Returns a file descriptor for modification
+    /// Throws std::out_of_range if the file descriptor is not present
+    FileDescriptor& modify(int fd) {
+      return mutableMap().at(fd);
+    }
+
+    /// Removes a file descriptor, returning how many have been removed
+    std::size_t erase(int fd) {
+      if (count(fd) == 0U) {
+        return 0U;
+      }
+
+      return mutableMap().erase(fd);
+    }
+
+    /// Removes all the file descriptors matching the given predicate
+    template <typename Predicate>
+    std::size_t eraseIf(Predicate predicate) {
+      std::size_t erased_count{0U};
+
+      for (const auto& p : map()) {
+        if (predicate(p.second)) {
+          ++erased_count;
+        }
+      }
+
+      if (erased_count == 0U) {
+        return 0U;
+      }
+
+      auto& fd_map = mutableMap();
+      for (auto fd_it = fd_map.begin(); fd_it != fd_map.end();) {
+        if (predicate(fd_it->second)) {
+          fd_it = fd_map.erase(fd_it);
+        } else {
+          ++fd_it;
+        }
+      }
+
+      return erased_count;
+    }
+
+   private:
+    const FileDescriptorMap& map() const {
+      static const FileDescriptorMap kEmptyMap;
+      return fd_map_ref ? *fd_map_ref : kEmptyMap;
+    }
+
+    FileDescriptorMap& mutableMap() {
+      if (!fd_map_ref) {
+        fd_map_ref = std::make_shared<FileDescriptorMap>();
+
+      } else if (fd_map_ref.use_count() > 1) {
+        fd_map_ref = std::make_shared<FileDescriptorMap>(*fd_map_ref);
+      }
+
+      return *fd_map_ref;
+    }
+
+    std::shared_ptr<FileDescriptorMap> fd_map_ref;
+  };
+
   /// Parent process id
   pid_t parent_process_id{};
 
@@ -70,10 +181,10 @@ struct ProcessContext final {
   std::vector<std::string> argv;
 
   /// Current working directory
-  std::string cwd;
+  InternedPath cwd;
 
   /// File descriptor map, automatically inherited when forking
-  FileDescriptorMap fd_map;
+  FileDescriptorTable fd_map;
 };
 
 using ProcessContextMap = std::unordered_map<pid_t, ProcessContext>;
@@ -142,10 +142,13 @@ bool ProcessContextFactory::captureSingleProcess(
     return false;
   }
 
-  if (!fs.readLinkAt(output.cwd, process_root.get(), "cwd")) {
+  std::string cwd;
+  if (!fs.readLinkAt(cwd, process_root.get(), "cwd")) {
     return false;
   }
 
+  output.cwd = std::move(cwd);
+
   if (!getParentPidFromStatFile(
           fs, output.parent_process_id, process_stat.get())) {
     return false;
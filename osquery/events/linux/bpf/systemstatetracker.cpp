@@ -339,7 +339,7 @@ bool SystemStateTracker::executeBinary(
     process_context.binary_path = binary_path;
 
   } else if (dirfd == AT_FDCWD) {
-    process_context.binary_path = process_context.cwd + '/' + binary_path;
+    process_context.binary_path = process_context.cwd.str() + '/' + binary_path;
 
   } else {
     std::string root_path;
@@ -364,15 +364,10 @@ bool SystemStateTracker::executeBinary(
 
   process_context.argv = argv;
 
-  for (auto fd_it = process_context.fd_map.begin();
-       fd_it != process_context.fd_map.end();) {
-    const auto& fd_info = fd_it->second;
-    if (fd_info.close_on_exec) {
-      fd_it = process_context.fd_map.erase(fd_it);
-    } else {
-      ++fd_it;
-    }
-  }
+  process_context.fd_map.eraseIf(
+      [](const ProcessContext::FileDescriptor& fd_info) -> bool {
+        return fd_info.close_on_exec;
+      });
 
   Event event;
   event.type = Event::Type::Exec;
@@ -427,11 +422,13 @@ bool SystemStateTracker::setWorkingDirectory(
     process_context.cwd = path;
 
   } else {
-    if (process_context.cwd.back() != '/') {
-      process_context.cwd += '/';
+    auto cwd = process_context.cwd.str();
+    if (cwd.back() != '/') {
+      cwd += '/';
     }
 
-    process_context.cwd += path;
+    cwd += path;
+    process_context.cwd = std::move(cwd);
   }
 
   return true;
@@ -458,7 +455,7 @@ bool SystemStateTracker::openFile(
       return false;
     }
 
-    absolute_path = process_context.cwd;
+    absolute_path = process_context.cwd.str();
     if (absolute_path.back() != '/') {
       absolute_path += '/';
     }
@@ -480,7 +477,7 @@ bool SystemStateTracker::openFile(
     const auto& file_data =
         std::get<ProcessContext::FileDescriptor::FileData>(fd_info.data);
 
-    absolute_path = file_data.path;
+    absolute_path = file_data.path.str();
 
     if ((flags & AT_EMPTY_PATH) == 0) {
       if (absolute_path.back() != '/') {
@@ -537,12 +534,10 @@ bool SystemStateTracker::closeHandle(
   auto& process_context =
       getProcessContext(context, process_context_factory, process_id);
 
-  auto fd_info_it = process_context.fd_map.find(fd);
-  if (fd_info_it == process_context.fd_map.end()) {
+  if (process_context.fd_map.erase(fd) == 0U) {
     return false;
   }
 
-  process_context.fd_map.erase(fd_info_it);
   return true;
 }
 
@@ -582,20 +577,16 @@ bool SystemStateTracker::bind(
 
   // If we dont have a file descriptor, create one right now. We may have
   // to figure out what's in the sockaddr structure
-  auto fd_info_it = process_context.fd_map.find(fd);
-  if (fd_info_it == process_context.fd_map.end()) {
+  if (process_context.fd_map.count(fd) == 0U) {
     ProcessContext::FileDescriptor fd_info;
     fd_info.close_on_exec = false;
     fd_info.data = ProcessContext::FileDescriptor::SocketData{};
 
-    auto insert_status =
-        process_context.fd_map.insert({fd, std::move(fd_info)});
-
-    fd_info_it = insert_status.first;
+    process_context.fd_map.insert({fd, std::move(fd_info)});
   }
 
   // Reset the file descriptor type if it's not a socket
-  auto& fd_info = fd_info_it->second;
+  auto& fd_info = process_context.fd_map.modify(fd);
   if (!std::holds_alternative<ProcessContext::FileDescriptor::SocketData>(
           fd_info.data)) {
     fd_info.data = ProcessContext::FileDescriptor::SocketData{};
@@ -726,20 +717,16 @@ bool SystemStateTracker::connect(
 
   // If we dont have a file descriptor, create one right now. We may have
   // to figure out what's in the sockaddr structure
-  auto fd_info_it = process_context.fd_map.find(fd);
-  if (fd_info_it == process_context.fd_map.end()) {
+  if (process_context.fd_map.count(fd) == 0U) {
     ProcessContext::FileDescriptor fd_info;
     fd_info.close_on_exec = false;
     fd_info.data = ProcessContext::FileDescriptor::SocketData{};
 
-    auto insert_status =
-        process_context.fd_map.insert({fd, std::move(fd_info)});
-
-    fd_info_it = insert_status.first;
+    process_context.fd_map.insert({fd, std::move(fd_info)});
   }
 
   // Reset the file descriptor type if it's not a socket
-  auto& fd_info = fd_info_it->second;
+  auto& fd_info = process_context.fd_map.modify(fd);
   if (!std::holds_alternative<ProcessContext::FileDescriptor::SocketData>(
           fd_info.data)) {
     fd_info.data = ProcessContext::FileDescriptor::SocketData{};
@@ -809,20 +796,16 @@ bool SystemStateTracker::accept(
 
   // If we dont have a file descriptor, create one right now. We may have
   // to figure out what's in the sockaddr structure
-  auto parent_fd_info_it = process_context.fd_map.find(fd);
-  if (parent_fd_info_it == process_context.fd_map.end()) {
+  if (process_context.fd_map.count(fd) == 0U) {
     ProcessContext::FileDescriptor fd_info;
     fd_info.close_on_exec = false;
     fd_info.data = ProcessContext::FileDescriptor::SocketData{};
 
-    auto insert_status =
-        process_context.fd_map.insert({fd, std::move(fd_info)});
-
-    parent_fd_info_it = insert_status.first;
+    process_context.fd_map.insert({fd, std::move(fd_info)});
   }
 
   // Reset the parent file descriptor type if it's not a socket
-  auto& parent_fd_info = parent_fd_info_it->second;
+  auto& parent_fd_info = process_context.fd_map.modify(fd);
   if (!std::holds_alternative<ProcessContext::FileDescriptor::SocketData>(
           parent_fd_info.data)) {
     parent_fd_info.data = ProcessContext::FileDescriptor::SocketData{};
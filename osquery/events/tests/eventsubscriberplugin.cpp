@@ -49,10 +49,196 @@ TEST_F(EventSubscriberPluginTests, generateEventDataIndex) {
       EventSubscriberPlugin::generateEventDataIndex(context, mocked_database);
 
   // Make sure we have found the 10 keys and that the broken ones
-  // have been deleted
+  // have been deleted. The rebuilt index is persisted as 10 time buckets
+  // and the last EventID.
   EXPECT_TRUE(status.ok());
-  EXPECT_EQ(mocked_database.key_map.size(), 10U);
+  EXPECT_EQ(mocked_database.key_map.size(), 21U);
   EXPECT_EQ(context.event_index.size(), 10U);
+  EXPECT_EQ(mocked_database.key_map.count("last_eid.type.name"), 1U);
+  EXPECT_EQ(mocked_database.key_map.count("time_index.type.name.0000000009"),
+            1U);
+}
+
+TEST_F(EventSubscriberPluginTests, generateEventDataIndexPersisted) {
+  MockedOsqueryDatabase mocked_database;
+  mocked_database.generateEvents("type", "name");
+
+  {
+    EventSubscriberPlugin::Context context;
+    EventSubscriberPlugin::setDatabaseNamespace(context, "type", "name");
+    ASSERT_TRUE(
+        EventSubscriberPlugin::generateEventDataIndex(context, mocked_database)
+            .ok());
+  }
+
+  // Remove an event's data, a full rebuild would drop it from the index.
+  mocked_database.key_map.erase(
+      "data.type.name." + EventSubscriberPlugin::toIndex(1));
+
+  // The persisted index only loads the time buckets.
+  EventSubscriberPlugin::Context context;
+  EventSubscriberPlugin::setDatabaseNamespace(context, "type", "name");
+  auto status =
+      EventSubscriberPlugin::generateEventDataIndex(context, mocked_database);
+  ASSERT_TRUE(status.ok());
+  EXPECT_EQ(context.event_index.size(), 10U);
+  EXPECT_EQ(context.unloaded_buckets.size(), 10U);
+  EXPECT_EQ(context.last_event_id.load(), 20U);
+
+  // Bucket EventIDs are loaded when a range is generated.
+  std::size_t callback_count{0U};
+  auto callback = [&callback_count](Row) { ++callback_count; };
+  EventSubscriberPlugin::generateRows(
+      context, mocked_database, callback, 5, 9);
+  EXPECT_EQ(callback_count, 5U);
+  EXPECT_EQ(context.unloaded_buckets.size(), 5U);
+  EXPECT_EQ(context.event_index.at(9).size(), 1U);
+  EXPECT_TRUE(context.event_index.at(0).empty());
+}
+
+TEST_F(EventSubscriberPluginTests, generateEventDataIndexStale) {
+  MockedOsqueryDatabase mocked_database;
+  mocked_database.generateEvents("type", "name");
+
+  {
+    EventSubscriberPlugin::Context context;
+    EventSubscriberPlugin::setDatabaseNamespace(context, "type", "name");
+    ASSERT_TRUE(
+        EventSubscriberPlugin::generateEventDataIndex(context, mocked_database)
+            .ok());
+  }
+
+  // Store an event without updating the index, as an older version would.
+  Row row = {{"time", "100"}, {"eid", EventSubscriberPlugin::toIndex(21)}};
+  std::string serialized_row;
+  ASSERT_TRUE(serializeRowJSON(row, serialized_row).ok());
+  mocked_database.key_map["data.type.name." +
+                          EventSubscriberPlugin::toIndex(21)] = serialized_row;
+
+  // The index is rebuilt from the event data.
+  EventSubscriberPlugin::Context context;
+  EventSubscriberPlugin::setDatabaseNamespace(context, "type", "name");
+  auto status =
+      EventSubscriberPlugin::generateEventDataIndex(context, mocked_database);
+  ASSERT_TRUE(status.ok());
+  EXPECT_EQ(context.event_index.size(), 11U);
+  EXPECT_TRUE(context.unloaded_buckets.empty());
+  EXPECT_EQ(context.last_event_id.load(), 21U);
+  EXPECT_EQ(mocked_database.key_map.at("last_eid.type.name"),
+            EventSubscriberPlugin::toIndex(21));
+}
+
+TEST_F(EventSubscriberPluginTests, generateEventDataIndexInvalidBucket) {
+  MockedOsqueryDatabase mocked_database;
+  mocked_database.generateEvents("type", "name");
+
+  {
+    EventSubscriberPlugin::Context context;
+    EventSubscriberPlugin::setDatabaseNamespace(context, "type", "name");
+    ASSERT_TRUE(
+        EventSubscriberPlugin::generateEventDataIndex(context, mocked_database)
+            .ok());
+  }
+
+  // An invalid time bucket key causes a rebuild instead of a partial index.
+  mocked_database.key_map["time_index.type.name.invalid"] = "";
+
+  EventSubscriberPlugin::Context context;
+  EventSubscriberPlugin::setDatabaseNamespace(context, "type", "name");
+  auto status =
+      EventSubscriberPlugin::generateEventDataIndex(context, mocked_database);
+  ASSERT_TRUE(status.ok());
+  EXPECT_EQ(context.event_index.size(), 10U);
+  EXPECT_TRUE(context.unloaded_buckets.empty());
+
+  // The replaced index no longer has the invalid key.
+  EXPECT_EQ(mocked_database.key_map.count("time_index.type.name.invalid"), 0U);
+  EXPECT_EQ(mocked_database.key_map.size(), 21U);
+}
+
+TEST_F(EventSubscriberPluginTests, serializeEventIDList) {
+  EventIDList event_id_list = {1, 2, 3, 5, 7, 8};
+  auto serialized = EventSubscriberPlugin::serializeEventIDList(event_id_list);
+  EXPECT_EQ(serialized, "1-3,5,7-8");
+
+  EventIDList deserialized;
+  EXPECT_TRUE(
+      EventSubscriberPlugin::deserializeEventIDList(serialized, deserialized));
+  EXPECT_EQ(deserialized, event_id_list);
+
+  EXPECT_FALSE(
+      EventSubscriberPlugin::deserializeEventIDList("3-1", deserialized));
+  EXPECT_FALSE(
+      EventSubscriberPlugin::deserializeEventIDList("1,x", deserialized));
+}
+
+TEST_F(EventSubscriberPluginTests, serializeEventBlock) {
+  std::vector<Row> row_list = {
+      {{"path", "/etc/hosts"}, {"pid", "1"}, {"time", "1"}, {"eid", "1"}},
+      {{"path", "/etc/passwd"}, {"uid", ""}},
+      {{"pid", "3"}, {"path", std::string(1024, 'a')}},
+  };
+  EventIDList event_id_list = {4, 5, 9};
+
+  for (auto compress : {false, true}) {
+    std::string block;
+    ASSERT_TRUE(EventSubscriberPlugin::serializeEventBlock(
+                    100, event_id_list, row_list, compress, block)
+                    .ok());
+
+    EventTime event_time{0U};
+    EventIDList deserialized_event_id_list;
+    std::vector<Row> deserialized_row_list;
+    ASSERT_TRUE(EventSubscriberPlugin::deserializeEventBlock(
+                    block,
+                    0,
+                    event_time,
+                    deserialized_event_id_list,
+                    deserialized_row_list)
+                    .ok());
+    EXPECT_EQ(event_time, 100U);
+    EXPECT_EQ(deserialized_event_id_list, event_id_list);
+
+    // The time and eid columns are restored from the block.
+    ASSERT_EQ(deserialized_row_list.size(), row_list.size());
+    for (std::size_t i = 0U; i < row_list.size(); ++i) {
+      auto expected_row = row_list[i];
+      expected_row["time"] = "100";
+      expected_row["eid"] = EventSubscriberPlugin::toIndex(event_id_list[i]);
+      EXPECT_EQ(deserialized_row_list[i], expected_row);
+    }
+
+    // Rows up to the last EventID are skipped.
+    ASSERT_TRUE(EventSubscriberPlugin::deserializeEventBlock(
+                    block,
+                    5,
+                    event_time,
+                    deserialized_event_id_list,
+                    deserialized_row_list)
+                    .ok());
+    EXPECT_EQ(deserialized_event_id_list, event_id_list);
+    ASSERT_EQ(deserialized_row_list.size(), 1U);
+    EXPECT_EQ(deserialized_row_list[0].at("pid"), "3");
+
+    // A truncated block is never valid.
+    for (std::size_t size = 0U; size < block.size(); ++size) {
+      EXPECT_FALSE(EventSubscriberPlugin::deserializeEventBlock(
+                       block.substr(0, size),
+                       0,
+                       event_time,
+                       deserialized_event_id_list,
+                       deserialized_row_list)
+                       .ok());
+    }
+  }
+
+  std::string block;
+  EXPECT_FALSE(EventSubscriberPlugin::serializeEventBlock(
+                   100, {5, 4}, {Row{}, Row{}}, false, block)
+                   .ok());
+  EXPECT_FALSE(
+      EventSubscriberPlugin::serializeEventBlock(100, {}, {}, false, block)
+          .ok());
 }
 
 TEST_F(EventSubscriberPluginTests, toIndex) {
@@ -68,7 +254,7 @@ TEST_F(EventSubscriberPluginTests, setOptimizeData) {
   const EventTime kEventTime{10U};
   const std::size_t kEventIdentifier{20U};
   EventSubscriberPlugin::setOptimizeData(
-      mocked_database, kEventTime, kEventIdentifier);
+      mocked_database, "test_query", kEventTime, kEventIdentifier);
 
   EXPECT_EQ(mocked_database.key_map.size(), 22U);
 
@@ -100,17 +286,21 @@ TEST_F(EventSubscriberPluginTests, getOptimizeData) {
   const EventTime kEventTime{10U};
   const std::size_t kEventIdentifier{20U};
   EventSubscriberPlugin::setOptimizeData(
-      mocked_database, kEventTime, kEventIdentifier);
+      mocked_database, "test_query", kEventTime, kEventIdentifier);
 
   EventTime event_time{};
   EventID event_id{};
-  std::string query_name;
   EventSubscriberPlugin::getOptimizeData(
-      mocked_database, event_time, event_id, query_name);
+      mocked_database, "test_query", event_time, event_id);
 
   EXPECT_EQ(kEventTime, event_time);
   EXPECT_EQ(kEventIdentifier, event_id);
-  EXPECT_EQ(query_name, "test_query");
+
+  // Each query continues from its own optimization data.
+  EventSubscriberPlugin::getOptimizeData(
+      mocked_database, "other_query", event_time, event_id);
+  EXPECT_EQ(0U, event_time);
+  EXPECT_EQ(0U, event_id);
 }
 
 TEST_F(EventSubscriberPluginTests, databaseKeyForEventId) {
@@ -235,6 +425,13 @@ TEST_F(EventSubscriberPluginTests, generateRows) {
       context, mocked_database, callback, 10, 15);
   EXPECT_EQ(callback_count, 20U);
   EXPECT_EQ(last, context.event_index.end());
+
+  // Only the events within the EventID range are generated.
+  callback_count = 0U;
+  last = EventSubscriberPlugin::generateRows(
+      context, mocked_database, callback, 0, 0, 4, 9);
+  EXPECT_EQ(callback_count, 3U);
+  EXPECT_EQ(last->first, 9U);
 }
 
 class FakeEventSubscriberPlugin : public EventSubscriberPlugin {
@@ -265,6 +462,10 @@ class FakeEventSubscriberPlugin : public EventSubscriberPlugin {
     expiry_ = expiry;
   }
 
+  void setUsesEventBlocks(bool uses_event_blocks) {
+    uses_event_blocks_ = uses_event_blocks;
+  }
+
   size_t getEventsExpiry() override {
     return expiry_;
   }
@@ -278,8 +479,13 @@ class FakeEventSubscriberPlugin : public EventSubscriberPlugin {
     return db_;
   }
 
+  bool usesEventBlocks() const override {
+    return uses_event_blocks_;
+  }
+
  private:
   bool optimize_{false};
+  bool uses_event_blocks_{false};
   IDatabaseInterface& db_;
   uint64_t time_{0};
   size_t expiry_{0};
@@ -345,10 +551,10 @@ TEST_F(EventSubscriberPluginTests, generateRowsWithExpiry) {
   auto callback = [&callback_count](Row) { ++callback_count; };
   // Time is in the future.
   subscriber.setTime(20);
-  subscriber.generateRows(callback, true, 0, 0);
+  subscriber.generateRows(callback, true, "test_query", 0, 0);
   EXPECT_EQ(10U, callback_count);
   // Events are expired after being queried.
-  subscriber.generateRows(callback, true, 0, 0);
+  subscriber.generateRows(callback, true, "test_query", 0, 0);
   EXPECT_EQ(10U, callback_count);
 }
 
@@ -365,30 +571,128 @@ TEST_F(EventSubscriberPluginTests, generateRowsWithOptimize) {
 
   size_t callback_count{0U};
   auto callback = [&callback_count](Row) { ++callback_count; };
-  subscriber.generateRows(callback, true, 0, 0);
+  subscriber.generateRows(callback, true, "test_query", 0, 0);
   // Queries are not tracked when not optimizing.
   EXPECT_EQ(0U, subscriber.queries_.size());
   EXPECT_EQ(10U, callback_count);
 
   const EventTime event_time{0U};
   const EventID event_id{0U};
-  subscriber.setOptimizeData(mocked_database, event_time, event_id);
+  subscriber.setOptimizeData(
+      mocked_database, "test_query", event_time, event_id);
 
   callback_count = 0;
   subscriber.setShouldOptimize(true);
-  subscriber.generateRows(callback, true, 0, 5);
+  subscriber.generateRows(callback, true, "test_query", 0, 5);
   EXPECT_EQ(6U, callback_count);
   EXPECT_EQ(1U, subscriber.queries_.size());
 
   // This should continue from the optimized placement.
   callback_count = 0;
-  subscriber.generateRows(callback, true, 0, 0);
+  subscriber.generateRows(callback, true, "test_query", 0, 0);
   EXPECT_EQ(4U, callback_count);
   EXPECT_EQ(1U, subscriber.queries_.size());
 
   callback_count = 0;
-  subscriber.generateRows(callback, true, 0, 0);
+  subscriber.generateRows(callback, true, "test_query", 0, 0);
   ASSERT_FALSE(subscriber.executedAllQueries());
   EXPECT_EQ(0U, callback_count);
 }
+
+TEST_F(EventSubscriberPluginTests, addBatchWithBlocks) {
+  MockedOsqueryDatabase mocked_database;
+  FakeEventSubscriberPlugin subscriber(mocked_database);
+  subscriber.setUsesEventBlocks(true);
+  subscriber.setDatabaseNamespace();
+  ASSERT_TRUE(subscriber.generateEventDataIndex().ok());
+
+  std::vector<Row> row_list = {{{"path", "/a"}},
+                               {{"path", "/b"}, {"pid", "1"}}};
+  ASSERT_TRUE(subscriber.addBatch(row_list, 10).ok());
+  row_list = {{{"path", "/c"}}};
+  ASSERT_TRUE(subscriber.addBatch(row_list, 10).ok());
+  row_list = {{{"path", "/d"}}};
+  ASSERT_TRUE(subscriber.addBatch(row_list, 11).ok());
+
+  // Each batch is stored as a single block, the bucket is marked.
+  EXPECT_EQ(
+      mocked_database.key_map.count("block.fake.fake.0000000010.0000000001"),
+      1U);
+  EXPECT_EQ(
+      mocked_database.key_map.count("block.fake.fake.0000000010.0000000003"),
+      1U);
+  EXPECT_EQ(mocked_database.key_map.count("data.fake.fake.0000000001"), 0U);
+  EXPECT_EQ(mocked_database.key_map.at("time_index.fake.fake.0000000010"),
+            "b:1-3");
+
+  std::vector<Row> generated_row_list;
+  auto callback = [&generated_row_list](Row row) {
+    generated_row_list.push_back(std::move(row));
+  };
+
+  EventSubscriberPlugin::generateRows(
+      subscriber.context, mocked_database, callback, 0, 0);
+  ASSERT_EQ(generated_row_list.size(), 4U);
+  EXPECT_EQ(generated_row_list[1].at("pid"), "1");
+  EXPECT_EQ(generated_row_list[1].at("time"), "10");
+  EXPECT_EQ(generated_row_list[1].at("eid"), "0000000002");
+  EXPECT_EQ(generated_row_list[3].at("path"), "/d");
+
+  // Events visited by an optimized query are skipped.
+  generated_row_list.clear();
+  EventSubscriberPlugin::generateRows(
+      subscriber.context, mocked_database, callback, 0, 0, 2);
+  ASSERT_EQ(generated_row_list.size(), 2U);
+  EXPECT_EQ(generated_row_list[0].at("path"), "/c");
+
+  // Events past the end EventID are skipped within a block.
+  generated_row_list.clear();
+  EventSubscriberPlugin::generateRows(
+      subscriber.context, mocked_database, callback, 0, 0, 1, 2);
+  ASSERT_EQ(generated_row_list.size(), 1U);
+  EXPECT_EQ(generated_row_list[0].at("path"), "/b");
+
+  {
+    // The persisted index finds the blocks once the buckets are loaded.
+    EventSubscriberPlugin::Context context;
+    EventSubscriberPlugin::setDatabaseNamespace(context, "fake", "fake");
+    ASSERT_TRUE(
+        EventSubscriberPlugin::generateEventDataIndex(context, mocked_database)
+            .ok());
+
+    generated_row_list.clear();
+    EventSubscriberPlugin::generateRows(
+        context, mocked_database, callback, 0, 0);
+    EXPECT_EQ(generated_row_list.size(), 4U);
+    EXPECT_EQ(context.block_buckets.size(), 2U);
+  }
+
+  {
+    // A full rebuild reads the EventIDs from the blocks.
+    EventSubscriberPlugin::Context context;
+    EventSubscriberPlugin::setDatabaseNamespace(context, "fake", "fake");
+    ASSERT_TRUE(
+        EventSubscriberPlugin::rebuildEventDataIndex(context, mocked_database)
+            .ok());
+    EXPECT_EQ(context.event_index.at(10), (EventIDList{1, 2, 3}));
+    EXPECT_EQ(context.block_buckets.size(), 2U);
+    EXPECT_EQ(context.last_event_id.load(), 4U);
+  }
+
+  // Removing a bucket deletes its blocks.
+  EventSubscriberPlugin::removeOverflowingEventBatches(
+      subscriber.context, mocked_database, 1);
+  EXPECT_EQ(subscriber.context.event_index.size(), 1U);
+  EXPECT_EQ(
+      mocked_database.key_map.count("block.fake.fake.0000000010.0000000001"),
+      0U);
+  EXPECT_EQ(
+      mocked_database.key_map.count("block.fake.fake.0000000010.0000000003"),
+      0U);
+  EXPECT_EQ(mocked_database.key_map.count("time_index.fake.fake.0000000010"),
+            0U);
+  EXPECT_EQ(
+      mocked_database.key_map.count("block.fake.fake.0000000011.0000000004"),
+      1U);
+}
 } // namespace osquery
@@ -12,9 +12,11 @@
 #include <gtest/gtest.h>
 
 #include <cstdint>
+#include <cstring>
 #include <ctime>
 
 #include <sstream>
+#include <string_view>
 
 #include <osquery/core/flags.h>
 #include <osquery/core/tables.h>
@@ -73,10 +75,42 @@ TEST_F(AuditTests, test_handle_reply) {
   EXPECT_EQ("1440542781.644:403030", audit_event_record.audit_id);
   EXPECT_EQ(audit_event_record.fields.size(), 4U);
   EXPECT_EQ(audit_event_record.fields.count("argc"), 1U);
-  EXPECT_EQ(audit_event_record.fields["argc"], "3");
-  EXPECT_EQ(audit_event_record.fields["a0"], "\"H=1 \"");
-  EXPECT_EQ(audit_event_record.fields["a1"], "\"/bin/sh\"");
-  EXPECT_EQ(audit_event_record.fields["a2"], "c");
+  EXPECT_EQ(audit_event_record.fields.at("argc"), "3");
+  EXPECT_EQ(audit_event_record.fields.at("a0"), "\"H=1 \"");
+  EXPECT_EQ(audit_event_record.fields.at("a1"), "\"/bin/sh\"");
+  EXPECT_EQ(audit_event_record.fields.at("a2"), "c");
+}
+
+TEST_F(AuditTests, test_record_buffer_pool) {
+  auto pool = std::make_shared<AuditRecordBufferPool>(1U);
+  auto buffer = pool->acquire();
+  auto other_buffer = pool->acquire();
+  auto buffer_address = buffer.get();
+
+  std::string message = "audit(1440542781.644:403030): argc=3 a0=\"x y\"";
+  std::memcpy(buffer->data, message.data(), message.size());
+  std::string_view message_view(buffer->data, message.size());
+
+  // The record fields point into the buffer, which is kept alive.
+  AuditEventRecord audit_event_record = {};
+  ASSERT_TRUE(AuditdNetlinkParser::ParseAuditMessage(
+      1, message_view, std::move(buffer), audit_event_record));
+  EXPECT_EQ(pool->freeBufferCount(), 0U);
+  EXPECT_EQ(audit_event_record.fields.at("a0"), "\"x y\"");
+  EXPECT_EQ(audit_event_record.fields.at("argc").data(),
+            buffer_address->data + 30);
+
+  // Released buffers are reused, until the pool is full.
+  audit_event_record = {};
+  EXPECT_EQ(pool->freeBufferCount(), 1U);
+  other_buffer.reset();
+  EXPECT_EQ(pool->freeBufferCount(), 1U);
+  EXPECT_EQ(pool->acquire().get(), buffer_address);
+
+  // The buffers may outlive the pool.
+  other_buffer = pool->acquire();
+  pool.reset();
+  other_buffer.reset();
 }
 
 TEST_F(AuditTests, test_audit_value_decode) {
@@ -0,0 +1,134 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include "bpftestsmain.h"
+
+#include <osquery/events/linux/bpf/bpfeventreorderbuffer.h>
+
+namespace osquery {
+
+namespace {
+
+const std::uint64_t kOneSecond{1000000000ULL};
+
+BPFEventReorderBuffer::Event generateEvent(std::uint64_t timestamp,
+                                           std::uint64_t identifier = 1U) {
+  BPFEventReorderBuffer::Event event{};
+  event.identifier = identifier;
+  event.header.timestamp = timestamp;
+
+  return event;
+}
+
+} // namespace
+
+TEST_F(BPFEventReorderBufferTests, release_order) {
+  BPFEventReorderBuffer reorder_buffer(2U);
+
+  reorder_buffer.insert(generateEvent(10U * kOneSecond + 300U));
+  reorder_buffer.insert(generateEvent(11U * kOneSecond + 100U));
+  reorder_buffer.insert(generateEvent(10U * kOneSecond + 100U));
+  reorder_buffer.insert(generateEvent(10U * kOneSecond + 200U));
+  EXPECT_EQ(reorder_buffer.size(), 4U);
+
+  // Nothing is old enough yet
+  auto event_list = reorder_buffer.release(11U * kOneSecond);
+  EXPECT_TRUE(event_list.empty());
+  EXPECT_EQ(reorder_buffer.size(), 4U);
+
+  // Only the events of second 10 can be released
+  event_list = reorder_buffer.release(12U * kOneSecond + 500U);
+  ASSERT_EQ(event_list.size(), 3U);
+  EXPECT_EQ(event_list.at(0).header.timestamp, 10U * kOneSecond + 100U);
+  EXPECT_EQ(event_list.at(1).header.timestamp, 10U * kOneSecond + 200U);
+  EXPECT_EQ(event_list.at(2).header.timestamp, 10U * kOneSecond + 300U);
+  EXPECT_EQ(reorder_buffer.size(), 1U);
+
+  event_list = reorder_buffer.release(13U * kOneSecond);
+  ASSERT_EQ(event_list.size(), 1U);
+  EXPECT_EQ(event_list.at(0).header.timestamp, 11U * kOneSecond + 100U);
+  EXPECT_EQ(reorder_buffer.size(), 0U);
+}
+
+TEST_F(BPFEventReorderBufferTests, equal_timestamps) {
+  BPFEventReorderBuffer reorder_buffer(1U);
+
+  reorder_buffer.insert(generateEvent(5U * kOneSecond, 1U));
+  reorder_buffer.insert(generateEvent(5U * kOneSecond, 2U));
+  reorder_buffer.insert(generateEvent(5U * kOneSecond, 3U));
+
+  auto event_list = reorder_buffer.release(6U * kOneSecond);
+  ASSERT_EQ(event_list.size(), 3U);
+
+  // Events with the same timestamp keep their insertion order
+  EXPECT_EQ(event_list.at(0).identifier, 1U);
+  EXPECT_EQ(event_list.at(1).identifier, 2U);
+  EXPECT_EQ(event_list.at(2).identifier, 3U);
+}
+
+TEST_F(BPFEventReorderBufferTests, late_events) {
+  BPFEventReorderBuffer reorder_buffer(1U);
+
+  reorder_buffer.insert(generateEvent(20U * kOneSecond + 100U));
+
+  // This event maps to the same bucket as the one above (the ring holds 3
+  // seconds), but it is older: it must be released on the next call
+  reorder_buffer.insert(generateEvent(17U * kOneSecond + 100U));
+  EXPECT_EQ(reorder_buffer.size(), 2U);
+
+  auto event_list = reorder_buffer.release(20U * kOneSecond);
+  ASSERT_EQ(event_list.size(), 1U);
+  EXPECT_EQ(event_list.at(0).header.timestamp, 17U * kOneSecond + 100U);
+
+  // A bucket reused for a newer second hands its stale events over
+  reorder_buffer.insert(generateEvent(23U * kOneSecond + 100U));
+  EXPECT_EQ(reorder_buffer.size(), 2U);
+
+  event_list = reorder_buffer.release(23U * kOneSecond);
+  ASSERT_EQ(event_list.size(), 1U);
+  EXPECT_EQ(event_list.at(0).header.timestamp, 20U * kOneSecond + 100U);
+  EXPECT_EQ(reorder_buffer.size(), 1U);
+}
+
+TEST_F(BPFEventReorderBufferTests, max_size) {
+  BPFEventReorderBuffer reorder_buffer(1U, 2U);
+
+  EXPECT_TRUE(reorder_buffer.insert(generateEvent(5U * kOneSecond, 1U)));
+  EXPECT_TRUE(reorder_buffer.insert(generateEvent(5U * kOneSecond, 2U)));
+
+  // The buffer is full, newer events are dropped
+  EXPECT_FALSE(reorder_buffer.insert(generateEvent(5U * kOneSecond, 3U)));
+  EXPECT_EQ(reorder_buffer.size(), 2U);
+
+  auto event_list = reorder_buffer.release(6U * kOneSecond);
+  ASSERT_EQ(event_list.size(), 2U);
+  EXPECT_EQ(event_list.at(1).identifier, 2U);
+
+  // Released events make room again
+  EXPECT_TRUE(reorder_buffer.insert(generateEvent(6U * kOneSecond, 4U)));
+}
+
+TEST_F(BPFEventReorderBufferTests, oldest_timestamp) {
+  BPFEventReorderBuffer reorder_buffer(5U);
+  EXPECT_EQ(reorder_buffer.oldestTimestamp(), 0U);
+
+  reorder_buffer.insert(generateEvent(8U * kOneSecond + 50U));
+  reorder_buffer.insert(generateEvent(7U * kOneSecond + 900U));
+  reorder_buffer.insert(generateEvent(7U * kOneSecond + 400U));
+  EXPECT_EQ(reorder_buffer.oldestTimestamp(), 7U * kOneSecond + 400U);
+
+  reorder_buffer.release(12U * kOneSecond);
+  EXPECT_EQ(reorder_buffer.oldestTimestamp(), 8U * kOneSecond + 50U);
+
+  reorder_buffer.release(13U * kOneSecond);
+  EXPECT_EQ(reorder_buffer.oldestTimestamp(), 0U);
+  EXPECT_EQ(reorder_buffer.size(), 0U);
+}
+
+} // namespace osquery
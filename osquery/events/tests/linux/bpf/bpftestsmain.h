@@ -23,6 +23,11 @@ class BPFEventPublisherTests : public testing::Test {
   virtual void SetUp() override{};
 };
 
+class BPFEventReorderBufferTests : public testing::Test {
+ protected:
+  virtual void SetUp() override{};
+};
+
 class ProcessContextFactoryTests : public testing::Test {
  protected:
   virtual void SetUp() override{};
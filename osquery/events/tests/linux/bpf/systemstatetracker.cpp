@@ -13,6 +13,8 @@
 
 #include <osquery/events/linux/bpf/systemstatetracker.h>
 
+#include <chrono>
+
 #include <arpa/inet.h>
 #include <linux/fcntl.h>
 #include <linux/netlink.h>
@@ -746,11 +748,11 @@ TEST_F(SystemStateTrackerTests, open_file) {
 
   EXPECT_TRUE(succeeded);
   EXPECT_EQ(process_context.fd_map.size(), 11U);
-  EXPECT_TRUE(
-      validateFileDescriptor(process_context,
-                             18,
-                             false,
-                             process_context.cwd + "/" + relative_test_path));
+  EXPECT_TRUE(validateFileDescriptor(
+      process_context,
+      18,
+      false,
+      process_context.cwd.str() + "/" + relative_test_path));
 
   EXPECT_EQ(process_context_factory->invocationCount(), 1U);
 
@@ -768,7 +770,7 @@ TEST_F(SystemStateTrackerTests, open_file) {
   validateFileDescriptor(process_context,
                          19,
                          true,
-                         process_context.cwd + "/" + relative_test_path);
+                         process_context.cwd.str() + "/" + relative_test_path);
 
   EXPECT_EQ(process_context_factory->invocationCount(), 1U);
 
@@ -1363,4 +1365,145 @@ TEST_F(SystemStateTrackerTests, expireFileHandleEntries) {
   EXPECT_EQ(context.file_handle_struct_map.size(), 1U);
   EXPECT_EQ(context.file_handle_struct_index.size(), 1U);
 }
+
+TEST_F(SystemStateTrackerTests, copy_on_write_fd_map) {
+  auto process_context_factory =
+      std::make_unique<MockedProcessContextFactory>();
+
+  auto bpf_event_header = kBaseBPFEventHeader;
+  bpf_event_header.process_id = 1001;
+
+  SystemStateTracker::Context context;
+  auto succeeded =
+      SystemStateTracker::createProcess(context,
+                                        *process_context_factory.get(),
+                                        bpf_event_header,
+                                        1000,
+                                        bpf_event_header.process_id);
+
+  EXPECT_TRUE(succeeded);
+
+  // The child process shares the file descriptors of its parent
+  const auto& parent_process = context.process_map.at(1000);
+  const auto& child_process = context.process_map.at(1001);
+
+  EXPECT_TRUE(parent_process.fd_map.shared());
+  EXPECT_TRUE(child_process.fd_map.shared());
+  EXPECT_EQ(&parent_process.fd_map.at(0), &child_process.fd_map.at(0));
+  EXPECT_EQ(&parent_process.cwd.str(), &child_process.cwd.str());
+
+  // The first write copies the map, leaving the parent untouched
+  succeeded = SystemStateTracker::openFile(context,
+                                           *process_context_factory.get(),
+                                           1001,
+                                           AT_FDCWD,
+                                           100,
+                                           "/etc/hosts",
+                                           0);
+
+  EXPECT_TRUE(succeeded);
+  EXPECT_FALSE(parent_process.fd_map.shared());
+  EXPECT_FALSE(child_process.fd_map.shared());
+
+  EXPECT_EQ(parent_process.fd_map.size(), 8U);
+  EXPECT_EQ(child_process.fd_map.size(), 9U);
+  EXPECT_EQ(parent_process.fd_map.count(100), 0U);
+  EXPECT_TRUE(validateFileDescriptor(child_process, 100, false, "/etc/hosts"));
+
+  // Paths are still shared after the copy
+  using FileData = ProcessContext::FileDescriptor::FileData;
+
+  const auto& parent_fd_data =
+      std::get<FileData>(parent_process.fd_map.at(11).data);
+
+  const auto& child_fd_data =
+      std::get<FileData>(child_process.fd_map.at(11).data);
+
+  EXPECT_EQ(&parent_fd_data.path.str(), &child_fd_data.path.str());
+
+  // Closing a missing file descriptor must not copy the map
+  auto context_copy = context.process_map.at(1000);
+  EXPECT_TRUE(parent_process.fd_map.shared());
+
+  succeeded = SystemStateTracker::closeHandle(
+      context, *process_context_factory.get(), 1000, 200);
+
+  EXPECT_FALSE(succeeded);
+  EXPECT_TRUE(parent_process.fd_map.shared());
+}
+
+TEST_F(SystemStateTrackerTests, fork_heavy_trace) {
+  // Replays a build server-like trace: a shell forking short lived
+  // children that open a file, close their stdin and exec. The elapsed
+  // time is reported as the fork_heavy_trace_ms test property
+  const pid_t kFirstChildProcessId{10000};
+  const std::size_t kForkCount{20000U};
+
+  auto process_context_factory =
+      std::make_unique<MockedProcessContextFactory>();
+
+  auto bpf_event_header = kBaseBPFEventHeader;
+  SystemStateTracker::Context context;
+
+  auto start_time = std::chrono::steady_clock::now();
+
+  for (std::size_t i = 0U; i < kForkCount; ++i) {
+    auto child_process_id = static_cast<pid_t>(kFirstChildProcessId + i);
+    bpf_event_header.process_id = child_process_id;
+
+    auto succeeded =
+        SystemStateTracker::createProcess(context,
+                                          *process_context_factory.get(),
+                                          bpf_event_header,
+                                          1000,
+                                          child_process_id);
+    ASSERT_TRUE(succeeded);
+
+    succeeded = SystemStateTracker::openFile(context,
+                                             *process_context_factory.get(),
+                                             child_process_id,
+                                             AT_FDCWD,
+                                             16,
+                                             "Makefile",
+                                             O_CLOEXEC);
+    ASSERT_TRUE(succeeded);
+
+    succeeded = SystemStateTracker::closeHandle(
+        context, *process_context_factory.get(), child_process_id, 0);
+    ASSERT_TRUE(succeeded);
+
+    succeeded =
+        SystemStateTracker::executeBinary(context,
+                                          *process_context_factory.get(),
+                                          bpf_event_header,
+                                          child_process_id,
+                                          AT_FDCWD,
+                                          0,
+                                          "/usr/bin/cc",
+                                          {"cc", "-c", "main.c"});
+    ASSERT_TRUE(succeeded);
+
+    context.event_list.clear();
+  }
+
+  auto elapsed_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start_time);
+
+  RecordProperty("fork_heavy_trace_ms",
+                 static_cast<int>(elapsed_time.count()));
+
+  ASSERT_EQ(context.process_map.size(), kForkCount + 1U);
+
+  const auto& parent_process = context.process_map.at(1000);
+  EXPECT_EQ(parent_process.fd_map.size(), 8U);
+
+  // Every child dropped stdin and the close on exec descriptors
+  const auto& last_child_process = context.process_map.at(
+      static_cast<pid_t>(kFirstChildProcessId + kForkCount - 1U));
+
+  EXPECT_EQ(last_child_process.fd_map.size(), 5U);
+  EXPECT_EQ(last_child_process.fd_map.count(0), 0U);
+  EXPECT_EQ(last_child_process.fd_map.count(16), 0U);
+  EXPECT_EQ(last_child_process.binary_path, "/usr/bin/cc");
+}
 } // namespace osquery
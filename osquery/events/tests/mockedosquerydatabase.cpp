@@ -26,7 +26,6 @@ const Row kBaseRow = {
 } // namespace
 
 extern const std::string kEvents;
-extern const std::string kExecutingQuery;
 
 void MockedOsqueryDatabase::generateEvents(const std::string& publisher,
                                            const std::string& name) {
@@ -67,24 +66,12 @@ Status MockedOsqueryDatabase::getDatabaseValue(const std::string& domain,
   if (domain == kEvents) {
     auto key_it = key_map.find(key);
     if (key_it == key_map.end()) {
-      throw std::logic_error(
-          "MockedOsqueryDatabase: Invalid key passed to getDatabaseValue: " +
-          key);
+      return Status::failure("MockedOsqueryDatabase: Key not found: " + key);
     }
 
     value = key_it->second;
     return Status::success();
 
-  } else if (domain == kPersistentSettings) {
-    if (key != kExecutingQuery) {
-      throw std::logic_error(
-          "MockedOsqueryDatabase: Invalid key passed to getDatabaseValue: " +
-          key);
-    }
-
-    value = "test_query";
-    return Status::success();
-
   } else {
     throw std::logic_error(
         "MockedOsqueryDatabase: Invalid domain passed to getDatabaseValue: " +
@@ -127,8 +114,32 @@ Status MockedOsqueryDatabase::setDatabaseValue(const std::string& domain,
 
 Status MockedOsqueryDatabase::setDatabaseBatch(
     const std::string& domain, const DatabaseStringValueList& data) const {
-  return Status::failure(
-      "MockedOsqueryDatabase: Unsupported setDatabaseBatch call");
+  if (domain != kEvents) {
+    throw std::logic_error(
+        "MockedOsqueryDatabase: Invalid domain passed to setDatabaseBatch: " +
+        domain);
+  }
+
+  for (const auto& p : data) {
+    key_map[p.first] = p.second;
+  }
+  return Status::success();
+}
+
+Status MockedOsqueryDatabase::setDatabaseBatch(
+    const std::string& domain,
+    const DatabaseStringValueList& data,
+    const std::vector<std::string>& removals) const {
+  if (domain != kEvents) {
+    throw std::logic_error(
+        "MockedOsqueryDatabase: Invalid domain passed to setDatabaseBatch: " +
+        domain);
+  }
+
+  for (const auto& key : removals) {
+    key_map.erase(key);
+  }
+  return setDatabaseBatch(domain, data);
 }
 
 Status MockedOsqueryDatabase::deleteDatabaseValue(
@@ -190,4 +201,26 @@ Status MockedOsqueryDatabase::scanDatabaseKeys(const std::string& domain,
   return Status::success();
 }
 
+Status MockedOsqueryDatabase::scanDatabaseRange(
+    const std::string& domain,
+    const std::string& low,
+    const std::string& high,
+    const DatabaseScanCallback& callback) const {
+  if (domain != kEvents) {
+    throw std::logic_error(
+        "MockedOsqueryDatabase: Invalid parameter passed to "
+        "scanDatabaseRange. domain:" +
+        domain);
+  }
+
+  for (auto it = key_map.lower_bound(low); it != key_map.end(); ++it) {
+    if ((!high.empty() && it->first >= high) ||
+        !callback(it->first, it->second)) {
+      break;
+    }
+  }
+
+  return Status::success();
+}
+
 } // namespace osquery
@@ -42,6 +42,11 @@ class MockedOsqueryDatabase final : public IDatabaseInterface {
       const std::string& domain,
       const DatabaseStringValueList& data) const override;
 
+  virtual Status setDatabaseBatch(
+      const std::string& domain,
+      const DatabaseStringValueList& data,
+      const std::vector<std::string>& removals) const override;
+
   virtual Status deleteDatabaseValue(const std::string& domain,
                                      const std::string& key) const override;
 
@@ -57,6 +62,12 @@ class MockedOsqueryDatabase final : public IDatabaseInterface {
                                   std::vector<std::string>& keys,
                                   const std::string& prefix,
                                   size_t max) const override;
+
+  virtual Status scanDatabaseRange(
+      const std::string& domain,
+      const std::string& low,
+      const std::string& high,
+      const DatabaseScanCallback& callback) const override;
 };
 
 } // namespace osquery
@@ -0,0 +1,147 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <mutex>
+
+#include <boost/filesystem.hpp>
+
+#include <osquery/core/tables.h>
+#include <osquery/extensions/extensions.h>
+#include <osquery/extensions/interface.h>
+#include <osquery/filesystem/fileops.h>
+#include <osquery/registry/registry_factory.h>
+#include <osquery/sql/sql.h>
+
+namespace fs = boost::filesystem;
+
+namespace osquery {
+
+DECLARE_uint64(extensions_idle_connections);
+
+namespace {
+
+/// The number of rows of the core table, each one calls the extension.
+size_t kBenchmarkOuterRows{0U};
+
+/// The extension socket, set once the extension is registered.
+std::string kBenchmarkExtensionSocket;
+
+} // namespace
+
+class BenchmarkOuterTablePlugin : public TablePlugin {
+ protected:
+  TableColumns columns() const override {
+    return {
+        std::make_tuple("id", INTEGER_TYPE, ColumnOptions::DEFAULT),
+    };
+  }
+
+  TableRows generate(QueryContext& ctx) override {
+    TableRows results;
+    for (size_t i = 0; i < kBenchmarkOuterRows; i++) {
+      results.push_back(make_table_row({{"id", std::to_string(i)}}));
+    }
+    return results;
+  }
+};
+
+class BenchmarkExtensionTablePlugin : public TablePlugin {
+ protected:
+  TableColumns columns() const override {
+    return {
+        std::make_tuple("id", INTEGER_TYPE, ColumnOptions::INDEX),
+        std::make_tuple("value", TEXT_TYPE, ColumnOptions::DEFAULT),
+    };
+  }
+
+  TableRows generate(QueryContext& ctx) override {
+    TableRows results;
+    for (const auto& id : ctx.constraints["id"].getAll(EQUALS)) {
+      results.push_back(make_table_row({{"id", id}, {"value", "extension"}}));
+    }
+    return results;
+  }
+};
+
+/**
+ * Start an extension manager and an extension within this process.
+ *
+ * As in the extensions tests, the extension table is broadcasted as an alias
+ * so calls to it are routed through the extension socket.
+ */
+static void setUpBenchmarkExtension() {
+  static std::once_flag setup_flag;
+  std::call_once(setup_flag, []() {
+    auto socket_path =
+        (fs::temp_directory_path() /
+         fs::unique_path("osquery.extensions_benchmark.%%%%.%%%%"))
+            .string();
+
+    auto& rf = RegistryFactory::get();
+    rf.registry("table")->add("benchmark_outer",
+                              std::make_shared<BenchmarkOuterTablePlugin>());
+    rf.registry("table")->add(
+        "benchmark_extension_local",
+        std::make_shared<BenchmarkExtensionTablePlugin>());
+    rf.addAlias("table", "benchmark_extension_local", "benchmark_extension");
+    rf.allowDuplicates(true);
+
+    startExtensionManager(socket_path);
+    auto status =
+        startExtension(socket_path, "benchmark", "0.1", "0.0.0", "0.0.0");
+    if (status.ok()) {
+      kBenchmarkExtensionSocket = socket_path + "." + status.getMessage();
+    }
+  });
+}
+
+static void EXTENSIONS_call(benchmark::State& state) {
+  setUpBenchmarkExtension();
+  FLAGS_extensions_idle_connections = state.range(0);
+  ExtensionClientPool::get().reset();
+
+  PluginRequest request = {{"action", "generate"},
+                           {"context", "{\"constraints\":[]}"}};
+  while (state.KeepRunning()) {
+    PluginResponse response;
+    callExtension(kBenchmarkExtensionSocket,
+                  "table",
+                  "benchmark_extension",
+                  request,
+                  response);
+  }
+}
+
+BENCHMARK(EXTENSIONS_call)->Arg(0)->Arg(2);
+
+static void EXTENSIONS_join_extension_table(benchmark::State& state) {
+  setUpBenchmarkExtension();
+  kBenchmarkOuterRows = state.range(0);
+  FLAGS_extensions_idle_connections = state.range(1);
+  ExtensionClientPool::get().reset();
+
+  // The extension is called once for each row of the core table.
+  while (state.KeepRunning()) {
+    SQL results(
+        "select * from benchmark_outer o join benchmark_extension e "
+        "using (id)");
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(EXTENSIONS_join_extension_table)
+    ->ArgPair(10, 0)
+    ->ArgPair(10, 2)
+    ->ArgPair(100, 0)
+    ->ArgPair(100, 2)
+    ->ArgPair(1000, 0)
+    ->ArgPair(1000, 2);
+} // namespace osquery
@@ -88,6 +88,11 @@ CLI_FLAG(string,
          "",
          "Comma-separated list of required extensions");
 
+CLI_FLAG(uint64,
+         extensions_idle_connections,
+         0,
+         "Connections kept open to each extension between calls");
+
 /**
  * @brief Alias the extensions_socket (used by core) to a simple 'socket'.
  *
@@ -197,6 +202,49 @@ Status extensionPathActive(const std::string& path, bool use_timeout = false) {
   }));
 }
 
+/// Call an extension using an idle pooled client, or a new connection.
+static Status callPooledClient(
+    const std::string& extension_path,
+    const std::function<Status(ExtensionClient&)>& call) {
+  auto& pool = ExtensionClientPool::get();
+  auto client = pool.acquire(extension_path);
+
+  Status status;
+  try {
+    if (client == nullptr) {
+      client = std::make_unique<ExtensionClient>(extension_path);
+    }
+    status = call(*client);
+  } catch (const std::exception& e) {
+    // The extension may have restarted, do not reuse its other connections.
+    pool.reset(extension_path);
+    return Status(1, "Extension call failed: " + std::string(e.what()));
+  }
+
+  pool.release(extension_path, std::move(client));
+  return status;
+}
+
+/**
+ * @brief Call an extension, checking its socket before a new connection.
+ *
+ * The check is skipped when an idle client is pooled. A single-threaded
+ * extension server only accepts a new connection once the idle one closes.
+ */
+static Status callPooledExtension(
+    const std::string& extension_path,
+    const std::function<Status(ExtensionClient&)>& call) {
+  if (ExtensionClientPool::get().idleCount(extension_path) == 0) {
+    // Make sure the extension manager path exists, and is writable.
+    auto status = extensionPathActive(extension_path);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  return callPooledClient(extension_path, call);
+}
+
 ExtensionWatcher::ExtensionWatcher(const std::string& path,
                                    size_t interval,
                                    bool fatal,
@@ -234,6 +282,7 @@ void ExtensionManagerWatcher::start() {
   }
 
   // When interrupted, request each extension tear down.
+  ExtensionClientPool::get().reset();
   const auto uuids = RegistryFactory::get().routeUUIDs();
   for (const auto& uuid : uuids) {
     try {
@@ -321,14 +370,9 @@ void ExtensionManagerWatcher::watch() {
     // If failures get to 2 then the extension will be removed.
     failures_[uuid] = 1;
     if (exists.ok()) {
-      try {
-        ExtensionClient client(path);
-        // Ping the extension until it goes down.
-        status = client.ping();
-      } catch (const std::exception& /* e */) {
-        failures_[uuid] += 1;
-        continue;
-      }
+      // Ping the extension until it goes down.
+      status = callPooledClient(
+          path, [](ExtensionClient& client) { return client.ping(); });
     } else {
       // Immediate fail non-writable paths.
       failures_[uuid] += 1;
@@ -347,6 +391,7 @@ void ExtensionManagerWatcher::watch() {
     if (uuid.second > 1) {
       LOG(INFO) << "Extension UUID " << uuid.first << " has gone away";
       RegistryFactory::get().removeBroadcast(uuid.first);
+      ExtensionClientPool::get().reset(getExtensionSocket(uuid.first));
       failures_[uuid.first] = 1;
     }
   }
@@ -617,20 +662,16 @@ Status pingExtension(const std::string& path) {
     return Status(1, "Extensions disabled");
   }
 
-  // Make sure the extension path exists, and is writable.
-  auto status = extensionPathActive(path);
+  Status ping_status;
+  auto status = callPooledExtension(path, [&](ExtensionClient& client) {
+    ping_status = client.ping();
+    return Status::success();
+  });
   if (!status.ok()) {
     return status;
   }
 
-  try {
-    ExtensionClient client(path);
-    status = client.ping();
-  } catch (const std::exception& e) {
-    return Status(1, "Extension call failed: " + std::string(e.what()));
-  }
-
-  return Status(0, status.getMessage());
+  return Status(0, ping_status.getMessage());
 }
 
 Status getExtensions(ExtensionList& extensions) {
@@ -687,20 +728,99 @@ Status callExtension(const std::string& extension_path,
                      const std::string& item,
                      const PluginRequest& request,
                      PluginResponse& response) {
-  // Make sure the extension manager path exists, and is writable.
-  auto status = extensionPathActive(extension_path);
-  if (!status.ok()) {
-    return status;
+  return callPooledExtension(extension_path, [&](ExtensionClient& client) {
+    return client.call(registry, item, request, response);
+  });
+}
+
+Status callExtensionTable(const std::string& table,
+                          const PluginRequest& request,
+                          PluginResponse& response,
+                          ColumnarRows& columns) {
+  RouteUUID uuid = 0;
+  auto registry = RegistryFactory::get().registry("table");
+  if (!registry->getExternalUUID(table, uuid)) {
+    return Registry::call("table", table, request, response);
   }
 
-  try {
-    ExtensionClient client(extension_path);
-    status = client.call(registry, item, request, response);
-  } catch (const std::exception& e) {
-    return Status(1, "Extension call failed: " + std::string(e.what()));
+  if (FLAGS_disable_extensions) {
+    return Status(1, "Extensions disabled");
   }
+  return callPooledExtension(
+      getExtensionSocket(uuid), [&](ExtensionClient& client) {
+        return client.callColumnar(table, request, response, columns);
+      });
+}
 
-  return status;
+ExtensionClientPool& ExtensionClientPool::get() {
+  static ExtensionClientPool pool;
+  return pool;
+}
+
+ExtensionClientPool::ClientRef ExtensionClientPool::acquire(
+    const std::string& path) {
+  while (true) {
+    ClientRef client;
+
+    {
+      WriteLock lock(mutex_);
+      auto it = idle_clients_.find(path);
+      if (it == idle_clients_.end() || it->second.empty()) {
+        return nullptr;
+      }
+
+      client = std::move(it->second.back());
+      it->second.pop_back();
+    }
+
+    // Drop the clients whose connection was closed by the extension.
+    if (client->isConnected()) {
+      return client;
+    }
+  }
+}
+
+void ExtensionClientPool::release(const std::string& path, ClientRef client) {
+  WriteLock lock(mutex_);
+  auto& clients = idle_clients_[path];
+  if (clients.size() < FLAGS_extensions_idle_connections) {
+    clients.push_back(std::move(client));
+    return;
+  }
+
+  // Close the connection outside of the lock.
+  lock.unlock();
+  client.reset();
+}
+
+void ExtensionClientPool::reset(const std::string& path) {
+  std::vector<ClientRef> clients;
+
+  {
+    WriteLock lock(mutex_);
+    auto it = idle_clients_.find(path);
+    if (it == idle_clients_.end()) {
+      return;
+    }
+
+    clients = std::move(it->second);
+    idle_clients_.erase(it);
+  }
+}
+
+void ExtensionClientPool::reset() {
+  std::map<std::string, std::vector<ClientRef>> idle_clients;
+
+  {
+    WriteLock lock(mutex_);
+    idle_clients.swap(idle_clients_);
+  }
+}
+
+size_t ExtensionClientPool::idleCount(const std::string& path) {
+  WriteLock lock(mutex_);
+  auto it = idle_clients_.find(path);
+  return it == idle_clients_.end() ? 0U : it->second.size();
 }
 
 Status startExtensionWatcher(const std::string& manager_path,
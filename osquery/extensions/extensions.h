@@ -12,6 +12,7 @@
 #include <osquery/core/core.h>
 #include <osquery/core/flags.h>
 #include <osquery/core/plugins/sql.h>
+#include <osquery/core/sql/columnar_rows.h>
 #include <osquery/registry/registry_interface.h>
 
 namespace osquery {
@@ -138,6 +139,25 @@ Status callExtension(const std::string& extension_path,
                      const PluginRequest& request,
                      PluginResponse& response);
 
+/**
+ * @brief Call a table's generate action, accepting the rows as columns.
+ *
+ * Tables broadcasted by an extension that supports columns respond with
+ * columns, otherwise the rows are in the response and the columns are empty.
+ * Tables that do not belong to an extension are called through the Registry.
+ *
+ * @param table The table name.
+ * @param request The plugin request input, with a generate action.
+ * @param response The plugin response output, if rows are not columns.
+ * @param columns The generated rows as columns.
+ * @return Success indicates Extension API call success and Extension's
+ * Registry::call success.
+ */
+Status callExtensionTable(const std::string& table,
+                          const PluginRequest& request,
+                          PluginResponse& response,
+                          ColumnarRows& columns);
+
 /// The main runloop entered by an Extension, start an ExtensionRunner thread.
 Status startExtension(const std::string& name, const std::string& version);
 
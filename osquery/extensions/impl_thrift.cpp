@@ -9,6 +9,7 @@
 
 #include <osquery/core/core.h>
 #include <osquery/core/system.h>
+#include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/logger/logger.h>
 
@@ -23,6 +24,8 @@
 #include <thrift/transport/TPipe.h>
 #include <thrift/transport/TPipeServer.h>
 #else
+#include <poll.h>
+
 #include <thrift/transport/TServerSocket.h>
 #include <thrift/transport/TSocket.h>
 #endif
@@ -181,6 +184,104 @@ struct ImplExtensionClient {
   std::shared_ptr<TPlatformSocket> socket;
 };
 
+/**
+ * @brief Response row key holding the columns sent by an extension.
+ *
+ * Columns are sent as a single response row, so the Thrift IDL and the
+ * other SDKs are unchanged. No table column has an empty name.
+ */
+const std::string kColumnarKey{""};
+
+/// Encode columns with the Thrift binary protocol, names are written once.
+static std::string serializeColumns(const ColumnarRows& columns) {
+  auto buffer = std::make_shared<TMemoryBuffer>();
+  TBinaryProtocol protocol(buffer);
+  protocol.writeI64(static_cast<int64_t>(columns.row_count));
+  protocol.writeI32(static_cast<int32_t>(columns.columns.size()));
+  for (const auto& column : columns.columns) {
+    protocol.writeString(column.name);
+    protocol.writeString(columnTypeName(column.type));
+    protocol.writeI32(static_cast<int32_t>(column.text_values.size()));
+    for (const auto& value : column.text_values) {
+      protocol.writeString(value);
+    }
+    protocol.writeI32(static_cast<int32_t>(column.integer_values.size()));
+    for (const auto& value : column.integer_values) {
+      protocol.writeI64(value);
+    }
+    protocol.writeI32(static_cast<int32_t>(column.double_values.size()));
+    for (const auto& value : column.double_values) {
+      protocol.writeDouble(value);
+    }
+    protocol.writeBinary(column.nulls);
+  }
+  return buffer->getBufferAsString();
+}
+
+/// Read a count, each of the counted values uses at least min_size bytes.
+static size_t readCount(TBinaryProtocol& protocol,
+                        const TMemoryBuffer& buffer,
+                        size_t min_size) {
+  int32_t count = 0;
+  protocol.readI32(count);
+  if (count < 0 ||
+      static_cast<size_t>(count) > buffer.available_read() / min_size) {
+    throw TProtocolException(TProtocolException::SIZE_LIMIT);
+  }
+  return static_cast<size_t>(count);
+}
+
+/// Decode columns encoded by serializeColumns.
+static Status deserializeColumns(const std::string& encoded,
+                                 ColumnarRows& columns) {
+  auto buffer = std::make_shared<TMemoryBuffer>(
+      reinterpret_cast<uint8_t*>(const_cast<char*>(encoded.data())),
+      static_cast<uint32_t>(encoded.size()),
+      TMemoryBuffer::OBSERVE);
+  TBinaryProtocol protocol(buffer);
+  protocol.setStringSizeLimit(static_cast<int32_t>(encoded.size()));
+  try {
+    int64_t row_count = 0;
+    protocol.readI64(row_count);
+    if (row_count < 0) {
+      throw TProtocolException(TProtocolException::NEGATIVE_SIZE);
+    }
+    columns.row_count = static_cast<size_t>(row_count);
+
+    // A column uses at least its name, type and three counts.
+    columns.columns.resize(readCount(protocol, *buffer, 24));
+    for (auto& column : columns.columns) {
+      std::string type;
+      protocol.readString(column.name);
+      protocol.readString(type);
+      column.type = columnTypeName(type);
+
+      column.text_values.resize(readCount(protocol, *buffer, 4));
+      for (auto& value : column.text_values) {
+        protocol.readString(value);
+      }
+      column.integer_values.resize(readCount(protocol, *buffer, 8));
+      for (auto& value : column.integer_values) {
+        protocol.readI64(value);
+      }
+      column.double_values.resize(readCount(protocol, *buffer, 8));
+      for (auto& value : column.double_values) {
+        protocol.readDouble(value);
+      }
+      protocol.readBinary(column.nulls);
+    }
+  } catch (const TException& /* e */) {
+    columns = ColumnarRows();
+    return Status(1, "Invalid columnar response from extension");
+  }
+
+  if (buffer->available_read() != 0 || !columns.valid()) {
+    columns = ColumnarRows();
+    return Status(1, "Invalid columnar response from extension");
+  }
+  return Status::success();
+}
+
 void ExtensionHandler::ping(extensions::ExtensionStatus& _return) {
   auto s = ExtensionInterface::ping();
   _return.code = (int)extensions::ExtensionCode::EXT_SUCCESS;
@@ -199,15 +300,27 @@ void ExtensionHandler::call(extensions::ExtensionResponse& _return,
   }
 
   PluginResponse response;
-  auto s = ExtensionInterface::call(registry, item, plugin_request, response);
+  ColumnarRows columns;
+  Status s;
+  if (registry == "table" && request.count("columnar") > 0) {
+    // The caller accepts generated table rows as columns.
+    s = ExtensionInterface::callColumnar(
+        item, plugin_request, response, columns);
+  } else {
+    s = ExtensionInterface::call(registry, item, plugin_request, response);
+  }
   _return.status.code = s.getCode();
   _return.status.message = s.getMessage();
   _return.status.uuid = getUUID();
 
   if (s.ok()) {
-    for (const auto& response_item : response) {
+    for (auto& response_item : response) {
       // Translate a PluginResponse to an ExtensionPluginResponse.
-      _return.response.push_back(response_item);
+      _return.response.push_back(std::move(response_item));
+    }
+
+    if (!columns.columns.empty()) {
+      _return.response.push_back({{kColumnarKey, serializeColumns(columns)}});
     }
   }
 }
@@ -432,6 +545,29 @@ bool ExtensionClientCore::manager() {
   return manager_;
 }
 
+bool ExtensionClientCore::isConnected() {
+  if (!client_->transport->isOpen()) {
+    return false;
+  }
+
+  // An idle connection has nothing to read, unless the server has closed it.
+#if !defined(WIN32)
+  pollfd fds[] = {{client_->socket->getSocketFD(), POLLIN, 0}};
+  return ::poll(fds, 1, 0) == 0;
+#else
+  DWORD available = 0;
+  if (!PeekNamedPipe(client_->socket->getPipeHandle(),
+                     nullptr,
+                     0,
+                     nullptr,
+                     &available,
+                     nullptr)) {
+    return false;
+  }
+  return available == 0;
+#endif
+}
+
 ExtensionClient::ExtensionClient(const std::string& path, size_t timeout) {
   init(path, false);
   setTimeouts(timeout == 0 ? FLAGS_thrift_timeout : timeout);
@@ -460,8 +596,37 @@ Status ExtensionClient::call(const std::string& registry,
   extensions::ExtensionResponse er;
   auto client = manager() ? client_->em : client_->e;
   client->call(er, registry, item, request);
-  for (const auto& r : er.response) {
-    response.push_back(r);
+  for (auto& r : er.response) {
+    response.push_back(std::move(r));
+  }
+
+  return Status(er.status.code, er.status.message);
+}
+
+Status ExtensionClient::callColumnar(const std::string& item,
+                                     const PluginRequest& request,
+                                     PluginResponse& response,
+                                     ColumnarRows& columns) {
+  // Extensions that do not know the columnar key ignore it.
+  extensions::ExtensionPluginRequest columnar_request = request;
+  columnar_request["columnar"] = "1";
+
+  extensions::ExtensionResponse er;
+  auto client = manager() ? client_->em : client_->e;
+  client->call(er, "table", item, columnar_request);
+  for (auto& r : er.response) {
+    response.push_back(std::move(r));
+  }
+
+  if (response.size() == 1 && response[0].size() == 1 &&
+      response[0].count(kColumnarKey) > 0) {
+    auto encoded = std::move(response[0][kColumnarKey]);
+    response.clear();
+
+    auto status = deserializeColumns(encoded, columns);
+    if (!status.ok()) {
+      return status;
+    }
   }
 
   return Status(er.status.code, er.status.message);
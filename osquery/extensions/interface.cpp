@@ -15,6 +15,7 @@
 #include <osquery/core/core.h>
 #include <osquery/core/shutdown.h>
 #include <osquery/core/system.h>
+#include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/logger/logger.h>
 #include <osquery/registry/registry_factory.h>
@@ -82,6 +83,29 @@ Status ExtensionInterface::call(const std::string& registry,
   return RegistryFactory::call(registry, local_item, request, response);
 }
 
+Status ExtensionInterface::callColumnar(const std::string& item,
+                                        const PluginRequest& request,
+                                        PluginResponse& response,
+                                        ColumnarRows& columns) {
+  auto local_item = RegistryFactory::get().getAlias("table", item);
+  if (RegistryFactory::get().exists("table", local_item, true)) {
+    auto table = std::dynamic_pointer_cast<TablePlugin>(
+        RegistryFactory::get().plugin("table", local_item));
+    if (table != nullptr) {
+      try {
+        return table->callColumnar(request, response, columns);
+      } catch (const std::exception& e) {
+        LOG(ERROR) << "table registry " << local_item
+                   << " plugin caused exception: " << e.what();
+        return Status(1, e.what());
+      }
+    }
+  }
+
+  // Tables that are not local to this process respond with rows.
+  return call("table", item, request, response);
+}
+
 void ExtensionInterface::shutdown() {
   // Request a graceful shutdown of the Thrift listener.
   VLOG(1) << "Extension " << uuid_ << " requested shutdown";
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <osquery/core/query.h>
+#include <osquery/core/sql/columnar_rows.h>
 #include <osquery/dispatcher/dispatcher.h>
 #include <osquery/extensions/extensions.h>
 
@@ -98,6 +99,12 @@ class ExtensionInterface : public ExtensionAPI {
                       PluginResponse& response) override;
   virtual void shutdown() override;
 
+  /// Call a table plugin, a generate action may respond with columns.
+  Status callColumnar(const std::string& item,
+                      const PluginRequest& request,
+                      PluginResponse& response,
+                      ColumnarRows& columns);
+
  protected:
   /// Transient UUID assigned to the extension after registering.
   std::atomic<RouteUUID> uuid_;
@@ -328,6 +335,9 @@ class ExtensionClientCore : private boost::noncopyable {
   /// Check if the client is an extension manager.
   bool manager();
 
+  /// Check that an idle connection has not been closed by the server.
+  bool isConnected();
+
  protected:
   /// Path to extension server socket.
   std::string path_;
@@ -366,6 +376,17 @@ class ExtensionClient : public ExtensionClientCore, public ExtensionAPI {
               const PluginRequest& request,
               PluginResponse& response) override;
 
+  /**
+   * @brief Call an extension's table plugin, accepting columns.
+   *
+   * Extensions that do not support columns respond with rows, and leave the
+   * columns empty.
+   */
+  Status callColumnar(const std::string& item,
+                      const PluginRequest& request,
+                      PluginResponse& response,
+                      ColumnarRows& columns);
+
   /// Request that the extension stop.
   void shutdown() override;
 };
@@ -405,6 +426,44 @@ class ExtensionManagerClient : public ExtensionClient,
   Status getQueryColumns(const std::string& sql, QueryData& qd) override;
 };
 
+/**
+ * @brief Keeps connections to each extension open between calls.
+ *
+ * Extension tables are called from xFilter, so a JOIN calls an extension once
+ * for every outer row. Up to `--extensions_idle_connections` clients per
+ * extension socket are kept connected; an idle client is checked before it is
+ * reused, and the clients of an extension are dropped when a call fails or
+ * when the extension goes away.
+ */
+class ExtensionClientPool : private boost::noncopyable {
+ public:
+  using ClientRef = std::unique_ptr<ExtensionClient>;
+
+  static ExtensionClientPool& get();
+
+  /// Take a connected idle client to an extension, or nullptr.
+  ClientRef acquire(const std::string& path);
+
+  /// Keep a client to an extension for the next calls.
+  void release(const std::string& path, ClientRef client);
+
+  /// Close the idle clients to an extension.
+  void reset(const std::string& path);
+
+  /// Close every idle client.
+  void reset();
+
+  /// The number of idle clients to an extension.
+  size_t idleCount(const std::string& path);
+
+ private:
+  /// Idle clients, by extension socket path.
+  std::map<std::string, std::vector<ClientRef>> idle_clients_;
+
+  /// Mutex for the idle clients.
+  Mutex mutex_;
+};
+
 /// Attempt to remove all stale extension sockets.
 void removeStalePaths(const std::string& manager);
 } // namespace osquery
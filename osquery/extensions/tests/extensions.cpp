@@ -13,6 +13,7 @@
 #endif
 
 #include <stdexcept>
+#include <thread>
 
 #include <gtest/gtest.h>
 
@@ -29,11 +30,35 @@
 
 #include <boost/filesystem.hpp>
 
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/server/TSimpleServer.h>
+#include <thrift/transport/TBufferTransports.h>
+
+#ifdef WIN32
+#include <thrift/transport/TPipeServer.h>
+#else
+#include <thrift/transport/TServerSocket.h>
+#endif
+
+#include "Extension.h"
+
 namespace fs = boost::filesystem;
 
+using namespace apache::thrift::protocol;
+using namespace apache::thrift::server;
+using namespace apache::thrift::transport;
+
 namespace osquery {
 
 DECLARE_string(extensions_require);
+DECLARE_uint64(extensions_idle_connections);
+DECLARE_uint32(thrift_timeout);
+
+#ifdef WIN32
+using TPlatformServerSocket = TPipeServer;
+#else
+using TPlatformServerSocket = TServerSocket;
+#endif
 
 const int kDelay = 20;
 const int kTimeout = 3000;
@@ -283,8 +308,102 @@ TEST_F(ExtensionsTest, test_extension_broadcast) {
   EXPECT_EQ(response.size(), 1U);
   EXPECT_EQ(response[0]["test_key"], "test_value");
 
+  // Without idle connections every call connects to the extension.
+  auto& pool = ExtensionClientPool::get();
+  EXPECT_EQ(pool.idleCount(ext_socket), 0U);
+
+  // With idle connections the connection is kept open and reused.
+  auto idle_connections = FLAGS_extensions_idle_connections;
+  FLAGS_extensions_idle_connections = 2;
+  response.clear();
+  status = callExtension(ext_socket,
+                         "extension_test",
+                         "test_alias",
+                         {{"test_key", "test_value"}},
+                         response);
+  EXPECT_TRUE(status.ok());
+  EXPECT_EQ(pool.idleCount(ext_socket), 1U);
+
+  response.clear();
+  status = callExtension(ext_socket,
+                         "extension_test",
+                         "test_alias",
+                         {{"test_key", "test_value"}},
+                         response);
+  EXPECT_TRUE(status.ok());
+  EXPECT_EQ(response.size(), 1U);
+  EXPECT_EQ(pool.idleCount(ext_socket), 1U);
+
+  pool.reset(ext_socket);
+  EXPECT_EQ(pool.idleCount(ext_socket), 0U);
+  FLAGS_extensions_idle_connections = idle_connections;
+
   rf.removeBroadcast(uuid);
   rf.allowDuplicates(false);
 }
 
+/// An extension served like the single-threaded Thrift servers of some SDKs.
+class SimpleExtensionHandler : public extensions::ExtensionIf {
+ public:
+  void ping(extensions::ExtensionStatus& _return) override {
+    _return.code = static_cast<int>(ExtensionCode::EXT_SUCCESS);
+    _return.message = "pong";
+  }
+
+  void call(extensions::ExtensionResponse& _return,
+            const std::string& registry,
+            const std::string& item,
+            const extensions::ExtensionPluginRequest& request) override {
+    _return.status.code = static_cast<int>(ExtensionCode::EXT_SUCCESS);
+    _return.response.push_back(request);
+  }
+
+  void shutdown() override {}
+};
+
+TEST_F(ExtensionsTest, test_extension_single_threaded_server) {
+  auto ext_socket = socket_path + ".simple";
+  auto server = std::make_shared<TSimpleServer>(
+      std::make_shared<extensions::ExtensionProcessor>(
+          std::make_shared<SimpleExtensionHandler>()),
+      std::make_shared<TPlatformServerSocket>(ext_socket),
+      std::make_shared<TBufferedTransportFactory>(),
+      std::make_shared<TBinaryProtocolFactory>());
+  std::thread serve([server]() { server->serve(); });
+  ASSERT_TRUE(socketExistsLocal(ext_socket));
+
+  // A blocked call fails with the timeout instead of hanging the test.
+  auto idle_connections = FLAGS_extensions_idle_connections;
+  auto thrift_timeout = FLAGS_thrift_timeout;
+  FLAGS_thrift_timeout = 3;
+
+  // The server only accepts a new connection once the previous one closed.
+  auto& pool = ExtensionClientPool::get();
+  for (size_t idle : {0, 1}) {
+    FLAGS_extensions_idle_connections = idle;
+    for (size_t i = 0; i < 2; i++) {
+      PluginResponse response;
+      auto status =
+          callExtension(ext_socket, "table", "simple", {{"i", "1"}}, response);
+      EXPECT_TRUE(status.ok()) << status.getMessage();
+      EXPECT_EQ(response.size(), 1U);
+      EXPECT_EQ(pool.idleCount(ext_socket), idle);
+
+      // The ping uses the idle connection while one is pooled.
+      status = pingExtension(ext_socket);
+      EXPECT_TRUE(status.ok()) << status.getMessage();
+      EXPECT_EQ(pool.idleCount(ext_socket), idle);
+    }
+  }
+
+  pool.reset(ext_socket);
+  FLAGS_extensions_idle_connections = idle_connections;
+  FLAGS_thrift_timeout = thrift_timeout;
+
+  server->stop();
+  serve.join();
+  if (!isPlatform(PlatformType::TYPE_WINDOWS)) {
+    fs::remove(fs::path(ext_socket));
+  }
+}
 } // namespace osquery
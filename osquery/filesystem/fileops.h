@@ -136,6 +136,8 @@ std::string lastErrorMessage(unsigned long);
 
 #define PF_NONBLOCK 0x0020
 #define PF_APPEND 0x0040
+// The file is read once from start to end, hint readahead and skip the atime.
+#define PF_SEQUENTIAL 0x0080
 
 /**
  * @brief Modes for seeking through a file.
@@ -282,6 +284,9 @@ class PlatformFile : private boost::noncopyable {
   /// Use the platform-specific seek.
   off_t seek(off_t offset, SeekMode mode);
 
+  /// Flush written data to the underlying storage device.
+  bool sync();
+
   /// Inspect the file size.
   size_t size() const;
 
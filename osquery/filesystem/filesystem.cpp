@@ -83,13 +83,19 @@ Status writeTextFile(const fs::path& path,
 
 struct OpenReadableFile : private boost::noncopyable {
  public:
-  explicit OpenReadableFile(const fs::path& path, bool blocking = false)
+  explicit OpenReadableFile(const fs::path& path,
+                            bool blocking = false,
+                            bool sequential = false)
       : blocking_io(blocking) {
     int mode = PF_OPEN_EXISTING | PF_READ;
     if (!blocking) {
       mode |= PF_NONBLOCK;
     }
 
+    if (sequential) {
+      mode |= PF_SEQUENTIAL;
+    }
+
     // Open the file descriptor and allow caller to perform error checking.
     fd = std::make_unique<PlatformFile>(path, mode);
 
@@ -113,8 +119,9 @@ Status readFile(const fs::path& path,
                 bool dry_run,
                 bool preserve_time,
                 std::function<void(std::string& buffer, size_t size)> predicate,
-                bool blocking) {
-  OpenReadableFile handle(path, blocking);
+                bool blocking,
+                bool sequential) {
+  OpenReadableFile handle(path, blocking, sequential);
 
   if (handle.fd == nullptr || !handle.fd->isValid()) {
     return Status::failure("Cannot open file for reading: " + path.string());
@@ -154,12 +161,18 @@ Status readFile(const fs::path& path,
 
   off_t total_bytes = 0;
   if (handle.blocking_io) {
-    // Reset block size to a sane minimum.
+    // Do not allocate more than the file needs, then reset block size to a
+    // sane minimum.
+    if (file_size > 0 && static_cast<off_t>(block_size) > file_size) {
+      block_size = static_cast<size_t>(file_size);
+    }
     block_size = (block_size < 4096) ? 4096 : block_size;
     ssize_t part_bytes = 0;
     bool overflow = false;
+    std::string part;
     do {
-      std::string part(block_size, '\0');
+      // The predicate may move the buffer out, resize reallocates if needed.
+      part.resize(block_size);
       part_bytes = handle.fd->read(&part[0], block_size);
       if (part_bytes > 0) {
         total_bytes += static_cast<off_t>(part_bytes);
@@ -78,14 +78,19 @@ Status forensicReadFile(const boost::filesystem::path& path,
  */
 Status readFile(const boost::filesystem::path& path, bool blocking = false);
 
-/// Internal representation for predicate-based chunk reading.
+/**
+ * @brief Internal representation for predicate-based chunk reading.
+ *
+ * @param sequential Open with PF_SEQUENTIAL, for files read once in full.
+ */
 Status readFile(const boost::filesystem::path& path,
                 size_t size,
                 size_t block_size,
                 bool dry_run,
                 bool preserve_time,
                 std::function<void(std::string& buffer, size_t size)> predicate,
-                bool blocking = false);
+                bool blocking = false,
+                bool sequential = false);
 
 /**
  * @brief Write text to disk.
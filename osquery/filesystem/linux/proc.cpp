@@ -10,14 +10,56 @@
 #include <linux/limits.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <exception>
+#include <future>
+#include <memory>
+
 #include <boost/filesystem.hpp>
 
+#include <osquery/core/flags.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/filesystem/linux/proc.h>
 #include <osquery/logger/logger.h>
 #include <osquery/utils/conversions/split.h>
+#include <osquery/utils/mutex.h>
+#include <osquery/utils/thread_pool.h>
 
 namespace osquery {
+
+FLAG(uint64,
+     proc_enumeration_threads,
+     1,
+     "Number of threads generating per-process table data (0 for one per "
+     "CPU)");
+
+namespace {
+
+/// Upper bound on the number of threads reading per-process data.
+const size_t kMaxProcEnumerationThreads = 16;
+
+/// Protects the shared process enumeration pool.
+Mutex kProcPoolMutex;
+
+/// Workers shared by all per-process table generators.
+std::shared_ptr<ThreadPool> kProcPool;
+
+/**
+ * @brief Get the shared process enumeration workers.
+ *
+ * The pool is replaced if the configured thread count changed. Callers keep
+ * a reference so a replaced pool is only destroyed once its last user is done.
+ */
+std::shared_ptr<ThreadPool> getProcPool(size_t workers) {
+  WriteLock lock(kProcPoolMutex);
+  if (kProcPool == nullptr || kProcPool->size() != workers) {
+    kProcPool = std::make_shared<ThreadPool>(workers, "proc");
+  }
+  return kProcPool;
+}
+
+} // namespace
+
 const std::vector<std::string> kUserNamespaceList = {
     "cgroup", "ipc", "mnt", "net", "pid", "user", "uts"};
 
@@ -310,6 +352,60 @@ Status procProcesses(std::set<std::string>& processes) {
   return procEnumerateProcesses<decltype(processes)>(processes, callback);
 }
 
+void procParallelFor(size_t count,
+                     const std::function<void(size_t)>& callback) {
+  auto threads = resolveThreadCount(FLAGS_proc_enumeration_threads,
+                                    kMaxProcEnumerationThreads);
+  if (threads <= 1 || count <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      callback(i);
+    }
+    return;
+  }
+
+  // Indexes are claimed one at a time so a slow process does not hold up a
+  // fixed share of the remaining work.
+  std::atomic<size_t> next{0};
+  auto work = [&next, &callback, count]() {
+    for (auto i = next++; i < count; i = next++) {
+      try {
+        callback(i);
+      } catch (...) {
+        next = count;
+        throw;
+      }
+    }
+  };
+
+  // The calling thread is one of the workers.
+  auto pool = getProcPool(threads - 1);
+  std::vector<std::future<void>> helpers;
+  for (size_t i = 1; i < std::min(threads, count); ++i) {
+    helpers.push_back(pool->submit(work));
+  }
+
+  std::exception_ptr error;
+  try {
+    work();
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  for (auto& helper : helpers) {
+    try {
+      helper.get();
+    } catch (...) {
+      if (error == nullptr) {
+        error = std::current_exception();
+      }
+    }
+  }
+
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
 Status procDescriptors(const std::string& process,
                        std::map<std::string, std::string>& descriptors) {
   auto callback = [](const std::string& pid,
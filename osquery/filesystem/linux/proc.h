@@ -9,7 +9,11 @@
 
 #pragma once
 
+#include <functional>
+#include <iterator>
+#include <set>
 #include <unordered_map>
+#include <vector>
 
 #include <arpa/inet.h>
 #include <linux/limits.h>
@@ -181,6 +185,54 @@ Status procEnumerateProcesses(UserData& user_data,
   return Status(0);
 }
 
+/**
+ * @brief Execute a callback for each index in [0, count) across the shared
+ * process enumeration workers.
+ *
+ * The number of workers is controlled by --proc_enumeration_threads and the
+ * calling thread takes part in the work, so the call always makes progress
+ * even when the shared workers are busy. Each index is executed exactly once;
+ * callers that need a deterministic output must store results by index.
+ *
+ * The first exception thrown by a callback is rethrown once all workers have
+ * stopped using the callback.
+ *
+ * @param count The number of indexes.
+ * @param callback The work for a single index.
+ */
+void procParallelFor(size_t count, const std::function<void(size_t)>& callback);
+
+/**
+ * @brief Generate rows for each pid in parallel and merge them in pid order.
+ *
+ * Each pid's rows are generated into a separate container by the generator,
+ * then appended to results in the iteration order of pids. The output is the
+ * same as calling the generator for each pid sequentially.
+ *
+ * The generator is executed concurrently and must not use shared mutable
+ * state beyond the rows argument it is given.
+ *
+ * @param pids The process ids to generate rows for.
+ * @param generator A callable taking the pid and the rows to append to.
+ * @param results The output parameter, rows are appended.
+ */
+template <typename Rows, typename Generator>
+void procGenerateRows(const std::set<std::string>& pids,
+                      Generator&& generator,
+                      Rows& results) {
+  const std::vector<std::string> pid_list(pids.begin(), pids.end());
+  std::vector<Rows> pid_rows(pid_list.size());
+  procParallelFor(pid_list.size(), [&](size_t i) {
+    generator(pid_list[i], pid_rows[i]);
+  });
+
+  for (auto& rows : pid_rows) {
+    results.insert(results.end(),
+                   std::make_move_iterator(rows.begin()),
+                   std::make_move_iterator(rows.end()));
+  }
+}
+
 /**
  * @brief Enumerate all file descriptors of a certain process identified by its
  * pid by listing files under /proc/<pid>/fd and execute a callback for each one
@@ -86,8 +86,23 @@ PlatformFile::PlatformFile(const fs::path& path, int mode, int perms)
       (!fs::exists(fname_, ec) || ec.value() != errc::success)) {
     handle_ = kInvalidHandle;
   } else {
-    handle_ = ::open(fname_.c_str(), oflag, perms);
+    handle_ = kInvalidHandle;
+#ifdef O_NOATIME
+    if ((mode & PF_SEQUENTIAL) == PF_SEQUENTIAL && (mode & PF_WRITE) == 0) {
+      // O_NOATIME requires owning the file or CAP_FOWNER, retry without.
+      handle_ = ::open(fname_.c_str(), oflag | O_NOATIME, perms);
+    }
+#endif
+    if (handle_ == kInvalidHandle) {
+      handle_ = ::open(fname_.c_str(), oflag, perms);
+    }
   }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+  if (handle_ != kInvalidHandle && (mode & PF_SEQUENTIAL) == PF_SEQUENTIAL) {
+    ::posix_fadvise(handle_, 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+#endif
 }
 
 PlatformFile::~PlatformFile() {
@@ -252,6 +267,14 @@ off_t PlatformFile::seek(off_t offset, SeekMode mode) {
   return ::lseek(handle_, offset, whence);
 }
 
+bool PlatformFile::sync() {
+  if (!isValid()) {
+    return false;
+  }
+
+  return (::fsync(handle_) == 0);
+}
+
 size_t PlatformFile::size() const {
   struct stat file;
   if (::fstat(handle_, &file) < 0) {
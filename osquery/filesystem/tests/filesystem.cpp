@@ -8,6 +8,7 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <fstream>
 
 #include <stdio.h>
@@ -37,6 +38,9 @@ namespace fs = boost::filesystem;
 namespace osquery {
 
 DECLARE_uint64(read_max);
+#ifdef __linux__
+DECLARE_uint64(proc_enumeration_threads);
+#endif
 
 class FilesystemTests : public testing::Test {
  protected:
@@ -101,6 +105,34 @@ TEST_F(FilesystemTests, test_read_file) {
   removePath(test_working_dir_ / "fstests-file");
 }
 
+TEST_F(FilesystemTests, test_read_file_sequential) {
+  auto test_file = test_working_dir_ / "fstests-sequential";
+  std::string expected(10000, 'a');
+  ASSERT_TRUE(writeTextFile(test_file, expected).ok());
+
+  // Blocks larger than the file are capped, smaller blocks are reused.
+  for (size_t block_size : {4096, 1024 * 1024}) {
+    std::string content;
+    size_t reads = 0;
+    auto s = readFile(test_file,
+                      0,
+                      block_size,
+                      false,
+                      true,
+                      ([&content, &reads](std::string& buffer, size_t size) {
+                        content += buffer.substr(0, size);
+                        reads++;
+                      }),
+                      true,
+                      true);
+    EXPECT_TRUE(s.ok());
+    EXPECT_EQ(content, expected);
+    EXPECT_EQ(reads, (block_size == 4096) ? 3U : 1U);
+  }
+
+  removePath(test_file);
+}
+
 TEST_F(FilesystemTests, test_remove_path) {
   auto test_dir = test_working_dir_ / "rmdir";
   fs::create_directories(test_dir);
@@ -461,6 +493,61 @@ TEST_F(FilesystemTests, test_user_namespace_parser) {
   removePath(temp_path);
   EXPECT_EQ(namespace_inode, static_cast<ino_t>(112233));
 }
+
+TEST_F(FilesystemTests, test_proc_parallel_for) {
+  auto threads = FLAGS_proc_enumeration_threads;
+  FLAGS_proc_enumeration_threads = 4;
+
+  // Every index is visited exactly once.
+  std::vector<std::atomic<size_t>> visits(1000);
+  procParallelFor(visits.size(), [&visits](size_t i) { visits[i]++; });
+  for (const auto& count : visits) {
+    EXPECT_EQ(count.load(), 1U);
+  }
+
+  // A failing callback is reported to the caller.
+  EXPECT_THROW(procParallelFor(100,
+                               [](size_t i) {
+                                 if (i == 50) {
+                                   throw std::runtime_error("failed");
+                                 }
+                               }),
+               std::runtime_error);
+
+  FLAGS_proc_enumeration_threads = threads;
+}
+
+TEST_F(FilesystemTests, test_proc_generate_rows_order) {
+  auto threads = FLAGS_proc_enumeration_threads;
+
+  std::set<std::string> pids;
+  for (size_t pid = 1; pid <= 500; pid++) {
+    pids.insert(std::to_string(pid));
+  }
+
+  auto generator = [](const std::string& pid, QueryData& rows) {
+    // A variable number of rows per pid, some pids have none.
+    for (size_t i = 0; i < std::stoul(pid) % 4; i++) {
+      Row r;
+      r["pid"] = pid;
+      r["index"] = std::to_string(i);
+      rows.push_back(std::move(r));
+    }
+  };
+
+  FLAGS_proc_enumeration_threads = 1;
+  QueryData sequential;
+  procGenerateRows(pids, generator, sequential);
+
+  FLAGS_proc_enumeration_threads = 8;
+  QueryData parallel;
+  procGenerateRows(pids, generator, parallel);
+
+  EXPECT_FALSE(sequential.empty());
+  EXPECT_EQ(sequential, parallel);
+
+  FLAGS_proc_enumeration_threads = threads;
+}
 #endif
 
 TEST_F(FilesystemTests, test_read_proc) {
@@ -602,6 +602,10 @@ PlatformFile::PlatformFile(const fs::path& path, int mode, int perms)
     is_nonblock_ = true;
   }
 
+  if ((mode & PF_SEQUENTIAL) == PF_SEQUENTIAL) {
+    flags_and_attrs |= FILE_FLAG_SEQUENTIAL_SCAN;
+  }
+
   if (perms != -1) {
     // TODO(#2001): set up a security descriptor based off the perms
   }
@@ -1099,6 +1103,14 @@ off_t PlatformFile::seek(off_t offset, SeekMode mode) {
   return cursor_;
 }
 
+bool PlatformFile::sync() {
+  if (!isValid()) {
+    return false;
+  }
+
+  return (::FlushFileBuffers(handle_) != FALSE);
+}
+
 size_t PlatformFile::size() const {
   return ::GetFileSize(handle_, nullptr);
 }
@@ -9,6 +9,7 @@
 
 #include <algorithm>
 #include <iomanip>
+#include <memory>
 #include <sstream>
 #include <unordered_map>
 #include <vector>
@@ -19,13 +20,12 @@
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/hashing/hashing.h>
 #include <osquery/utils/base64.h>
-#include <osquery/utils/info/platform_type.h>
 #include <osquery/utils/status/status.h>
 
 namespace osquery {
 
-/// The buffer read size from file IO to hashing structures.
-const size_t kHashChunkSize{4096};
+/// The largest buffer read from file IO to hashing structures.
+const size_t kHashChunkSize{1024 * 1024};
 
 Hash::~Hash() {
   if (ctx_ != nullptr) {
@@ -102,27 +102,39 @@ std::string hashFromBuffer(HashType hash_type,
   return hash.digest();
 }
 
+namespace {
+
+using HashMap = std::map<HashType, std::shared_ptr<Hash>>;
+
+void updateHashes(HashMap& hashes, int mask, const void* buffer, size_t size) {
+  for (auto& hash : hashes) {
+    if (mask & hash.first) {
+      hash.second->update(buffer, size);
+    }
+  }
+}
+
+} // namespace
+
 MultiHashes hashMultiFromFile(int mask, const std::string& path) {
-  std::map<HashType, std::shared_ptr<Hash>> hashes = {
+  HashMap hashes = {
       {HASH_TYPE_MD5, std::make_shared<Hash>(HASH_TYPE_MD5)},
       {HASH_TYPE_SHA1, std::make_shared<Hash>(HASH_TYPE_SHA1)},
       {HASH_TYPE_SHA256, std::make_shared<Hash>(HASH_TYPE_SHA256)},
   };
 
-  auto blocking = isPlatform(PlatformType::TYPE_WINDOWS);
+  // Read in chunks, the file is opened for a sequential read with readahead
+  // and without updating the atime where permitted.
   auto s = readFile(path,
                     0,
                     kHashChunkSize,
                     false,
                     true,
                     ([&hashes, &mask](std::string& buffer, size_t size) {
-                      for (auto& hash : hashes) {
-                        if (mask & hash.first) {
-                          hash.second->update(&buffer[0], size);
-                        }
-                      }
+                      updateHashes(hashes, mask, &buffer[0], size);
                     }),
-                    blocking);
+                    true,
+                    true);
 
   MultiHashes mh = {};
   if (!s.ok()) {
@@ -13,10 +13,17 @@
 #include <osquery/core/flags.h>
 #include <osquery/logger/logger.h>
 #include <osquery/registry/registry_factory.h>
+#include <plugins/logger/filesystem_logger.h>
+
+#include <boost/filesystem.hpp>
+
+namespace fs = boost::filesystem;
 
 namespace osquery {
 
 DECLARE_bool(disable_logging);
+DECLARE_string(logger_path);
+DECLARE_uint64(logger_flush_interval);
 
 class DummyLoggerPlugin : public LoggerPlugin {
  public:
@@ -83,4 +90,41 @@ static void LOGGER_logstring_plugin(benchmark::State& state) {
 }
 
 BENCHMARK(LOGGER_logstring_plugin);
+
+/// Measures the filesystem logger result lines per second.
+/// The first argument is --logger_flush_interval and the second the line size.
+static void LOGGER_filesystem_plugin(benchmark::State& state) {
+  auto log_path =
+      fs::temp_directory_path() /
+      fs::unique_path("osquery.logger_benchmarks.%%%%.%%%%.logs");
+  fs::create_directories(log_path);
+
+  auto logger_path = FLAGS_logger_path;
+  FLAGS_logger_path = log_path.string();
+  FLAGS_logger_flush_interval = state.range(0);
+
+  FilesystemLoggerPlugin plugin;
+  plugin.setUp();
+
+  std::string line(state.range(1), 'A');
+  while (state.KeepRunning()) {
+    plugin.logString(line);
+  }
+
+  plugin.tearDown();
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * (line.size() + 1));
+
+  FLAGS_logger_path = logger_path;
+  FLAGS_logger_flush_interval = 0;
+
+  boost::system::error_code ec;
+  fs::remove_all(log_path, ec);
+}
+
+BENCHMARK(LOGGER_filesystem_plugin)
+    ->ArgPair(0, 256)
+    ->ArgPair(1000, 256)
+    ->ArgPair(0, 4096)
+    ->ArgPair(1000, 4096);
 }
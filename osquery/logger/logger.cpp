@@ -16,6 +16,8 @@
 #include <optional>
 #include <queue>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include <boost/noncopyable.hpp>
 
@@ -56,6 +58,12 @@ FLAG(bool,
      false,
      "Log scheduled snapshot results as events");
 
+/// Bound the number of serialized events held while logging query results.
+FLAG(uint64,
+     logger_event_chunk_size,
+     1024,
+     "Maximum number of result events sent to the logger at once");
+
 /// Alias for the minloglevel used internally by GLOG.
 FLAG(int32, logger_min_status, 0, "Minimum level for status log recording");
 
@@ -399,7 +407,61 @@ Status logString(const std::string& message,
 
 namespace {
 const std::string kTotalQueryCounterMonitorPath("query.total.count");
+
+/**
+ * @brief Stream the results of a query to the receiving loggers as events.
+ *
+ * Events are serialized and logged in chunks, so only a chunk of events is
+ * held at a time no matter how many rows the query returned.
+ */
+Status logQueryLogItemEvents(const QueryLogItem& item,
+                             const std::string& receiver,
+                             bool snapshot) {
+  // Resolve the loggers once, extension loggers are called through the
+  // registry for each event.
+  std::vector<std::pair<std::string, std::shared_ptr<LoggerPlugin>>> loggers;
+  for (const auto& logger : osquery::split(receiver, ",")) {
+    std::shared_ptr<LoggerPlugin> logger_plugin;
+    if (Registry::get().exists("logger", logger, true)) {
+      auto plugin = Registry::get().plugin("logger", logger);
+      logger_plugin = std::dynamic_pointer_cast<LoggerPlugin>(plugin);
+    }
+    loggers.emplace_back(logger, std::move(logger_plugin));
+  }
+
+  Status status;
+  auto serialize_status = serializeQueryLogItemAsEventChunks(
+      item,
+      FLAGS_logger_event_chunk_size,
+      [&loggers, &status, snapshot](std::vector<std::string>& events) {
+        for (const auto& logger : loggers) {
+          if (logger.second != nullptr) {
+            status = logger.second->logChunk(events, snapshot);
+            continue;
+          }
+
+          for (const auto& event : events) {
+            if (snapshot) {
+              status = Registry::call(
+                  "logger", logger.first, {{"snapshot", event}});
+            } else {
+              status = Registry::call(
+                  "logger",
+                  logger.first,
+                  {{"string", event}, {"category", "event"}});
+            }
+          }
+        }
+
+        // A failing logger does not stop the remaining events.
+        return Status::success();
+      });
+  if (!serialize_status.ok()) {
+    return serialize_status;
+  }
+  return status;
 }
+} // namespace
 
 Status logQueryLogItem(const QueryLogItem& results) {
   return logQueryLogItem(results, RegistryFactory::get().getActive("logger"));
@@ -416,23 +478,16 @@ Status logQueryLogItem(const QueryLogItem& results,
         kTotalQueryCounterMonitorPath, 1, monitoring::PreAggregationType::Sum);
   }
 
-  std::vector<std::string> json_items;
-  Status status;
   if (FLAGS_logger_event_type) {
-    status = serializeQueryLogItemAsEventsJSON(results, json_items);
-  } else {
-    std::string json;
-    status = serializeQueryLogItemJSON(results, json);
-    json_items.emplace_back(json);
+    return logQueryLogItemEvents(results, receiver, false);
   }
+
+  std::string json;
+  auto status = serializeQueryLogItemJSON(results, json);
   if (!status.ok()) {
     return status;
   }
-
-  for (const auto& json : json_items) {
-    status = logString(json, "event", receiver);
-  }
-  return status;
+  return logString(json, "event", receiver);
 }
 
 Status logSnapshotQuery(const QueryLogItem& item) {
@@ -445,29 +500,24 @@ Status logSnapshotQuery(const QueryLogItem& item) {
         kTotalQueryCounterMonitorPath, 1, monitoring::PreAggregationType::Sum);
   }
 
-  std::vector<std::string> json_items;
-  Status status;
+  auto receiver = RegistryFactory::get().getActive("logger");
   if (FLAGS_logger_snapshot_event_type) {
-    status = serializeQueryLogItemAsEventsJSON(item, json_items);
-  } else {
-    std::string json;
-    status = serializeQueryLogItemJSON(item, json);
-    json_items.emplace_back(json);
+    return logQueryLogItemEvents(item, receiver, true);
   }
+
+  std::string json;
+  auto status = serializeQueryLogItemJSON(item, json);
   if (!status.ok()) {
     return status;
   }
 
-  for (const auto& json : json_items) {
-    auto receiver = RegistryFactory::get().getActive("logger");
-    for (const auto& logger : osquery::split(receiver, ",")) {
-      if (Registry::get().exists("logger", logger, true)) {
-        auto plugin = Registry::get().plugin("logger", logger);
-        auto logger_plugin = std::dynamic_pointer_cast<LoggerPlugin>(plugin);
-        status = logger_plugin->logSnapshot(json);
-      } else {
-        status = Registry::call("logger", logger, {{"snapshot", json}});
-      }
+  for (const auto& logger : osquery::split(receiver, ",")) {
+    if (Registry::get().exists("logger", logger, true)) {
+      auto plugin = Registry::get().plugin("logger", logger);
+      auto logger_plugin = std::dynamic_pointer_cast<LoggerPlugin>(plugin);
+      status = logger_plugin->logSnapshot(json);
+    } else {
+      status = Registry::call("logger", logger, {{"snapshot", json}});
     }
   }
 
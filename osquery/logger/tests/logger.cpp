@@ -30,6 +30,7 @@ DECLARE_bool(logger_event_type);
 DECLARE_bool(logger_snapshot_event_type);
 DECLARE_bool(disable_logging);
 DECLARE_bool(logger_numerics);
+DECLARE_uint64(logger_event_chunk_size);
 
 class LoggerTests : public testing::Test {
  public:
@@ -412,6 +413,55 @@ TEST_F(LoggerTests, test_logger_numeric_flag) {
   EXPECT_EQ(LoggerTests::log_lines.back(), expected);
 }
 
+class ChunkTestLoggerPlugin : public LoggerPlugin {
+ public:
+  Status logString(const std::string& s) override {
+    return Status::success();
+  }
+
+  Status logChunk(const std::vector<std::string>& lines,
+                  bool snapshot) override {
+    chunk_sizes.push_back(lines.size());
+    snapshot_chunks += (snapshot) ? 1 : 0;
+    return Status::success();
+  }
+
+  /// The number of lines in each logged chunk.
+  std::vector<size_t> chunk_sizes;
+
+  /// The number of chunks of snapshot results.
+  size_t snapshot_chunks{0};
+};
+
+TEST_F(LoggerTests, test_logger_event_chunks) {
+  auto& rf = RegistryFactory::get();
+  auto chunk_logger = std::make_shared<ChunkTestLoggerPlugin>();
+  rf.registry("logger")->add("chunk_test", chunk_logger);
+  EXPECT_TRUE(rf.setActive("logger", "chunk_test").ok());
+
+  QueryLogItem item;
+  item.name = "test_query";
+  item.identifier = "unknown_test_host";
+  item.time = 0;
+  item.calendar_time = "no_time";
+  for (long long i = 0; i < 5; i++) {
+    item.results.added.push_back({{"test_column", i}});
+  }
+
+  // Results are sent to the logger in bounded chunks.
+  FLAGS_logger_event_chunk_size = 2;
+  EXPECT_TRUE(logQueryLogItem(item));
+  EXPECT_EQ(chunk_logger->chunk_sizes, (std::vector<size_t>{2, 2, 1}));
+  EXPECT_EQ(chunk_logger->snapshot_chunks, 0U);
+
+  FLAGS_logger_snapshot_event_type = true;
+  EXPECT_TRUE(logSnapshotQuery(item));
+  EXPECT_EQ(chunk_logger->chunk_sizes.size(), 6U);
+  EXPECT_EQ(chunk_logger->snapshot_chunks, 3U);
+  FLAGS_logger_snapshot_event_type = false;
+  FLAGS_logger_event_chunk_size = 1024;
+}
+
 class RecursiveLoggerPlugin : public LoggerPlugin {
  protected:
   bool usesLogStatus() override {
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#ifdef __linux__
+// Needed for linux specific RUSAGE_THREAD, before including anything else
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#endif
+
+#include <cstdio>
+
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+#include <osquery/profiler/resource_usage.h>
+
+namespace osquery {
+namespace {
+
+uint64_t toMilliseconds(const struct timeval& tv) {
+  return static_cast<uint64_t>(tv.tv_sec) * 1000 +
+         static_cast<uint64_t>(tv.tv_usec) / 1000;
+}
+
+#ifdef __linux__
+uint64_t getResidentSize(const struct rusage&) {
+  // The second field of statm is the resident set size in pages.
+  FILE* statm = std::fopen("/proc/self/statm", "r");
+  if (statm == nullptr) {
+    return 0;
+  }
+
+  unsigned long long size = 0;
+  unsigned long long resident = 0;
+  auto fields = std::fscanf(statm, "%llu %llu", &size, &resident);
+  std::fclose(statm);
+  if (fields != 2) {
+    return 0;
+  }
+  return resident * static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+}
+#elif defined(__APPLE__)
+uint64_t getResidentSize(const struct rusage&) {
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(),
+                MACH_TASK_BASIC_INFO,
+                reinterpret_cast<task_info_t>(&info),
+                &count) != KERN_SUCCESS) {
+    return 0;
+  }
+  return info.resident_size;
+}
+#else
+uint64_t getResidentSize(const struct rusage& stats) {
+  // Without a cheap current RSS source use the peak, reported in kilobytes.
+  return static_cast<uint64_t>(stats.ru_maxrss) * 1024;
+}
+#endif
+
+} // namespace
+
+ResourceUsage getResourceUsage() {
+  ResourceUsage usage;
+  usage.time = std::chrono::steady_clock::now();
+
+  struct rusage stats {};
+#ifdef __linux__
+  auto status = getrusage(RUSAGE_THREAD, &stats);
+#else
+  auto status = getrusage(RUSAGE_SELF, &stats);
+#endif
+  if (status == 0) {
+    usage.user_time = toMilliseconds(stats.ru_utime);
+    usage.system_time = toMilliseconds(stats.ru_stime);
+  }
+
+  usage.resident_size = getResidentSize(stats);
+  return usage;
+}
+
+} // namespace osquery
@@ -0,0 +1,45 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace osquery {
+
+/**
+ * @brief A cheap sample of the resources used by the calling thread.
+ *
+ * CPU times are for the calling thread where the platform allows it, and for
+ * the process otherwise. The resident size is always process-wide.
+ */
+struct ResourceUsage {
+  /// Monotonic time of the sample.
+  std::chrono::steady_clock::time_point time;
+
+  /// CPU time in milliseconds spent in user space.
+  uint64_t user_time{0};
+
+  /// CPU time in milliseconds spent in kernel space.
+  uint64_t system_time{0};
+
+  /// Bytes of resident memory used by the process.
+  uint64_t resident_size{0};
+};
+
+/**
+ * @brief Sample the resource usage of the calling thread.
+ *
+ * This uses only a few system calls and never inspects the process table,
+ * it is suitable for bracketing every scheduled query execution.
+ */
+ResourceUsage getResourceUsage();
+
+} // namespace osquery
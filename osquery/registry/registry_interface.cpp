@@ -49,6 +49,18 @@ std::map<std::string, RouteUUID> RegistryInterface::getExternal() const {
   return external_;
 }
 
+bool RegistryInterface::getExternalUUID(const std::string& item_name,
+                                        RouteUUID& uuid) const {
+  ReadLock lock(mutex_);
+
+  auto it = external_.find(item_name);
+  if (it == external_.end()) {
+    return false;
+  }
+  uuid = it->second;
+  return true;
+}
+
 std::string RegistryInterface::getActive() const {
   ReadLock lock(mutex_);
 
@@ -75,6 +75,9 @@ class RegistryInterface : private boost::noncopyable {
   /// Allow others to introspect into the routes from extensions.
   std::map<std::string, RouteUUID> getExternal() const;
 
+  /// Get the UUID of the extension that broadcasted an item, if there is one.
+  bool getExternalUUID(const std::string& item_name, RouteUUID& uuid) const;
+
   /// Get the 'active' plugin, return success with the active plugin name.
   std::string getActive() const;
 
@@ -10,10 +10,12 @@
 #include <benchmark/benchmark.h>
 
 #include <osquery/core/core.h>
+#include <osquery/core/flags.h>
 #include <osquery/core/tables.h>
 #include <osquery/registry/registry.h>
 #include <osquery/sql/sql.h>
 
+#include "osquery/sql/indexed_table_row.h"
 #include "osquery/sql/virtual_table.h"
 
 namespace osquery {
@@ -195,6 +197,48 @@ static void SQL_virtual_table_internal_long(benchmark::State& state) {
 
 BENCHMARK(SQL_virtual_table_internal_long);
 
+class BenchmarkLongIndexedTablePlugin : public BenchmarkLongTablePlugin {
+ private:
+  TableRows generate(QueryContext& ctx) override {
+    static const auto kColumns = std::make_shared<const IndexedColumns>(
+        IndexedColumns{"test_int", "test_text"});
+
+    TableRows results;
+    for (size_t i = 0; i < 1000; i++) {
+      auto r = make_indexed_row(kColumns);
+      r->set(0, 0);
+      r->set(1, "hello");
+      results.push_back(std::move(r));
+    }
+    return results;
+  }
+};
+
+static void SQL_virtual_table_internal_long_indexed(benchmark::State& state) {
+  auto tables = RegistryFactory::get().registry("table");
+  tables->add("long_indexed_benchmark",
+              std::make_shared<BenchmarkLongIndexedTablePlugin>());
+
+  PluginResponse res;
+  Registry::call(
+      "table", "long_indexed_benchmark", {{"action", "columns"}}, res);
+
+  // Attach a sample virtual table.
+  auto dbc = SQLiteDBManager::getUnique();
+  attachTableInternal("long_indexed_benchmark",
+                      columnDefinition(res, false, false),
+                      dbc,
+                      false);
+
+  while (state.KeepRunning()) {
+    QueryData results;
+    queryInternal("select * from long_indexed_benchmark", results, dbc);
+    dbc->clearAffectedTables();
+  }
+}
+
+BENCHMARK(SQL_virtual_table_internal_long_indexed);
+
 size_t kWideCount{0};
 
 class BenchmarkWideTablePlugin : public TablePlugin {
@@ -291,6 +335,59 @@ BENCHMARK(SQL_virtual_table_internal_wide_yield)
     ->ArgPair(0, 100)
     ->ArgPair(0, 1000);
 
+class BenchmarkWideIndexedTablePlugin : public BenchmarkWideTablePlugin {
+ protected:
+  TableRows generate(QueryContext& ctx) override {
+    static const auto kColumns = [] {
+      IndexedColumns names;
+      for (size_t i = 0; i < 20; i++) {
+        names.push_back("test_" + std::to_string(i));
+      }
+      return std::make_shared<const IndexedColumns>(std::move(names));
+    }();
+
+    TableRows results;
+    for (size_t k = 0; k < kWideCount; k++) {
+      auto r = make_indexed_row(kColumns);
+      for (size_t i = 0; i < 20; i++) {
+        r->set(i, 0);
+      }
+      results.push_back(std::move(r));
+    }
+    return results;
+  }
+};
+
+static void SQL_virtual_table_internal_wide_indexed(benchmark::State& state) {
+  auto tables = RegistryFactory::get().registry("table");
+  tables->add("wide_indexed_benchmark",
+              std::make_shared<BenchmarkWideIndexedTablePlugin>());
+
+  PluginResponse res;
+  Registry::call(
+      "table", "wide_indexed_benchmark", {{"action", "columns"}}, res);
+
+  // Attach a sample virtual table.
+  auto dbc = SQLiteDBManager::getUnique();
+  attachTableInternal("wide_indexed_benchmark",
+                      columnDefinition(res, false, false),
+                      dbc,
+                      false);
+
+  kWideCount = state.range(1);
+  while (state.KeepRunning()) {
+    QueryData results;
+    queryInternal("select * from wide_indexed_benchmark", results, dbc);
+    dbc->clearAffectedTables();
+  }
+}
+
+BENCHMARK(SQL_virtual_table_internal_wide_indexed)
+    ->ArgPair(0, 1)
+    ->ArgPair(0, 10)
+    ->ArgPair(0, 100)
+    ->ArgPair(0, 1000);
+
 static void SQL_select_metadata(benchmark::State& state) {
   auto dbc = SQLiteDBManager::getUnique();
   while (state.KeepRunning()) {
@@ -310,4 +407,80 @@ static void SQL_select_basic(benchmark::State& state) {
 }
 
 BENCHMARK(SQL_select_basic);
+
+static void SQL_select_processes_pid(benchmark::State& state) {
+  // Only the pid column is used, no /proc/<pid> content is read.
+  // Run on a host with many (5k+) processes to compare against select *.
+  while (state.KeepRunning()) {
+    SQLInternal results("select pid from processes");
+  }
+}
+
+BENCHMARK(SQL_select_processes_pid);
+
+static void SQL_select_processes_all(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    SQLInternal results("select * from processes");
+  }
+}
+
+BENCHMARK(SQL_select_processes_all);
+
+static void SQL_select_regex(benchmark::State& state) {
+  // The pattern is compiled once per statement, not once per row.
+  auto query =
+      "with recursive n(x) as (select 1 union all select x + 1 from n "
+      "where x < " +
+      std::to_string(state.range(0)) +
+      ") select count(*) from n where ('/usr/bin/' || x) regexp "
+      "'^/usr/(s?bin|lib)/[0-9]+5$'";
+  while (state.KeepRunning()) {
+    SQLInternal results(query);
+  }
+}
+
+BENCHMARK(SQL_select_regex)->Arg(1000)->Arg(20000);
+
+static void SQL_select_repeated(benchmark::State& state) {
+  auto tables = RegistryFactory::get().registry("table");
+  tables->add("benchmark", std::make_shared<BenchmarkTablePlugin>());
+
+  // Compare preparing each query (0) to reusing cached prepared statements.
+  auto cache_size = Flag::getValue("sqlite_statement_cache_size");
+  Flag::updateValue("sqlite_statement_cache_size",
+                    std::to_string(state.range(0)));
+  auto dbc = SQLiteDBManager::getUnique();
+  Flag::updateValue("sqlite_statement_cache_size", cache_size);
+
+  while (state.KeepRunning()) {
+    QueryData results;
+    queryInternal(
+        "select b1.test_int, b2.test_text from benchmark b1 join benchmark b2 "
+        "on b1.test_int = b2.test_int where b2.test_text = 'hello'",
+        results,
+        dbc);
+    dbc->clearAffectedTables();
+  }
+}
+
+BENCHMARK(SQL_select_repeated)->Arg(0)->Arg(32);
+
+static void SQL_connection_unique(benchmark::State& state) {
+  // Each new transient connection attaches every registered table.
+  while (state.KeepRunning()) {
+    auto dbc = SQLiteDBManager::getUnique();
+  }
+}
+
+BENCHMARK(SQL_connection_unique);
+
+static void SQL_connection_pooled(benchmark::State& state) {
+  // Hold the primary database, contending requests use pooled connections.
+  auto primary = SQLiteDBManager::get();
+  while (state.KeepRunning()) {
+    auto dbc = SQLiteDBManager::get();
+  }
+}
+
+BENCHMARK(SQL_connection_pooled);
 } // namespace osquery
@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include "columnar_table_row.h"
+#include "virtual_table.h"
+
+#include <osquery/core/tables.h>
+#include <osquery/logger/logger.h>
+
+namespace rj = rapidjson;
+
+namespace osquery {
+
+TableRows tableRowsFromColumns(ColumnarRows&& columns) {
+  auto shared_columns =
+      std::make_shared<const ColumnarRows>(std::move(columns));
+
+  TableRows result;
+  result.reserve(shared_columns->row_count);
+  for (size_t row = 0; row < shared_columns->row_count; row++) {
+    result.push_back(
+        TableRowHolder(new ColumnarTableRow(shared_columns, row)));
+  }
+
+  return result;
+}
+
+std::string ColumnarTableRow::getText(
+    const ColumnarRows::Column& column) const {
+  switch (column.type) {
+  case INTEGER_TYPE:
+  case BIGINT_TYPE:
+  case UNSIGNED_BIGINT_TYPE:
+    return BIGINT(column.integer_values[row_]);
+  case DOUBLE_TYPE:
+    return DOUBLE(column.double_values[row_]);
+  default:
+    return column.text_values[row_];
+  }
+}
+
+ColumnarTableRow::operator Row() const {
+  Row row;
+  for (const auto& column : columns_->columns) {
+    if (!column.isNull(row_)) {
+      row[column.name] = getText(column);
+    }
+  }
+  return row;
+}
+
+int ColumnarTableRow::get_rowid(sqlite_int64 default_value,
+                                sqlite_int64* pRowid) const {
+  auto column = columns_->find("rowid");
+  if (column == nullptr || column->isNull(row_)) {
+    *pRowid = default_value;
+  } else if (column->type == INTEGER_TYPE || column->type == BIGINT_TYPE ||
+             column->type == UNSIGNED_BIGINT_TYPE) {
+    *pRowid = column->integer_values[row_];
+  } else {
+    VLOG(1) << "Invalid rowid column type returned";
+    return SQLITE_ERROR;
+  }
+  return SQLITE_OK;
+}
+
+int ColumnarTableRow::get_column(sqlite3_context* ctx,
+                                 sqlite3_vtab* vtab,
+                                 int col) {
+  VirtualTable* pVtab = (VirtualTable*)vtab;
+  const auto& content = pVtab->content;
+  auto column_index = static_cast<size_t>(col);
+  auto alias = content->aliases.find(std::get<0>(content->columns[col]));
+  if (alias != content->aliases.end()) {
+    // Read the value of the column the alias was moved to.
+    column_index = alias->second;
+  }
+
+  // Columns are sent in the declared order, fall back to a lookup by name.
+  const auto& column_name = std::get<0>(content->columns[column_index]);
+  const ColumnarRows::Column* column = nullptr;
+  if (column_index < columns_->columns.size() &&
+      columns_->columns[column_index].name == column_name) {
+    column = &columns_->columns[column_index];
+  } else {
+    column = columns_->find(column_name);
+  }
+
+  if (column == nullptr || column->isNull(row_)) {
+    sqlite3_result_null(ctx);
+    return SQLITE_OK;
+  }
+
+  switch (column->type) {
+  case TEXT_TYPE:
+  case BLOB_TYPE: {
+    const auto& value = column->text_values[row_];
+    sqlite3_result_text(
+        ctx, value.c_str(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
+    break;
+  }
+  case INTEGER_TYPE:
+    sqlite3_result_int(ctx, static_cast<int>(column->integer_values[row_]));
+    break;
+  case BIGINT_TYPE:
+  case UNSIGNED_BIGINT_TYPE:
+    sqlite3_result_int64(ctx, column->integer_values[row_]);
+    break;
+  case DOUBLE_TYPE:
+    sqlite3_result_double(ctx, column->double_values[row_]);
+    break;
+  default:
+    LOG(ERROR) << "Error unknown column type " << column_name;
+    break;
+  }
+
+  return SQLITE_OK;
+}
+
+Status ColumnarTableRow::serialize(JSON& doc, rj::Value& obj) const {
+  for (const auto& column : columns_->columns) {
+    if (!column.isNull(row_)) {
+      doc.addCopy(column.name, getText(column), obj);
+    }
+  }
+
+  return Status::success();
+}
+
+TableRowHolder ColumnarTableRow::clone() const {
+  return TableRowHolder(new ColumnarTableRow(columns_, row_));
+}
+
+} // namespace osquery
@@ -0,0 +1,45 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <memory>
+
+#include <osquery/core/sql/columnar_rows.h>
+#include <osquery/core/sql/table_row.h>
+#include <osquery/core/sql/table_rows.h>
+
+namespace osquery {
+
+/** A TableRow backed by a row of typed columns, shared by all rows. */
+class ColumnarTableRow : public TableRow {
+ public:
+  ColumnarTableRow(std::shared_ptr<const ColumnarRows> columns, size_t row)
+      : columns_(std::move(columns)), row_(row) {}
+  ColumnarTableRow(const ColumnarTableRow&) = delete;
+  ColumnarTableRow& operator=(const ColumnarTableRow&) = delete;
+  explicit operator Row() const;
+  virtual int get_rowid(sqlite_int64 default_value, sqlite_int64* pRowid) const;
+  virtual int get_column(sqlite3_context* ctx, sqlite3_vtab* pVtab, int col);
+  virtual Status serialize(JSON& doc, rapidjson::Value& obj) const;
+  virtual TableRowHolder clone() const;
+
+ private:
+  /// Get a column's value as text, the column must not be null.
+  std::string getText(const ColumnarRows::Column& column) const;
+
+ private:
+  std::shared_ptr<const ColumnarRows> columns_;
+  size_t row_;
+};
+
+/// Converts columns to TableRows, the rows share the column storage.
+TableRows tableRowsFromColumns(ColumnarRows&& columns);
+
+} // namespace osquery
@@ -90,23 +90,29 @@ int DynamicTableRow::get_column(sqlite3_context* ctx,
                                 sqlite3_vtab* vtab,
                                 int col) {
   VirtualTable* pVtab = (VirtualTable*)vtab;
-  auto& column_name = std::get<0>(pVtab->content->columns[col]);
-  auto& type = std::get<1>(pVtab->content->columns[col]);
-  if (pVtab->content->aliases.count(column_name)) {
-    // Overwrite the aliased column with the type and name of the new column.
-    type = std::get<1>(
-        pVtab->content->columns[pVtab->content->aliases.at(column_name)]);
-    column_name = std::get<0>(
-        pVtab->content->columns[pVtab->content->aliases.at(column_name)]);
+  const auto& content = pVtab->content;
+  auto column_index = static_cast<size_t>(col);
+  if (!content->aliases.empty()) {
+    auto alias = content->aliases.find(std::get<0>(content->columns[col]));
+    if (alias != content->aliases.end()) {
+      // Read the value and type of the column the alias was moved to.
+      column_index = alias->second;
+    }
   }
+  const auto& column_name = std::get<0>(content->columns[column_index]);
+  const auto type = std::get<1>(content->columns[column_index]);
 
   // Attempt to cast each xFilter-populated row/column to the SQLite type.
-  const auto& value = row[column_name];
-  if (this->row.count(column_name) == 0) {
+  auto it = row.find(column_name);
+  if (it == row.end()) {
     // Missing content.
     VLOG(1) << "Error " << column_name << " is empty";
     sqlite3_result_null(ctx);
-  } else if (type == TEXT_TYPE || type == BLOB_TYPE) {
+    return SQLITE_OK;
+  }
+
+  const auto& value = it->second;
+  if (type == TEXT_TYPE || type == BLOB_TYPE) {
     sqlite3_result_text(
         ctx, value.c_str(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
   } else if (value.empty() &&
@@ -0,0 +1,216 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include "indexed_table_row.h"
+#include "virtual_table.h"
+
+#include <cstdlib>
+
+#include <osquery/core/tables.h>
+#include <osquery/logger/logger.h>
+#include <osquery/utils/conversions/tryto.h>
+
+namespace rj = rapidjson;
+
+namespace osquery {
+
+namespace {
+
+/// Get a non-null value as text, as a string-valued row would hold it.
+std::string getText(const IndexedTableRow::Value& value) {
+  if (auto integer = std::get_if<int64_t>(&value)) {
+    return BIGINT(*integer);
+  } else if (auto real = std::get_if<double>(&value)) {
+    return DOUBLE(*real);
+  }
+  return std::get<std::string>(value);
+}
+
+void resultInteger(sqlite3_context* ctx,
+                   const std::string& column_name,
+                   const IndexedTableRow::Value& value,
+                   bool bigint) {
+  long long result = 0;
+  if (auto integer = std::get_if<int64_t>(&value)) {
+    result = *integer;
+  } else if (auto real = std::get_if<double>(&value)) {
+    result = static_cast<long long>(*real);
+  } else {
+    const auto& text = std::get<std::string>(value);
+    if (text.empty()) {
+      sqlite3_result_null(ctx);
+      return;
+    }
+
+    auto afinite = tryTo<long long>(text, 0);
+    if (afinite.isError()) {
+      VLOG(1) << "Error casting " << column_name << " (" << text
+              << ") to " << (bigint ? "BIGINT. " : "INTEGER. ")
+              << afinite.getError();
+      sqlite3_result_null(ctx);
+      return;
+    }
+    result = afinite.take();
+  }
+
+  if (bigint) {
+    sqlite3_result_int64(ctx, result);
+  } else {
+    sqlite3_result_int(ctx, static_cast<int>(result));
+  }
+}
+
+void resultDouble(sqlite3_context* ctx,
+                  const std::string& column_name,
+                  const IndexedTableRow::Value& value) {
+  if (auto real = std::get_if<double>(&value)) {
+    sqlite3_result_double(ctx, *real);
+    return;
+  } else if (auto integer = std::get_if<int64_t>(&value)) {
+    sqlite3_result_double(ctx, static_cast<double>(*integer));
+    return;
+  }
+
+  const auto& text = std::get<std::string>(value);
+  char* end = nullptr;
+  double afinite = strtod(text.c_str(), &end);
+  if (text.empty()) {
+    sqlite3_result_null(ctx);
+  } else if (end == nullptr || end == text.c_str() || *end != '\0') {
+    VLOG(1) << "Error casting " << column_name << " (" << text
+            << ") to DOUBLE";
+    sqlite3_result_null(ctx);
+  } else {
+    sqlite3_result_double(ctx, afinite);
+  }
+}
+
+} // namespace
+
+const IndexedTableRow::Value* IndexedTableRow::find(
+    const std::string& name) const {
+  for (size_t i = 0; i < columns_->size(); i++) {
+    if ((*columns_)[i] == name) {
+      return &values_[i];
+    }
+  }
+  return nullptr;
+}
+
+IndexedTableRow::operator Row() const {
+  Row row;
+  for (size_t i = 0; i < values_.size(); i++) {
+    if (!std::holds_alternative<std::monostate>(values_[i])) {
+      row[(*columns_)[i]] = getText(values_[i]);
+    }
+  }
+  return row;
+}
+
+int IndexedTableRow::get_rowid(sqlite_int64 default_value,
+                               sqlite_int64* pRowid) const {
+  auto value = find("rowid");
+  if (value == nullptr || std::holds_alternative<std::monostate>(*value)) {
+    *pRowid = default_value;
+  } else if (auto integer = std::get_if<int64_t>(value)) {
+    *pRowid = *integer;
+  } else {
+    auto exp = tryTo<long long>(getText(*value), 10);
+    if (exp.isError()) {
+      VLOG(1) << "Invalid rowid value returned " << exp.getError();
+      return SQLITE_ERROR;
+    }
+    *pRowid = exp.take();
+  }
+  return SQLITE_OK;
+}
+
+int IndexedTableRow::get_column(sqlite3_context* ctx,
+                                sqlite3_vtab* vtab,
+                                int col) {
+  VirtualTable* pVtab = (VirtualTable*)vtab;
+  const auto& content = pVtab->content;
+  auto column_index = static_cast<size_t>(col);
+  if (!content->aliases.empty()) {
+    auto alias = content->aliases.find(std::get<0>(content->columns[col]));
+    if (alias != content->aliases.end()) {
+      // Read the value of the column the alias was moved to.
+      column_index = alias->second;
+    }
+  }
+
+  // Values are held in the declared column order, the table's columns should
+  // match them. Fall back to a lookup by name for a mismatching table.
+  const auto& column_name = std::get<0>(content->columns[column_index]);
+  const auto type = std::get<1>(content->columns[column_index]);
+  const Value* value = nullptr;
+  if (column_index < values_.size() &&
+      (*columns_)[column_index] == column_name) {
+    value = &values_[column_index];
+  } else {
+    value = find(column_name);
+  }
+
+  if (value == nullptr || std::holds_alternative<std::monostate>(*value)) {
+    sqlite3_result_null(ctx);
+    return SQLITE_OK;
+  }
+
+  switch (type) {
+  case TEXT_TYPE:
+  case BLOB_TYPE: {
+    if (auto text = std::get_if<std::string>(value)) {
+      sqlite3_result_text(
+          ctx, text->c_str(), static_cast<int>(text->size()), SQLITE_TRANSIENT);
+    } else {
+      auto text_value = getText(*value);
+      sqlite3_result_text(ctx,
+                          text_value.c_str(),
+                          static_cast<int>(text_value.size()),
+                          SQLITE_TRANSIENT);
+    }
+    break;
+  }
+  case INTEGER_TYPE:
+    resultInteger(ctx, column_name, *value, false);
+    break;
+  case BIGINT_TYPE:
+  case UNSIGNED_BIGINT_TYPE:
+    resultInteger(ctx, column_name, *value, true);
+    break;
+  case DOUBLE_TYPE:
+    resultDouble(ctx, column_name, *value);
+    break;
+  default:
+    LOG(ERROR) << "Error unknown column type " << column_name;
+    break;
+  }
+
+  return SQLITE_OK;
+}
+
+Status IndexedTableRow::serialize(JSON& doc, rj::Value& obj) const {
+  for (size_t i = 0; i < values_.size(); i++) {
+    if (auto text = std::get_if<std::string>(&values_[i])) {
+      doc.addRef((*columns_)[i], *text, obj);
+    } else if (!std::holds_alternative<std::monostate>(values_[i])) {
+      doc.addCopy((*columns_)[i], getText(values_[i]), obj);
+    }
+  }
+
+  return Status::success();
+}
+
+TableRowHolder IndexedTableRow::clone() const {
+  auto row = make_indexed_row(columns_);
+  row->values_ = values_;
+  return TableRowHolder(std::move(row));
+}
+
+} // namespace osquery
@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include <osquery/core/sql/table_row.h>
+#include <osquery/core/sql/table_rows.h>
+#include <osquery/utils/json/json.h>
+
+namespace osquery {
+
+/// The column names of an IndexedTableRow, in the table's declared order.
+using IndexedColumns = std::vector<std::string>;
+using IndexedColumnsRef = std::shared_ptr<const IndexedColumns>;
+
+/**
+ * @brief A TableRow holding typed values addressed by column ordinal.
+ *
+ * Tables populate the values by the ordinal of the column in their spec, the
+ * generated osquery/rows/<table>.h header defines the ordinals and names.
+ * The column names are shared by all rows of a table. A column that is not
+ * set is null.
+ */
+class IndexedTableRow : public TableRow {
+ public:
+  using Value = std::variant<std::monostate, int64_t, double, std::string>;
+
+  explicit IndexedTableRow(IndexedColumnsRef columns)
+      : columns_(std::move(columns)), values_(columns_->size()) {}
+  IndexedTableRow(const IndexedTableRow&) = delete;
+  IndexedTableRow& operator=(const IndexedTableRow&) = delete;
+
+  /// Set an integer value, unsigned values above INT64_MAX are kept as text.
+  template <typename T,
+            typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+  void set(size_t column, T value) {
+    if (std::is_unsigned<T>::value &&
+        static_cast<uint64_t>(value) >
+            static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+      values_[column] = std::to_string(value);
+    } else {
+      values_[column] = static_cast<int64_t>(value);
+    }
+  }
+
+  void set(size_t column, double value) {
+    values_[column] = value;
+  }
+
+  void set(size_t column, std::string value) {
+    values_[column] = std::move(value);
+  }
+
+  void set(size_t column, const char* value) {
+    values_[column] = std::string(value);
+  }
+
+  void setNull(size_t column) {
+    values_[column] = std::monostate();
+  }
+
+  const Value& operator[](size_t column) const {
+    return values_[column];
+  }
+
+  explicit operator Row() const;
+  virtual int get_rowid(sqlite_int64 default_value, sqlite_int64* pRowid) const;
+  virtual int get_column(sqlite3_context* ctx, sqlite3_vtab* pVtab, int col);
+  virtual Status serialize(JSON& doc, rapidjson::Value& obj) const;
+  virtual TableRowHolder clone() const;
+
+ private:
+  /// Find the value of a column by name, returns nullptr if there is none.
+  const Value* find(const std::string& name) const;
+
+ private:
+  IndexedColumnsRef columns_;
+  std::vector<Value> values_;
+};
+
+inline std::unique_ptr<IndexedTableRow> make_indexed_row(
+    const IndexedColumnsRef& columns) {
+  return std::make_unique<IndexedTableRow>(columns);
+}
+
+} // namespace osquery
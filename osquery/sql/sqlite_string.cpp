@@ -16,13 +16,17 @@
 #endif
 
 #include <functional>
-#include <regex>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include <boost/regex.hpp>
+
 #include <osquery/core/flags.h>
 #include <osquery/logger/logger.h>
+#include <osquery/utils/caches/lru.h>
 #include <osquery/utils/conversions/split.h>
+#include <osquery/utils/mutex.h>
 
 #include <sqlite3.h>
 
@@ -33,12 +37,81 @@ HIDDEN_FLAG(
     regex_max_size,
     256,
     "Defines the maximum size in bytes of a regex that can be used with the "
-    "regex_match and regex_split functions");
+    "regex_match, regex_split and REGEXP functions");
+
+HIDDEN_FLAG(uint32,
+            regex_cache_size,
+            64,
+            "Number of compiled regexes kept across queries (default 64)");
 
 using SplitResult = std::vector<std::string>;
 using StringSplitFunction = std::function<SplitResult(
     const std::string& input, const std::string& tokens)>;
 
+using RegexRef = std::shared_ptr<const boost::regex>;
+
+/// Compiled regexes by pattern, shared by all queries.
+static caches::LRU<std::string, RegexRef>& regexCache() {
+  static caches::LRU<std::string, RegexRef> cache(FLAGS_regex_cache_size);
+  return cache;
+}
+
+static Mutex kRegexCacheMutex;
+
+/**
+ * @brief Get the compiled regex for a function's pattern argument.
+ *
+ * A constant pattern is compiled once per statement and kept as the argument's
+ * auxiliary data, so each row of a query reuses it. Patterns used by earlier
+ * statements are found in a small LRU cache before compiling.
+ *
+ * Throws a std::runtime_error if the pattern is invalid.
+ */
+static RegexRef getRegex(sqlite3_context* context,
+                         int argument,
+                         const std::string& pattern) {
+  auto aux = static_cast<RegexRef*>(sqlite3_get_auxdata(context, argument));
+  if (aux != nullptr && (*aux)->str() == pattern) {
+    return *aux;
+  }
+
+  RegexRef regex;
+  {
+    WriteLock lock(kRegexCacheMutex);
+    auto cached = regexCache().get(pattern);
+    if (cached != nullptr) {
+      regex = *cached;
+    }
+  }
+
+  if (regex == nullptr) {
+    regex = std::make_shared<const boost::regex>(pattern);
+    WriteLock lock(kRegexCacheMutex);
+    if (regexCache().capacity() > 0) {
+      regexCache().insert(pattern, regex);
+    }
+  }
+
+  // SQLite may release the auxiliary data immediately, keep our own copy.
+  sqlite3_set_auxdata(context, argument, new RegexRef(regex), [](void* p) {
+    delete static_cast<RegexRef*>(p);
+  });
+  return regex;
+}
+
+/// Check a pattern against the regex_max_size flag, sets an error if too big.
+static bool checkRegexSize(sqlite3_context* context, const char* regex) {
+  if (strnlen(regex, FLAGS_regex_max_size) == FLAGS_regex_max_size &&
+      regex[FLAGS_regex_max_size] != '\0') {
+    std::string error = "Invalid regex: too big, max size is " +
+                        std::to_string(FLAGS_regex_max_size) + " bytes";
+    LOG(INFO) << error;
+    sqlite3_result_error(context, error.c_str(), -1);
+    return false;
+  }
+  return true;
+}
+
 /**
  * @brief A simple SQLite column string split implementation.
  *
@@ -74,19 +147,14 @@ static SplitResult tokenSplit(const std::string& input,
  *      192.168
  */
 static SplitResult regexSplit(const std::string& input,
-                              const std::string& token) {
+                              const boost::regex& pattern) {
   // Split using the token as a regex to support multi-character tokens.
   // Exceptions are caught by the caller, as that's where the sql context is
   std::vector<std::string> result;
 
-  if (token.size() > FLAGS_regex_max_size) {
-    throw std::regex_error(std::regex_constants::error_complexity);
-  }
-
-  std::regex pattern = std::regex(token);
-  std::sregex_token_iterator iter_begin(
+  boost::sregex_token_iterator iter_begin(
       input.begin(), input.end(), pattern, -1);
-  std::sregex_token_iterator iter_end;
+  boost::sregex_token_iterator iter_end;
   std::copy(iter_begin, iter_end, std::back_inserter(result));
 
   return result;
@@ -140,8 +208,17 @@ static void regexStringSplitFunc(sqlite3_context* context,
                                  int argc,
                                  sqlite3_value** argv) {
   try {
-    callStringSplitFunc(context, argc, argv, regexSplit);
-  } catch (const std::regex_error& e) {
+    callStringSplitFunc(
+        context,
+        argc,
+        argv,
+        [context](const std::string& input, const std::string& token) {
+          if (token.size() > FLAGS_regex_max_size) {
+            throw boost::regex_error(boost::regex_constants::error_complexity);
+          }
+          return regexSplit(input, *getRegex(context, 1, token));
+        });
+  } catch (const std::runtime_error& e) {
     LOG(INFO) << "Invalid regex: " << e.what();
     sqlite3_result_error(context, "Invalid regex", -1);
   }
@@ -173,22 +250,18 @@ static void regexStringMatchFunc(sqlite3_context* context,
   // parse and verify input parameters
   const std::string input(
       reinterpret_cast<const char*>(sqlite3_value_text(argv[0])));
-  std::smatch results;
+  boost::smatch results;
   auto index = static_cast<size_t>(sqlite3_value_int(argv[2]));
   bool isMatchFound = false;
 
-  if (strnlen(regex, FLAGS_regex_max_size) == FLAGS_regex_max_size &&
-      regex[FLAGS_regex_max_size] != '\0') {
-    std::string error = "Invalid regex: too big, max size is " +
-                        std::to_string(FLAGS_regex_max_size) + " bytes";
-    LOG(INFO) << error;
-    sqlite3_result_error(context, error.c_str(), -1);
+  if (!checkRegexSize(context, regex)) {
     return;
   }
 
   try {
-    isMatchFound = std::regex_search(input, results, std::regex(regex));
-  } catch (const std::regex_error& e) {
+    isMatchFound =
+        boost::regex_search(input, results, *getRegex(context, 1, regex));
+  } catch (const std::runtime_error& e) {
     LOG(INFO) << "Invalid regex: " << e.what();
     sqlite3_result_error(context, "Invalid regex", -1);
     return;
@@ -210,6 +283,45 @@ static void regexStringMatchFunc(sqlite3_context* context,
                       SQLITE_TRANSIENT);
 }
 
+/**
+ * @brief The REGEXP operator, `X REGEXP Y` calls regexp(Y, X)
+ *
+ * Returns 1 if the pattern matches anywhere in the value, otherwise 0.
+ */
+static void regexpFunc(sqlite3_context* context,
+                       int argc,
+                       sqlite3_value** argv) {
+  assert(argc == 2);
+  if (SQLITE_NULL == sqlite3_value_type(argv[0]) ||
+      SQLITE_NULL == sqlite3_value_type(argv[1])) {
+    sqlite3_result_null(context);
+    return;
+  }
+
+  const char* regex =
+      reinterpret_cast<const char*>(sqlite3_value_text(argv[0]));
+  const char* input =
+      reinterpret_cast<const char*>(sqlite3_value_text(argv[1]));
+  if (regex == nullptr || input == nullptr) {
+    sqlite3_result_null(context);
+    return;
+  }
+
+  if (!checkRegexSize(context, regex)) {
+    return;
+  }
+
+  try {
+    auto pattern = getRegex(context, 0, regex);
+    auto size = static_cast<size_t>(sqlite3_value_bytes(argv[1]));
+    sqlite3_result_int(context,
+                       boost::regex_search(input, input + size, *pattern));
+  } catch (const std::runtime_error& e) {
+    LOG(INFO) << "Invalid regex: " << e.what();
+    sqlite3_result_error(context, "Invalid regex", -1);
+  }
+}
+
 static void concatFunc(sqlite3_context* context,
                        std::string sep,
                        int starting,
@@ -336,6 +448,14 @@ void registerStringExtensions(sqlite3* db) {
                           regexStringMatchFunc,
                           nullptr,
                           nullptr);
+  sqlite3_create_function(db,
+                          "regexp",
+                          2,
+                          SQLITE_UTF8 | SQLITE_DETERMINISTIC,
+                          nullptr,
+                          regexpFunc,
+                          nullptr,
+                          nullptr);
   sqlite3_create_function(db,
                           "concat",
                           -1,
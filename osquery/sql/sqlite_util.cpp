@@ -39,10 +39,23 @@ FLAG(string,
 
 FLAG(string, nullvalue, "", "Set string for NULL values, default ''");
 
+HIDDEN_FLAG(uint32,
+            sqlite_statement_cache_size,
+            32,
+            "Number of prepared statements cached per SQLite connection");
+
+HIDDEN_FLAG(uint32,
+            sqlite_connection_pool_size,
+            4,
+            "Number of idle transient SQLite connections kept attached");
+
 using OpReg = QueryPlanner::Opcode::Register;
 
 using SQLiteDBInstanceRef = std::shared_ptr<SQLiteDBInstance>;
 
+/// Number of SQLite virtual machine instructions between deadline checks.
+const int kDeadlineProgressInterval{1000};
+
 /**
  * @brief A map of SQLite status codes to their corresponding message string
  *
@@ -181,14 +194,19 @@ Status SQLiteSQLPlugin::getQueryTables(const std::string& query,
   return Status(0);
 }
 
-SQLInternal::SQLInternal(const std::string& query, bool use_cache) {
-  auto dbc = SQLiteDBManager::get();
+SQLInternal::SQLInternal(const std::string& query, bool use_cache)
+    : SQLInternal(query, SQLiteDBManager::get(), use_cache) {}
+
+SQLInternal::SQLInternal(const std::string& query,
+                         const SQLiteDBInstanceRef& dbc,
+                         bool use_cache) {
   dbc->useCache(use_cache);
   status_ = queryInternal(query, resultsTyped_, dbc);
 
   // One of the advantages of using SQLInternal (aside from the Registry-bypass)
   // is the ability to "deep-inspect" the table attributes and actions.
   event_based_ = (dbc->getAttributes() & TableAttributes::EVENT_BASED) != 0;
+  table_stats_ = dbc->getTableStats();
 
   dbc->clearAffectedTables();
 }
@@ -205,6 +223,10 @@ bool SQLInternal::eventBased() const {
   return event_based_;
 }
 
+const TablePerformanceMap& SQLInternal::tableStats() const {
+  return table_stats_;
+}
+
 // Temporary:  I'm going to move this from sql.cpp to here in change immediately
 // following since this is the only place we actually use it (breaking up to
 // make CRs smaller)
@@ -233,6 +255,9 @@ void SQLInternal::escapeResults() {
 }
 
 Status SQLiteSQLPlugin::attach(const std::string& name) {
+  // Pooled connections and cached statements are from the previous tables.
+  SQLiteDBManager::instance().table_generation_++;
+
   PluginResponse response;
   auto status =
       Registry::call("table", name, {{"action", "columns"}}, response);
@@ -253,6 +278,8 @@ Status SQLiteSQLPlugin::attach(const std::string& name) {
 }
 
 Status SQLiteSQLPlugin::detach(const std::string& name) {
+  SQLiteDBManager::instance().table_generation_++;
+
   // Detach requests occurring via the plugin/registry APIs must act on the
   // primary database. To allow this, getConnection can explicitly request the
   // primary instance and avoid the contention decisions.
@@ -260,17 +287,23 @@ Status SQLiteSQLPlugin::detach(const std::string& name) {
   return detachTableInternal(name, dbc);
 }
 
-SQLiteDBInstance::SQLiteDBInstance(sqlite3*& db, Mutex& mtx)
-    : db_(db), lock_(mtx, boost::try_to_lock) {
-  if (lock_.owns_lock()) {
-    primary_ = true;
-  } else {
-    db_ = nullptr;
-    VLOG(1) << "DBManager contention: opening transient SQLite database";
-    init();
-  }
+SQLiteDBInstance::SQLiteDBInstance()
+    : statements_(FLAGS_sqlite_statement_cache_size) {
+  init();
 }
 
+SQLiteDBInstance::SQLiteDBInstance(sqlite3* db)
+    : primary_(true),
+      managed_(true),
+      db_(db),
+      statements_(FLAGS_sqlite_statement_cache_size) {}
+
+SQLiteDBInstance::SQLiteDBInstance(sqlite3* db, WriteLock&& lock)
+    : primary_(true),
+      db_(db),
+      lock_(std::move(lock)),
+      statements_(FLAGS_sqlite_statement_cache_size) {}
+
 // This function is called by SQLite when a statement is prepared and we use
 // it to allowlist specific actions.
 int sqliteAuthorizer(void* userData,
@@ -280,6 +313,11 @@ int sqliteAuthorizer(void* userData,
                      const char* arg5,
                      const char* arg6) {
   if (kAllowedSQLiteActionCodes.count(code) > 0) {
+    if (userData != nullptr && code != SQLITE_READ && code != SQLITE_SELECT &&
+        code != SQLITE_FUNCTION && code != SQLITE_RECURSIVE) {
+      // The connection may no longer match a freshly attached one.
+      static_cast<SQLiteDBInstance*>(userData)->modified_ = true;
+    }
     return SQLITE_OK;
   }
 
@@ -298,7 +336,8 @@ int sqliteAuthorizer(void* userData,
   return SQLITE_DENY;
 }
 
-static inline void openOptimized(sqlite3*& db) {
+static inline void openOptimized(sqlite3*& db,
+                                 SQLiteDBInstance* instance = nullptr) {
   sqlite3_open(":memory:", &db);
 
   std::string settings;
@@ -319,7 +358,7 @@ static inline void openOptimized(sqlite3*& db) {
   registerHashingExtensions(db);
   registerEncodingExtensions(db);
 
-  auto rc = sqlite3_set_authorizer(db, &sqliteAuthorizer, nullptr);
+  auto rc = sqlite3_set_authorizer(db, &sqliteAuthorizer, instance);
   if (rc != SQLITE_OK) {
     LOG(ERROR) << "Failed to set sqlite authorizer: " << sqlite3_errmsg(db);
     requestShutdown(rc);
@@ -328,7 +367,7 @@ static inline void openOptimized(sqlite3*& db) {
 
 void SQLiteDBInstance::init() {
   primary_ = false;
-  openOptimized(db_);
+  openOptimized(db_, this);
 }
 
 void SQLiteDBInstance::useCache(bool use_cache) {
@@ -346,6 +385,77 @@ RecursiveLock SQLiteDBInstance::attachLock() const {
   return RecursiveLock(attach_mutex_);
 }
 
+SQLiteDBInstance* SQLiteDBInstance::connectionInstance() {
+  if (isPrimary() && !managed_) {
+    // A temporary primary instance forwards to the DB manager's 'connection'.
+    return SQLiteDBManager::getConnection(true).get();
+  }
+  return this;
+}
+
+std::shared_ptr<sqlite3_stmt> SQLiteDBInstance::getStatement(
+    const std::string& sql) {
+  auto rdbc = connectionInstance();
+  if (rdbc->statements_.capacity() == 0) {
+    return nullptr;
+  }
+
+  auto generation = SQLiteDBManager::tableGeneration();
+  if (rdbc->statements_generation_ != generation) {
+    rdbc->statements_.clear();
+    rdbc->statements_generation_ = generation;
+    return nullptr;
+  }
+
+  auto cached = rdbc->statements_.get(sql);
+  if (cached == nullptr || sqlite3_stmt_busy(cached->statement.get())) {
+    return nullptr;
+  }
+
+  // The tables' planned constraints are cleared after each query.
+  for (const auto& plan : cached->plans) {
+    plan.table->constraints[plan.index] = plan.constraints;
+    plan.table->colsUsed[plan.index] = plan.colsUsed;
+    plan.table->colsUsedBitsets[plan.index] = plan.colsUsedBitset;
+  }
+  return cached->statement;
+}
+
+void SQLiteDBInstance::cacheStatement(const std::string& sql,
+                                      std::shared_ptr<sqlite3_stmt> statement) {
+  auto rdbc = connectionInstance();
+  if (rdbc->statements_.capacity() == 0) {
+    return;
+  }
+
+  PreparedStatement prepared;
+  prepared.statement = std::move(statement);
+  for (const auto& planned : rdbc->planned_indexes_) {
+    const auto& table = planned.first;
+    PlannedIndex plan;
+    plan.table = table;
+    plan.index = planned.second;
+    plan.constraints = table->constraints[planned.second];
+    plan.colsUsed = table->colsUsed[planned.second];
+    plan.colsUsedBitset = table->colsUsedBitsets[planned.second];
+    prepared.plans.push_back(std::move(plan));
+  }
+  rdbc->statements_.insert(sql, std::move(prepared));
+}
+
+void SQLiteDBInstance::eraseStatement(const std::string& sql) {
+  connectionInstance()->statements_.erase(sql);
+}
+
+void SQLiteDBInstance::addPlannedIndex(
+    std::shared_ptr<VirtualTableContent> table, size_t index) {
+  planned_indexes_.push_back(std::make_pair(std::move(table), index));
+}
+
+void SQLiteDBInstance::clearPlannedIndexes() {
+  connectionInstance()->planned_indexes_.clear();
+}
+
 void SQLiteDBInstance::addAffectedTable(
     std::shared_ptr<VirtualTableContent> table) {
   // An xFilter/scan was requested for this virtual table.
@@ -356,6 +466,24 @@ bool SQLiteDBInstance::tableCalled(VirtualTableContent const& table) {
   return (affected_tables_.count(table.name) > 0);
 }
 
+void SQLiteDBInstance::recordTableGenerate(const std::string& table,
+                                           size_t rows,
+                                           uint64_t generate_time) {
+  auto& stats = table_stats_[table];
+  stats.generations += 1;
+  stats.rows += rows;
+  stats.generate_time += generate_time;
+}
+
+TablePerformanceMap SQLiteDBInstance::getTableStats() const {
+  const SQLiteDBInstance* rdbc = this;
+  if (isPrimary() && !managed_) {
+    // Similarly to getAttributes, the connection may be forwarded.
+    rdbc = SQLiteDBManager::getConnection(true).get();
+  }
+  return rdbc->table_stats_;
+}
+
 TableAttributes SQLiteDBInstance::getAttributes() const {
   const SQLiteDBInstance* rdbc = this;
   if (isPrimary() && !managed_) {
@@ -387,10 +515,14 @@ void SQLiteDBInstance::clearAffectedTables() {
   // Since the affected tables are cleared, there are no more affected tables.
   // There is no concept of compounding tables between queries.
   affected_tables_.clear();
+  table_stats_.clear();
+  planned_indexes_.clear();
   use_cache_ = false;
 }
 
 SQLiteDBInstance::~SQLiteDBInstance() {
+  // Statements are finalized before the database is closed.
+  statements_.clear();
   if (!isPrimary() && db_ != nullptr) {
     sqlite3_close(db_);
   } else {
@@ -440,10 +572,18 @@ bool SQLiteDBManager::isDisabled(const std::string& table_name) {
   return true;
 }
 
+TableGeneration SQLiteDBManager::tableGeneration() {
+  return std::make_pair(instance().table_generation_.load(),
+                        RegistryFactory::get().count("table"));
+}
+
 void SQLiteDBManager::resetPrimary() {
   auto& self = instance();
 
   WriteLock connection_lock(self.mutex_);
+  if (self.connection_ != nullptr) {
+    self.connection_->statements_.clear();
+  }
   self.connection_.reset();
 
   {
@@ -471,32 +611,93 @@ SQLiteDBInstanceRef SQLiteDBManager::getUnique() {
   return instance;
 }
 
+SQLiteDBInstanceRef SQLiteDBManager::getWorkerConnection() {
+  thread_local SQLiteDBInstanceRef instance{nullptr};
+  thread_local TableGeneration table_generation;
+
+  auto current_generation = tableGeneration();
+  if (instance == nullptr || table_generation != current_generation) {
+    instance = SQLiteDBManager::getUnique();
+    table_generation = current_generation;
+  }
+  return instance;
+}
+
 SQLiteDBInstanceRef SQLiteDBManager::getConnection(bool primary) {
   auto& self = instance();
-  WriteLock lock(self.create_mutex_);
+  {
+    WriteLock lock(self.create_mutex_);
+
+    if (self.db_ == nullptr) {
+      // Create primary SQLite DB instance.
+      openOptimized(self.db_);
+      self.connection_ = SQLiteDBInstanceRef(new SQLiteDBInstance(self.db_));
+      attachVirtualTables(self.connection_);
+    }
+
+    // Internal usage may request the primary connection explicitly.
+    if (primary) {
+      return self.connection_;
+    }
+
+    // Create a 'database connection' for the managed database instance.
+    WriteLock primary_lock(self.mutex_, boost::try_to_lock);
+    if (primary_lock.owns_lock()) {
+      return std::make_shared<SQLiteDBInstance>(self.db_,
+                                                std::move(primary_lock));
+    }
+  }
+
+  VLOG(1) << "DBManager contention: using a transient SQLite database";
+  return getPooledConnection();
+}
+
+SQLiteDBInstanceRef SQLiteDBManager::getPooledConnection() {
+  auto& self = instance();
+  auto generation = tableGeneration();
 
-  if (self.db_ == nullptr) {
-    // Create primary SQLite DB instance.
-    openOptimized(self.db_);
-    self.connection_ = SQLiteDBInstanceRef(new SQLiteDBInstance(self.db_));
-    attachVirtualTables(self.connection_);
+  std::shared_ptr<SQLiteDBInstance> dbc;
+  {
+    WriteLock lock(self.pool_mutex_);
+    while (dbc == nullptr && !self.pool_.empty()) {
+      dbc = std::move(self.pool_.back());
+      self.pool_.pop_back();
+      if (dbc->generation_ != generation) {
+        dbc.reset();
+      }
+    }
   }
 
-  // Internal usage may request the primary connection explicitly.
-  if (primary) {
-    return self.connection_;
+  if (dbc == nullptr) {
+    dbc = std::make_shared<SQLiteDBInstance>();
+    attachVirtualTables(dbc);
+    dbc->generation_ = generation;
+    dbc->modified_ = false;
   }
 
-  // Create a 'database connection' for the managed database instance.
-  auto instance = std::make_shared<SQLiteDBInstance>(self.db_, self.mutex_);
-  if (!instance->isPrimary()) {
-    attachVirtualTables(instance);
+  // The connection returns to the pool when the caller releases it.
+  return SQLiteDBInstanceRef(dbc.get(), [dbc](SQLiteDBInstance*) {
+    releasePooledConnection(dbc);
+  });
+}
+
+void SQLiteDBManager::releasePooledConnection(
+    std::shared_ptr<SQLiteDBInstance> dbc) {
+  // Tables or views a query created would be seen by the next query.
+  if (dbc->modified_ || dbc->generation_ != tableGeneration()) {
+    return;
   }
 
-  return instance;
+  dbc->clearAffectedTables();
+  auto& self = instance();
+  WriteLock lock(self.pool_mutex_);
+  if (self.pool_.size() < FLAGS_sqlite_connection_pool_size) {
+    self.pool_.push_back(std::move(dbc));
+  }
 }
 
 SQLiteDBManager::~SQLiteDBManager() {
+  pool_.clear();
   connection_ = nullptr;
   if (db_ != nullptr) {
     sqlite3_close(db_);
@@ -599,7 +800,7 @@ Status queryInternal(const std::string& query,
 }
 
 Status readRows(sqlite3_stmt* prepared_statement,
-                QueryDataTyped& results,
+                const RowTypedCallback& callback,
                 const SQLiteDBInstanceRef& instance) {
   // Do nothing with a null prepared_statement (eg, if the sql was just
   // whitespace)
@@ -638,29 +839,43 @@ Status readRows(sqlite3_stmt* prepared_statement,
               sqlite3_column_text(prepared_statement, i)));
         }
       }
-      results.push_back(std::move(row));
+      auto s = callback(std::move(row));
+      if (!s.ok()) {
+        return s;
+      }
       rc = sqlite3_step(prepared_statement);
     } while (SQLITE_ROW == rc);
   }
   if (rc != SQLITE_DONE) {
-    auto s = Status::failure(sqlite3_errmsg(instance->db()));
-    sqlite3_finalize(prepared_statement);
-    return s;
-  }
-
-  rc = sqlite3_finalize(prepared_statement);
-  if (rc != SQLITE_OK) {
     return Status::failure(sqlite3_errmsg(instance->db()));
   }
 
   return Status::success();
 }
 
+/// Check if only whitespace remains after a prepared statement.
+static bool isLastStatement(const char* leftover_sql) {
+  while (leftover_sql != nullptr && isspace(leftover_sql[0])) {
+    leftover_sql++;
+  }
+  return leftover_sql == nullptr || leftover_sql[0] == '\0';
+}
+
 Status queryInternal(const std::string& query,
                      QueryDataTyped& results,
                      const SQLiteDBInstanceRef& instance) {
-  sqlite3_stmt* prepared_statement{nullptr}; /* Statement to execute. */
+  return queryInternal(
+      query,
+      [&results](RowTyped&& row) {
+        results.push_back(std::move(row));
+        return Status::success();
+      },
+      instance);
+}
 
+Status queryInternal(const std::string& query,
+                     const RowTypedCallback& callback,
+                     const SQLiteDBInstanceRef& instance) {
   int rc = SQLITE_OK; /* Return Code */
   const char* leftover_sql = nullptr; /* Tail of unprocessed SQL */
   const char* sql = query.c_str(); /* SQL to be processed */
@@ -673,15 +888,42 @@ Status queryInternal(const std::string& query,
     while (isspace(sql[0])) {
       sql++;
     }
-    rc = sqlite3_prepare_v2(
-        instance->db(), sql, -1, &prepared_statement, &leftover_sql);
-    if (rc != SQLITE_OK) {
-      Status s = Status::failure(sqlite3_errmsg(instance->db()));
-      sqlite3_finalize(prepared_statement);
-      return s;
+
+    // The last statement of a query is cached by its text, a scheduled query
+    // is prepared once per connection.
+    std::string statement_sql(sql);
+    instance->clearPlannedIndexes();
+    auto statement = instance->getStatement(statement_sql);
+    bool cached = (statement != nullptr);
+    if (cached) {
+      leftover_sql = sql + statement_sql.size();
+    } else {
+      sqlite3_stmt* prepared_statement{nullptr}; /* Statement to execute. */
+      rc = sqlite3_prepare_v2(
+          instance->db(), sql, -1, &prepared_statement, &leftover_sql);
+      if (rc != SQLITE_OK) {
+        Status s = Status::failure(sqlite3_errmsg(instance->db()));
+        sqlite3_finalize(prepared_statement);
+        return s;
+      }
+
+      statement.reset(prepared_statement, sqlite3_finalize);
+      if (prepared_statement != nullptr && isLastStatement(leftover_sql)) {
+        instance->cacheStatement(statement_sql, statement);
+        cached = true;
+      }
     }
 
-    Status s = readRows(prepared_statement, results, instance);
+    Status s = readRows(statement.get(), callback, instance);
+    if (cached) {
+      // Rows may remain if the callback stopped the query.
+      sqlite3_reset(statement.get());
+      if (sqlite3_stmt_status(
+              statement.get(), SQLITE_STMTSTATUS_REPREPARE, 1) > 0) {
+        // The schema changed, the planned constraints are no longer valid.
+        instance->eraseStatement(statement_sql);
+      }
+    }
     if (!s.ok()) {
       return s;
     }
@@ -692,6 +934,34 @@ Status queryInternal(const std::string& query,
   return Status::success();
 }
 
+SQLiteQueryDeadline::SQLiteQueryDeadline(const SQLiteDBInstanceRef& instance,
+                                         std::chrono::milliseconds timeout) {
+  if (timeout.count() > 0) {
+    instance_ = instance;
+    deadline_ = std::chrono::steady_clock::now() + timeout;
+    sqlite3_progress_handler(instance_->db(),
+                             kDeadlineProgressInterval,
+                             &SQLiteQueryDeadline::onProgress,
+                             this);
+  }
+}
+
+SQLiteQueryDeadline::~SQLiteQueryDeadline() {
+  if (instance_ != nullptr) {
+    sqlite3_progress_handler(instance_->db(), 0, nullptr, nullptr);
+  }
+}
+
+int SQLiteQueryDeadline::onProgress(void* deadline) {
+  auto self = static_cast<SQLiteQueryDeadline*>(deadline);
+  if (std::chrono::steady_clock::now() >= self->deadline_) {
+    // A non-zero return interrupts the running statement.
+    self->expired_ = true;
+    return 1;
+  }
+  return 0;
+}
+
 Status getQueryColumnsInternal(const std::string& q,
                                TableColumns& columns,
                                const SQLiteDBInstanceRef& instance) {
@@ -10,17 +10,23 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <unordered_set>
+#include <vector>
 
 #include <sqlite3.h>
 
 #include <boost/filesystem.hpp>
 #include <boost/noncopyable.hpp>
 
+#include <osquery/core/sql/query_performance.h>
 #include <osquery/sql/sql.h>
 
+#include <osquery/utils/caches/lru.h>
 #include <osquery/utils/mutex.h>
 
 #include <gtest/gtest_prod.h>
@@ -84,6 +90,9 @@ const std::unordered_set<std::string> kAllowedSQLitePragmas = {
 
 class SQLiteDBManager;
 
+/// The attach generation and number of registered tables, see SQLiteDBManager.
+using TableGeneration = std::pair<size_t, size_t>;
+
 /**
  * @brief An RAII wrapper around an `sqlite3` object.
  *
@@ -93,14 +102,13 @@ class SQLiteDBManager;
  *
  * If there is resource contention (multiple threads want access to the SQLite
  * abstraction layer), then the SQLiteDBManager will provide a transient
- * SQLiteDBInstance.
+ * SQLiteDBInstance. Transient instances are kept in a small pool with their
+ * virtual tables attached and reused by the next contending request.
  */
 class SQLiteDBInstance : private boost::noncopyable {
  public:
-  SQLiteDBInstance() {
-    init();
-  }
-  SQLiteDBInstance(sqlite3*& db, Mutex& mtx);
+  SQLiteDBInstance();
+  SQLiteDBInstance(sqlite3* db, WriteLock&& lock);
   ~SQLiteDBInstance();
 
   /// Check if the instance is the osquery primary.
@@ -128,6 +136,22 @@ class SQLiteDBInstance : private boost::noncopyable {
   /// Check if a virtual table had been called already.
   bool tableCalled(VirtualTableContent const& table);
 
+  /**
+   * @brief Record the rows and time a virtual table spent generating.
+   *
+   * Statistics are per-query and are cleared with the affected tables.
+   *
+   * @param table The virtual table name.
+   * @param rows The number of rows the table produced.
+   * @param generate_time The time spent generating, in microseconds.
+   */
+  void recordTableGenerate(const std::string& table,
+                           size_t rows,
+                           uint64_t generate_time);
+
+  /// Get the virtual table statistics recorded since the last clear.
+  TablePerformanceMap getTableStats() const;
+
   /// Request that virtual tables use a warm cache for their results.
   void useCache(bool use_cache);
 
@@ -137,14 +161,63 @@ class SQLiteDBInstance : private boost::noncopyable {
   /// Lock the database for attaching virtual tables.
   RecursiveLock attachLock() const;
 
+  /**
+   * @brief Get the cached prepared statement for a query's SQL text.
+   *
+   * A cached statement is reset after each use and keeps the constraints its
+   * virtual tables planned when it was prepared, these are restored for the
+   * next execution. A statement that is executing is not returned.
+   *
+   * @param sql The SQL text of a single statement.
+   * @return The statement or nullptr if it must be prepared.
+   */
+  std::shared_ptr<sqlite3_stmt> getStatement(const std::string& sql);
+
+  /**
+   * @brief Cache a statement that was just prepared.
+   *
+   * The constraints recorded with addPlannedIndex since the last call to
+   * clearPlannedIndexes are kept with the statement.
+   */
+  void cacheStatement(const std::string& sql,
+                      std::shared_ptr<sqlite3_stmt> statement);
+
+  /// Remove a statement from the cache, for example when it was re-prepared.
+  void eraseStatement(const std::string& sql);
+
+  /// Record a constraint set a virtual table planned in xBestIndex.
+  void addPlannedIndex(std::shared_ptr<VirtualTableContent> table,
+                       size_t index);
+
+  /// Clear the planned constraint sets before preparing a statement.
+  void clearPlannedIndexes();
+
  private:
   /// Handle the primary/forwarding requests for table attribute accesses.
   TableAttributes getAttributes() const;
 
+  /// The instance keeping the state of the connection, see clearAffectedTables.
+  SQLiteDBInstance* connectionInstance();
+
  private:
   /// An opaque constructor only used by the DBManager.
-  explicit SQLiteDBInstance(sqlite3* db)
-      : primary_(true), managed_(true), db_(db) {}
+  explicit SQLiteDBInstance(sqlite3* db);
+
+ private:
+  /// A constraint set of a virtual table planned for a prepared statement.
+  struct PlannedIndex {
+    std::shared_ptr<VirtualTableContent> table;
+    size_t index;
+    ConstraintSet constraints;
+    UsedColumns colsUsed;
+    UsedColumnsBitset colsUsedBitset;
+  };
+
+  /// A cached prepared statement and its planned constraint sets.
+  struct PreparedStatement {
+    std::shared_ptr<sqlite3_stmt> statement;
+    std::vector<PlannedIndex> plans;
+  };
 
  private:
   /// Introspection into the database pointer, primary means managed.
@@ -160,9 +233,9 @@ class SQLiteDBInstance : private boost::noncopyable {
   sqlite3* db_{nullptr};
 
   /**
-   * @brief An attempted unique lock on the manager's primary database mutex.
+   * @brief A unique lock on the manager's primary database mutex.
    *
-   * This lock is not always acquired. If it is then this instance has locked
+   * This lock is only held by a temporary primary instance, it has locked
    * access to the 'primary' SQLite database.
    */
   WriteLock lock_;
@@ -182,12 +255,38 @@ class SQLiteDBInstance : private boost::noncopyable {
   /// Vector of tables that need their constraints cleared after execution.
   std::map<std::string, std::shared_ptr<VirtualTableContent>> affected_tables_;
 
+  /// Generate statistics for each table used by the current query.
+  TablePerformanceMap table_stats_;
+
+  /// Prepared statements by SQL text.
+  caches::LRU<std::string, PreparedStatement> statements_;
+
+  /// The table generation of the cached statements.
+  TableGeneration statements_generation_;
+
+  /// Virtual table constraint sets planned since the last clear.
+  std::vector<std::pair<std::shared_ptr<VirtualTableContent>, size_t>>
+      planned_indexes_;
+
+  /// The table generation when a pooled connection attached its tables.
+  TableGeneration generation_;
+
+  /// Set by the authorizer when a statement may change the schema or data.
+  bool modified_{false};
+
  private:
   friend class SQLiteDBManager;
   friend class SQLInternal;
+  friend int sqliteAuthorizer(void* userData,
+                              int code,
+                              const char* arg3,
+                              const char* arg4,
+                              const char* arg5,
+                              const char* arg6);
 
  private:
   FRIEND_TEST(SQLiteUtilTests, test_affected_tables);
+  FRIEND_TEST(SQLiteUtilTests, test_statement_cache);
 };
 
 using SQLiteDBInstanceRef = std::shared_ptr<SQLiteDBInstance>;
@@ -231,6 +330,16 @@ class SQLiteDBManager : private boost::noncopyable {
   /// See `get` but always return a transient DB connection (for testing).
   static SQLiteDBInstanceRef getUnique();
 
+  /**
+   * @brief Return a transient DB connection kept by the calling thread.
+   *
+   * Worker threads executing queries concurrently each keep a connection
+   * rather than contending for the primary database. The connection is
+   * re-created if the set of registered tables changes, for example when an
+   * extension registers or removes a table.
+   */
+  static SQLiteDBInstanceRef getWorkerConnection();
+
   /**
    * @brief Reset the primary database connection.
    *
@@ -251,6 +360,16 @@ class SQLiteDBManager : private boost::noncopyable {
    */
   static bool isDisabled(const std::string& table_name);
 
+  /**
+   * @brief Get the generation of the set of registered tables.
+   *
+   * The generation changes when a table is attached or detached through the
+   * registry, for example by an extension, or when the number of registered
+   * tables changes. Connections and statements from an earlier generation are
+   * not reused.
+   */
+  static TableGeneration tableGeneration();
+
  protected:
   SQLiteDBManager();
   virtual ~SQLiteDBManager();
@@ -287,6 +406,22 @@ class SQLiteDBManager : private boost::noncopyable {
   /// Request a connection, optionally request the primary connection.
   static SQLiteDBInstanceRef getConnection(bool primary = false);
 
+  /// Take an idle transient connection from the pool or create one.
+  static SQLiteDBInstanceRef getPooledConnection();
+
+  /// Return a transient connection to the pool, if it may be reused.
+  static void releasePooledConnection(std::shared_ptr<SQLiteDBInstance> dbc);
+
+ private:
+  /// Idle transient connections with the virtual tables attached.
+  std::vector<std::shared_ptr<SQLiteDBInstance>> pool_;
+
+  /// Mutex protecting the pool of transient connections.
+  Mutex pool_mutex_;
+
+  /// See tableGeneration.
+  std::atomic<size_t> table_generation_{0};
+
  private:
   friend class SQLiteDBInstance;
   friend class SQLiteSQLPlugin;
@@ -397,6 +532,67 @@ Status queryInternal(const std::string& q,
                      QueryData& results,
                      const SQLiteDBInstanceRef& instance);
 
+/// Receives each row of a query as it is read, a failure stops the query.
+using RowTypedCallback = std::function<Status(RowTyped&& row)>;
+
+/**
+ * @brief SQLite Internal: Execute a query and stream each row to a callback
+ *
+ * Rows are handed over as they are stepped, so the results of the query are
+ * never held at once. The instance remains locked while the callback runs.
+ *
+ * @param q the query to execute
+ * @param callback called for each row, a failure is returned as the status.
+ * @param db the SQLite3 database to execute query q against
+ *
+ * @return A status indicating SQL query results.
+ */
+Status queryInternal(const std::string& q,
+                     const RowTypedCallback& callback,
+                     const SQLiteDBInstanceRef& instance);
+
+/**
+ * @brief Interrupt queries on a connection that execute past a deadline.
+ *
+ * A SQLite progress handler is installed on the connection for the lifetime
+ * of the object. Once the deadline passes, the running statement fails with
+ * SQLITE_INTERRUPT. A virtual table's generate is not interrupted, the
+ * statement fails when SQLite next steps its program.
+ */
+class SQLiteQueryDeadline : private boost::noncopyable {
+ public:
+  /**
+   * @brief Start the deadline for queries on a connection.
+   *
+   * @param instance The SQLite database connection to interrupt.
+   * @param timeout The time queries may execute, 0 for no deadline.
+   */
+  SQLiteQueryDeadline(const SQLiteDBInstanceRef& instance,
+                      std::chrono::milliseconds timeout);
+
+  /// Remove the progress handler from the connection.
+  ~SQLiteQueryDeadline();
+
+  /// Check if the deadline passed and queries were interrupted.
+  bool expired() const {
+    return expired_;
+  }
+
+ private:
+  /// The SQLite progress handler.
+  static int onProgress(void* deadline);
+
+ private:
+  /// The connection with the progress handler installed.
+  SQLiteDBInstanceRef instance_;
+
+  /// The point in time at which queries are interrupted.
+  std::chrono::steady_clock::time_point deadline_;
+
+  /// Set once the deadline passed.
+  bool expired_{false};
+};
+
 /**
  * @brief SQLite Intern: Analyze a query, providing information about the
  * result columns
@@ -430,6 +626,20 @@ class SQLInternal : private only_movable {
    */
   explicit SQLInternal(const std::string& query, bool use_cache = false);
 
+  /**
+   * @brief Instantiate an instance of the class using a specific connection.
+   *
+   * Callers executing queries concurrently may hold their own connection
+   * rather than contending for the manager's primary database.
+   *
+   * @param query An osquery SQL query.
+   * @param instance The SQLite database connection to execute against.
+   * @param use_cache [optional] Set true to use the query cache.
+   */
+  SQLInternal(const std::string& query,
+              const SQLiteDBInstanceRef& instance,
+              bool use_cache = false);
+
  public:
   /**
    * @brief Const accessor for the rows returned by the query.
@@ -453,6 +663,9 @@ class SQLInternal : private only_movable {
    */
   bool eventBased() const;
 
+  /// The generate time and rows of each virtual table used by the query.
+  const TablePerformanceMap& tableStats() const;
+
   /// ASCII escape the results of the query.
   void escapeResults();
 
@@ -464,6 +677,9 @@ class SQLInternal : private only_movable {
   Status status_;
   /// Before completing the execution, store a check for EVENT_BASED.
   bool event_based_{false};
+
+  /// Before completing the execution, store the virtual table statistics.
+  TablePerformanceMap table_stats_;
 };
 
 /**
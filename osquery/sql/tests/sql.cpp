@@ -265,6 +265,68 @@ TEST_F(SQLTests, test_regex_match_too_big) {
             0);
 }
 
+TEST_F(SQLTests, test_regex_match_many_rows) {
+  QueryData d;
+  // The compiled pattern is reused for each row.
+  query(
+      "with recursive n(x) as (select 1 union all select x + 1 from n "
+      "where x < 100) select x from n "
+      "where regex_match('p' || x, '^p(9[0-9])$', 1) is not null",
+      d);
+  ASSERT_EQ(d.size(), 10U);
+  EXPECT_EQ(d[0]["x"], "90");
+  EXPECT_EQ(d[9]["x"], "99");
+}
+
+/*
+ * regexp
+ */
+
+TEST_F(SQLTests, test_regexp) {
+  QueryData d;
+  auto status = query(
+      "select 'hello world' regexp 'o w' as t0, \
+              'hello world' regexp '^world' as t1, \
+              'hello world' regexp '(l+)o' as t2, \
+              NULL regexp 'hello' as t3",
+      d);
+  ASSERT_TRUE(status.ok());
+  ASSERT_EQ(d.size(), 1U);
+  EXPECT_EQ(d[0]["t0"], "1");
+  EXPECT_EQ(d[0]["t1"], "0");
+  EXPECT_EQ(d[0]["t2"], "1");
+  EXPECT_EQ(d[0]["t3"], "");
+}
+
+TEST_F(SQLTests, test_regexp_where) {
+  QueryData d;
+  auto status = query(
+      "with recursive n(x) as (select 1 union all select x + 1 from n "
+      "where x < 1000) select count(*) as c from n where x regexp '^1[0-9]*5$'",
+      d);
+  ASSERT_TRUE(status.ok());
+  ASSERT_EQ(d.size(), 1U);
+  EXPECT_EQ(d[0]["c"], "11");
+}
+
+TEST_F(SQLTests, test_regexp_invalid) {
+  QueryData d;
+  auto status = query("select 'foo/bar' regexp '(/'", d);
+  ASSERT_FALSE(status.ok());
+
+  // Catastrophic backtracking is stopped instead of running forever.
+  status = query(
+      "select 'aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab' regexp '(a*)*c'", d);
+  ASSERT_FALSE(status.ok());
+}
+
+TEST_F(SQLTests, test_regexp_too_big) {
+  QueryData d;
+  std::string regex(100000, 'a');
+  auto status = query("select 'foo/bar' regexp '" + regex + "'", d);
+  ASSERT_FALSE(status.ok());
+}
+
 /*
  * split
  */
@@ -185,6 +185,79 @@ TEST_F(SQLiteUtilTests, test_affected_tables) {
   EXPECT_EQ(dbc->affected_tables_.size(), 0U);
 }
 
+TEST_F(SQLiteUtilTests, test_statement_cache) {
+  auto dbc = getTestDBC();
+  for (size_t i = 0; i < 2; i++) {
+    QueryDataTyped results;
+    auto status = queryInternal(kTestQuery, results, dbc);
+    EXPECT_TRUE(status.ok());
+    EXPECT_EQ(results, getTestDBExpectedResults());
+  }
+  EXPECT_EQ(dbc->statements_.size(), 1U);
+
+  // Only the last statement of a query is cached.
+  QueryDataTyped results;
+  auto status = queryInternal("select 1; select 2 as two;", results, dbc);
+  EXPECT_TRUE(status.ok());
+  EXPECT_EQ(dbc->statements_.size(), 2U);
+
+  // A cached statement sees changes to the schema.
+  sqlite3_exec(dbc->db(),
+               "DROP TABLE test_table; "
+               "CREATE TABLE test_table (username varchar(30), age int); "
+               "INSERT INTO test_table VALUES ('sam', 20)",
+               nullptr,
+               nullptr,
+               nullptr);
+  results.clear();
+  status = queryInternal(kTestQuery, results, dbc);
+  EXPECT_TRUE(status.ok());
+  ASSERT_EQ(results.size(), 1U);
+  EXPECT_EQ(boost::get<std::string>(results[0]["username"]), "sam");
+}
+
+TEST_F(SQLiteUtilTests, test_connection_pool) {
+  // Hold the primary database, other connections are transient.
+  auto primary = SQLiteDBManager::get();
+  ASSERT_TRUE(primary->isPrimary());
+
+  auto dbc = SQLiteDBManager::get();
+  ASSERT_FALSE(dbc->isPrimary());
+  auto db = dbc->db();
+  dbc.reset();
+
+  // A released connection is handed out again, with its tables attached.
+  dbc = SQLiteDBManager::get();
+  EXPECT_EQ(dbc->db(), db);
+  QueryDataTyped results;
+  auto status = queryInternal("select * from time", results, dbc);
+  EXPECT_TRUE(status.ok());
+  EXPECT_EQ(results.size(), 1U);
+
+  // A connection a query created a view on is not reused.
+  status = queryInternal("create view pool_view as select 1", results, dbc);
+  EXPECT_TRUE(status.ok());
+  dbc.reset();
+  dbc = SQLiteDBManager::get();
+  status = queryInternal("select * from pool_view", results, dbc);
+  EXPECT_FALSE(status.ok());
+}
+
+TEST_F(SQLiteUtilTests, test_table_stats) {
+  auto dbc = getTestDBC();
+  SQLInternal sql("SELECT * FROM time", dbc);
+  ASSERT_TRUE(sql.getStatus().ok());
+
+  // Each scanned table records its generate calls and rows for the query.
+  const auto& stats = sql.tableStats();
+  ASSERT_EQ(stats.count("time"), 1U);
+  EXPECT_EQ(stats.at("time").generations, 1U);
+  EXPECT_EQ(stats.at("time").rows, 1U);
+
+  // The statistics are per-query and cleared with the affected tables.
+  EXPECT_TRUE(dbc->getTableStats().empty());
+}
+
 TEST_F(SQLiteUtilTests, test_table_attributes_event_based) {
   {
     SQLInternal sql_internal("select * from process_events");
@@ -14,7 +14,9 @@
 #include <osquery/database/database.h>
 #include <osquery/logger/logger.h>
 #include <osquery/registry/registry.h>
+#include <osquery/sql/columnar_table_row.h>
 #include <osquery/sql/dynamic_table_row.h>
+#include <osquery/sql/indexed_table_row.h>
 #include <osquery/sql/sql.h>
 
 #include <osquery/sql/virtual_table.h>
@@ -451,6 +453,154 @@ TEST_F(VirtualTableTests, test_null_values) {
   }
 }
 
+class columnarTablePlugin : public TablePlugin {
+ protected:
+  TableColumns columns() const override {
+    return {
+        std::make_tuple("name", TEXT_TYPE, ColumnOptions::DEFAULT),
+        std::make_tuple("count", INTEGER_TYPE, ColumnOptions::DEFAULT),
+        std::make_tuple("size", BIGINT_TYPE, ColumnOptions::DEFAULT),
+        std::make_tuple("ratio", DOUBLE_TYPE, ColumnOptions::DEFAULT),
+    };
+  }
+
+ public:
+  TableRows generate(QueryContext&) override {
+    TableRows results;
+    results.push_back(make_table_row(
+        {{"name", "a"}, {"count", "1"}, {"size", "0x10"}, {"ratio", "0.5"}}));
+    results.push_back(make_table_row(
+        {{"name", ""}, {"count", ""}, {"size", "x"}, {"ratio", "1.5"}}));
+    results.push_back(make_table_row({{"count", "3"}}));
+    if (undeclared_column_) {
+      results.push_back(make_table_row({{"name", "c"}, {"rowid", "1"}}));
+    }
+    return results;
+  }
+
+ public:
+  bool undeclared_column_{false};
+};
+
+class columnarResultsTablePlugin : public columnarTablePlugin {
+ public:
+  TableRows generate(QueryContext& context) override {
+    // Respond as an extension would, with the generated rows as columns.
+    auto rows = columnarTablePlugin::generate(context);
+    ColumnarRows results;
+    tableRowsToColumns(rows, columns(), results);
+    return tableRowsFromColumns(std::move(results));
+  }
+};
+
+TEST_F(VirtualTableTests, test_columnar_rows) {
+  auto tables = RegistryFactory::get().registry("table");
+  auto rows_table = std::make_shared<columnarTablePlugin>();
+  auto columns_table = std::make_shared<columnarResultsTablePlugin>();
+  tables->add("columnar_rows", rows_table);
+  tables->add("columnar_columns", columns_table);
+
+  auto dbc = SQLiteDBManager::getUnique();
+  attachTableInternal(
+      "columnar_rows", rows_table->columnDefinition(false), dbc, false);
+  attachTableInternal(
+      "columnar_columns", columns_table->columnDefinition(false), dbc, false);
+
+  // Columns are converted to the same SQL values as rows.
+  std::string statement =
+      "SELECT name, typeof(name) AS tn, count, typeof(count) AS tc, size, "
+      "typeof(size) AS ts, ratio, typeof(ratio) AS tr FROM ";
+  QueryData row_results;
+  auto status = queryInternal(statement + "columnar_rows", row_results, dbc);
+  ASSERT_TRUE(status.ok()) << status.what();
+  QueryData column_results;
+  status = queryInternal(statement + "columnar_columns", column_results, dbc);
+  ASSERT_TRUE(status.ok()) << status.what();
+  ASSERT_EQ(column_results.size(), 3U);
+  EXPECT_EQ(row_results, column_results);
+  EXPECT_EQ(column_results[0]["size"], "16");
+  EXPECT_EQ(column_results[1]["tc"], "null");
+  EXPECT_EQ(column_results[2]["tn"], "null");
+
+  // A row with a value outside of the declared columns is sent as a row.
+  rows_table->undeclared_column_ = true;
+  PluginResponse response;
+  ColumnarRows columns;
+  status =
+      rows_table->callColumnar({{"action", "generate"}}, response, columns);
+  ASSERT_TRUE(status.ok());
+  EXPECT_TRUE(columns.columns.empty());
+  ASSERT_EQ(response.size(), 4U);
+  EXPECT_EQ(response[3]["rowid"], "1");
+}
+
+class indexedTablePlugin : public columnarTablePlugin {
+ public:
+  TableRows generate(QueryContext&) override {
+    auto names = std::make_shared<const IndexedColumns>(
+        IndexedColumns{"name", "count", "size", "ratio"});
+
+    TableRows results;
+    auto r = make_indexed_row(names);
+    r->set(0, "a");
+    r->set(1, 1);
+    r->set(2, "0x10");
+    r->set(3, 0.5);
+    results.push_back(std::move(r));
+
+    r = make_indexed_row(names);
+    r->set(0, "");
+    r->set(1, "");
+    r->set(2, "x");
+    r->set(3, "1.5");
+    results.push_back(std::move(r));
+
+    r = make_indexed_row(names);
+    r->set(1, 3);
+    results.push_back(std::move(r));
+    return results;
+  }
+};
+
+TEST_F(VirtualTableTests, test_indexed_rows) {
+  auto tables = RegistryFactory::get().registry("table");
+  auto rows_table = std::make_shared<columnarTablePlugin>();
+  auto indexed_table = std::make_shared<indexedTablePlugin>();
+  tables->add("indexed_dynamic_rows", rows_table);
+  tables->add("indexed_rows", indexed_table);
+
+  auto dbc = SQLiteDBManager::getUnique();
+  attachTableInternal(
+      "indexed_dynamic_rows", rows_table->columnDefinition(false), dbc, false);
+  attachTableInternal(
+      "indexed_rows", indexed_table->columnDefinition(false), dbc, false);
+
+  // Typed values are converted to the same SQL values as text values.
+  std::string statement =
+      "SELECT name, typeof(name) AS tn, count, typeof(count) AS tc, size, "
+      "typeof(size) AS ts, ratio, typeof(ratio) AS tr FROM ";
+  QueryData row_results;
+  auto status =
+      queryInternal(statement + "indexed_dynamic_rows", row_results, dbc);
+  ASSERT_TRUE(status.ok()) << status.what();
+  QueryData indexed_results;
+  status = queryInternal(statement + "indexed_rows", indexed_results, dbc);
+  ASSERT_TRUE(status.ok()) << status.what();
+  ASSERT_EQ(indexed_results.size(), 3U);
+  EXPECT_EQ(row_results, indexed_results);
+
+  // Unset columns are omitted and large unsigned values are kept as text.
+  auto r = make_indexed_row(std::make_shared<const IndexedColumns>(
+      IndexedColumns{"count", "size"}));
+  r->set(1, std::numeric_limits<uint64_t>::max());
+  auto row = static_cast<Row>(*r);
+  EXPECT_EQ(row.count("count"), 0U);
+  EXPECT_EQ(row["size"], "18446744073709551615");
+
+  auto copy = r->clone();
+  EXPECT_EQ(static_cast<Row>(*copy), row);
+}
+
 class cacheTablePlugin : public TablePlugin {
  private:
   TableColumns columns() const override {
@@ -788,6 +938,28 @@ TEST_F(VirtualTableTests, test_like_constraints) {
   EXPECT_EQ(results[1]["op"], "LIKE");
 }
 
+TEST_F(VirtualTableTests, test_cached_statement_constraints) {
+  auto table = std::make_shared<likeTablePlugin>();
+  auto table_registry = RegistryFactory::get().registry("table");
+  table_registry->add("like_cached_table", table);
+
+  auto dbc = SQLiteDBManager::getUnique();
+  attachTableInternal(
+      "like_cached_table", table->columnDefinition(false), dbc, false);
+
+  // The statement is prepared once, the constraints planned for it must be
+  // used again after each query cleared them.
+  for (size_t i = 0; i < 3; i++) {
+    QueryData results;
+    queryInternal(
+        "SELECT * FROM like_cached_table WHERE i LIKE '/test/%'", results, dbc);
+    dbc->clearAffectedTables();
+    ASSERT_EQ(results.size(), 1U);
+    EXPECT_EQ(results[0]["i"], "/test/%");
+    EXPECT_EQ(results[0]["op"], "LIKE");
+  }
+}
+
 class indexIOptimizedTablePlugin : public TablePlugin {
  private:
   TableColumns columns() const override {
@@ -1192,6 +1364,91 @@ TEST_F(VirtualTableTests, test_noindex_constraints) {
   ASSERT_EQ("0", results[1]["straints"]);
 }
 
+class textEventIdTablePlugin : public TablePlugin {
+ public:
+  explicit textEventIdTablePlugin(TableAttributes attributes)
+      : attributes_(attributes) {}
+
+ private:
+  TableColumns columns() const override {
+    return {
+        std::make_tuple("value", TEXT_TYPE, ColumnOptions::DEFAULT),
+        std::make_tuple("time", BIGINT_TYPE, ColumnOptions::HIDDEN),
+        std::make_tuple("eid", TEXT_TYPE, ColumnOptions::HIDDEN),
+    };
+  }
+
+  TableAttributes attributes() const override {
+    return attributes_;
+  }
+
+ public:
+  TableRows generate(QueryContext& context) override {
+    time_constraints += context.constraints["time"].getAll().size();
+    eid_constraints += context.constraints["eid"].getAll().size();
+
+    // Event subscribers narrow their scan numerically on pushed constraints.
+    auto eids = context.constraints["eid"].getAll<long long>(LESS_THAN);
+    TableRows rows;
+    for (int i = 1; i <= 3; i++) {
+      if (!eids.empty() && i * 100 >= *eids.begin()) {
+        continue;
+      }
+
+      auto eid = std::string(7, '0') + std::to_string(i * 100);
+      rows.push_back(make_table_row(
+          {{"value", std::to_string(i)}, {"time", "100"}, {"eid", eid}}));
+    }
+    return rows;
+  }
+
+  size_t time_constraints{0};
+  size_t eid_constraints{0};
+
+ private:
+  TableAttributes attributes_;
+};
+
+TEST_F(VirtualTableTests, test_event_text_eid_constraints) {
+  auto tables = RegistryFactory::get().registry("table");
+  auto events =
+      std::make_shared<textEventIdTablePlugin>(TableAttributes::EVENT_BASED);
+  auto plain = std::make_shared<textEventIdTablePlugin>(TableAttributes::NONE);
+  tables->add("text_eid_events", events);
+  tables->add("text_eid_plain", plain);
+
+  auto dbc = SQLiteDBManager::getUnique();
+  attachTableInternal(
+      "text_eid_events", events->columnDefinition(false), dbc, false);
+  attachTableInternal(
+      "text_eid_plain", plain->columnDefinition(false), dbc, false);
+
+  // A TEXT eid compares as text, every zero-padded value sorts before '150'.
+  QueryData pushed;
+  auto status = queryInternal(
+      "SELECT value FROM text_eid_events WHERE eid < 150 AND time >= 100",
+      pushed,
+      dbc);
+  dbc->clearAffectedTables();
+  ASSERT_TRUE(status.ok());
+
+  QueryData filtered;
+  status = queryInternal(
+      "SELECT value FROM text_eid_plain WHERE eid < 150 AND time >= 100",
+      filtered,
+      dbc);
+  dbc->clearAffectedTables();
+  ASSERT_TRUE(status.ok());
+
+  EXPECT_EQ(pushed.size(), 3U);
+  EXPECT_EQ(pushed, filtered);
+
+  // Only the numeric time constraint is pushed into the event table scan.
+  EXPECT_EQ(events->eid_constraints, 0U);
+  EXPECT_EQ(events->time_constraints, 1U);
+  EXPECT_EQ(plain->time_constraints, 0U);
+}
+
 class exceptionalTablePlugin : public TablePlugin {
  private:
   TableColumns columns() const override {
@@ -8,14 +8,17 @@
  */
 
 #include <atomic>
+#include <chrono>
 #include <unordered_set>
 
 #include <osquery/core/core.h>
 #include <osquery/core/flags.h>
 #include <osquery/core/system.h>
+#include <osquery/extensions/extensions.h>
 #include <osquery/logger/logger.h>
 #include <osquery/process/process.h>
 #include <osquery/registry/registry_factory.h>
+#include <osquery/sql/columnar_table_row.h>
 #include <osquery/sql/dynamic_table_row.h>
 #include <osquery/sql/virtual_table.h>
 #include <osquery/utils/conversions/tryto.h>
@@ -42,6 +45,21 @@ DECLARE_bool(disable_events);
 
 RecursiveMutex kAttachMutex;
 
+/// The number of held TableGenerateGuardScope%s.
+static std::atomic<size_t> kTableGenerateGuardScopes{0};
+
+TableGenerateGuardScope::TableGenerateGuardScope() {
+  ++kTableGenerateGuardScopes;
+}
+
+TableGenerateGuardScope::~TableGenerateGuardScope() {
+  --kTableGenerateGuardScopes;
+}
+
+bool TableGenerateGuardScope::active() {
+  return kTableGenerateGuardScopes > 0;
+}
+
 namespace tables {
 namespace sqlite {
 /// For planner and debugging an incrementing cursor ID is used.
@@ -107,6 +125,62 @@ class TableList final {
 
 TableList extension_table_list;
 
+/// Per-table locks used while a TableGenerateGuardScope is held.
+class TableGenerateGuards final {
+  std::unordered_map<std::string, std::unique_ptr<RecursiveMutex>> guards;
+  Mutex mutex;
+
+ public:
+  RecursiveLock lock(const std::string& table_name) {
+    RecursiveMutex* guard{nullptr};
+    {
+      WriteLock write_lock(mutex);
+      auto& entry = guards[table_name];
+      if (entry == nullptr) {
+        entry = std::make_unique<RecursiveMutex>();
+      }
+      guard = entry.get();
+    }
+    return RecursiveLock(*guard);
+  }
+};
+
+TableGenerateGuards table_generate_guards;
+
+/// Lock the generation of a table if table generation is guarded.
+RecursiveLock lockTableGenerate(const std::string& table_name) {
+  RecursiveLock generate_lock;
+  if (TableGenerateGuardScope::active()) {
+    generate_lock = table_generate_guards.lock(table_name);
+  }
+  return generate_lock;
+}
+
+/// Microseconds elapsed since a monotonic start time.
+uint64_t elapsedMicroseconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+/**
+ * @brief Record the work of a generator cursor since it was last filtered.
+ *
+ * Generators yield rows across cursor steps, so their statistics are recorded
+ * when the cursor is filtered again or closed.
+ */
+void recordGeneratorStats(BaseCursor* pCur) {
+  if (!pCur->uses_generator) {
+    return;
+  }
+
+  auto* pVtab = (VirtualTable*)pCur->base.pVtab;
+  pVtab->instance->recordTableGenerate(
+      pVtab->content->name, pCur->row, pCur->generate_time);
+  pCur->uses_generator = false;
+  pCur->generate_time = 0;
+}
+
 // A map containing an sqlite module object for each virtual table
 std::unordered_map<std::string, struct sqlite3_module> sqlite_module_map;
 Mutex sqlite_module_map_mutex;
@@ -310,6 +384,13 @@ int xOpen(sqlite3_vtab* tab, sqlite3_vtab_cursor** ppCursor) {
 int xClose(sqlite3_vtab_cursor* cur) {
   BaseCursor* pCur = (BaseCursor*)cur;
   plan("Closing cursor (" + std::to_string(pCur->id) + ")");
+  recordGeneratorStats(pCur);
+  if (pCur->generator != nullptr) {
+    // An unfinished generator unwinds within the table's code.
+    auto* pVtab = (VirtualTable*)cur->pVtab;
+    auto generate_lock = lockTableGenerate(pVtab->content->name);
+    pCur->generator = nullptr;
+  }
   delete pCur;
   return SQLITE_OK;
 }
@@ -341,10 +422,15 @@ int xDestroy(sqlite3_vtab* p) {
 int xNext(sqlite3_vtab_cursor* cur) {
   BaseCursor* pCur = (BaseCursor*)cur;
   if (pCur->uses_generator) {
+    auto start = std::chrono::steady_clock::now();
+    // The generator runs the table's code until it yields the next row.
+    auto* pVtab = (VirtualTable*)cur->pVtab;
+    auto generate_lock = lockTableGenerate(pVtab->content->name);
     pCur->generator->operator()();
     if (*pCur->generator) {
       pCur->current = pCur->generator->get();
     }
+    pCur->generate_time += elapsedMicroseconds(start);
   }
   pCur->row++;
   return SQLITE_OK;
@@ -704,6 +790,24 @@ static inline bool sensibleComparison(ColumnType type, unsigned char op) {
   return true;
 }
 
+static inline bool isEventScanConstraint(TableAttributes attributes,
+                                         const std::string& name,
+                                         ColumnType type,
+                                         unsigned char op) {
+  if ((attributes & TableAttributes::EVENT_BASED) == 0 ||
+      (name != "time" && name != "eid")) {
+    return false;
+  }
+
+  // Several event tables declare a zero-padded TEXT eid. SQLite compares
+  // those as text, numeric scan ranges would drop rows it matches.
+  if (type != INTEGER_TYPE && type != BIGINT_TYPE) {
+    return false;
+  }
+  return op == EQUALS || op == GREATER_THAN || op == GREATER_THAN_OR_EQUALS ||
+         op == LESS_THAN || op == LESS_THAN_OR_EQUALS;
+}
+
 static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
   auto* pVtab = (VirtualTable*)tab;
   const auto& columns = pVtab->content->columns;
@@ -758,6 +862,13 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
         cost = 1;
       } else if (options & (ColumnOptions::INDEX | ColumnOptions::ADDITIONAL)) {
         cost = 1;
+      } else if (isEventScanConstraint(pVtab->content->attributes,
+                                       name,
+                                       type,
+                                       constraint_info.op)) {
+        // Event tables narrow their scan to the matching time buckets and
+        // EventIDs, sqlite still filters the rows.
+        cost = 1;
       } else {
         // not indexed, let sqlite filter it
         continue;
@@ -836,6 +947,7 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
   pVtab->content->constraints[pIdxInfo->idxNum] = std::move(constraints);
   pVtab->content->colsUsed[pIdxInfo->idxNum] = std::move(colsUsed);
   pVtab->content->colsUsedBitsets[pIdxInfo->idxNum] = colsUsedBitset;
+  pVtab->instance->addPlannedIndex(pVtab->content, pIdxInfo->idxNum);
   pIdxInfo->estimatedCost = cost;
 
   return SQLITE_OK;
@@ -855,6 +967,8 @@ static int xFilter(sqlite3_vtab_cursor* pVtabCursor,
   }
   pVtab->instance->addAffectedTable(content);
 
+  // A cursor may be filtered again, for example within a JOIN.
+  recordGeneratorStats(pCur);
   pCur->row = 0;
   pCur->n = 0;
   QueryContext context(content);
@@ -985,10 +1099,13 @@ static int xFilter(sqlite3_vtab_cursor* pVtabCursor,
 
   // Generate the row data set.
   plan("Scanning rows for cursor (" + std::to_string(pCur->id) + ")");
+  auto generate_start = std::chrono::steady_clock::now();
   if (Registry::get().exists("table", pVtab->content->name, true)) {
     auto plugin = Registry::get().plugin("table", pVtab->content->name);
     auto table = std::dynamic_pointer_cast<TablePlugin>(plugin);
     try {
+      // Generators yield across cursor steps, each step is guarded.
+      auto generate_lock = lockTableGenerate(pVtab->content->name);
       if (table->usesGenerator()) {
         pCur->uses_generator = true;
         pCur->generator = std::make_unique<RowGenerator::pull_type>(
@@ -999,6 +1116,7 @@ static int xFilter(sqlite3_vtab_cursor* pVtabCursor,
         if (*pCur->generator) {
           pCur->current = pCur->generator->get();
         }
+        pCur->generate_time = elapsedMicroseconds(generate_start);
         return SQLITE_OK;
       }
       pCur->rows = table->generate(context);
@@ -1015,18 +1133,28 @@ static int xFilter(sqlite3_vtab_cursor* pVtabCursor,
     PluginRequest request = {{"action", "generate"}};
     TablePlugin::setRequestFromContext(context, request);
     QueryData qd;
-    auto status = Registry::call("table", pVtab->content->name, request, qd);
+    ColumnarRows columns;
+    auto status =
+        callExtensionTable(pVtab->content->name, request, qd, columns);
     if (!status.ok()) {
       VLOG(1) << "Invalid response from the extension table. Error "
               << status.getCode() << ": " << status.getMessage();
       setTableErrorMessage(pVtabCursor->pVtab, status.getMessage());
       return SQLITE_ERROR;
     }
-    pCur->rows = tableRowsFromQueryData(std::move(qd));
+
+    // Extensions that do not support columns respond with rows.
+    if (!columns.columns.empty()) {
+      pCur->rows = tableRowsFromColumns(std::move(columns));
+    } else {
+      pCur->rows = tableRowsFromQueryData(std::move(qd));
+    }
   }
 
   // Set the number of rows.
   pCur->n = pCur->rows.size();
+  pVtab->instance->recordTableGenerate(
+      content->name, pCur->n, elapsedMicroseconds(generate_start));
 
   if (FLAGS_planner) {
     plan("xFilter " + pVtab->content->name +
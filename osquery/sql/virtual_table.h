@@ -28,6 +28,24 @@ namespace osquery {
  */
 extern RecursiveMutex kAttachMutex;
 
+/**
+ * @brief Guard table generation while queries execute concurrently.
+ *
+ * TablePlugin%s are registry singletons and may keep state that is not
+ * thread-safe. Each concurrent execution, the schedule or distributed queries,
+ * holds a scope until its queries have finished. While any scope is held, a
+ * table's generate and each step of a table's generator are guarded by a
+ * per-table lock. Different tables still generate in parallel.
+ */
+class TableGenerateGuardScope : private boost::noncopyable {
+ public:
+  TableGenerateGuardScope();
+  ~TableGenerateGuardScope();
+
+  /// Return true if table generation is guarded.
+  static bool active();
+};
+
 /**
  * @brief osquery cursor object.
  *
@@ -58,6 +76,9 @@ struct BaseCursor : private boost::noncopyable {
 
   /// Total number of rows.
   size_t n{0};
+
+  /// Microseconds spent stepping a generator since the last filter.
+  uint64_t generate_time{0};
 };
 
 /**
@@ -1180,6 +1180,10 @@ Status ProcessFileEventSubscriber::init() {
   return Status::success();
 }
 
+bool ProcessFileEventSubscriber::usesEventBlocks() const {
+  return true;
+}
+
 void ProcessFileEventSubscriber::configure() {
   auto parser = Config::getParser("file_paths");
   Config::get().files([this](const std::string& category,
@@ -303,6 +303,9 @@ class ProcessFileEventSubscriber final
   static const std::set<int>& GetSyscallSet() noexcept;
 
  private:
+  /// File events are high volume, store them as blocks.
+  bool usesEventBlocks() const override;
+
   /// This structure holds information like handle and inode maps
   AuditdFimContext context_;
 };
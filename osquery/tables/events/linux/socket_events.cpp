@@ -107,6 +107,10 @@ Status SocketEventSubscriber::init() {
   return Status::success();
 }
 
+bool SocketEventSubscriber::usesEventBlocks() const {
+  return true;
+}
+
 Status SocketEventSubscriber::Callback(const ECRef& ec, const SCRef& sc) {
   std::vector<Row> emitted_row_list;
   auto status = ProcessEvents(emitted_row_list, ec->audit_events);
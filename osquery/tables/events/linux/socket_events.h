@@ -30,6 +30,10 @@ class SocketEventSubscriber final
 
   /// Returns the set of syscalls that this subscriber can handle
   static const std::set<int>& GetSyscallSet() noexcept;
+
+ private:
+  /// Socket events are high volume, store them as blocks.
+  bool usesEventBlocks() const override;
 };
 
 } // namespace osquery
@@ -65,65 +65,96 @@ QueryData genOpenSockets(QueryContext& context) {
    * 1 and 2.
    */
 
-  /* Use a set to record the namespaces already processed */
-  std::set<ino_t> netns_list;
-  SocketInodeToProcessInfoMap inode_proc_map;
-  SocketInfoList socket_list;
-  for (const auto& pid : pids) {
+  /* Steps 1 and 2 are independent for each pid and run in parallel. */
+  struct ProcessSockets {
+    SocketInodeToProcessInfoMap inode_proc_map;
+    ino_t ns{0};
+  };
+
+  const std::vector<std::string> pid_list(pids.begin(), pids.end());
+  std::vector<ProcessSockets> pid_sockets(pid_list.size());
+  procParallelFor(pid_list.size(), [&](size_t i) {
+    const auto& pid = pid_list[i];
+
     /* Step 1 */
-    status = procGetSocketInodeToProcessInfoMap(pid, inode_proc_map);
-    if (!status.ok()) {
+    auto pid_status =
+        procGetSocketInodeToProcessInfoMap(pid, pid_sockets[i].inode_proc_map);
+    if (!pid_status.ok()) {
       VLOG(1) << "Results for process_open_sockets might be incomplete. Failed "
                  "to acquire socket inode to process map for pid "
-              << pid << ": " << status.what();
+              << pid << ": " << pid_status.what();
     }
 
     /* Step 2 */
-    ino_t ns;
     ProcessNamespaceList namespaces;
-    status = procGetProcessNamespaces(pid, namespaces, {"net"});
-    if (status.ok()) {
-      ns = namespaces["net"];
+    pid_status = procGetProcessNamespaces(pid, namespaces, {"net"});
+    if (pid_status.ok()) {
+      pid_sockets[i].ns = namespaces["net"];
     } else {
       /* If namespaces are not available we allways set ns to 0 and step 3 will
        * run once for the first pid in the list.
        */
-      ns = 0;
       VLOG(1) << "Results for the process_open_sockets might be incomplete."
                  "Failed to acquire network namespace information for process "
                  "with pid "
-              << pid << ": " << status.what();
+              << pid << ": " << pid_status.what();
+    }
+  });
+
+  /* Merge in pid order and record the first pid found in each namespace. */
+  std::set<ino_t> netns_list;
+  std::vector<std::pair<ino_t, std::string>> netns_pids;
+  SocketInodeToProcessInfoMap inode_proc_map;
+  for (size_t i = 0; i < pid_list.size(); ++i) {
+    for (auto& inode : pid_sockets[i].inode_proc_map) {
+      inode_proc_map[inode.first] = std::move(inode.second);
     }
 
-    if (netns_list.count(ns) == 0) {
-      netns_list.insert(ns);
-
-      /* Step 3 */
-      for (const auto& pair : kLinuxProtocolNames) {
-        status = procGetSocketList(AF_INET, pair.first, ns, pid, socket_list);
-        if (!status.ok()) {
-          VLOG(1)
-              << "Results for process_open_sockets might be incomplete. Failed "
-                 "to acquire basic socket information for AF_INET "
-              << pair.second << ": " << status.what();
-        }
-
-        status = procGetSocketList(AF_INET6, pair.first, ns, pid, socket_list);
-        if (!status.ok()) {
-          VLOG(1)
-              << "Results for process_open_sockets might be incomplete. Failed "
-                 "to acquire basic socket information for AF_INET6 "
-              << pair.second << ": " << status.what();
-        }
+    if (netns_list.insert(pid_sockets[i].ns).second) {
+      netns_pids.emplace_back(pid_sockets[i].ns, pid_list[i]);
+    }
+  }
+
+  /* Step 3, for each namespace in parallel. */
+  std::vector<SocketInfoList> netns_sockets(netns_pids.size());
+  procParallelFor(netns_pids.size(), [&](size_t i) {
+    const auto& ns = netns_pids[i].first;
+    const auto& pid = netns_pids[i].second;
+    auto& ns_socket_list = netns_sockets[i];
+
+    Status ns_status;
+    for (const auto& pair : kLinuxProtocolNames) {
+      ns_status =
+          procGetSocketList(AF_INET, pair.first, ns, pid, ns_socket_list);
+      if (!ns_status.ok()) {
+        VLOG(1)
+            << "Results for process_open_sockets might be incomplete. Failed "
+               "to acquire basic socket information for AF_INET "
+            << pair.second << ": " << ns_status.what();
       }
-      status = procGetSocketList(AF_UNIX, IPPROTO_IP, ns, pid, socket_list);
-      if (!status.ok()) {
+
+      ns_status =
+          procGetSocketList(AF_INET6, pair.first, ns, pid, ns_socket_list);
+      if (!ns_status.ok()) {
         VLOG(1)
             << "Results for process_open_sockets might be incomplete. Failed "
-               "to acquire basic socket information for AF_UNIX: "
-            << status.what();
+               "to acquire basic socket information for AF_INET6 "
+            << pair.second << ": " << ns_status.what();
       }
     }
+    ns_status = procGetSocketList(AF_UNIX, IPPROTO_IP, ns, pid, ns_socket_list);
+    if (!ns_status.ok()) {
+      VLOG(1) << "Results for process_open_sockets might be incomplete. Failed "
+                 "to acquire basic socket information for AF_UNIX: "
+              << ns_status.what();
+    }
+  });
+
+  SocketInfoList socket_list;
+  for (auto& ns_socket_list : netns_sockets) {
+    socket_list.insert(socket_list.end(),
+                       std::make_move_iterator(ns_socket_list.begin()),
+                       std::make_move_iterator(ns_socket_list.end()));
   }
 
   /* Finally correlate all the information. Go through all the sockets
@@ -8,6 +8,7 @@
  */
 
 #include <osquery/core/tables.h>
+#include <osquery/rows/listening_ports.h>
 #include <osquery/sql/sql.h>
 #include <osquery/utils/info/platform_type.h>
 
@@ -19,8 +20,9 @@ const std::string kAF_INET6 = "10";
 
 namespace osquery {
 namespace tables {
-QueryData genListeningPorts(QueryContext& context) {
-  QueryData results;
+TableRows genListeningPorts(QueryContext& context) {
+  using C = ListeningPortsColumns;
+  TableRows results;
 
   auto sockets = SQL::selectAllFrom("process_open_sockets");
 
@@ -36,43 +38,43 @@ QueryData genListeningPorts(QueryContext& context) {
       continue;
     }
 
-    Row r;
-    r["pid"] = socket.at("pid");
+    auto r = make_indexed_row(C::names());
+    r->set(C::PID, socket.at("pid"));
 
     if (socket.at("family") == kAF_UNIX) {
-      r["port"] = "0";
-      r["path"] = socket.at("path");
-      r["socket"] = "0";
+      r->set(C::PORT, 0);
+      r->set(C::PATH, socket.at("path"));
+      r->set(C::SOCKET, 0);
     } else {
-      r["address"] = socket.at("local_address");
-      r["port"] = socket.at("local_port");
+      r->set(C::ADDRESS, socket.at("local_address"));
+      r->set(C::PORT, socket.at("local_port"));
 
       auto socket_it = socket.find("socket");
       if (socket_it != socket.end()) {
-        r["socket"] = socket_it->second;
+        r->set(C::SOCKET, socket_it->second);
       } else {
-        r["socket"] = "0";
+        r->set(C::SOCKET, 0);
       }
     }
 
-    r["protocol"] = socket.at("protocol");
-    r["family"] = socket.at("family");
+    r->set(C::PROTOCOL, socket.at("protocol"));
+    r->set(C::FAMILY, socket.at("family"));
 
     auto fd_it = socket.find("fd");
     if (fd_it != socket.end()) {
-      r["fd"] = fd_it->second;
+      r->set(C::FD, fd_it->second);
     } else {
-      r["fd"] = "0";
+      r->set(C::FD, 0);
     }
 
     // When running under linux, we also have the user namespace
     // column available. It can be used with the docker_containers
     // table
     if (isPlatform(PlatformType::TYPE_LINUX)) {
-      r["net_namespace"] = socket.at("net_namespace");
+      r->set(C::NET_NAMESPACE, socket.at("net_namespace"));
     }
 
-    results.push_back(r);
+    results.push_back(std::move(r));
   }
 
   return results;
@@ -14,13 +14,15 @@
 #include <osquery/core/core.h>
 #include <osquery/core/tables.h>
 #include <osquery/logger/logger.h>
+#include <osquery/rows/dns_resolvers.h>
 #include <osquery/tables/networking/posix/utils.h>
 
 namespace osquery {
 namespace tables {
 
-QueryData genDNSResolvers(QueryContext& context) {
-  QueryData results;
+TableRows genDNSResolvers(QueryContext& context) {
+  using C = DnsResolversColumns;
+  TableRows results;
 
   // libresolv will populate a global structure with resolver information.
   if (res_init() == -1) {
@@ -33,38 +35,39 @@ QueryData genDNSResolvers(QueryContext& context) {
   struct __res_state& rr = _res;
   if (rr.nscount > 0) {
     for (size_t i = 0; i < static_cast<size_t>(_res.nscount); i++) {
-      Row r;
-      r["id"] = INTEGER(i);
-      r["type"] = "nameserver";
-      r["address"] = ipAsString((const struct sockaddr*)&_res.nsaddr_list[i]);
-      r["netmask"] = "32";
+      auto r = make_indexed_row(C::names());
+      r->set(C::ID, i);
+      r->set(C::TYPE, "nameserver");
+      r->set(C::ADDRESS,
+             ipAsString((const struct sockaddr*)&_res.nsaddr_list[i]));
+      r->set(C::NETMASK, "32");
       // Options applies to every resolver.
-      r["options"] = BIGINT(_res.options);
-      results.push_back(r);
+      r->set(C::OPTIONS, _res.options);
+      results.push_back(std::move(r));
     }
   }
 
   if (_res.nsort > 0) {
     for (size_t i = 0; i < static_cast<size_t>(_res.nsort); i++) {
-      Row r;
-      r["id"] = INTEGER(i);
-      r["type"] = "sortlist";
-      r["address"] =
-          ipAsString((const struct sockaddr*)&_res.sort_list[i].addr);
-      r["netmask"] = INTEGER(_res.sort_list[i].mask);
-      r["options"] = BIGINT(_res.options);
-      results.push_back(r);
+      auto r = make_indexed_row(C::names());
+      r->set(C::ID, i);
+      r->set(C::TYPE, "sortlist");
+      r->set(C::ADDRESS,
+             ipAsString((const struct sockaddr*)&_res.sort_list[i].addr));
+      r->set(C::NETMASK, std::to_string(_res.sort_list[i].mask));
+      r->set(C::OPTIONS, _res.options);
+      results.push_back(std::move(r));
     }
   }
 
   for (size_t i = 0; i < MAXDNSRCH; i++) {
     if (_res.dnsrch[i] != nullptr) {
-      Row r;
-      r["id"] = INTEGER(i);
-      r["type"] = "search";
-      r["address"] = std::string(_res.dnsrch[0]);
-      r["options"] = BIGINT(_res.options);
-      results.push_back(r);
+      auto r = make_indexed_row(C::names());
+      r->set(C::ID, i);
+      r->set(C::TYPE, "search");
+      r->set(C::ADDRESS, std::string(_res.dnsrch[0]));
+      r->set(C::OPTIONS, _res.options);
+      results.push_back(std::move(r));
     }
   }
 
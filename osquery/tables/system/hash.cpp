@@ -20,19 +20,37 @@
 #include <fuzzy.h>
 #endif
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include <boost/filesystem.hpp>
+#include <boost/noncopyable.hpp>
 
 #include <osquery/core/flags.h>
+#include <osquery/database/database.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/hashing/hashing.h>
 #include <osquery/logger/logger.h>
 #include <osquery/core/tables.h>
 #include <osquery/sql/dynamic_table_row.h>
+#include <osquery/tables/system/hash.h>
+#include <osquery/utils/caches/lru.h>
+#include <osquery/utils/conversions/split.h>
+#include <osquery/utils/conversions/tryto.h>
 #include <osquery/utils/mutex.h>
+#include <osquery/utils/thread_pool.h>
 #include <osquery/utils/info/platform_type.h>
+#include <osquery/utils/system/time.h>
 #include <osquery/worker/ipc/platform_table_container_ipc.h>
 #include <osquery/worker/logging/glog/glog_logger.h>
 #include <osquery/worker/logging/logger.h>
@@ -46,58 +64,135 @@ FLAG(bool,
 
 FLAG(uint32, hash_cache_max, 500, "Size of LRU file hash cache");
 
+FLAG(bool,
+     hash_cache_persist,
+     false,
+     "Persist cached file hashes in the database across restarts");
+
+FLAG(uint32,
+     hash_cache_persist_max,
+     10000,
+     "Maximum number of file hashes persisted in the database");
+
 HIDDEN_FLAG(uint32,
             hash_delay,
             20,
             "Number of milliseconds to delay after hashing");
 
+FLAG(uint32,
+     hash_threads,
+     1,
+     "Number of threads hashing files for the hash table (0 for one per CPU)");
+
+FLAG(uint64,
+     hash_query_max_bytes,
+     0,
+     "Maximum bytes of files hashed by a single query (0 for no limit)");
+
+FLAG(uint64,
+     hash_query_max_rate,
+     0,
+     "Maximum bytes per second hashed by a single query (0 for no limit)");
+
 namespace tables {
 
-/// Clear this amount of rows every time cache eviction is triggered.
-const size_t kHashCacheEvictSize{5};
+/// Number of independently locked partitions of the file hash cache.
+const size_t kHashCacheShards{16};
+
+/// Upper bound on the number of threads hashing files.
+const size_t kMaxHashThreads{16};
 
 /**
- * @brief Implements persistent in-memory caching of files' hashes.
+ * @brief The byte and throughput limits of a single hash query.
  *
- * This cache has LRU eviction policy. The hash is recalculated
- * every time the mtime or size of the file changes.
+ * Only files that are read count against the limits, cached hashes are free.
+ * The budget is shared by every thread hashing files for the query.
  */
-struct FileHashCache {
-  /// The file's modification time, changes with a touch.
-  time_t file_mtime;
+class HashQueryBudget : private boost::noncopyable {
+ public:
+  HashQueryBudget() : start_(std::chrono::steady_clock::now()) {}
+
+  /**
+   * @brief Account for a file that is about to be hashed.
+   *
+   * @param path The file path, used for logging.
+   * @param size The file size in bytes.
+   * @param logger The query's logger.
+   * @return false if hashing the file would exceed --hash_query_max_bytes.
+   */
+  bool reserve(const std::string& path, uint64_t size, Logger& logger) {
+    auto total = bytes_.fetch_add(size) + size;
+    if (FLAGS_hash_query_max_bytes > 0 && total > FLAGS_hash_query_max_bytes) {
+      bytes_ -= size;
+      if (!exhausted_.exchange(true)) {
+        logger.log(google::GLOG_WARNING,
+                   "Hash query exceeded the hash_query_max_bytes limit, "
+                   "remaining files are not hashed");
+      }
+      logger.vlog(1, "Not hashing file over the query limit: " + path);
+      return false;
+    }
+    return true;
+  }
+
+  /// Delay the calling thread to keep within --hash_query_max_rate.
+  void throttle() {
+    if (FLAGS_hash_query_max_rate == 0) {
+      return;
+    }
 
-  /// The file's serial or information number (inode).
-  ino_t file_inode;
+    auto expected = std::chrono::duration<double>(
+        static_cast<double>(bytes_.load()) / FLAGS_hash_query_max_rate);
+    auto elapsed = std::chrono::steady_clock::now() - start_;
+    if (elapsed < expected) {
+      std::this_thread::sleep_for(expected - elapsed);
+    }
+  }
 
-  /// The file's size.
-  off_t file_size;
+ private:
+  /// Bytes of files hashed, or being hashed, by the query.
+  std::atomic<uint64_t> bytes_{0};
 
-  /// For eviction, the last time this cache item was used.
-  time_t cache_access_time;
+  /// Set once the byte limit is reached, to warn only once.
+  std::atomic<bool> exhausted_{false};
 
-  /// Cache content, the hashes.
-  MultiHashes hashes;
+  /// The time the query started hashing.
+  const std::chrono::steady_clock::time_point start_;
+};
 
-  /// Cache index, the file path.
-  std::string path;
+/// Serializes the use of a query logger by hashing threads.
+class SynchronizedLogger final : public Logger {
+ public:
+  explicit SynchronizedLogger(Logger& logger) : logger_(logger) {}
 
-  /// Comparison function for organizing the LRU heap.
-  static bool greater(const FileHashCache* l, const FileHashCache* r) {
-    return l->cache_access_time > r->cache_access_time;
+  void log(int severity, const std::string& message) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    logger_.log(severity, message);
   }
 
-  /**
-   * @brief Do-it-all access function.
-   *
-   * Maintains the cache of hash sums, stats file at path, if it has changed or
-   * it is not present in cache calculates the hashes and caches the result.
-   *
-   * @param path the path of file to hash.
-   * @param out stores the calculated hashes.
-   *
-   * @return true if succeeded, false if something went wrong.
-   */
-  static bool load(const std::string& path, MultiHashes& out, Logger& logger);
+  void vlog(int severity, const std::string& message) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    logger_.vlog(severity, message);
+  }
+
+ private:
+  Logger& logger_;
+  std::mutex mutex_;
+};
+
+/**
+ * @brief One partition of the file hash cache.
+ *
+ * Paths are assigned to a shard by their hash so concurrent hash queries
+ * rarely wait on each other. Each shard has an O(1) LRU of its share of
+ * --hash_cache_max entries.
+ */
+struct FileHashCacheShard {
+  /// Protects the LRU, which reorders entries on every access.
+  Mutex mutex;
+
+  /// path => cache entry, created with the first use of the shard.
+  std::unique_ptr<caches::LRU<std::string, FileHashCache>> lru;
 };
 
 #if defined(WIN32)
@@ -107,6 +202,148 @@ struct FileHashCache {
 
 #endif
 
+namespace {
+
+std::array<FileHashCacheShard, kHashCacheShards> kFileHashCacheShards;
+
+FileHashCacheShard& getFileHashCacheShard(const std::string& path) {
+  return kFileHashCacheShards[std::hash<std::string>{}(path) %
+                              kHashCacheShards];
+}
+
+/// The LRU capacity of a single shard, rounded up to keep at least one entry.
+size_t getFileHashCacheShardSize() {
+  return std::max<size_t>(
+      (FLAGS_hash_cache_max + kHashCacheShards - 1) / kHashCacheShards, 1);
+}
+
+/// Number of fields of a persisted entry, the last is the time it was stored.
+const size_t kFileHashFields{8};
+
+/// Count of the entries persisted in the database, used to cap them.
+struct PersistedFileHashes {
+  /// Protects the count, and serializes sweeps.
+  Mutex mutex;
+
+  /// Set once the entries have been counted from the database.
+  bool counted{false};
+
+  /// The number of persisted entries.
+  size_t count{0};
+};
+
+PersistedFileHashes kPersistedFileHashes;
+
+std::string serializeFileHashCache(const FileHashCache& fh) {
+  return std::to_string(fh.file_inode) + ":" + std::to_string(fh.file_mtime) +
+         ":" + std::to_string(fh.file_ctime) + ":" +
+         std::to_string(fh.file_size) + ":" + fh.hashes.md5 + ":" +
+         fh.hashes.sha1 + ":" + fh.hashes.sha256 + ":" +
+         std::to_string(getUnixTime());
+}
+
+bool deserializeFileHashCache(const std::string& value, FileHashCache& fh) {
+  auto fields = osquery::split(value, ":");
+  if (fields.size() != kFileHashFields) {
+    return false;
+  }
+
+  auto inode = tryTo<unsigned long long>(fields[0]);
+  auto mtime = tryTo<long long>(fields[1]);
+  auto ctime = tryTo<long long>(fields[2]);
+  auto size = tryTo<long long>(fields[3]);
+  if (inode.isError() || mtime.isError() || ctime.isError() ||
+      size.isError()) {
+    return false;
+  }
+
+  fh.file_inode = static_cast<ino_t>(inode.take());
+  fh.file_mtime = static_cast<time_t>(mtime.take());
+  fh.file_ctime = static_cast<time_t>(ctime.take());
+  fh.file_size = static_cast<off_t>(size.take());
+  fh.hashes.mask = HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256;
+  fh.hashes.md5 = std::move(fields[4]);
+  fh.hashes.sha1 = std::move(fields[5]);
+  fh.hashes.sha256 = std::move(fields[6]);
+  return true;
+}
+
+bool useFileHashDatabase() {
+  return FLAGS_hash_cache_persist && databaseInitialized();
+}
+
+/// The time a persisted entry was stored, 0 if the entry is invalid.
+uint64_t getFileHashStoredTime(const std::string& value) {
+  auto fields = osquery::split(value, ":");
+  if (fields.size() != kFileHashFields) {
+    return 0;
+  }
+  return tryTo<unsigned long long>(fields.back()).takeOr(0ULL);
+}
+
+/**
+ * @brief Remove the least recently stored entries from the database.
+ *
+ * Keeps 90% of --hash_cache_persist_max entries, so a sweep only happens
+ * after a tenth of the maximum new entries. Invalid entries go first.
+ */
+void sweepPersistedFileHashes(PersistedFileHashes& persisted) {
+  std::vector<std::pair<uint64_t, std::string>> entries;
+  scanDatabasePrefix(kFileHashes,
+                     "",
+                     [&entries](const std::string& key,
+                                const std::string& value) {
+                       entries.emplace_back(getFileHashStoredTime(value), key);
+                       return true;
+                     });
+
+  size_t keep = FLAGS_hash_cache_persist_max -
+                FLAGS_hash_cache_persist_max / 10;
+  if (entries.size() > keep) {
+    auto evict_end = entries.begin() + (entries.size() - keep);
+    std::nth_element(entries.begin(), evict_end, entries.end());
+    for (auto it = entries.begin(); it != evict_end; ++it) {
+      deleteDatabaseValue(kFileHashes, it->second);
+    }
+    entries.erase(entries.begin(), evict_end);
+  }
+  persisted.count = entries.size();
+}
+
+/**
+ * @brief Store an entry, sweeping the oldest entries over the maximum.
+ *
+ * @param path the path of the hashed file.
+ * @param fh the entry to store.
+ * @param replaced true if an entry for the path was already stored.
+ */
+void persistFileHashCache(const std::string& path,
+                          const FileHashCache& fh,
+                          bool replaced) {
+  if (!setDatabaseValue(kFileHashes, path, serializeFileHashCache(fh)).ok() ||
+      replaced) {
+    return;
+  }
+
+  auto& persisted = kPersistedFileHashes;
+  WriteLock lock(persisted.mutex);
+  if (!persisted.counted) {
+    // The first count includes the entry that was just stored.
+    std::vector<std::string> keys;
+    scanDatabaseKeys(kFileHashes, keys);
+    persisted.count = keys.size();
+    persisted.counted = true;
+  } else {
+    persisted.count++;
+  }
+
+  if (persisted.count > FLAGS_hash_cache_persist_max) {
+    sweepPersistedFileHashes(persisted);
+  }
+}
+
+} // namespace
+
 /**
  * @brief Checks the current stat output against the cached view.
  *
@@ -128,16 +365,8 @@ static inline bool statInvalid(const struct stat& st, const FileHashCache& fh) {
 
 bool FileHashCache::load(const std::string& path,
                          MultiHashes& out,
+                         HashQueryBudget& budget,
                          Logger& logger) {
-  // synchronize the access to cache
-  static Mutex mx;
-  // path => cache entry
-  static std::unordered_map<std::string, FileHashCache> cache;
-  // minheap on cache_access_time
-  static std::vector<FileHashCache*> lru;
-
-  WriteLock guard(mx);
-
   struct stat st;
   if (stat(path.c_str(), &st) != 0) {
     char buf[0x200] = {0};
@@ -146,53 +375,70 @@ bool FileHashCache::load(const std::string& path,
     return false;
   }
 
-  auto entry = cache.find(path);
-  if (entry == cache.end()) { // none, load
-    if (cache.size() >= FLAGS_hash_cache_max) {
-      // too large, evict
-      for (size_t i = 0; i < kHashCacheEvictSize; ++i) {
-        if (lru.empty()) {
-          continue;
-        }
-        std::string key = lru[0]->path;
-        std::pop_heap(lru.begin(), lru.end(), FileHashCache::greater);
-        lru.pop_back();
-        if (cache.find(key) != cache.end()) {
-          cache.erase(key);
-        }
+  auto& shard = getFileHashCacheShard(path);
+  {
+    WriteLock guard(shard.mutex);
+    if (shard.lru != nullptr) {
+      auto entry = shard.lru->get(path);
+      if (entry != nullptr && !statInvalid(st, *entry)) {
+        out = entry->hashes;
+        return true;
       }
     }
+  }
 
-    auto hashes = hashMultiFromFile(
-        HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256, path);
-    FileHashCache rec = {st.st_mtime, // .file_mtime
-                         st.st_ino, // .file_inode
-                         st.st_size, // .file_size
-                         time(nullptr), // .cache_access_time
-                         std::move(hashes), // .hashes
-                         path}; // .path
-    cache[path] = std::move(rec);
-    lru.push_back(&cache[path]);
-    std::push_heap(lru.begin(), lru.end(), FileHashCache::greater);
-    out = cache[path].hashes;
-  } else if (statInvalid(st, entry->second)) { // changed, update
-    auto hashes = hashMultiFromFile(
+  // The shard is not locked while reading the database or hashing.
+  FileHashCache rec;
+  bool stored = false;
+  bool valid = false;
+  if (useFileHashDatabase()) {
+    std::string value;
+    stored = getDatabaseValue(kFileHashes, path, value).ok();
+    valid = stored && deserializeFileHashCache(value, rec) &&
+            !statInvalid(st, rec) && st.st_ctime == rec.file_ctime;
+  }
+
+  if (!valid) {
+    if (!budget.reserve(path, st.st_size, logger)) {
+      return false;
+    }
+
+    rec.file_mtime = st.st_mtime;
+    rec.file_ctime = st.st_ctime;
+    rec.file_inode = st.st_ino;
+    rec.file_size = st.st_size;
+    rec.hashes = hashMultiFromFile(
         HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256, path);
-    entry->second.cache_access_time = time(nullptr);
-    entry->second.file_inode = st.st_ino;
-    entry->second.file_mtime = st.st_mtime;
-    entry->second.file_size = st.st_size;
-    entry->second.hashes = std::move(hashes);
-    std::make_heap(lru.begin(), lru.end(), FileHashCache::greater);
-    out = entry->second.hashes;
-  } else { // ok, got it
-    out = entry->second.hashes;
-    entry->second.cache_access_time = time(nullptr);
-    std::make_heap(lru.begin(), lru.end(), FileHashCache::greater);
+    budget.throttle();
+
+    if (useFileHashDatabase() && !rec.hashes.md5.empty()) {
+      persistFileHashCache(path, rec, stored);
+    }
   }
+
+  out = rec.hashes;
+
+  WriteLock guard(shard.mutex);
+  auto capacity = getFileHashCacheShardSize();
+  if (shard.lru == nullptr || shard.lru->capacity() != capacity) {
+    shard.lru =
+        std::make_unique<caches::LRU<std::string, FileHashCache>>(capacity);
+  }
+  shard.lru->insert(path, std::move(rec));
   return true;
 }
 
+void FileHashCache::clear() {
+  for (auto& shard : kFileHashCacheShards) {
+    WriteLock guard(shard.mutex);
+    shard.lru.reset();
+  }
+
+  WriteLock lock(kPersistedFileHashes.mutex);
+  kPersistedFileHashes.counted = false;
+  kPersistedFileHashes.count = 0;
+}
+
 Status genSsdeepForFile(const std::string& path, std::string& ssdeep_hash) {
 #ifdef OSQUERY_POSIX
   ssdeep_hash.resize(FUZZY_MAX_RESULT, '\0');
@@ -209,51 +455,148 @@ Status genSsdeepForFile(const std::string& path, std::string& ssdeep_hash) {
 #endif
 }
 
-void genHashForFile(const std::string& path,
-                    const std::string& dir,
-                    QueryContext& context,
-                    QueryData& results,
-                    Logger& logger) {
-  // Must provide the path, filename, directory separate from boost path->string
-  // helpers to match any explicit (query-parsed) predicate constraints.
-  auto tr = TableRowHolder(new DynamicTableRow());
-  MultiHashes hashes;
+/// The hashes of a single file, computed by a hashing thread.
+struct FileHashResult {
+  MultiHashes hashes{};
+  std::string ssdeep;
+};
+
+namespace {
+
+/// Protects the shared hashing pool.
+Mutex kHashPoolMutex;
+
+/// Threads shared by all hash queries.
+std::shared_ptr<ThreadPool> kHashPool;
+
+std::shared_ptr<ThreadPool> getHashPool(size_t threads) {
+  WriteLock lock(kHashPoolMutex);
+  if (kHashPool == nullptr || kHashPool->size() != threads) {
+    kHashPool = std::make_shared<ThreadPool>(threads, "hash");
+  }
+  return kHashPool;
+}
+
+} // namespace
+
+FileHashResult hashFile(const std::string& path,
+                        bool ssdeep,
+                        HashQueryBudget& budget,
+                        Logger& logger) {
+  FileHashResult result;
   if (!FLAGS_disable_hash_cache) {
-    FileHashCache::load(path, hashes, logger);
+    FileHashCache::load(path, result.hashes, budget, logger);
   } else {
-    if (context.isCached(path)) {
-      // Use the inner-query cache if the global hash cache is disabled.
-      // This protects against hashing the same content twice in the same query.
-      tr = context.getCache(path);
-    } else {
-      hashes = hashMultiFromFile(
+    boost::system::error_code ec;
+    auto size = boost::filesystem::file_size(path, ec);
+    if (!ec && budget.reserve(path, size, logger)) {
+      result.hashes = hashMultiFromFile(
           HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256, path);
+      budget.throttle();
       std::this_thread::sleep_for(std::chrono::milliseconds(FLAGS_hash_delay));
     }
   }
 
-  DynamicTableRow& r = *dynamic_cast<DynamicTableRow*>(tr.get());
-  r["path"] = path;
-  r["directory"] = dir;
-  r["md5"] = std::move(hashes.md5);
-  r["sha1"] = std::move(hashes.sha1);
-  r["sha256"] = std::move(hashes.sha256);
-
-  if (isPlatform(PlatformType::TYPE_POSIX) && context.isColumnUsed("ssdeep")) {
-    auto status = genSsdeepForFile(path, r["ssdeep"]);
-
+  // Files skipped by the query limits are not read again for the ssdeep.
+  if (ssdeep && !result.hashes.md5.empty()) {
+    auto status = genSsdeepForFile(path, result.ssdeep);
     if (!status.ok()) {
       logger.log(google::GLOG_WARNING, status.getMessage());
     }
   }
+  return result;
+}
 
-  if (FLAGS_disable_hash_cache) {
-    context.setCache(path, tr);
+/**
+ * @brief Generate a row for each file, hashing files concurrently.
+ *
+ * Files are hashed on up to --hash_threads shared threads and the rows are
+ * returned in the order of files. When the global hash cache is disabled the
+ * inner-query cache protects against hashing the same content twice.
+ *
+ * @param files Pairs of file path and directory column value.
+ */
+void genHashForFiles(
+    const std::vector<std::pair<std::string, std::string>>& files,
+    QueryContext& context,
+    QueryData& results,
+    Logger& logger) {
+  bool ssdeep =
+      isPlatform(PlatformType::TYPE_POSIX) && context.isColumnUsed("ssdeep");
+
+  // Each distinct path not in the inner-query cache is hashed once.
+  std::map<std::string, size_t> jobs;
+  std::vector<std::string> job_paths;
+  for (const auto& file : files) {
+    if (FLAGS_disable_hash_cache && context.isCached(file.first)) {
+      continue;
+    }
+    if (jobs.emplace(file.first, job_paths.size()).second) {
+      job_paths.push_back(file.first);
+    }
   }
 
-  r["pid_with_namespace"] = "0";
+  HashQueryBudget budget;
+  SynchronizedLogger hash_logger(logger);
+  std::vector<FileHashResult> hashes(job_paths.size());
+  auto pool_threads = resolveThreadCount(FLAGS_hash_threads, kMaxHashThreads);
+  if (std::min(pool_threads, job_paths.size()) <= 1) {
+    for (size_t i = 0; i < job_paths.size(); ++i) {
+      hashes[i] = hashFile(job_paths[i], ssdeep, budget, hash_logger);
+    }
+  } else {
+    auto pool = getHashPool(pool_threads);
+    std::vector<std::future<FileHashResult>> pending;
+    pending.reserve(job_paths.size());
+    for (const auto& path : job_paths) {
+      pending.push_back(pool->submit([&, path]() {
+        return hashFile(path, ssdeep, budget, hash_logger);
+      }));
+    }
+
+    // Every task must finish before the budget and logger go out of scope.
+    for (auto& task : pending) {
+      task.wait();
+    }
+    for (size_t i = 0; i < pending.size(); ++i) {
+      hashes[i] = pending[i].get();
+    }
+  }
 
-  results.push_back(static_cast<Row>(r));
+  for (const auto& file : files) {
+    const auto& path = file.first;
+
+    // Must provide the path, filename, directory separate from boost
+    // path->string helpers to match any explicit (query-parsed) predicate
+    // constraints.
+    auto tr = TableRowHolder(new DynamicTableRow());
+    auto job = jobs.find(path);
+    if (job == jobs.end()) {
+      // Use the inner-query cache if the global hash cache is disabled.
+      tr = context.getCache(path);
+    }
+
+    DynamicTableRow& r = *dynamic_cast<DynamicTableRow*>(tr.get());
+    r["path"] = path;
+    r["directory"] = file.second;
+    if (job != jobs.end()) {
+      const auto& result = hashes[job->second];
+      r["md5"] = result.hashes.md5;
+      r["sha1"] = result.hashes.sha1;
+      r["sha256"] = result.hashes.sha256;
+      if (ssdeep) {
+        r["ssdeep"] = result.ssdeep;
+      }
+
+      if (FLAGS_disable_hash_cache) {
+        context.setCache(path, tr);
+      }
+    }
+
+    r["pid_with_namespace"] = "0";
+
+    results.push_back(static_cast<Row>(r));
+  }
 }
 
 void expandFSPathConstraints(QueryContext& context,
@@ -286,15 +629,15 @@ QueryData genHashImpl(QueryContext& context, Logger& logger) {
   auto paths = context.constraints["path"].getAll(EQUALS);
   expandFSPathConstraints(context, "path", paths);
 
-  // Iterate through the file paths, adding the hash results
+  // Collect the files in path then directory order, then hash them.
+  std::vector<std::pair<std::string, std::string>> files;
   for (const auto& path_string : paths) {
     boost::filesystem::path path = path_string;
     if (!boost::filesystem::is_regular_file(path, ec)) {
       continue;
     }
 
-    genHashForFile(
-        path_string, path.parent_path().string(), context, results, logger);
+    files.emplace_back(path_string, path.parent_path().string());
   }
 
   // Now loop through constraints using the directory column constraint.
@@ -313,12 +656,12 @@ QueryData genHashImpl(QueryContext& context, Logger& logger) {
     boost::filesystem::directory_iterator begin(directory), end;
     for (; begin != end; ++begin) {
       if (boost::filesystem::is_regular_file(begin->path(), ec)) {
-        genHashForFile(
-            begin->path().string(), directory_string, context, results, logger);
+        files.emplace_back(begin->path().string(), directory_string);
       }
     }
   }
 
+  genHashForFiles(files, context, results, logger);
   return results;
 }
 
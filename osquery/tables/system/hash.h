@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <ctime>
+#include <string>
+
+#include <osquery/hashing/hashing.h>
+
+namespace osquery {
+
+class Logger;
+
+namespace tables {
+
+class HashQueryBudget;
+
+/**
+ * @brief A cached view of a file's hashes.
+ *
+ * The hashes are recalculated every time the inode, mtime or size of the file
+ * changes. Entries read from the database are also checked against the ctime,
+ * which cannot be set from userland, since they may predate a restart.
+ */
+struct FileHashCache {
+  /// The file's modification time, changes with a touch.
+  time_t file_mtime;
+
+  /// The file's status change time.
+  time_t file_ctime;
+
+  /// The file's serial or information number (inode).
+  ino_t file_inode;
+
+  /// The file's size.
+  off_t file_size;
+
+  /// Cache content, the hashes.
+  MultiHashes hashes;
+
+  /**
+   * @brief Do-it-all access function.
+   *
+   * Maintains the cache of hash sums, stats file at path, if it has changed or
+   * it is not present in cache calculates the hashes and caches the result.
+   *
+   * @param path the path of file to hash.
+   * @param out stores the calculated hashes.
+   * @param budget the limits of the hash query.
+   *
+   * @return true if succeeded, false if something went wrong.
+   */
+  static bool load(const std::string& path,
+                   MultiHashes& out,
+                   HashQueryBudget& budget,
+                   Logger& logger);
+
+  /**
+   * @brief Drop every in-memory entry, the persisted entries are kept.
+   *
+   * The count of persisted entries is also dropped, it is recounted from the
+   * database with the next new persisted entry.
+   */
+  static void clear();
+};
+
+} // namespace tables
+} // namespace osquery
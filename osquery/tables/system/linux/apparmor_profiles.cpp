@@ -11,6 +11,7 @@
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/logger/logger.h>
+#include <osquery/rows/apparmor_profiles.h>
 
 #include <boost/algorithm/string.hpp>
 
@@ -152,7 +153,7 @@ Status generateProfileList(AppArmorProfileList& profile_list) {
 }
 } // namespace
 
-QueryData genAppArmorProfiles(QueryContext& context) {
+TableRows genAppArmorProfiles(QueryContext& context) {
   if (!pathExists(kAppArmorProfilesPath).ok()) {
     return {};
   }
@@ -164,15 +165,16 @@ QueryData genAppArmorProfiles(QueryContext& context) {
     return {};
   }
 
-  QueryData row_list;
+  TableRows row_list;
 
   for (const auto& profile : profile_list) {
-    Row row = {};
-    row["name"] = profile.name;
-    row["mode"] = profile.mode;
-    row["attach"] = profile.attach;
-    row["sha1"] = profile.sha1;
-    row["path"] = profile.path;
+    using C = ApparmorProfilesColumns;
+    auto row = make_indexed_row(C::names());
+    row->set(C::NAME, profile.name);
+    row->set(C::MODE, profile.mode);
+    row->set(C::ATTACH, profile.attach);
+    row->set(C::SHA1, profile.sha1);
+    row->set(C::PATH, profile.path);
 
     row_list.push_back(std::move(row));
   }
@@ -15,6 +15,7 @@
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/logger/logger.h>
+#include <osquery/rows/kernel_modules.h>
 #include <osquery/utils/conversions/split.h>
 
 namespace osquery {
@@ -22,8 +23,8 @@ namespace tables {
 
 static const std::string kKernelModulePath = "/proc/modules";
 
-QueryData genKernelModules(QueryContext& context) {
-  QueryData results;
+TableRows genKernelModules(QueryContext& context) {
+  TableRows results;
 
   if (!pathExists(kKernelModulePath).ok()) {
     VLOG(1) << "Cannot find kernel modules proc file: " << kKernelModulePath;
@@ -41,7 +42,6 @@ QueryData genKernelModules(QueryContext& context) {
                                  std::istreambuf_iterator<char>());
 
   for (const auto& module : osquery::split(module_info, "\n")) {
-    Row r;
     auto details = osquery::split(module, " ");
     if (details.size() < 6) {
       // Interesting error case, this module line is not well formed.
@@ -56,12 +56,14 @@ QueryData genKernelModules(QueryContext& context) {
       }
     }
 
-    r["name"] = details[0];
-    r["size"] = details[1];
-    r["used_by"] = details[3];
-    r["status"] = details[4];
-    r["address"] = details[5];
-    results.push_back(r);
+    using C = KernelModulesColumns;
+    auto r = make_indexed_row(C::names());
+    r->set(C::NAME, std::move(details[0]));
+    r->set(C::SIZE, std::move(details[1]));
+    r->set(C::USED_BY, std::move(details[3]));
+    r->set(C::STATUS, std::move(details[4]));
+    r->set(C::ADDRESS, std::move(details[5]));
+    results.push_back(std::move(r));
   }
 
   return results;
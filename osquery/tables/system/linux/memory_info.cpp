@@ -14,6 +14,7 @@
 #include <osquery/core/core.h>
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
+#include <osquery/rows/memory_info.h>
 #include <osquery/utils/conversions/split.h>
 #include <osquery/utils/conversions/tryto.h>
 
@@ -22,21 +23,21 @@ namespace tables {
 
 const std::string kMemInfoPath = {"/proc/meminfo"};
 
-const std::map<std::string, std::string> kMemInfoMap = {
-    {"memory_total", "MemTotal:"},
-    {"memory_free", "MemFree:"},
-    {"buffers", "Buffers:"},
-    {"cached", "Cached:"},
-    {"swap_cached", "SwapCached:"},
-    {"active", "Active:"},
-    {"inactive", "Inactive:"},
-    {"swap_total", "SwapTotal:"},
-    {"swap_free", "SwapFree:"},
+const std::map<size_t, std::string> kMemInfoMap = {
+    {MemoryInfoColumns::MEMORY_TOTAL, "MemTotal:"},
+    {MemoryInfoColumns::MEMORY_FREE, "MemFree:"},
+    {MemoryInfoColumns::BUFFERS, "Buffers:"},
+    {MemoryInfoColumns::CACHED, "Cached:"},
+    {MemoryInfoColumns::SWAP_CACHED, "SwapCached:"},
+    {MemoryInfoColumns::ACTIVE, "Active:"},
+    {MemoryInfoColumns::INACTIVE, "Inactive:"},
+    {MemoryInfoColumns::SWAP_TOTAL, "SwapTotal:"},
+    {MemoryInfoColumns::SWAP_FREE, "SwapFree:"},
 };
 
-QueryData getMemoryInfo(QueryContext& context) {
-  QueryData results;
-  Row r;
+TableRows getMemoryInfo(QueryContext& context) {
+  TableRows results;
+  auto r = make_indexed_row(MemoryInfoColumns::names());
 
   std::string meminfo_content;
   if (forensicReadFile(kMemInfoPath, meminfo_content).ok()) {
@@ -50,14 +51,14 @@ QueryData getMemoryInfo(QueryContext& context) {
         if (line.find(singleMap.second) == 0) {
           auto const value_exp = tryTo<long>(tokens[1], 10);
           if (value_exp.isValue()) {
-            r[singleMap.first] = BIGINT(value_exp.get() * 1024l);
+            r->set(singleMap.first, value_exp.get() * 1024l);
           }
           break;
         }
       }
     }
   }
-  results.push_back(r);
+  results.push_back(std::move(r));
   return results;
 }
 }
@@ -11,6 +11,7 @@
 
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
+#include <osquery/rows/memory_map.h>
 #include <osquery/utils/conversions/split.h>
 #include <osquery/utils/expected/expected.h>
 
@@ -21,8 +22,9 @@ namespace tables {
 
 const std::string kIOMemLocation = "/proc/iomem";
 
-QueryData genMemoryMap(QueryContext& context) {
-  QueryData results;
+TableRows genMemoryMap(QueryContext& context) {
+  using C = MemoryMapColumns;
+  TableRows results;
 
   std::vector<std::string> regions;
   std::string content;
@@ -36,14 +38,15 @@ QueryData genMemoryMap(QueryContext& context) {
       continue;
     }
 
-    Row r;
-    r["start"] = "0x" + line.substr(0, b1);
     if (b1 == line.size() || line.size() <= b2 + 3) {
       continue;
     }
-    r["end"] = "0x" + line.substr(b1 + 1, b2 - b1);
-    r["name"] = line.substr(b2 + 3);
-    results.push_back(r);
+
+    auto r = make_indexed_row(C::names());
+    r->set(C::START, "0x" + line.substr(0, b1));
+    r->set(C::END, "0x" + line.substr(b1 + 1, b2 - b1));
+    r->set(C::NAME, line.substr(b2 + 3));
+    results.push_back(std::move(r));
   }
 
   return results;
@@ -10,6 +10,7 @@
 #include <osquery/core/core.h>
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
+#include <osquery/filesystem/linux/proc.h>
 #include <osquery/logger/logger.h>
 
 namespace osquery {
@@ -46,12 +47,15 @@ QueryData genOpenFiles(QueryContext& context) {
     osquery::procProcesses(pids);
   }
 
-  for (const auto& process : pids) {
-    std::map<std::string, std::string> descriptors;
-    if (osquery::procDescriptors(process, descriptors).ok()) {
-      genDescriptors(process, descriptors, results);
-    }
-  }
+  procGenerateRows(
+      pids,
+      [](const std::string& process, QueryData& rows) {
+        std::map<std::string, std::string> descriptors;
+        if (osquery::procDescriptors(process, descriptors).ok()) {
+          genDescriptors(process, descriptors, rows);
+        }
+      },
+      results);
 
   return results;
 }
@@ -7,6 +7,7 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <algorithm>
 #include <map>
 #include <regex>
 #include <string>
@@ -24,6 +25,8 @@
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/filesystem/linux/proc.h>
 #include <osquery/logger/logger.h>
+#include <osquery/rows/process_namespaces.h>
+#include <osquery/rows/processes.h>
 #include <osquery/sql/dynamic_table_row.h>
 
 #include <osquery/utils/conversions/split.h>
@@ -36,6 +39,10 @@ namespace tables {
 
 const int kMSIn1CLKTCK = (1000 / sysconf(_SC_CLK_TCK));
 
+/// The namespaces reported as <name>_namespace by process_namespaces.
+const std::vector<std::string> kProcessNamespaceList = {
+    "cgroup", "ipc", "mnt", "net", "pid", "user", "uts"};
+
 inline std::string getProcAttr(const std::string& attr,
                                const std::string& pid) {
   return "/proc/" + pid + "/" + attr;
@@ -137,7 +144,10 @@ std::set<std::string> getProcList(const QueryContext& context) {
   return pidlist;
 }
 
-void genProcessEnvironment(const std::string& pid, QueryData& results) {
+void genProcessEnvironment(const std::string& pid,
+                           bool key_used,
+                           bool value_used,
+                           QueryData& results) {
   auto attr = getProcAttr("environ", pid);
 
   std::string content;
@@ -151,16 +161,26 @@ void genProcessEnvironment(const std::string& pid, QueryData& results) {
 
     Row r;
     r["pid"] = pid;
-    r["key"] = buf.substr(0, idx);
-    r["value"] = buf.substr(idx + 1);
-    results.push_back(r);
+    if (key_used) {
+      r["key"] = buf.substr(0, idx);
+    }
+    if (value_used) {
+      r["value"] = buf.substr(idx + 1);
+    }
+    results.push_back(std::move(r));
     variable += buf.size() + 1;
   }
 }
 
-void genProcessMap(const std::string& pid, QueryData& results) {
+void genProcessMap(const std::string& pid,
+                   const QueryContext& context,
+                   QueryData& results) {
   auto map = getProcAttr("maps", pid);
 
+  // Every mapping is a row, only the used fields are formatted.
+  bool offset_used = context.isColumnUsed("offset");
+  bool path_used = context.isAnyColumnUsed({"path", "pseudo"});
+
   std::string content;
   readFile(map, content);
   for (auto& line : osquery::split(content, "\n")) {
@@ -184,19 +204,23 @@ void genProcessMap(const std::string& pid, QueryData& results) {
     }
 
     r["permissions"] = fields[1];
-    auto offset = tryTo<long long>(fields[2], 16);
-    r["offset"] = BIGINT((offset) ? offset.take() : -1);
+    if (offset_used) {
+      auto offset = tryTo<long long>(fields[2], 16);
+      r["offset"] = BIGINT((offset) ? offset.take() : -1);
+    }
     r["device"] = fields[3];
     r["inode"] = fields[4];
 
-    // Path name must be trimmed.
-    if (fields.size() > 5) {
-      boost::trim(fields[5]);
-      r["path"] = fields[5];
-    }
+    if (path_used) {
+      // Path name must be trimmed.
+      if (fields.size() > 5) {
+        boost::trim(fields[5]);
+        r["path"] = fields[5];
+      }
 
-    // BSS with name in pathname.
-    r["pseudo"] = (fields[4] == "0" && !r["path"].empty()) ? "1" : "0";
+      // BSS with name in pathname.
+      r["pseudo"] = (fields[4] == "0" && !r["path"].empty()) ? "1" : "0";
+    }
     results.push_back(std::move(r));
   }
 }
@@ -227,12 +251,23 @@ struct SimpleProcStat : private boost::noncopyable {
   /// For errors processing proc data.
   Status status;
 
-  explicit SimpleProcStat(const std::string& pid);
+  /**
+   * @brief Parse the process stat and status.
+   *
+   * @param pid The process ID.
+   * @param read_stat Parse /proc/<pid>/stat.
+   * @param read_status Parse /proc/<pid>/status.
+   */
+  explicit SimpleProcStat(const std::string& pid,
+                          bool read_stat = true,
+                          bool read_status = true);
 };
 
-SimpleProcStat::SimpleProcStat(const std::string& pid) {
+SimpleProcStat::SimpleProcStat(const std::string& pid,
+                               bool read_stat,
+                               bool read_status) {
   std::string content;
-  if (readFile(getProcAttr("stat", pid), content).ok()) {
+  if (read_stat && readFile(getProcAttr("stat", pid), content).ok()) {
     auto start = content.find_last_of(")");
     // Start parsing stats from ") <MODE>..."
     if (start == std::string::npos || content.size() <= start + 2) {
@@ -256,6 +291,10 @@ SimpleProcStat::SimpleProcStat(const std::string& pid) {
     this->start_time = details.at(19);
   }
 
+  if (!read_status) {
+    return;
+  }
+
   // /proc/N/status may be not available, or readable by this user.
   if (!readFile(getProcAttr("status", pid), content).ok()) {
     status = Status(1, "Cannot read /proc/status");
@@ -392,92 +431,189 @@ int getOnDisk(const std::string& pid, std::string& path) {
   }
 }
 
+/**
+ * @brief The /proc sources needed by the columns a processes query uses.
+ *
+ * Determined once per query, each source is only read when at least one of
+ * its columns is used.
+ */
+struct ProcessSources {
+  /// /proc/<pid>/stat
+  bool stat{true};
+
+  /// /proc/<pid>/status
+  bool status{true};
+
+  /// /proc/<pid>/io
+  bool io{true};
+
+  /// /proc/<pid>/exe
+  bool exe{true};
+
+  /// on_disk may read /proc/<pid>/maps
+  bool on_disk{true};
+
+  /// /proc/<pid>/cmdline
+  bool cmdline{true};
+
+  /// /proc/<pid>/cwd
+  bool cwd{true};
+
+  /// /proc/<pid>/root
+  bool root{true};
+
+  explicit ProcessSources(const QueryContext& context)
+      : stat(context.isAnyColumnUsed({"state",
+                                      "parent",
+                                      "pgroup",
+                                      "nice",
+                                      "threads",
+                                      "user_time",
+                                      "system_time",
+                                      "start_time"})),
+        status(context.isAnyColumnUsed({"name",
+                                        "uid",
+                                        "euid",
+                                        "suid",
+                                        "gid",
+                                        "egid",
+                                        "sgid",
+                                        "resident_size",
+                                        "total_size"})),
+        io(context.isAnyColumnUsed({"disk_bytes_read", "disk_bytes_written"})),
+        exe(context.isAnyColumnUsed({"path", "on_disk"})),
+        on_disk(context.isColumnUsed("on_disk")),
+        cmdline(context.isColumnUsed("cmdline")),
+        cwd(context.isColumnUsed("cwd")),
+        root(context.isColumnUsed("root")) {}
+};
+
 void genProcess(const std::string& pid,
                 long system_boot_time,
+                const ProcessSources& sources,
                 TableRows& results) {
   // Parse the process stat and status.
-  SimpleProcStat proc_stat(pid);
-  // Parse the process io
-  SimpleProcIo proc_io(pid);
-
+  SimpleProcStat proc_stat(pid, sources.stat, sources.status);
   if (!proc_stat.status.ok()) {
     VLOG(1) << proc_stat.status.getMessage() << " for pid " << pid;
     return;
   }
 
-  auto r = make_table_row();
-  r["pid"] = pid;
-  r["parent"] = proc_stat.parent;
-  r["path"] = readProcLink("exe", pid);
-  r["name"] = proc_stat.name;
-  r["pgroup"] = proc_stat.group;
-  r["state"] = proc_stat.state;
-  r["nice"] = proc_stat.nice;
-  r["threads"] = proc_stat.threads;
-  // Read/parse cmdline arguments.
-  r["cmdline"] = readProcCMDLine(pid);
-  r["cwd"] = readProcLink("cwd", pid);
-  r["root"] = readProcLink("root", pid);
-  r["uid"] = proc_stat.real_uid;
-  r["euid"] = proc_stat.effective_uid;
-  r["suid"] = proc_stat.saved_uid;
-  r["gid"] = proc_stat.real_gid;
-  r["egid"] = proc_stat.effective_gid;
-  r["sgid"] = proc_stat.saved_gid;
-
-  r["on_disk"] = INTEGER(getOnDisk(pid, r["path"]));
+  using C = ProcessesColumns;
+  auto r = make_indexed_row(C::names());
+  r->set(C::PID, pid);
+  if (sources.stat) {
+    r->set(C::PARENT, proc_stat.parent);
+    r->set(C::PGROUP, proc_stat.group);
+    r->set(C::STATE, proc_stat.state);
+    r->set(C::NICE, proc_stat.nice);
+    r->set(C::THREADS, proc_stat.threads);
+  }
 
-  // size/memory information
-  r["wired_size"] = "0"; // No support for unpagable counters in linux.
-  r["resident_size"] = proc_stat.resident_size;
-  r["total_size"] = proc_stat.total_size;
-
-  // time information
-  auto usr_time = std::strtoull(proc_stat.user_time.data(), nullptr, 10);
-  r["user_time"] = std::to_string(usr_time * kMSIn1CLKTCK);
-  auto sys_time = std::strtoull(proc_stat.system_time.data(), nullptr, 10);
-  r["system_time"] = std::to_string(sys_time * kMSIn1CLKTCK);
-
-  auto proc_start_time_exp = tryTo<long>(proc_stat.start_time);
-  if (proc_start_time_exp.isValue() && system_boot_time > 0) {
-    r["start_time"] = INTEGER(system_boot_time + proc_start_time_exp.take() /
-                                                     sysconf(_SC_CLK_TCK));
-  } else {
-    r["start_time"] = "-1";
+  std::string path;
+  if (sources.exe) {
+    path = readProcLink("exe", pid);
   }
 
-  if (!proc_io.status.ok()) {
-    // /proc/<pid>/io can require root to access, so don't fail if we can't
-    VLOG(1) << proc_io.status.getMessage();
-  } else {
-    r["disk_bytes_read"] = proc_io.read_bytes;
-    long long write_bytes = tryTo<long long>(proc_io.write_bytes).takeOr(0ll);
-    long long cancelled_write_bytes =
-        tryTo<long long>(proc_io.cancelled_write_bytes).takeOr(0ll);
+  if (sources.cmdline) {
+    // Read/parse cmdline arguments.
+    r->set(C::CMDLINE, readProcCMDLine(pid));
+  }
 
-    r["disk_bytes_written"] =
-        std::to_string(write_bytes - cancelled_write_bytes);
+  if (sources.cwd) {
+    r->set(C::CWD, readProcLink("cwd", pid));
   }
 
-  results.push_back(r);
-}
+  if (sources.root) {
+    r->set(C::ROOT, readProcLink("root", pid));
+  }
 
-void genNamespaces(const std::string& pid, QueryData& results) {
-  Row r;
+  if (sources.status) {
+    r->set(C::NAME, proc_stat.name);
+    r->set(C::UID, proc_stat.real_uid);
+    r->set(C::EUID, proc_stat.effective_uid);
+    r->set(C::SUID, proc_stat.saved_uid);
+    r->set(C::GID, proc_stat.real_gid);
+    r->set(C::EGID, proc_stat.effective_gid);
+    r->set(C::SGID, proc_stat.saved_gid);
+  }
 
-  ProcessNamespaceList proc_ns;
-  Status status = procGetProcessNamespaces(pid, proc_ns);
-  if (!status.ok()) {
-    VLOG(1) << "Namespaces for pid " << pid
-            << " are incomplete: " << status.what();
+  if (sources.on_disk) {
+    r->set(C::ON_DISK, getOnDisk(pid, path));
   }
 
-  r["pid"] = pid;
-  for (const auto& pair : proc_ns) {
-    r[pair.first + "_namespace"] = std::to_string(pair.second);
+  if (sources.exe) {
+    r->set(C::PATH, std::move(path));
   }
 
-  results.push_back(r);
+  // size/memory information
+  r->set(C::WIRED_SIZE, 0); // No support for unpagable counters in linux.
+  if (sources.status) {
+    r->set(C::RESIDENT_SIZE, proc_stat.resident_size);
+    r->set(C::TOTAL_SIZE, proc_stat.total_size);
+  }
+
+  if (sources.stat) {
+    // time information
+    auto usr_time = std::strtoull(proc_stat.user_time.data(), nullptr, 10);
+    r->set(C::USER_TIME, usr_time * kMSIn1CLKTCK);
+    auto sys_time = std::strtoull(proc_stat.system_time.data(), nullptr, 10);
+    r->set(C::SYSTEM_TIME, sys_time * kMSIn1CLKTCK);
+
+    auto proc_start_time_exp = tryTo<long>(proc_stat.start_time);
+    if (proc_start_time_exp.isValue() && system_boot_time > 0) {
+      r->set(C::START_TIME,
+             system_boot_time +
+                 proc_start_time_exp.take() / sysconf(_SC_CLK_TCK));
+    } else {
+      r->set(C::START_TIME, -1);
+    }
+  }
+
+  if (sources.io) {
+    // Parse the process io
+    SimpleProcIo proc_io(pid);
+    if (!proc_io.status.ok()) {
+      // /proc/<pid>/io can require root to access, so don't fail if we can't
+      VLOG(1) << proc_io.status.getMessage();
+    } else {
+      r->set(C::DISK_BYTES_READ, proc_io.read_bytes);
+      long long write_bytes =
+          tryTo<long long>(proc_io.write_bytes).takeOr(0ll);
+      long long cancelled_write_bytes =
+          tryTo<long long>(proc_io.cancelled_write_bytes).takeOr(0ll);
+
+      r->set(C::DISK_BYTES_WRITTEN, write_bytes - cancelled_write_bytes);
+    }
+  }
+
+  results.push_back(std::move(r));
+}
+
+void genNamespaces(const std::string& pid,
+                   const std::vector<std::string>& namespaces,
+                   const std::map<std::string, size_t>& namespace_columns,
+                   TableRows& results) {
+  auto r = make_indexed_row(ProcessNamespacesColumns::names());
+  r->set(ProcessNamespacesColumns::PID, pid);
+
+  if (!namespaces.empty()) {
+    ProcessNamespaceList proc_ns;
+    Status status = procGetProcessNamespaces(pid, proc_ns, namespaces);
+    if (!status.ok()) {
+      VLOG(1) << "Namespaces for pid " << pid
+              << " are incomplete: " << status.what();
+    }
+
+    for (const auto& pair : proc_ns) {
+      auto column = namespace_columns.find(pair.first);
+      if (column != namespace_columns.end()) {
+        r->set(column->second, std::to_string(pair.second));
+      }
+    }
+  }
+
+  results.push_back(std::move(r));
 }
 
 TableRows genProcesses(QueryContext& context) {
@@ -487,10 +623,13 @@ TableRows genProcesses(QueryContext& context) {
     system_boot_time = std::time(nullptr) - system_boot_time;
   }
 
+  ProcessSources sources(context);
   auto pidlist = getProcList(context);
-  for (const auto& pid : pidlist) {
-    genProcess(pid, system_boot_time, results);
-  }
+  procGenerateRows(pidlist,
+                   [&](const std::string& pid, TableRows& rows) {
+                     genProcess(pid, system_boot_time, sources, rows);
+                   },
+                   results);
 
   return results;
 }
@@ -498,10 +637,14 @@ TableRows genProcesses(QueryContext& context) {
 QueryData genProcessEnvs(QueryContext& context) {
   QueryData results;
 
+  bool key_used = context.isColumnUsed("key");
+  bool value_used = context.isColumnUsed("value");
   auto pidlist = getProcList(context);
-  for (const auto& pid : pidlist) {
-    genProcessEnvironment(pid, results);
-  }
+  procGenerateRows(pidlist,
+                   [&](const std::string& pid, QueryData& rows) {
+                     genProcessEnvironment(pid, key_used, value_used, rows);
+                   },
+                   results);
 
   return results;
 }
@@ -510,21 +653,41 @@ QueryData genProcessMemoryMap(QueryContext& context) {
   QueryData results;
 
   auto pidlist = getProcList(context);
-  for (const auto& pid : pidlist) {
-    genProcessMap(pid, results);
-  }
+  procGenerateRows(pidlist,
+                   [&context](const std::string& pid, QueryData& rows) {
+                     genProcessMap(pid, context, rows);
+                   },
+                   results);
 
   return results;
 }
 
-QueryData genProcessNamespaces(QueryContext& context) {
-  QueryData results;
+TableRows genProcessNamespaces(QueryContext& context) {
+  TableRows results;
 
-  const auto pidlist = getProcList(context);
-  for (const auto& pid : pidlist) {
-    genNamespaces(pid, results);
+  // Only read the namespace links of the used columns.
+  const auto& column_names = *ProcessNamespacesColumns::names();
+  std::vector<std::string> namespaces;
+  std::map<std::string, size_t> namespace_columns;
+  for (const auto& namespace_name : kProcessNamespaceList) {
+    auto column_name = namespace_name + "_namespace";
+    if (context.isColumnUsed(column_name)) {
+      auto column =
+          std::find(column_names.begin(), column_names.end(), column_name);
+      if (column != column_names.end()) {
+        namespaces.push_back(namespace_name);
+        namespace_columns[namespace_name] = column - column_names.begin();
+      }
+    }
   }
 
+  const auto pidlist = getProcList(context);
+  procGenerateRows(pidlist,
+                   [&](const std::string& pid, TableRows& rows) {
+                     genNamespaces(pid, namespaces, namespace_columns, rows);
+                   },
+                   results);
+
   return results;
 }
 }
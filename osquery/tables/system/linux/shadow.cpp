@@ -14,6 +14,7 @@
 
 #include <osquery/core/core.h>
 #include <osquery/core/tables.h>
+#include <osquery/rows/shadow.h>
 #include <osquery/utils/mutex.h>
 
 namespace osquery {
@@ -21,41 +22,42 @@ namespace tables {
 
 const auto kPasswordHashAlgRegex = std::regex("^\\$(\\w+)\\$");
 
-void genShadowForAccount(const struct spwd* spwd, QueryData& results) {
-  Row r;
-  r["last_change"] = BIGINT(spwd->sp_lstchg);
-  r["min"] = BIGINT(spwd->sp_min);
-  r["max"] = BIGINT(spwd->sp_max);
-  r["warning"] = BIGINT(spwd->sp_warn);
-  r["inactive"] = BIGINT(spwd->sp_inact);
-  r["expire"] = BIGINT(spwd->sp_expire);
-  r["flag"] = BIGINT(spwd->sp_flag);
+void genShadowForAccount(const struct spwd* spwd, TableRows& results) {
+  using C = ShadowColumns;
+  auto r = make_indexed_row(C::names());
+  r->set(C::LAST_CHANGE, spwd->sp_lstchg);
+  r->set(C::MIN, spwd->sp_min);
+  r->set(C::MAX, spwd->sp_max);
+  r->set(C::WARNING, spwd->sp_warn);
+  r->set(C::INACTIVE, spwd->sp_inact);
+  r->set(C::EXPIRE, spwd->sp_expire);
+  r->set(C::FLAG, spwd->sp_flag);
 
-  r["username"] = spwd->sp_namp != nullptr ? TEXT(spwd->sp_namp) : "";
+  r->set(C::USERNAME, spwd->sp_namp != nullptr ? spwd->sp_namp : "");
 
   if (spwd->sp_pwdp != nullptr) {
     std::string password = std::string(spwd->sp_pwdp);
     std::smatch matches;
     if (password == "!!") {
-      r["password_status"] = "not_set";
+      r->set(C::PASSWORD_STATUS, "not_set");
     } else if (password[0] == '!' || password[0] == '*' || password[0] == 'x') {
-      r["password_status"] = "locked";
+      r->set(C::PASSWORD_STATUS, "locked");
     } else if (password.empty()) {
-      r["password_status"] = "empty";
+      r->set(C::PASSWORD_STATUS, "empty");
     } else {
-      r["password_status"] = "active";
+      r->set(C::PASSWORD_STATUS, "active");
     }
     if (std::regex_search(password, matches, kPasswordHashAlgRegex)) {
-      r["hash_alg"] = std::string(matches[1]);
+      r->set(C::HASH_ALG, std::string(matches[1]));
     }
   } else {
-    r["password_status"] = "empty";
+    r->set(C::PASSWORD_STATUS, "empty");
   }
-  results.push_back(r);
+  results.push_back(std::move(r));
 }
 
-QueryData genShadow(QueryContext& context) {
-  QueryData results;
+TableRows genShadow(QueryContext& context) {
+  TableRows results;
   Mutex spwdEnumerationMutex;
 
   struct spwd* spwd = nullptr;
@@ -14,6 +14,7 @@
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/logger/logger.h>
+#include <osquery/rows/shared_memory.h>
 
 namespace osquery {
 namespace tables {
@@ -27,8 +28,9 @@ struct shm_info {
   unsigned long swap_successes;
 } __attribute__((unused));
 
-QueryData genSharedMemory(QueryContext &context) {
-  QueryData results;
+TableRows genSharedMemory(QueryContext &context) {
+  using C = SharedMemoryColumns;
+  TableRows results;
 
   // Use shared memory control (shmctl) to get the max SHMID.
   struct shm_info shm_info;
@@ -49,35 +51,35 @@ QueryData genSharedMemory(QueryContext &context) {
       continue;
     }
 
-    Row r;
-    r["shmid"] = INTEGER(shmid);
+    auto r = make_indexed_row(C::names());
+    r->set(C::SHMID, shmid);
 
     struct passwd *pw = getpwuid(shmseg.shm_perm.uid);
     if (pw != nullptr) {
-      r["owner_uid"] = BIGINT(pw->pw_uid);
+      r->set(C::OWNER_UID, pw->pw_uid);
     }
 
     pw = getpwuid(shmseg.shm_perm.cuid);
     if (pw != nullptr) {
-      r["creator_uid"] = BIGINT(pw->pw_uid);
+      r->set(C::CREATOR_UID, pw->pw_uid);
     }
 
     // Accessor, creator pids.
-    r["pid"] = BIGINT(shmseg.shm_lpid);
-    r["creator_pid"] = BIGINT(shmseg.shm_cpid);
+    r->set(C::PID, shmseg.shm_lpid);
+    r->set(C::CREATOR_PID, shmseg.shm_cpid);
 
     // Access, detached, creator times
-    r["atime"] = BIGINT(shmseg.shm_atime);
-    r["dtime"] = BIGINT(shmseg.shm_dtime);
-    r["ctime"] = BIGINT(shmseg.shm_ctime);
+    r->set(C::ATIME, shmseg.shm_atime);
+    r->set(C::DTIME, shmseg.shm_dtime);
+    r->set(C::CTIME, shmseg.shm_ctime);
 
-    r["permissions"] = lsperms(ipcp->mode);
-    r["size"] = BIGINT(shmseg.shm_segsz);
-    r["attached"] = INTEGER(shmseg.shm_nattch);
-    r["status"] = (ipcp->mode & SHM_DEST) ? "dest" : "";
-    r["locked"] = (ipcp->mode & SHM_LOCKED) ? "1" : "0";
+    r->set(C::PERMISSIONS, lsperms(ipcp->mode));
+    r->set(C::SIZE, shmseg.shm_segsz);
+    r->set(C::ATTACHED, shmseg.shm_nattch);
+    r->set(C::STATUS, (ipcp->mode & SHM_DEST) ? "dest" : "");
+    r->set(C::LOCKED, (ipcp->mode & SHM_LOCKED) ? 1 : 0);
 
-    results.push_back(r);
+    results.push_back(std::move(r));
   }
 
   return results;
@@ -8,7 +8,7 @@
  */
 
 #include <osquery/core/tables.h>
-#include <osquery/sql/dynamic_table_row.h>
+#include <osquery/rows/systemd_units.h>
 #include <osquery/tables/system/linux/dbus/methods/getstringproperty.h>
 #include <osquery/tables/system/linux/dbus/methods/listunitsmethodhandler.h>
 
@@ -19,14 +19,18 @@ namespace tables {
 namespace {
 struct PropertyQueryDesc final {
   std::string property_name;
-  std::string column_name;
+  size_t column;
   std::string interface;
 };
 
 const std::vector<PropertyQueryDesc> kStringPropertyQueryList = {
-    {"FragmentPath", "fragment_path", "org.freedesktop.systemd1.Unit"},
-    {"SourcePath", "source_path", "org.freedesktop.systemd1.Unit"},
-    {"User", "user", "org.freedesktop.systemd1.Service"},
+    {"FragmentPath",
+     SystemdUnitsColumns::FRAGMENT_PATH,
+     "org.freedesktop.systemd1.Unit"},
+    {"SourcePath",
+     SystemdUnitsColumns::SOURCE_PATH,
+     "org.freedesktop.systemd1.Unit"},
+    {"User", SystemdUnitsColumns::USER, "org.freedesktop.systemd1.Service"},
 };
 } // namespace
 
@@ -50,21 +54,22 @@ TableRows genSystemdUnits(QueryContext& context) {
     return {};
   }
 
+  using C = SystemdUnitsColumns;
   TableRows results;
 
   for (const auto& unit : unit_list) {
-    auto row = make_table_row();
-
-    row["id"] = TEXT(unit.id);
-    row["description"] = TEXT(unit.description);
-    row["load_state"] = TEXT(unit.load_state);
-    row["active_state"] = TEXT(unit.active_state);
-    row["sub_state"] = TEXT(unit.sub_state);
-    row["following"] = TEXT(unit.following);
-    row["object_path"] = TEXT(unit.path);
-    row["job_id"] = BIGINT(unit.job_id);
-    row["job_type"] = TEXT(unit.job_type);
-    row["job_path"] = TEXT(unit.job_path);
+    auto row = make_indexed_row(C::names());
+
+    row->set(C::ID, unit.id);
+    row->set(C::DESCRIPTION, unit.description);
+    row->set(C::LOAD_STATE, unit.load_state);
+    row->set(C::ACTIVE_STATE, unit.active_state);
+    row->set(C::SUB_STATE, unit.sub_state);
+    row->set(C::FOLLOWING, unit.following);
+    row->set(C::OBJECT_PATH, unit.path);
+    row->set(C::JOB_ID, unit.job_id);
+    row->set(C::JOB_TYPE, unit.job_type);
+    row->set(C::JOB_PATH, unit.job_path);
 
     for (const auto& query : kStringPropertyQueryList) {
       std::string property_value;
@@ -80,7 +85,7 @@ TableRows genSystemdUnits(QueryContext& context) {
                    << " on the following systemd unit: " << unit.path;
       }
 
-      row[query.column_name] = TEXT(property_value);
+      row->set(query.column, std::move(property_value));
     }
 
     results.push_back(std::move(row));
@@ -14,6 +14,7 @@
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/logger/logger.h>
+#include <osquery/rows/authorized_keys.h>
 #include <osquery/tables/system/system_utils.h>
 #include <osquery/utils/conversions/split.h>
 #include <osquery/utils/system/system.h>
@@ -27,7 +28,7 @@ const std::vector<std::string> kSSHAuthorizedkeys = {".ssh/authorized_keys",
 void genSSHkeysForUser(const std::string& uid,
                        const std::string& gid,
                        const std::string& directory,
-                       QueryData& results) {
+                       TableRows& results) {
   for (const auto& kfile : kSSHAuthorizedkeys) {
     boost::filesystem::path keys_file = directory;
     keys_file /= kfile;
@@ -42,15 +43,18 @@ void genSSHkeysForUser(const std::string& uid,
     // base64-encoded key, comment.
     for (const auto& line : split(keys_content, "\n")) {
       if (!line.empty() && line[0] != '#') {
-        Row r = {{"uid", uid}, {"key", line}, {"key_file", keys_file.string()}};
-        results.push_back(r);
+        auto r = make_indexed_row(AuthorizedKeysColumns::names());
+        r->set(AuthorizedKeysColumns::UID, uid);
+        r->set(AuthorizedKeysColumns::KEY, line);
+        r->set(AuthorizedKeysColumns::KEY_FILE, keys_file.string());
+        results.push_back(std::move(r));
       }
     }
   }
 }
 
-QueryData getAuthorizedKeys(QueryContext& context) {
-  QueryData results;
+TableRows getAuthorizedKeys(QueryContext& context) {
+  TableRows results;
 
   // Iterate over each user
   QueryData users = usersFromContext(context);
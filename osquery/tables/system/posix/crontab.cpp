@@ -15,6 +15,7 @@
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/logger/logger.h>
+#include <osquery/rows/crontab.h>
 #include <osquery/utils/conversions/split.h>
 
 namespace osquery {
@@ -56,50 +57,53 @@ std::vector<std::string> cronFromFile(const std::string& path) {
 
 void genCronLine(const std::string& path,
                  const std::string& line,
-                 QueryData& results) {
-  Row r;
+                 TableRows& results) {
+  using C = CrontabColumns;
+  auto r = make_indexed_row(C::names());
 
-  r["path"] = path;
+  r->set(C::PATH, path);
   auto columns = split(line, " \t");
 
   size_t index = 0;
+  std::string command;
   auto iterator = columns.begin();
   for (; iterator != columns.end(); ++iterator) {
     if (index == 0) {
       if ((*iterator).at(0) == '@') {
         // If the first value is an 'at' then skip to the command.
-        r["event"] = *iterator;
+        r->set(C::EVENT, *iterator);
         index = 5;
         continue;
       }
-      r["minute"] = *iterator;
+      r->set(C::MINUTE, *iterator);
     } else if (index == 1) {
-      r["hour"] = *iterator;
+      r->set(C::HOUR, *iterator);
     } else if (index == 2) {
-      r["day_of_month"] = *iterator;
+      r->set(C::DAY_OF_MONTH, *iterator);
     } else if (index == 3) {
-      r["month"] = *iterator;
+      r->set(C::MONTH, *iterator);
     } else if (index == 4) {
-      r["day_of_week"] = *iterator;
+      r->set(C::DAY_OF_WEEK, *iterator);
     } else if (index == 5) {
-      r["command"] = *iterator;
+      command = *iterator;
     } else {
       // Long if switch to handle command breaks from space delim.
-      r["command"] += " " + *iterator;
+      command += " " + *iterator;
     }
     index++;
   }
 
-  if (r["command"].size() == 0) {
+  if (command.size() == 0) {
     // The line was not well-formed, perhaps it was a variable?
     return;
   }
 
-  results.push_back(r);
+  r->set(C::COMMAND, std::move(command));
+  results.push_back(std::move(r));
 }
 
-QueryData genCronTab(QueryContext& context) {
-  QueryData results;
+TableRows genCronTab(QueryContext& context) {
+  TableRows results;
   std::vector<std::string> file_list;
 
   file_list.push_back(kSystemCron);
@@ -14,6 +14,7 @@
 #include <boost/utility/string_view.hpp>
 
 #include <osquery/core/tables.h>
+#include <osquery/rows/load_average.h>
 
 namespace osquery {
 namespace tables {
@@ -23,17 +24,17 @@ static constexpr std::array<boost::string_view, 3> kPeriods = {
      boost::string_view("5m", 2),
      boost::string_view("15m", 3)}};
 
-QueryData genLoadAverage(QueryContext& context) {
-  QueryData results(3);
+TableRows genLoadAverage(QueryContext& context) {
+  TableRows results;
 
   double loads[3];
 
   if (getloadavg(loads, 3) != -1) {
     for (int i = 0; i < 3; i++) {
-      Row r = {{"period", kPeriods[i].data()},
-               {"average", std::to_string(loads[i])}};
-
-      results[i] = r;
+      auto r = make_indexed_row(LoadAverageColumns::names());
+      r->set(LoadAverageColumns::PERIOD, kPeriods[i].data());
+      r->set(LoadAverageColumns::AVERAGE, std::to_string(loads[i]));
+      results.push_back(std::move(r));
     }
   };
 
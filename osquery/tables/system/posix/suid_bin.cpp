@@ -16,6 +16,7 @@
 #include <osquery/core/tables.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/logger/logger.h>
+#include <osquery/rows/suid_bin.h>
 
 namespace fs = boost::filesystem;
 
@@ -27,7 +28,7 @@ std::vector<std::string> kBinarySearchPaths = {
     "/usr/local/bin", "/usr/local/sbin", "/tmp",
 };
 
-Status genBin(const fs::path& path, int perms, QueryData& results) {
+Status genBin(const fs::path& path, int perms, TableRows& results) {
   struct stat info;
   // store user and group
   if (stat(path.c_str(), &info) != 0) {
@@ -35,8 +36,9 @@ Status genBin(const fs::path& path, int perms, QueryData& results) {
   }
 
   // store path
-  Row r;
-  r["path"] = path.string();
+  using C = SuidBinColumns;
+  auto r = make_indexed_row(C::names());
+  r->set(C::PATH, path.string());
   struct passwd* pw = getpwuid(info.st_uid);
   struct group* gr = getgrgid(info.st_gid);
 
@@ -55,19 +57,20 @@ Status genBin(const fs::path& path, int perms, QueryData& results) {
     group = std::to_string(info.st_gid);
   }
 
-  r["username"] = user;
-  r["groupname"] = group;
+  r->set(C::USERNAME, std::move(user));
+  r->set(C::GROUPNAME, std::move(group));
 
-  r["permissions"] = "";
+  std::string permissions;
   if ((perms & 04000) == 04000) {
-    r["permissions"] += "S";
+    permissions += "S";
   }
 
   if ((perms & 02000) == 02000) {
-    r["permissions"] += "G";
+    permissions += "G";
   }
 
-  results.push_back(r);
+  r->set(C::PERMISSIONS, std::move(permissions));
+  results.push_back(std::move(r));
   return Status::success();
 }
 
@@ -82,7 +85,7 @@ bool isSuidBin(const fs::path& path, int perms) {
   return false;
 }
 
-void genSuidBinsFromPath(const std::string& path, QueryData& results) {
+void genSuidBinsFromPath(const std::string& path, TableRows& results) {
   if (!pathExists(path).ok()) {
     // Creating an iterator on a missing path will except.
     return;
@@ -118,8 +121,8 @@ void genSuidBinsFromPath(const std::string& path, QueryData& results) {
   }
 }
 
-QueryData genSuidBin(QueryContext& context) {
-  QueryData results;
+TableRows genSuidBin(QueryContext& context) {
+  TableRows results;
 
   // Todo: add hidden column to select on that triggers non-std path searches.
   for (const auto& path : kBinarySearchPaths) {
@@ -16,6 +16,7 @@
 
 #include <osquery/core/tables.h>
 #include <osquery/logger/logger.h>
+#include <osquery/rows/ulimit_info.h>
 
 namespace osquery {
 namespace tables {
@@ -62,7 +63,7 @@ const std::map<std::string, int> kLimitsResourceMap = {
 #endif
 };
 
-void getLimit(QueryData& results) {
+void getLimit(TableRows& results) {
   for (const auto& it : kLimitsResourceMap) {
     struct rlimit rlp;
     auto result = getrlimit(it.second, &rlp);
@@ -71,20 +72,20 @@ void getLimit(QueryData& results) {
                 << std::strerror(errno);
       continue;
     }
-    Row r;
-    r["type"] = it.first;
-    r["soft_limit"] = (rlp.rlim_cur == RLIM_INFINITY)
-                          ? "unlimited"
-                          : std::to_string(rlp.rlim_cur);
-    r["hard_limit"] = (rlp.rlim_max == RLIM_INFINITY)
-                          ? "unlimited"
-                          : std::to_string(rlp.rlim_max);
-    results.push_back(r);
+    auto r = make_indexed_row(UlimitInfoColumns::names());
+    r->set(UlimitInfoColumns::TYPE, it.first);
+    r->set(UlimitInfoColumns::SOFT_LIMIT,
+           (rlp.rlim_cur == RLIM_INFINITY) ? "unlimited"
+                                           : std::to_string(rlp.rlim_cur));
+    r->set(UlimitInfoColumns::HARD_LIMIT,
+           (rlp.rlim_max == RLIM_INFINITY) ? "unlimited"
+                                           : std::to_string(rlp.rlim_max));
+    results.push_back(std::move(r));
   }
 }
 
-QueryData genUlimitInfo(QueryContext& context) {
-  QueryData results;
+TableRows genUlimitInfo(QueryContext& context) {
+  TableRows results;
 
   getLimit(results);
 
@@ -7,6 +7,9 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <sys/stat.h>
+#include <sys/types.h>
+
 #include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
@@ -22,12 +25,19 @@
 #include <osquery/logger/logger.h>
 #include <osquery/registry/registry_factory.h>
 #include <osquery/sql/sql.h>
+#include <osquery/tables/system/hash.h>
 #ifdef OSQUERY_WINDOWS
 #include <osquery/utils/conversions/windows/strings.h>
 #endif
 #include <osquery/utils/info/platform_type.h>
 
 namespace osquery {
+
+DECLARE_bool(hash_cache_persist);
+DECLARE_uint32(hash_cache_persist_max);
+DECLARE_uint32(hash_threads);
+DECLARE_uint64(hash_query_max_bytes);
+
 namespace tables {
 
 class SystemsTablesTests : public testing::Test {
@@ -379,5 +389,115 @@ TEST_F(HashTableTest, test_cache_updates) {
   EXPECT_NE(rows[0].at("md5"), contentMd5);
   EXPECT_EQ(rows[0].at("md5"), badContentMd5);
 }
+
+TEST_F(HashTableTest, test_cache_persisted) {
+  initDatabasePluginForTesting();
+  FLAGS_hash_cache_persist = true;
+  SetContent(0);
+  FileHashCache::clear();
+
+  SQL r1(qry);
+  ASSERT_EQ(r1.rows().size(), 1U);
+  EXPECT_EQ(r1.rows()[0].at("md5"), contentMd5);
+
+  std::string value;
+  ASSERT_TRUE(getDatabaseValue(kFileHashes, tmpPath.string(), value).ok());
+  EXPECT_NE(value.find(contentMd5), std::string::npos);
+
+  struct stat st;
+  ASSERT_EQ(stat(tmpPath.string().c_str(), &st), 0);
+  auto stored = [&st, this](time_t ctime) {
+    return std::to_string(st.st_ino) + ":" + std::to_string(st.st_mtime) +
+           ":" + std::to_string(ctime) + ":" + std::to_string(st.st_size) +
+           ":" + badContentMd5 + ":" + contentSha1 + ":" + contentSha256 +
+           ":" + std::to_string(time(nullptr));
+  };
+
+  // A stored entry matching the file is used after the memory cache is lost.
+  setDatabaseValue(kFileHashes, tmpPath.string(), stored(st.st_ctime));
+  FileHashCache::clear();
+  SQL r2(qry);
+  ASSERT_EQ(r2.rows().size(), 1U);
+  EXPECT_EQ(r2.rows()[0].at("md5"), badContentMd5);
+
+  // A stored entry with a different ctime is recalculated and replaced.
+  setDatabaseValue(kFileHashes, tmpPath.string(), stored(st.st_ctime - 1));
+  FileHashCache::clear();
+  SQL r3(qry);
+  ASSERT_EQ(r3.rows().size(), 1U);
+  EXPECT_EQ(r3.rows()[0].at("md5"), contentMd5);
+  ASSERT_TRUE(getDatabaseValue(kFileHashes, tmpPath.string(), value).ok());
+  EXPECT_NE(value.find(contentMd5), std::string::npos);
+
+  deleteDatabaseValue(kFileHashes, tmpPath.string());
+  FileHashCache::clear();
+  FLAGS_hash_cache_persist = false;
+}
+
+TEST_F(HashTableTest, test_cache_persisted_max) {
+  initDatabasePluginForTesting();
+  FLAGS_hash_cache_persist = true;
+  FLAGS_hash_cache_persist_max = 2;
+  FileHashCache::clear();
+
+  auto directory = tmpPath.string();
+  boost::filesystem::create_directories(directory);
+  for (size_t i = 0; i < 4; ++i) {
+    writeTextFile(directory + "/file" + std::to_string(i),
+                  "content " + std::to_string(i));
+  }
+
+  // Storing more entries than the maximum removes the oldest.
+  SQL r1("select md5 from hash where directory = '" + directory + "'");
+  ASSERT_EQ(r1.rows().size(), 4U);
+
+  std::vector<std::string> keys;
+  ASSERT_TRUE(scanDatabaseKeys(kFileHashes, keys).ok());
+  EXPECT_EQ(keys.size(), 2U);
+
+  for (const auto& key : keys) {
+    deleteDatabaseValue(kFileHashes, key);
+  }
+  FileHashCache::clear();
+  FLAGS_hash_cache_persist_max = 10000;
+  FLAGS_hash_cache_persist = false;
+}
+
+TEST_F(HashTableTest, test_concurrent_hashing) {
+  auto directory = tmpPath.string();
+  boost::filesystem::create_directories(directory);
+  for (size_t i = 0; i < 20; ++i) {
+    writeTextFile(directory + "/file" + std::to_string(i),
+                  "content " + std::to_string(i));
+  }
+
+  auto query = "select path, md5, sha256 from hash where directory = '" +
+               directory + "'";
+  FileHashCache::clear();
+  SQL r1(query);
+  ASSERT_EQ(r1.rows().size(), 20U);
+
+  // Hashing on several threads keeps the rows and their order.
+  FLAGS_hash_threads = 4;
+  FileHashCache::clear();
+  SQL r2(query);
+  EXPECT_EQ(r1.rows(), r2.rows());
+  for (const auto& row : r2.rows()) {
+    EXPECT_FALSE(row.at("md5").empty());
+  }
+
+  // Files over the byte limit of the query are not hashed.
+  FLAGS_hash_query_max_bytes = 1;
+  FileHashCache::clear();
+  SQL r3(query);
+  ASSERT_EQ(r3.rows().size(), 20U);
+  for (const auto& row : r3.rows()) {
+    EXPECT_TRUE(row.at("md5").empty());
+  }
+
+  FLAGS_hash_query_max_bytes = 0;
+  FLAGS_hash_threads = 1;
+  FileHashCache::clear();
+}
 } // namespace tables
 } // namespace osquery
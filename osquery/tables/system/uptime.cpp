@@ -8,23 +8,24 @@
  */
 
 #include <osquery/core/tables.h>
+#include <osquery/rows/uptime.h>
 #include <osquery/utils/system/uptime.h>
 
 namespace osquery {
 namespace tables {
 
-QueryData genUptime(QueryContext& context) {
-  Row r;
-  QueryData results;
+TableRows genUptime(QueryContext& context) {
+  TableRows results;
   long uptime_in_seconds = getUptime();
 
   if (uptime_in_seconds >= 0) {
-    r["days"] = INTEGER(uptime_in_seconds / 60 / 60 / 24);
-    r["hours"] = INTEGER((uptime_in_seconds / 60 / 60) % 24);
-    r["minutes"] = INTEGER((uptime_in_seconds / 60) % 60);
-    r["seconds"] = INTEGER(uptime_in_seconds % 60);
-    r["total_seconds"] = BIGINT(uptime_in_seconds);
-    results.push_back(r);
+    auto r = make_indexed_row(UptimeColumns::names());
+    r->set(UptimeColumns::DAYS, uptime_in_seconds / 60 / 60 / 24);
+    r->set(UptimeColumns::HOURS, (uptime_in_seconds / 60 / 60) % 24);
+    r->set(UptimeColumns::MINUTES, (uptime_in_seconds / 60) % 60);
+    r->set(UptimeColumns::SECONDS, uptime_in_seconds % 60);
+    r->set(UptimeColumns::TOTAL_SECONDS, uptime_in_seconds);
+    results.push_back(std::move(r));
   }
 
   return results;
@@ -13,6 +13,7 @@
 #include <osquery/core/flags.h>
 #include <osquery/core/system.h>
 #include <osquery/core/tables.h>
+#include <osquery/database/database.h>
 #include <osquery/events/eventfactory.h>
 #include <osquery/events/eventpublisher.h>
 #include <osquery/events/eventsubscriber.h>
@@ -178,6 +179,29 @@ QueryData genOsqueryRegistry(QueryContext& context) {
   return results;
 }
 
+QueryData genOsqueryDatabaseStats(QueryContext& context) {
+  QueryData results;
+
+  PluginResponse stats;
+  auto status = getDatabaseStats(stats);
+  if (!status.ok()) {
+    VLOG(1) << "Cannot get database statistics: " << status.getMessage();
+    return results;
+  }
+
+  auto plugin = Registry::get().getActive("database");
+  for (auto& stat : stats) {
+    Row r;
+    r["plugin"] = plugin;
+    r["domain"] = std::move(stat["domain"]);
+    r["name"] = std::move(stat["name"]);
+    r["value"] = std::move(stat["value"]);
+    results.push_back(std::move(r));
+  }
+
+  return results;
+}
+
 QueryData genOsqueryExtensions(QueryContext& context) {
   QueryData results;
 
@@ -248,6 +272,9 @@ QueryData genOsquerySchedule(QueryContext& context) {
         r["system_time"] = "0";
         r["average_memory"] = "0";
         r["last_executed"] = "0";
+        r["wall_time_ms"] = "0";
+        r["generate_time_ms"] = "0";
+        r["generated_rows"] = "0";
 
         // Report optional performance information.
         Config::get().getPerformanceStats(
@@ -258,6 +285,16 @@ QueryData genOsquerySchedule(QueryContext& context) {
               r["user_time"] = BIGINT(perf.user_time);
               r["system_time"] = BIGINT(perf.system_time);
               r["average_memory"] = BIGINT(perf.average_memory);
+              r["wall_time_ms"] = BIGINT(perf.wall_time_ms);
+
+              unsigned long long int generate_time = 0;
+              unsigned long long int generated_rows = 0;
+              for (const auto& table : perf.tables) {
+                generate_time += table.second.generate_time;
+                generated_rows += table.second.rows;
+              }
+              r["generate_time_ms"] = BIGINT(generate_time / 1000);
+              r["generated_rows"] = BIGINT(generated_rows);
             });
 
         results.push_back(r);
@@ -265,5 +302,28 @@ QueryData genOsquerySchedule(QueryContext& context) {
       true);
   return results;
 }
+
+QueryData genOsqueryScheduleTables(QueryContext& context) {
+  QueryData results;
+
+  Config::get().scheduledQueries(
+      [&results](std::string name, const ScheduledQuery& query) {
+        Config::get().getPerformanceStats(
+            name, [&results, &name](const QueryPerformance& perf) {
+              for (const auto& table : perf.tables) {
+                Row r;
+                r["name"] = name;
+                r["table_name"] = table.first;
+                r["generations"] = BIGINT(table.second.generations);
+                r["rows"] = BIGINT(table.second.rows);
+                r["generate_time_ms"] =
+                    BIGINT(table.second.generate_time / 1000);
+                results.push_back(r);
+              }
+            });
+      },
+      true);
+  return results;
+}
 } // namespace tables
 } // namespace osquery
@@ -16,6 +16,7 @@
 #include <osquery/core/flags.h>
 #include <osquery/core/system.h>
 #include <osquery/core/tables.h>
+#include <osquery/rows/time.h>
 
 namespace osquery {
 
@@ -23,8 +24,9 @@ DECLARE_bool(utc);
 
 namespace tables {
 
-QueryData genTime(QueryContext& context) {
-  Row r;
+TableRows genTime(QueryContext& context) {
+  using C = TimeColumns;
+  auto r = make_indexed_row(C::names());
   time_t local_time = getUnixTime();
   auto osquery_time = getUnixTime();
   auto osquery_timestamp = getAsciiTime();
@@ -63,35 +65,30 @@ QueryData genTime(QueryContext& context) {
     li.LowPart = ft.dwLowDateTime;
     li.HighPart = ft.dwHighDateTime;
     long long int hns = li.QuadPart;
-    r["win_timestamp"] = BIGINT(hns);
+    r->set(C::WIN_TIMESTAMP, hns);
   }
 #endif
-  r["weekday"] = SQL_TEXT(weekday);
-  r["year"] = INTEGER(now.tm_year + 1900);
-  r["month"] = INTEGER(now.tm_mon + 1);
-  r["day"] = INTEGER(now.tm_mday);
-  r["hour"] = INTEGER(now.tm_hour);
-  r["minutes"] = INTEGER(now.tm_min);
-  r["seconds"] = INTEGER(now.tm_sec);
-  r["timezone"] = SQL_TEXT(timezone);
-  if (r["timezone"].empty()) {
-    r["timezone"] = "UTC";
-  }
-
-  r["local_time"] = INTEGER(local_time);
-  r["local_timezone"] = SQL_TEXT(local_timezone);
-  if (r["local_timezone"].empty()) {
-    r["local_timezone"] = "UTC";
-  }
-
-  r["unix_time"] = INTEGER(osquery_time);
-  r["timestamp"] = SQL_TEXT(osquery_timestamp);
+  r->set(C::WEEKDAY, weekday);
+  r->set(C::YEAR, now.tm_year + 1900);
+  r->set(C::MONTH, now.tm_mon + 1);
+  r->set(C::DAY, now.tm_mday);
+  r->set(C::HOUR, now.tm_hour);
+  r->set(C::MINUTES, now.tm_min);
+  r->set(C::SECONDS, now.tm_sec);
+  r->set(C::TIMEZONE, timezone[0] != '\0' ? timezone : "UTC");
+
+  r->set(C::LOCAL_TIME, local_time);
+  r->set(C::LOCAL_TIMEZONE,
+         local_timezone[0] != '\0' ? local_timezone : "UTC");
+
+  r->set(C::UNIX_TIME, osquery_time);
+  r->set(C::TIMESTAMP, std::move(osquery_timestamp));
   // Date time is provided in ISO 8601 format, then duplicated in iso_8601.
-  r["datetime"] = SQL_TEXT(iso_8601);
-  r["iso_8601"] = SQL_TEXT(iso_8601);
+  r->set(C::DATETIME, iso_8601);
+  r->set(C::ISO_8601, iso_8601);
 
-  QueryData results;
-  results.push_back(r);
+  TableRows results;
+  results.push_back(std::move(r));
   return results;
 }
 } // namespace tables
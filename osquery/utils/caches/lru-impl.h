@@ -47,5 +47,14 @@ ValueType const* LRU<KeyType, ValueType>::get(const KeyType& key) {
   return &map_iter->second.value;
 }
 
+template <typename KeyType, typename ValueType>
+void LRU<KeyType, ValueType>::erase(const KeyType& key) {
+  auto map_iter = map_.find(key);
+  if (map_iter != map_.end()) {
+    queue_.erase(map_iter->second.iter);
+    map_.erase(map_iter);
+  }
+}
+
 } // namespace caches
 } // namespace osquery
@@ -94,6 +94,21 @@ class LRU {
     return map_.find(key) != map_.end();
   }
 
+  /**
+   * @brief Remove the element with certain key from the cache, if it exists.
+   *
+   * @param KeyType key of the element to remove.
+   */
+  void erase(const KeyType& key);
+
+  /**
+   * @brief Remove all elements from the cache.
+   */
+  void clear() noexcept {
+    map_.clear();
+    queue_.clear();
+  }
+
  private:
   void evict() {
     map_.erase(queue_.back());
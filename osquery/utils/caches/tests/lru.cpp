@@ -115,6 +115,37 @@ TEST_F(LruCacheTests, has_does_not_change_the_place_in_queue) {
   EXPECT_TRUE(cache.has(3));
 }
 
+TEST_F(LruCacheTests, erase) {
+  auto cache = caches::LRU<int, int>(2);
+  cache.insert(1, 212);
+  cache.insert(2, 213);
+  cache.erase(1);
+  cache.erase(3);
+  EXPECT_FALSE(cache.has(1));
+  EXPECT_EQ(cache.size(), 1U);
+
+  // The erased element does not take the place of an eviction.
+  cache.insert(3, 214);
+  EXPECT_TRUE(cache.has(2));
+  EXPECT_TRUE(cache.has(3));
+}
+
+TEST_F(LruCacheTests, clear) {
+  auto cache = caches::LRU<int, int>(2);
+  cache.insert(1, 212);
+  cache.insert(2, 213);
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0U);
+  EXPECT_EQ(cache.get(1), nullptr);
+
+  cache.insert(3, 214);
+  cache.insert(4, 215);
+  cache.insert(5, 216);
+  EXPECT_FALSE(cache.has(3));
+  EXPECT_TRUE(cache.has(4));
+  EXPECT_TRUE(cache.has(5));
+}
+
 TEST_F(LruCacheTests, pointer_validity_after_insertions) {
   auto cache = caches::LRU<int, std::string>(16);
   auto ptr_1 = cache.insert(1, "Arctic");
@@ -0,0 +1,74 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <osquery/utils/thread_pool.h>
+
+namespace osquery {
+
+class ThreadPoolTests : public testing::Test {};
+
+TEST_F(ThreadPoolTests, test_results_in_submission_order) {
+  ThreadPool pool(4);
+  EXPECT_EQ(pool.size(), 4U);
+
+  std::vector<std::future<int>> results;
+  for (int i = 0; i < 100; ++i) {
+    results.push_back(pool.submit([i]() { return i * 2; }));
+  }
+
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(results[i].get(), i * 2);
+  }
+}
+
+TEST_F(ThreadPoolTests, test_zero_threads) {
+  ThreadPool pool(0);
+  EXPECT_EQ(pool.size(), 1U);
+  EXPECT_EQ(pool.submit([]() { return 1; }).get(), 1);
+}
+
+TEST_F(ThreadPoolTests, test_exception_propagation) {
+  ThreadPool pool(2);
+  auto result = pool.submit([]() -> int { throw std::runtime_error("fail"); });
+  EXPECT_THROW(result.get(), std::runtime_error);
+
+  // The worker survives a failed task.
+  EXPECT_EQ(pool.submit([]() { return 2; }).get(), 2);
+}
+
+TEST_F(ThreadPoolTests, test_destructor_drains_queue) {
+  std::atomic<size_t> counter{0};
+  {
+    ThreadPool pool(2);
+    for (size_t i = 0; i < 50; ++i) {
+      pool.submit([&counter]() {
+        std::this_thread::sleep_for(std::chrono::microseconds(10));
+        counter++;
+      });
+    }
+  }
+  EXPECT_EQ(counter, 50U);
+}
+
+TEST_F(ThreadPoolTests, test_resolve_thread_count) {
+  EXPECT_EQ(resolveThreadCount(3), 3U);
+  EXPECT_EQ(resolveThreadCount(8, 2), 2U);
+  EXPECT_GE(resolveThreadCount(0), 1U);
+  EXPECT_LE(resolveThreadCount(0, 1), 1U);
+}
+
+} // namespace osquery
@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#include <algorithm>
+
+#include <osquery/logger/logger.h>
+#include <osquery/utils/thread_pool.h>
+
+namespace osquery {
+
+ThreadPool::ThreadPool(size_t threads, std::string name)
+    : name_(std::move(name)) {
+  threads = std::max<size_t>(threads, 1);
+  workers_.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    workers_.emplace_back([this]() { work(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  condition_.notify_all();
+
+  for (auto& worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+size_t ThreadPool::pending() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tasks_.size();
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  condition_.notify_one();
+}
+
+void ThreadPool::work() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        // Stopping and the queue is drained.
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+
+    try {
+      task();
+    } catch (const std::exception& e) {
+      // Submitted tasks are wrapped in a packaged_task and will not throw.
+      LOG(ERROR) << "Uncaught exception in thread pool " << name_ << ": "
+                 << e.what();
+    }
+  }
+}
+
+size_t resolveThreadCount(size_t configured, size_t max_threads) {
+  size_t count = configured;
+  if (count == 0) {
+    count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+
+  if (max_threads > 0) {
+    count = std::min(count, max_threads);
+  }
+  return count;
+}
+
+} // namespace osquery
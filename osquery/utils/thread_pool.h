@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+namespace osquery {
+
+/**
+ * @brief A bounded pool of worker threads executing queued tasks.
+ *
+ * The pool owns a fixed set of threads created at construction. Tasks are
+ * executed in submission order by the first available worker. Destroying the
+ * pool drains any queued tasks and joins the workers.
+ *
+ * Work that must keep a deterministic output order should collect the returned
+ * futures in submission order and consume them in that same order.
+ */
+class ThreadPool : private boost::noncopyable {
+ public:
+  /**
+   * @brief Create a pool of worker threads.
+   *
+   * @param threads The number of workers, a value of 0 is treated as 1.
+   * @param name An optional name used when logging worker failures.
+   */
+  explicit ThreadPool(size_t threads, std::string name = "");
+
+  /// Drain the queued work and join all workers.
+  ~ThreadPool();
+
+  /**
+   * @brief Queue a callable for execution on a worker.
+   *
+   * @param func Any callable taking no arguments.
+   * @return A future for the callable's result, or exception.
+   */
+  template <typename Func>
+  auto submit(Func&& func) -> std::future<std::invoke_result_t<Func>> {
+    using ResultType = std::invoke_result_t<Func>;
+    auto task = std::make_shared<std::packaged_task<ResultType()>>(
+        std::forward<Func>(func));
+    auto result = task->get_future();
+    enqueue([task]() { (*task)(); });
+    return result;
+  }
+
+  /// The number of worker threads.
+  size_t size() const {
+    return workers_.size();
+  }
+
+  /// The number of tasks waiting for a worker.
+  size_t pending() const;
+
+ private:
+  /// Push a type-erased task and wake a worker.
+  void enqueue(std::function<void()> task);
+
+  /// Worker thread entry point.
+  void work();
+
+ private:
+  /// Name used for diagnostics.
+  const std::string name_;
+
+  /// The fixed set of worker threads.
+  std::vector<std::thread> workers_;
+
+  /// Queued tasks, protected by mutex_.
+  std::deque<std::function<void()>> tasks_;
+
+  /// Protects tasks_ and stopping_.
+  mutable std::mutex mutex_;
+
+  /// Signaled when tasks are queued or the pool is stopping.
+  std::condition_variable condition_;
+
+  /// Set when the pool is being destroyed.
+  bool stopping_{false};
+};
+
+/**
+ * @brief Resolve a configured worker count.
+ *
+ * A configured value of 0 means one worker per available hardware thread.
+ *
+ * @param configured The configured (flag) value.
+ * @param max_threads An upper bound on the resolved count, 0 for no bound.
+ */
+size_t resolveThreadCount(size_t configured, size_t max_threads = 0);
+
+} // namespace osquery
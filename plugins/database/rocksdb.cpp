@@ -9,9 +9,14 @@
 
 #include <sys/stat.h>
 
+#include <memory>
+
 #include <rocksdb/db.h>
 #include <rocksdb/env.h>
+#include <rocksdb/filter_policy.h>
 #include <rocksdb/options.h>
+#include <rocksdb/table.h>
+#include <rocksdb/utilities/table_properties_collectors.h>
 
 #include <osquery/core/flags.h>
 #include <osquery/filesystem/fileops.h>
@@ -30,6 +35,15 @@ HIDDEN_FLAG(int32, rocksdb_write_buffer, 16, "Max write buffer number");
 HIDDEN_FLAG(int32, rocksdb_merge_number, 4, "Min write buffer number to merge");
 HIDDEN_FLAG(int32, rocksdb_background_flushes, 4, "Max background flushes");
 HIDDEN_FLAG(int32, rocksdb_buffer_blocks, 256, "Write buffer blocks (4k)");
+HIDDEN_FLAG(uint64,
+            rocksdb_compaction_ttl,
+            86400,
+            "Seconds before event and log files are compacted");
+
+FLAG(uint64,
+     rocksdb_cache_size,
+     8,
+     "Size of the RocksDB block cache (MB), including indexes and filters");
 
 DECLARE_string(database_path);
 
@@ -44,6 +58,58 @@ std::atomic<bool> kRocksDBCorruptionIndicator{false};
 /// Backing-storage provider for osquery internal/core.
 REGISTER_INTERNAL(RocksDBDatabasePlugin, "database", "rocksdb");
 
+namespace {
+
+/// Number of deleted keys in a file's window that request its compaction.
+const size_t kDeletionWindowSize{128 * 1024};
+const size_t kDeletionTrigger{16 * 1024};
+
+/**
+ * @brief Extract the "<kind>.<namespace>." prefix of event keys.
+ *
+ * Event keys are "<kind>.<publisher>.<subscriber>.<index>", such as the
+ * "data." and "block." keys of a subscriber. Other keys have no prefix.
+ */
+class EventKeyPrefixTransform : public rocksdb::SliceTransform {
+ public:
+  const char* Name() const override {
+    return "osquery.EventKeyPrefix";
+  }
+
+  rocksdb::Slice Transform(const rocksdb::Slice& key) const override {
+    return rocksdb::Slice(key.data(), prefixSize(key));
+  }
+
+  bool InDomain(const rocksdb::Slice& key) const override {
+    return prefixSize(key) > 0;
+  }
+
+ private:
+  /// The prefix ends at the third '.', returns 0 if there is no such prefix.
+  static size_t prefixSize(const rocksdb::Slice& key) {
+    size_t separators = 0;
+    for (size_t i = 0; i < key.size(); i++) {
+      if (key[i] == '.' && ++separators == 3) {
+        return i + 1;
+      }
+    }
+    return 0;
+  }
+};
+
+rocksdb::BlockBasedTableOptions getTableOptions(
+    const std::shared_ptr<rocksdb::Cache>& cache) {
+  rocksdb::BlockBasedTableOptions table_options;
+  table_options.block_cache = cache;
+
+  // Charge the index and filter blocks to the cache so it caps their memory.
+  table_options.cache_index_and_filter_blocks = true;
+  table_options.pin_l0_filter_and_index_blocks_in_cache = true;
+  return table_options;
+}
+
+} // namespace
+
 void GlogRocksDBLogger::Logv(const char* format, va_list ap) {
   // Convert RocksDB log to string and check if header or level-ed log.
   std::string log_line;
@@ -93,7 +159,7 @@ Status RocksDBDatabasePlugin::setUp() {
     options_.max_manifest_file_size = 1024 * 500;
 
     // Performance and optimization settings.
-    // Use rocksdb::kZSTD to use ZSTD database compression
+    // Domains with large values use ZSTD compression, see getDomainOptions.
     options_.compression = rocksdb::kNoCompression;
     options_.compaction_style = rocksdb::kCompactionStyleLevel;
     options_.arena_block_size = (4 * 1024);
@@ -111,12 +177,20 @@ Status RocksDBDatabasePlugin::setUp() {
     }
     options_.info_log = logger_;
 
+    // All column families share one block cache with a memory cap.
+    cache_ = rocksdb::NewLRUCache(FLAGS_rocksdb_cache_size * 1024 * 1024);
+    options_.table_factory.reset(
+        rocksdb::NewBlockBasedTableFactory(getTableOptions(cache_)));
+
+    statistics_ = rocksdb::CreateDBStatistics();
+    options_.statistics = statistics_;
+
     column_families_.push_back(rocksdb::ColumnFamilyDescriptor(
         rocksdb::kDefaultColumnFamilyName, options_));
 
     for (const auto& cf_name : kDomains) {
       column_families_.push_back(
-          rocksdb::ColumnFamilyDescriptor(cf_name, options_));
+          rocksdb::ColumnFamilyDescriptor(cf_name, getDomainOptions(cf_name)));
     }
   }
 
@@ -171,6 +245,54 @@ Status RocksDBDatabasePlugin::setUp() {
   return Status(0);
 }
 
+rocksdb::ColumnFamilyOptions RocksDBDatabasePlugin::getDomainOptions(
+    const std::string& domain) {
+  rocksdb::ColumnFamilyOptions cf_options(options_);
+
+  if (domain == kEvents || domain == kLogs) {
+    // Events and logs are written once then expired or sent, and deleted.
+    // Files with many deleted keys and files older than the TTL are compacted
+    // to drop the deletions, instead of waiting for the level to fill.
+    cf_options.ttl = FLAGS_rocksdb_compaction_ttl;
+    cf_options.table_properties_collector_factories.push_back(
+        rocksdb::NewCompactOnDeletionCollectorFactory(kDeletionWindowSize,
+                                                      kDeletionTrigger));
+  }
+
+  if (domain == kEvents) {
+    // Prefix seeks of a subscriber's keys skip the files without the prefix.
+    event_prefix_extractor_ = std::make_shared<EventKeyPrefixTransform>();
+    cf_options.prefix_extractor = event_prefix_extractor_;
+
+    auto table_options = getTableOptions(cache_);
+    table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10, false));
+    table_options.whole_key_filtering = true;
+    cf_options.table_factory.reset(
+        rocksdb::NewBlockBasedTableFactory(table_options));
+
+    // Recent events are read and expired often, older events are compressed.
+    cf_options.bottommost_compression = rocksdb::kZSTD;
+  } else if (domain == kQueries) {
+    // Query results are large values that are overwritten in place.
+    cf_options.compression = rocksdb::kZSTD;
+  }
+
+  return cf_options;
+}
+
+bool RocksDBDatabasePlugin::usePrefixSeek(const std::string& domain,
+                                          const std::string& low,
+                                          const std::string& high) const {
+  if (domain != kEvents || event_prefix_extractor_ == nullptr || high.empty() ||
+      !event_prefix_extractor_->InDomain(low)) {
+    return false;
+  }
+
+  auto prefix = event_prefix_extractor_->Transform(low).ToString();
+  auto prefix_end = getDatabasePrefixEnd(prefix);
+  return prefix_end.empty() || high <= prefix_end;
+}
+
 Status RocksDBDatabasePlugin::compactFiles(const std::string& domain) {
   auto handle = getHandleForColumnFamily(domain);
   if (handle == nullptr) {
@@ -311,6 +433,13 @@ inline bool skipWal(const std::string& domain) {
 
 Status RocksDBDatabasePlugin::putBatch(const std::string& domain,
                                        const DatabaseStringValueList& data) {
+  return writeBatch(domain, data, {});
+}
+
+Status RocksDBDatabasePlugin::writeBatch(
+    const std::string& domain,
+    const DatabaseStringValueList& data,
+    const std::vector<std::string>& removals) {
   auto cfh = getHandleForColumnFamily(domain);
   if (cfh == nullptr) {
     return Status(1, "Could not get column family for " + domain);
@@ -325,6 +454,10 @@ Status RocksDBDatabasePlugin::putBatch(const std::string& domain,
   }
 
   rocksdb::WriteBatch batch;
+  for (const auto& key : removals) {
+    batch.Delete(cfh, key);
+  }
+
   for (const auto& p : data) {
     const auto& key = p.first;
     const auto& value = p.second;
@@ -415,22 +548,132 @@ Status RocksDBDatabasePlugin::scan(const std::string& domain,
   auto options = rocksdb::ReadOptions();
   options.verify_checksums = false;
   options.fill_cache = false;
+  options.total_order_seek =
+      !usePrefixSeek(domain, prefix, getDatabasePrefixEnd(prefix));
   auto it = getDB()->NewIterator(options, cfh);
   if (it == nullptr) {
     return Status(1, "Could not get iterator for " + domain);
   }
 
+  // Keys are ordered bytewise, matching keys are contiguous from the prefix.
   size_t count = 0;
-  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+  for (it->Seek(prefix); it->Valid(); it->Next()) {
     auto key = it->key().ToString();
-    if (key.find(prefix) == 0) {
-      results.push_back(std::move(key));
-      if (max > 0 && ++count >= max) {
-        break;
-      }
+    if (key.compare(0, prefix.size(), prefix) != 0) {
+      break;
+    }
+
+    results.push_back(std::move(key));
+    if (max > 0 && ++count >= max) {
+      break;
     }
   }
   delete it;
   return Status::success();
 }
+
+Status RocksDBDatabasePlugin::scanRange(
+    const std::string& domain,
+    const std::string& low,
+    const std::string& high,
+    const DatabaseScanCallback& callback) const {
+  if (getDB() == nullptr) {
+    return Status(1, "Database not opened");
+  }
+
+  auto cfh = getHandleForColumnFamily(domain);
+  if (cfh == nullptr) {
+    return Status(1, "Could not get column family for " + domain);
+  }
+  auto options = rocksdb::ReadOptions();
+  options.verify_checksums = false;
+  options.fill_cache = false;
+
+  // The iterator stops at the upper bound instead of reading past the range.
+  rocksdb::Slice upper_bound(high);
+  if (!high.empty()) {
+    options.iterate_upper_bound = &upper_bound;
+  }
+  options.total_order_seek = !usePrefixSeek(domain, low, high);
+
+  std::unique_ptr<rocksdb::Iterator> it(getDB()->NewIterator(options, cfh));
+  if (it == nullptr) {
+    return Status(1, "Could not get iterator for " + domain);
+  }
+
+  for (it->Seek(low); it->Valid(); it->Next()) {
+    if (!callback(it->key().ToString(), it->value().ToString())) {
+      break;
+    }
+  }
+  auto s = it->status();
+  return Status(s.code(), s.ToString());
+}
+
+Status RocksDBDatabasePlugin::stats(PluginResponse& response) const {
+  if (getDB() == nullptr) {
+    return Status(1, "Database not opened");
+  }
+
+  auto add = [&response](const std::string& domain,
+                         const std::string& name,
+                         uint64_t value) {
+    response.push_back(
+        {{"domain", domain}, {"name", name}, {"value", std::to_string(value)}});
+  };
+
+  if (statistics_ != nullptr) {
+    const std::vector<std::pair<std::string, uint32_t>> tickers = {
+        {"stall_micros", rocksdb::STALL_MICROS},
+        {"compact_read_bytes", rocksdb::COMPACT_READ_BYTES},
+        {"compact_write_bytes", rocksdb::COMPACT_WRITE_BYTES},
+        {"flush_write_bytes", rocksdb::FLUSH_WRITE_BYTES},
+        {"bytes_read", rocksdb::BYTES_READ},
+        {"bytes_written", rocksdb::BYTES_WRITTEN},
+        {"block_cache_hit", rocksdb::BLOCK_CACHE_HIT},
+        {"block_cache_miss", rocksdb::BLOCK_CACHE_MISS},
+        {"bloom_filter_useful", rocksdb::BLOOM_FILTER_USEFUL},
+        {"bloom_filter_prefix_useful", rocksdb::BLOOM_FILTER_PREFIX_USEFUL},
+    };
+    for (const auto& ticker : tickers) {
+      add("", ticker.first, statistics_->getTickerCount(ticker.second));
+    }
+
+    auto hits = statistics_->getTickerCount(rocksdb::BLOCK_CACHE_HIT);
+    auto lookups =
+        hits + statistics_->getTickerCount(rocksdb::BLOCK_CACHE_MISS);
+    add("",
+        "block_cache_hit_percent",
+        (lookups > 0) ? hits * 100 / lookups : 0);
+  }
+
+  if (cache_ != nullptr) {
+    add("", "block_cache_usage", cache_->GetUsage());
+    add("", "block_cache_capacity", cache_->GetCapacity());
+  }
+
+  const std::vector<std::pair<std::string, std::string>> properties = {
+      {"live_data_size", rocksdb::DB::Properties::kEstimateLiveDataSize},
+      {"sst_files_size", rocksdb::DB::Properties::kTotalSstFilesSize},
+      {"pending_compaction_bytes",
+       rocksdb::DB::Properties::kEstimatePendingCompactionBytes},
+      {"memtable_size", rocksdb::DB::Properties::kCurSizeAllMemTables},
+      {"estimate_num_keys", rocksdb::DB::Properties::kEstimateNumKeys},
+  };
+  for (const auto& domain : kDomains) {
+    auto cfh = getHandleForColumnFamily(domain);
+    if (cfh == nullptr) {
+      continue;
+    }
+
+    for (const auto& property : properties) {
+      uint64_t value = 0;
+      if (getDB()->GetIntProperty(cfh, property.second, &value)) {
+        add(domain, property.first, value);
+      }
+    }
+  }
+
+  return Status::success();
+}
 } // namespace osquery
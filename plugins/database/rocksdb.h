@@ -9,7 +9,10 @@
 
 #include <atomic>
 
+#include <rocksdb/cache.h>
 #include <rocksdb/db.h>
+#include <rocksdb/slice_transform.h>
+#include <rocksdb/statistics.h>
 
 #include <osquery/core/core.h>
 #include <osquery/database/database.h>
@@ -57,6 +60,11 @@ class RocksDBDatabasePlugin : public DatabasePlugin {
   Status putBatch(const std::string& domain,
                   const DatabaseStringValueList& data) override;
 
+  /// Remove keys and store values in a single RocksDB write batch.
+  Status writeBatch(const std::string& domain,
+                    const DatabaseStringValueList& data,
+                    const std::vector<std::string>& removals) override;
+
   /// Data removal method.
   Status remove(const std::string& domain, const std::string& k) override;
 
@@ -71,6 +79,15 @@ class RocksDBDatabasePlugin : public DatabasePlugin {
               const std::string& prefix,
               uint64_t max) const override;
 
+  /// Key and value range lookup method.
+  Status scanRange(const std::string& domain,
+                   const std::string& low,
+                   const std::string& high,
+                   const DatabaseScanCallback& callback) const override;
+
+  /// Statistics of the database and each domain's column family.
+  Status stats(PluginResponse& response) const override;
+
  public:
   /// Database workflow: open and setup.
   Status setUp() override;
@@ -102,6 +119,25 @@ class RocksDBDatabasePlugin : public DatabasePlugin {
    */
   rocksdb::DB* getDB() const;
 
+  /**
+   * @brief Get the column family options tuned for a domain's workload.
+   *
+   * Events and logs are written once and deleted, their files are compacted
+   * after a TTL. Large values are compressed. Event keys use a prefix bloom
+   * filter for their "<kind>.<namespace>." prefix.
+   */
+  rocksdb::ColumnFamilyOptions getDomainOptions(const std::string& domain);
+
+  /**
+   * @brief Check if a scan of [low, high) may use the domain's prefix filter.
+   *
+   * A prefix seek is only correct when the range is within one prefix of the
+   * extractor, other scans use a total order seek.
+   */
+  bool usePrefixSeek(const std::string& domain,
+                     const std::string& low,
+                     const std::string& high) const;
+
   /// Request RocksDB compact each domain and level to that same level.
   Status compactFiles(const std::string& domain);
 
@@ -145,11 +181,22 @@ class RocksDBDatabasePlugin : public DatabasePlugin {
   /// The RocksDB connection options that are used to connect to RocksDB
   rocksdb::Options options_;
 
+  /// Block cache shared by all column families, including index and filters.
+  std::shared_ptr<rocksdb::Cache> cache_{nullptr};
+
+  /// Database statistics, such as stall time and compaction bytes.
+  std::shared_ptr<rocksdb::Statistics> statistics_{nullptr};
+
+  /// Prefix extractor used for the events domain.
+  std::shared_ptr<const rocksdb::SliceTransform> event_prefix_extractor_{
+      nullptr};
+
   /// Deconstruction mutex.
   Mutex close_mutex_;
 
  private:
   friend class GlogRocksDBLogger;
   FRIEND_TEST(RocksDBDatabasePluginTests, test_corruption);
+  FRIEND_TEST(RocksDBDatabasePluginTests, test_event_prefix_seek);
 };
 } // namespace osquery
@@ -292,4 +292,55 @@ Status SQLiteDatabasePlugin::scan(const std::string& domain,
 
   return Status::success();
 }
+
+Status SQLiteDatabasePlugin::scanRange(
+    const std::string& domain,
+    const std::string& low,
+    const std::string& high,
+    const DatabaseScanCallback& callback) const {
+  // Keys use the BINARY collation, the primary key index is ordered bytewise.
+  std::string q = "select key, value from " + domain + " where key >= ?1";
+  if (!high.empty()) {
+    q += " and key < ?2";
+  }
+  q += " order by key;";
+
+  sqlite3_stmt* stmt = nullptr;
+  auto rc = sqlite3_prepare_v2(db_, q.c_str(), -1, &stmt, nullptr);
+  if (rc != SQLITE_OK) {
+    sqlite3_finalize(stmt);
+    return Status(1, sqlite3_errmsg(db_));
+  }
+
+  sqlite3_bind_text(
+      stmt, 1, low.c_str(), static_cast<int>(low.size()), SQLITE_STATIC);
+  if (!high.empty()) {
+    sqlite3_bind_text(
+        stmt, 2, high.c_str(), static_cast<int>(high.size()), SQLITE_STATIC);
+  }
+
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    auto key = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    auto value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    if (key == nullptr) {
+      continue;
+    }
+
+    std::string value_string;
+    if (value != nullptr) {
+      value_string.assign(value, sqlite3_column_bytes(stmt, 1));
+    }
+    if (!callback(std::string(key, sqlite3_column_bytes(stmt, 0)),
+                  value_string)) {
+      rc = SQLITE_DONE;
+      break;
+    }
+  }
+
+  sqlite3_finalize(stmt);
+  if (rc != SQLITE_DONE) {
+    return Status(1, sqlite3_errmsg(db_));
+  }
+  return Status::success();
+}
 } // namespace osquery
@@ -55,6 +55,12 @@ class SQLiteDatabasePlugin : public DatabasePlugin {
               const std::string& prefix,
               uint64_t max) const override;
 
+  /// Key and value range lookup method.
+  Status scanRange(const std::string& domain,
+                   const std::string& low,
+                   const std::string& high,
+                   const DatabaseScanCallback& callback) const override;
+
  public:
   /// Database workflow: open and setup.
   Status setUp() override;
@@ -7,6 +7,8 @@
  * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
  */
 
+#include <set>
+
 #include <osquery/database/tests/test_utils.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/sql/sql.h>
@@ -51,4 +53,61 @@ TEST_F(RocksDBDatabasePluginTests, test_corruption) {
   resetDatabase();
   EXPECT_FALSE(pathExists(path_ + ".backup"));
 }
+
+TEST_F(RocksDBDatabasePluginTests, test_event_prefix_seek) {
+  RocksDBDatabasePlugin plugin;
+  plugin.getDomainOptions(kEvents);
+
+  // Ranges within one "<kind>.<namespace>." prefix use the prefix filter.
+  EXPECT_TRUE(
+      plugin.usePrefixSeek(kEvents, "data.type.name.", "data.type.name/"));
+  EXPECT_TRUE(plugin.usePrefixSeek(
+      kEvents, "block.type.name.0001.", "block.type.name.0001/"));
+  EXPECT_FALSE(plugin.usePrefixSeek(kEvents, "data.type.", "data.type/"));
+  EXPECT_FALSE(plugin.usePrefixSeek(kEvents, "data.type.name.", ""));
+  EXPECT_FALSE(plugin.usePrefixSeek(kEvents, "data.type.a.", "data.type.b."));
+  EXPECT_FALSE(
+      plugin.usePrefixSeek(kQueries, "data.type.name.", "data.type.name/"));
+
+  // Prefix scans return the same keys as a total order scan.
+  setDatabaseValue(kEvents, "data.type.name.1", "1");
+  setDatabaseValue(kEvents, "data.type.name.2", "2");
+  setDatabaseValue(kEvents, "data.type.other.1", "3");
+  setDatabaseValue(kEvents, "eid.type.name", "2");
+
+  std::vector<std::string> keys;
+  scanDatabaseKeys(kEvents, keys, "data.type.name.", 0);
+  EXPECT_EQ(keys.size(), 2U);
+
+  keys.clear();
+  scanDatabaseKeys(kEvents, keys, "data.type.", 0);
+  EXPECT_EQ(keys.size(), 3U);
+
+  keys.clear();
+  scanDatabasePrefix(kEvents,
+                     "data.type.name.",
+                     [&keys](const std::string& key, const std::string&) {
+                       keys.push_back(key);
+                       return true;
+                     });
+  std::vector<std::string> expected = {"data.type.name.1", "data.type.name.2"};
+  EXPECT_EQ(keys, expected);
+}
+
+TEST_F(RocksDBDatabasePluginTests, test_stats) {
+  setDatabaseValue(kQueries, "test_stats", "value");
+
+  PluginResponse stats;
+  ASSERT_TRUE(getDatabaseStats(stats).ok());
+
+  std::set<std::string> names;
+  for (const auto& row : stats) {
+    ASSERT_EQ(row.count("value"), 1U);
+    names.insert(row.at("domain") + ":" + row.at("name"));
+  }
+  EXPECT_EQ(names.count(":stall_micros"), 1U);
+  EXPECT_EQ(names.count(":compact_write_bytes"), 1U);
+  EXPECT_EQ(names.count(":block_cache_hit_percent"), 1U);
+  EXPECT_EQ(names.count(kQueries + ":sst_files_size"), 1U);
+}
 }
@@ -54,19 +54,20 @@ Status BufferedLogForwarder::setUp() {
 }
 
 void BufferedLogForwarder::check() {
-  // Get a list of all the buffered log items, with a max of 1024 lines.
+  // Get all the buffered log items, with a max of 1024 lines. The keys and
+  // values are read together by a single seek to the index prefix.
   std::vector<std::string> indexes;
-  auto status = scanDatabaseKeys(kLogs, indexes, index_name_, max_log_lines_);
-
-  // For each index, accumulate the log line into the result or status set.
   std::vector<std::string> results, statuses;
-  iterate(indexes, ([&results, &statuses, this](std::string& index) {
-            std::string value;
-            auto& target = isResultIndex(index) ? results : statuses;
-            if (getDatabaseValue(kLogs, index, value)) {
-              target.emplace_back(std::move(value));
-            }
-          }));
+  auto status = scanDatabasePrefix(
+      kLogs,
+      index_name_,
+      ([&indexes, &results, &statuses, this](const std::string& index,
+                                             const std::string& value) {
+        auto& target = isResultIndex(index) ? results : statuses;
+        target.push_back(value);
+        indexes.push_back(index);
+        return max_log_lines_ == 0 || indexes.size() < max_log_lines_;
+      }));
 
   // If any results/statuses were found in the flushed buffer, send.
   if (results.size() > 0) {
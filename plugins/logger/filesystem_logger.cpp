@@ -9,12 +9,15 @@
 
 #include "filesystem_logger.h"
 #include "logrotate.h"
+#include "logwriter.h"
 
 #include <osquery/core/flags.h>
+#include <osquery/dispatcher/dispatcher.h>
 #include <osquery/filesystem/filesystem.h>
 #include <osquery/logger/logger.h>
 #include <osquery/utils/config/default_paths.h>
 
+#include <chrono>
 #include <exception>
 
 namespace fs = boost::filesystem;
@@ -46,11 +49,30 @@ FLAG(uint64,
 
 FLAG(int32, logger_mode, 0640, "Octal mode for log files (default '0640')");
 
+FLAG(uint64,
+     logger_flush_interval,
+     0,
+     "Milliseconds to buffer filesystem log lines (default 0, no buffering)");
+
+FLAG(uint64,
+     logger_flush_size,
+     1024 * 1024,
+     "Bytes of buffered filesystem log lines that trigger a write");
+
+FLAG(string,
+     logger_fsync,
+     "none",
+     "Filesystem log fsync policy: none or flush (after every write)");
+
 const std::string kFilesystemLoggerFilename = "osqueryd.results.log";
 const std::string kFilesystemLoggerSnapshots = "osqueryd.snapshots.log";
 
 bool LogRotate::shouldRotate() {
-  return this->fileSize(path_) >= this->getRotateSize();
+  return shouldRotate(this->fileSize(path_));
+}
+
+bool LogRotate::shouldRotate(size_t file_size) {
+  return file_size >= this->getRotateSize();
 }
 
 Status LogRotate::rotate(size_t max_files) {
@@ -135,79 +157,270 @@ Status LogRotate::moveFiles(const std::vector<std::string>& moves,
   return Status::success();
 }
 
+LogWriter::LogWriter(const std::string& path) : path_(path), rotate_(path) {}
+
+LogWriter::~LogWriter() {
+  flush();
+}
+
+Status LogWriter::open() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return openLocked();
+}
+
+Status LogWriter::write(const std::string& line) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  buffer_.append(line);
+  buffer_.push_back('\n');
+
+  if (FLAGS_logger_flush_interval == 0 ||
+      buffer_.size() >= FLAGS_logger_flush_size) {
+    return flushLocked();
+  }
+
+  return Status::success();
+}
+
+Status LogWriter::write(const std::vector<std::string>& lines) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& line : lines) {
+    buffer_.append(line);
+    buffer_.push_back('\n');
+  }
+
+  if (FLAGS_logger_flush_interval == 0 ||
+      buffer_.size() >= FLAGS_logger_flush_size) {
+    return flushLocked();
+  }
+
+  return Status::success();
+}
+
+Status LogWriter::flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return flushLocked();
+}
+
+Status LogWriter::openLocked() {
+  file_.reset();
+
+  auto file = std::make_unique<PlatformFile>(
+      path_, PF_OPEN_ALWAYS | PF_WRITE | PF_APPEND, FLAGS_logger_mode);
+  if (!file->isValid()) {
+    return Status::failure("Could not create file: " + path_);
+  }
+
+  // If the file existed with different permissions before our open
+  // they must be restricted.
+  if (!platformChmod(path_, FLAGS_logger_mode)) {
+    return Status::failure("Failed to change permissions for file: " + path_);
+  }
+
+  file_ = std::move(file);
+  file_size_ = file_->size();
+  last_file_check_ = std::chrono::steady_clock::now();
+  return Status::success();
+}
+
+Status LogWriter::checkFileLocked() {
+  if (file_ == nullptr) {
+    return openLocked();
+  }
+
+  // The log file may be moved or truncated by an external rotation tool,
+  // which is only detected once a second to avoid a stat for every write.
+  auto now = std::chrono::steady_clock::now();
+  if (now - last_file_check_ < std::chrono::seconds(1)) {
+    return Status::success();
+  }
+
+  last_file_check_ = now;
+
+  boost::system::error_code ec;
+  auto size = fs::file_size(path_, ec);
+  if (ec || size != file_size_) {
+    return openLocked();
+  }
+
+  return Status::success();
+}
+
+Status LogWriter::flushLocked() {
+  if (buffer_.empty()) {
+    return Status::success();
+  }
+
+  auto status = checkFileLocked();
+  if (!status.ok()) {
+    return status;
+  }
+
+  if (FLAGS_logger_rotate && rotate_.shouldRotate(file_size_)) {
+    file_.reset();
+
+    status = rotate_.rotate(FLAGS_logger_rotate_max_files);
+    if (!status.ok()) {
+      return status;
+    }
+
+    status = openLocked();
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  size_t offset = 0;
+  while (offset < buffer_.size()) {
+    auto bytes =
+        file_->write(buffer_.data() + offset, buffer_.size() - offset);
+    if (bytes <= 0) {
+      // Drop the lines, like a failed write of a single line would.
+      buffer_.clear();
+      file_.reset();
+      return Status::failure("Failed to write contents to file: " + path_);
+    }
+
+    offset += static_cast<size_t>(bytes);
+  }
+
+  file_size_ += buffer_.size();
+  buffer_.clear();
+
+  if (FLAGS_logger_fsync == "flush" && !file_->sync()) {
+    return Status::failure("Failed to sync file: " + path_);
+  }
+
+  return Status::success();
+}
+
+namespace {
+
+/// Writes the buffered filesystem log lines every --logger_flush_interval.
+class FilesystemLogFlusher : public InternalRunnable {
+ public:
+  FilesystemLogFlusher(std::shared_ptr<LogWriter> results_writer,
+                       std::shared_ptr<LogWriter> snapshot_writer)
+      : InternalRunnable("FilesystemLogFlusher"),
+        results_writer_(std::move(results_writer)),
+        snapshot_writer_(std::move(snapshot_writer)) {}
+
+ protected:
+  void start() override {
+    while (!interrupted()) {
+      pause(std::chrono::milliseconds(FLAGS_logger_flush_interval));
+      flush();
+    }
+
+    flush();
+  }
+
+ private:
+  void flush() {
+    results_writer_->flush();
+    snapshot_writer_->flush();
+  }
+
+ private:
+  std::shared_ptr<LogWriter> results_writer_;
+  std::shared_ptr<LogWriter> snapshot_writer_;
+};
+
+} // namespace
+
 struct FilesystemLoggerPlugin::impl {
   /// The folder where Glog and the result/snapshot files are written.
   boost::filesystem::path log_path;
 
-  /// Results log rotator.
-  std::unique_ptr<LogRotate> results_rotate{nullptr};
-  /// Snapshot log rotator.
-  std::unique_ptr<LogRotate> snapshot_rotate{nullptr};
+  /// Results log writer.
+  std::shared_ptr<LogWriter> results_writer{nullptr};
+  /// Snapshot log writer.
+  std::shared_ptr<LogWriter> snapshot_writer{nullptr};
 
-  /// Filesystem results log writer mutex.
-  Mutex snapshot_mutex;
-  /// Filesystem snapshot log write mutex.
-  Mutex results_mutex;
+  /// Periodically flushes the writers when lines are buffered.
+  InternalRunnableRef flusher{nullptr};
 };
 
 FilesystemLoggerPlugin::FilesystemLoggerPlugin()
     : pimpl_(std::make_unique<FilesystemLoggerPlugin::impl>()) {}
 
-FilesystemLoggerPlugin::~FilesystemLoggerPlugin() = default;
+FilesystemLoggerPlugin::~FilesystemLoggerPlugin() {
+  tearDown();
+}
 
 Status FilesystemLoggerPlugin::setUp() {
-  pimpl_->log_path = fs::path(FLAGS_logger_path);
-  pimpl_->results_rotate = std::make_unique<LogRotate>(
-      (pimpl_->log_path / kFilesystemLoggerFilename).string());
-  pimpl_->snapshot_rotate = std::make_unique<LogRotate>(
-      (pimpl_->log_path / kFilesystemLoggerSnapshots).string());
+  // Write out the lines buffered by a previous setup.
+  tearDown();
+
+  try {
+    pimpl_->log_path = fs::path(FLAGS_logger_path);
+    pimpl_->results_writer = std::make_shared<LogWriter>(
+        (pimpl_->log_path / kFilesystemLoggerFilename).string());
+    pimpl_->snapshot_writer = std::make_shared<LogWriter>(
+        (pimpl_->log_path / kFilesystemLoggerSnapshots).string());
+  } catch (const std::exception& e) {
+    return Status::failure(e.what());
+  }
 
   // Ensure that the Glog status logs use the same mode as our results log.
   // Glog 0.3.4 does not support a logfile mode.
   // FLAGS_logfile_mode = FLAGS_logger_mode;
 
   // Ensure that we create the results log here.
-  WriteLock lock(pimpl_->results_mutex);
-  return logStringToFile("", kFilesystemLoggerFilename, true);
+  auto status = pimpl_->results_writer->open();
+  if (!status.ok()) {
+    return status;
+  }
+
+  if (FLAGS_logger_flush_interval > 0) {
+    pimpl_->flusher = std::make_shared<FilesystemLogFlusher>(
+        pimpl_->results_writer, pimpl_->snapshot_writer);
+    Dispatcher::addService(pimpl_->flusher);
+  }
+
+  return Status::success();
+}
+
+void FilesystemLoggerPlugin::tearDown() {
+  if (pimpl_->flusher != nullptr) {
+    pimpl_->flusher->interrupt();
+    pimpl_->flusher.reset();
+  }
+
+  if (pimpl_->results_writer != nullptr) {
+    pimpl_->results_writer->flush();
+  }
+
+  if (pimpl_->snapshot_writer != nullptr) {
+    pimpl_->snapshot_writer->flush();
+  }
 }
 
 Status FilesystemLoggerPlugin::logString(const std::string& s) {
-  WriteLock lock(pimpl_->results_mutex);
-  if (FLAGS_logger_rotate && pimpl_->results_rotate->shouldRotate()) {
-    auto s = pimpl_->results_rotate->rotate(FLAGS_logger_rotate_max_files);
-    if (!s.ok()) {
-      return s;
-    }
+  if (pimpl_->results_writer == nullptr) {
+    return Status::failure("The filesystem logger is not set up");
   }
 
-  return logStringToFile(s, kFilesystemLoggerFilename);
+  return pimpl_->results_writer->write(s);
 }
 
 Status FilesystemLoggerPlugin::logSnapshot(const std::string& s) {
   // Send the snapshot data to a separate filename.
-  WriteLock lock(pimpl_->snapshot_mutex);
-  if (FLAGS_logger_rotate && pimpl_->snapshot_rotate->shouldRotate()) {
-    auto s = pimpl_->snapshot_rotate->rotate(FLAGS_logger_rotate_max_files);
-    if (!s.ok()) {
-      return s;
-    }
+  if (pimpl_->snapshot_writer == nullptr) {
+    return Status::failure("The filesystem logger is not set up");
   }
 
-  return logStringToFile(s, kFilesystemLoggerSnapshots);
+  return pimpl_->snapshot_writer->write(s);
 }
 
-Status FilesystemLoggerPlugin::logStringToFile(const std::string& s,
-                                               const std::string& filename,
-                                               bool empty) {
-  Status status;
-  try {
-    auto filepath = (pimpl_->log_path / filename).string();
-    status =
-        writeTextFile(filepath, (empty) ? "" : s + '\n', FLAGS_logger_mode);
-  } catch (const std::exception& e) {
-    return Status(1, e.what());
+Status FilesystemLoggerPlugin::logChunk(const std::vector<std::string>& lines,
+                                        bool snapshot) {
+  const auto& writer =
+      (snapshot) ? pimpl_->snapshot_writer : pimpl_->results_writer;
+  if (writer == nullptr) {
+    return Status::failure("The filesystem logger is not set up");
   }
-  return status;
+
+  return writer->write(lines);
 }
 
 Status FilesystemLoggerPlugin::logStatus(
@@ -25,12 +25,19 @@ class FilesystemLoggerPlugin : public LoggerPlugin {
 
   Status setUp() override;
 
+  /// Write out any buffered lines.
+  void tearDown() override;
+
   /// Log results (differential) to a distinct path.
   Status logString(const std::string& s) override;
 
   /// Log snapshot data to a distinct path.
   Status logSnapshot(const std::string& s) override;
 
+  /// Log a chunk of results or snapshot events under a single lock.
+  Status logChunk(const std::vector<std::string>& lines,
+                  bool snapshot) override;
+
   /**
    * @brief Initialize the logger plugin after osquery has begun.
    *
@@ -44,12 +51,6 @@ class FilesystemLoggerPlugin : public LoggerPlugin {
   /// Write a status to Glog.
   Status logStatus(const std::vector<StatusLogLine>& log) override;
 
- private:
-  /// The plugin-internal filesystem writer method.
-  Status logStringToFile(const std::string& s,
-                         const std::string& filename,
-                         bool empty = false);
-
  private:
   struct impl;
   std::unique_ptr<impl> pimpl_{nullptr};
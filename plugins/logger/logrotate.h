@@ -27,6 +27,9 @@ class LogRotate {
   /// Check if the current file under rotation has exceeded the limits.
   bool shouldRotate();
 
+  /// Check if a file of the given size has exceeded the limits.
+  bool shouldRotate(size_t file_size);
+
   /// Applies rotation to the target accumulating file.
   Status rotate(size_t max_files);
 
@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+#pragma once
+
+#include "logrotate.h"
+
+#include <osquery/filesystem/fileops.h>
+#include <osquery/utils/status/status.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace osquery {
+
+/**
+ * @brief An append-only writer for a filesystem log.
+ *
+ * The log file is kept open between writes and lines are collected in a
+ * buffer. The buffer is written out with a single write when it reaches
+ * `--logger_flush_size` bytes, when flush is called by the owner (usually on
+ * a `--logger_flush_interval` timer), or after every write when the flush
+ * interval is 0. Rotation is driven by the number of bytes written instead
+ * of the on-disk file size.
+ */
+class LogWriter {
+ public:
+  explicit LogWriter(const std::string& path);
+  ~LogWriter();
+
+  /// Create or open the log file, applying the configured mode.
+  Status open();
+
+  /// Append a line, a newline is added.
+  Status write(const std::string& line);
+
+  /// Append several lines at once, a newline is added to each.
+  Status write(const std::vector<std::string>& lines);
+
+  /// Write the buffered lines to the log file.
+  Status flush();
+
+ private:
+  /// Open the log file, the lock must be held.
+  Status openLocked();
+
+  /// Write the buffered lines, the lock must be held.
+  Status flushLocked();
+
+  /// Reopen the log file if it was moved, removed or truncated by others.
+  Status checkFileLocked();
+
+ private:
+  /// Full path to the log file.
+  std::string path_;
+
+  /// Protects all of the members below.
+  std::mutex mutex_;
+
+  /// The open log file.
+  std::unique_ptr<PlatformFile> file_;
+
+  /// Lines waiting to be written.
+  std::string buffer_;
+
+  /// Bytes in the log file, including the ones written by this writer.
+  size_t file_size_{0};
+
+  /// Last time the log file was checked for external changes.
+  std::chrono::steady_clock::time_point last_file_check_;
+
+  /// Rotates the log file when it exceeds the configured size.
+  LogRotate rotate_;
+};
+
+} // namespace osquery
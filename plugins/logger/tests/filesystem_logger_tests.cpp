@@ -33,6 +33,10 @@ namespace osquery {
 DECLARE_string(logger_path);
 DECLARE_bool(disable_logging);
 DECLARE_bool(logger_numerics);
+DECLARE_bool(logger_rotate);
+DECLARE_uint64(logger_rotate_size);
+DECLARE_uint64(logger_flush_interval);
+DECLARE_uint64(logger_flush_size);
 
 class FilesystemLoggerTests : public testing::Test {
  public:
@@ -85,6 +89,78 @@ TEST_F(FilesystemLoggerTests, test_log_string) {
   EXPECT_EQ(content, "{\"json\": true}\n");
 }
 
+TEST_F(FilesystemLoggerTests, test_log_string_many) {
+  std::string expected;
+  for (size_t i = 0; i < 100; ++i) {
+    auto line = "{\"line\": " + std::to_string(i) + "}";
+    EXPECT_TRUE(logString(line, "event"));
+    expected += line + '\n';
+  }
+
+  std::string content;
+  EXPECT_TRUE(readFile(results_path_, content));
+  EXPECT_EQ(content, expected);
+}
+
+TEST_F(FilesystemLoggerTests, test_log_string_buffered) {
+  auto plugin = Registry::get().plugin("logger", "filesystem");
+
+  // Flush on a timer that will not expire during the test.
+  FLAGS_logger_flush_interval = 60 * 1000;
+  ASSERT_TRUE(plugin->setUp());
+
+  EXPECT_TRUE(logString("{\"line\": 1}", "event"));
+  EXPECT_TRUE(logString("{\"line\": 2}", "event"));
+
+  std::string content;
+  EXPECT_TRUE(readFile(results_path_, content));
+  EXPECT_EQ(content, "");
+
+  // Tearing down writes out the buffered lines.
+  plugin->tearDown();
+  FLAGS_logger_flush_interval = 0;
+
+  EXPECT_TRUE(readFile(results_path_, content));
+  EXPECT_EQ(content, "{\"line\": 1}\n{\"line\": 2}\n");
+
+  // A full buffer is written without waiting for the timer.
+  FLAGS_logger_flush_interval = 60 * 1000;
+  FLAGS_logger_flush_size = 16;
+  ASSERT_TRUE(plugin->setUp());
+
+  EXPECT_TRUE(logString("{\"line\": 3}", "event"));
+  EXPECT_TRUE(logString("{\"line\": 4}", "event"));
+
+  EXPECT_TRUE(readFile(results_path_, content));
+  EXPECT_EQ(content,
+            "{\"line\": 1}\n{\"line\": 2}\n{\"line\": 3}\n{\"line\": 4}\n");
+
+  plugin->tearDown();
+  FLAGS_logger_flush_interval = 0;
+  FLAGS_logger_flush_size = 1024 * 1024;
+}
+
+TEST_F(FilesystemLoggerTests, test_log_string_rotate) {
+  FLAGS_logger_rotate = true;
+  FLAGS_logger_rotate_size = 32;
+
+  // Each line is 12 bytes, the fourth write finds 36 bytes in the log,
+  // which is over the rotation size.
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_TRUE(logString("{\"line\": " + std::to_string(i) + "}", "event"));
+  }
+
+  FLAGS_logger_rotate = false;
+  FLAGS_logger_rotate_size = 25 * 1024 * 1024;
+
+  std::string content;
+  EXPECT_TRUE(readFile(results_path_ + ".1", content));
+  EXPECT_EQ(content, "{\"line\": 0}\n{\"line\": 1}\n{\"line\": 2}\n");
+
+  EXPECT_TRUE(readFile(results_path_, content));
+  EXPECT_EQ(content, "{\"line\": 3}\n");
+}
+
 class FilesystemTestLoggerPlugin : public LoggerPlugin {
  public:
   Status logString(const std::string& s) override {
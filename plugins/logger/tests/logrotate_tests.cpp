@@ -96,6 +96,7 @@ class FakeLogRotate : public LogRotate {
 
  private:
   FRIEND_TEST(LogRotateTests, test_should_rotate);
+  FRIEND_TEST(LogRotateTests, test_should_rotate_size);
   FRIEND_TEST(LogRotateTests, test_rotate);
   FRIEND_TEST(LogRotateTests, test_rotate_missing_file);
   FRIEND_TEST(LogRotateTests, test_rotate_overflow);
@@ -111,6 +112,16 @@ TEST_F(LogRotateTests, test_should_rotate) {
   EXPECT_TRUE(rotate.shouldRotate());
 }
 
+TEST_F(LogRotateTests, test_should_rotate_size) {
+  FakeLogRotate rotate("/doesnotexist/logdir");
+  rotate.setRotateSize(100);
+
+  // The tracked size is used instead of the file size.
+  EXPECT_FALSE(rotate.shouldRotate(99));
+  EXPECT_TRUE(rotate.shouldRotate(100));
+  EXPECT_FALSE(rotate.shouldRotate());
+}
+
 TEST_F(LogRotateTests, test_rotate) {
   FakeLogRotate rotate("/doesnotexist/logdir");
   rotate.insertFile("/doesnotexist/logdir", 100);
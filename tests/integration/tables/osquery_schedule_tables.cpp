@@ -0,0 +1,39 @@
+/**
+ * Copyright (c) 2014-present, The osquery authors
+ *
+ * This source code is licensed as defined by the LICENSE file found in the
+ * root directory of this source tree.
+ *
+ * SPDX-License-Identifier: (Apache-2.0 OR GPL-2.0-only)
+ */
+
+// Sanity check integration test for osquery_schedule_tables
+// Spec file: specs/utility/osquery_schedule_tables.table
+
+#include <osquery/tests/integration/tables/helper.h>
+
+namespace osquery {
+namespace table_tests {
+
+class osqueryScheduleTables : public testing::Test {
+ protected:
+  void SetUp() override {
+    setUpEnvironment();
+  }
+};
+
+TEST_F(osqueryScheduleTables, test_sanity) {
+  // There is no schedule within the test environment, rows may be empty.
+  auto const data = execute_query("select * from osquery_schedule_tables");
+  ValidationMap row_map = {
+      {"name", NonEmptyString},
+      {"table_name", NonEmptyString},
+      {"generations", NonNegativeInt},
+      {"rows", NonNegativeInt},
+      {"generate_time_ms", NonNegativeInt},
+  };
+  validate_rows(data, row_map);
+}
+
+} // namespace table_tests
+} // namespace osquery